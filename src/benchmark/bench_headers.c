@@ -0,0 +1,263 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file benchmark/bench_headers.c
+ * @brief  Cost of the header-line parsing path per request and per byte
+ * @author libmicrohttpd contributors
+ *
+ * The header parser is internal to connection.c, so it is timed
+ * through the library: the request heads of corpus.h are written,
+ * pipelined, into a socketpair given to the daemon with
+ * #MHD_add_connection(), and the daemon is driven with #MHD_run()
+ * until all (constant, small) responses arrived.  The cost of the
+ * "minimal" head is the fixed cost of a request; "ns_per_extra_byte"
+ * is what each byte of header above it costs.
+ *
+ * Usage: bench_headers [MILLISECONDS_PER_INPUT]
+ */
+#include "MHD_config.h"
+#include "platform.h"
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "corpus.h"
+
+/**
+ * Number of requests written at once.
+ */
+#define PIPELINE 32
+
+
+/**
+ * Response of all requests.
+ */
+static struct MHD_Response *response;
+
+
+/**
+ * Get the time from a monotonic clock.
+ *
+ * @return time in microseconds
+ */
+static uint64_t
+now_usec (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+static int
+ahc_headers (void *cls,
+             struct MHD_Connection *connection,
+             const char *url,
+             const char *method,
+             const char *version,
+             const char *upload_data,
+             size_t *upload_data_size,
+             void **con_cls)
+{
+  static int marker;
+
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data;
+  if (&marker != *con_cls)
+    {
+      /* the first call, the header was parsed */
+      *con_cls = &marker;
+      return MHD_YES;
+    }
+  if (0 != *upload_data_size)
+    {
+      *upload_data_size = 0;
+      return MHD_YES;
+    }
+  return MHD_queue_response (connection, MHD_HTTP_OK, response);
+}
+
+
+/**
+ * Drive the daemon until @a expected bytes were received.
+ *
+ * @param d the daemon
+ * @param fd client end of the connection
+ * @param expected number of bytes to wait for, 0 to wait for the
+ *        end of one response
+ * @return number of bytes received, 0 on error
+ */
+static size_t
+receive (struct MHD_Daemon *d,
+         int fd,
+         size_t expected)
+{
+  char buf[16384];
+  char tail[4] = { 0 };
+  size_t total = 0;
+  unsigned int idle = 0;
+  ssize_t got;
+
+  while (idle < 1000000)
+    {
+      MHD_run (d);
+      got = recv (fd, buf, sizeof (buf), 0);
+      if (got <= 0)
+        {
+          if ( (0 == got) ||
+               ( (EAGAIN != errno) && (EWOULDBLOCK != errno) ) )
+            return 0;
+          idle++;
+          continue;
+        }
+      total += got;
+      if ( (0 != expected) &&
+           (total >= expected) )
+        return total;
+      if (got >= 4)
+        memcpy (tail, &buf[got - 4], 4);
+      else
+        {
+          memmove (tail, &tail[got], 4 - got);
+          memcpy (&tail[4 - got], buf, got);
+        }
+      if ( (0 == expected) &&
+           (0 == memcmp (tail, "\r\nok", 4)) )
+        return total;
+    }
+  return 0;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  static const char *page = "ok";
+  struct MHD_Daemon *d;
+  struct sockaddr_in sa;
+  char *batch;
+  uint64_t min_usec = 200000;
+  uint64_t usec;
+  uint64_t start;
+  uint64_t requests;
+  size_t len;
+  size_t resp_len;
+  size_t min_len = 0;
+  double min_ns = 0;
+  double ns;
+  unsigned int i;
+  unsigned int j;
+  int sv[2];
+  int ret = 0;
+
+  if (argc > 1)
+    min_usec = (uint64_t) strtoul (argv[1], NULL, 10) * 1000;
+  response = MHD_create_response_from_buffer (strlen (page),
+                                              (void *) page,
+                                              MHD_RESPMEM_PERSISTENT);
+  d = MHD_start_daemon (MHD_USE_NO_LISTEN_SOCKET,
+                        0, NULL, NULL, &ahc_headers, NULL,
+                        MHD_OPTION_END);
+  if ( (NULL == response) ||
+       (NULL == d) )
+    return 2;
+  memset (&sa, 0, sizeof (sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  printf ("[\n");
+  for (i = 0; NULL != corpus_heads[i].name; i++)
+    {
+      len = strlen (corpus_heads[i].data);
+      batch = malloc (len * PIPELINE);
+      if (NULL == batch)
+        return 2;
+      for (j = 0; j < PIPELINE; j++)
+        memcpy (&batch[j * len], corpus_heads[i].data, len);
+      if (0 != socketpair (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv))
+        return 2;
+      if (MHD_YES != MHD_add_connection (d,
+                                         sv[1],
+                                         (const struct sockaddr *) &sa,
+                                         sizeof (sa)))
+        return 2;
+      /* the responses all have the same size */
+      if ( ((ssize_t) len != send (sv[0], batch, len, MSG_NOSIGNAL)) ||
+           (0 == (resp_len = receive (d, sv[0], 0))) )
+        {
+          fprintf (stderr, "No response to %s\n", corpus_heads[i].name);
+          ret = 1;
+          close (sv[0]);
+          free (batch);
+          continue;
+        }
+      requests = 0;
+      start = now_usec ();
+      do
+        {
+          if ( ((ssize_t) (len * PIPELINE) !=
+                send (sv[0], batch, len * PIPELINE, MSG_NOSIGNAL)) ||
+               (resp_len * PIPELINE != receive (d,
+                                                sv[0],
+                                                resp_len * PIPELINE)) )
+            {
+              ret = 1;
+              break;
+            }
+          requests += PIPELINE;
+          usec = now_usec () - start;
+        }
+      while (usec < min_usec);
+      close (sv[0]);
+      free (batch);
+      if (0 == requests)
+        {
+          fprintf (stderr, "Failed to run %s\n", corpus_heads[i].name);
+          continue;
+        }
+      ns = usec * 1000.0 / requests;
+      if (0 == i)
+        {
+          min_len = len;
+          min_ns = ns;
+        }
+      printf ("%s  {\"path\": \"header_parsing\", \"input\": \"%s\", "
+              "\"requests\": %llu, \"bytes_per_request\": %u, "
+              "\"ns_per_request\": %.1f, \"ns_per_byte\": %.3f, "
+              "\"ns_per_extra_byte\": %.3f}",
+              (0 == i) ? "" : ",\n",
+              corpus_heads[i].name,
+              (unsigned long long) requests,
+              (unsigned int) len,
+              ns,
+              ns / len,
+              (len > min_len) ? (ns - min_ns) / (len - min_len) : 0.0);
+      fflush (stdout);
+    }
+  printf ("\n]\n");
+  MHD_stop_daemon (d);
+  MHD_destroy_response (response);
+  return ret;
+}
@@ -0,0 +1,766 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file benchmark/bench_http.c
+ * @brief  HTTP scenarios against each threading mode, over loopback
+ * @author libmicrohttpd contributors
+ *
+ * For each scenario and threading mode, a daemon is started on
+ * 127.0.0.1 and loaded by the clients of loadgen.c for a fixed time.
+ * The results are written to stdout as a JSON array with one object
+ * per run, so that builds can be compared on the same machine.
+ *
+ * Usage: bench_http [-d SECONDS] [-c CONNECTIONS] [-t THREADS]
+ *                   [-s SCENARIO] [-m MODE] [-p PORT]
+ */
+#include "MHD_config.h"
+#include "platform.h"
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "loadgen.h"
+#ifdef HTTPS_SUPPORT
+#include "tls_test_keys.h"
+#endif
+
+/* CPU_COUNT clashes with the macro of <sched.h> */
+#if defined(BENCH_POOL_SIZE) && (BENCH_POOL_SIZE+0) < 2
+#undef BENCH_POOL_SIZE
+#endif
+#if !defined(BENCH_POOL_SIZE)
+#define BENCH_POOL_SIZE 2
+#endif
+
+/**
+ * Size of the file sent by "/file".
+ */
+#define FILE_SIZE (4 * 1024 * 1024)
+
+/**
+ * Number of 1 KiB blocks sent by "/chunked".
+ */
+#define CHUNKED_BLOCKS 64
+
+/**
+ * Size of the file part of the multipart upload.
+ */
+#define MULTIPART_SIZE (16 * 1024)
+
+/**
+ * Size of the body sent after "100 Continue".
+ */
+#define CONTINUE_SIZE (64 * 1024)
+
+/**
+ * Size of the messages on upgraded connections.
+ */
+#define ECHO_SIZE 64
+
+/**
+ * Boundary of the multipart upload.
+ */
+#define BOUNDARY "bench-boundary-1c4e"
+
+
+/**
+ * A threading mode of the daemon.
+ */
+struct Mode
+{
+  /**
+   * Name in the output.
+   */
+  const char *name;
+
+  /**
+   * Flags for #MHD_start_daemon().
+   */
+  unsigned int flags;
+
+  /**
+   * Size of the thread pool, 0 for none.
+   */
+  unsigned int pool;
+
+  /**
+   * Feature the mode needs, or #MHD_FEATURE_MESSGES (always there).
+   */
+  enum MHD_FEATURE feature;
+};
+
+
+/**
+ * What the clients of a scenario send.
+ */
+struct Scenario
+{
+  /**
+   * Name in the output.
+   */
+  const char *name;
+
+  /**
+   * Settings of the clients; port, connections, threads and duration
+   * come from the command line.
+   */
+  struct LoadConfig cfg;
+};
+
+
+static struct Mode modes[] = {
+  { "select", MHD_USE_SELECT_INTERNALLY, 0, MHD_FEATURE_MESSGES },
+  { "poll", MHD_USE_POLL_INTERNALLY, 0, MHD_FEATURE_POLL },
+  { "epoll", MHD_USE_EPOLL_INTERNALLY, 0, MHD_FEATURE_EPOLL },
+  { "epoll_pool", MHD_USE_EPOLL_INTERNALLY, BENCH_POOL_SIZE, MHD_FEATURE_EPOLL },
+  { "thread_per_connection", MHD_USE_THREAD_PER_CONNECTION, 0, MHD_FEATURE_MESSGES },
+  { NULL, 0, 0, MHD_FEATURE_MESSGES }
+};
+
+
+/**
+ * Response of "/small" and of the uploads.
+ */
+static struct MHD_Response *small_response;
+
+/**
+ * Response of "/file".
+ */
+static struct MHD_Response *file_response;
+
+/**
+ * Number of upgraded connections still echoing.
+ */
+static unsigned int echo_threads;
+
+/**
+ * Protects @e echo_threads.
+ */
+static pthread_mutex_t echo_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/**
+ * State of an upload.
+ */
+struct Upload
+{
+#ifdef HAVE_POSTPROCESSOR
+  /**
+   * Parser of a multipart upload, NULL for other uploads.
+   */
+  struct MHD_PostProcessor *pp;
+#endif
+
+  /**
+   * Number of bytes received.
+   */
+  uint64_t size;
+};
+
+
+#ifdef HAVE_POSTPROCESSOR
+static int
+post_iterator (void *cls,
+               enum MHD_ValueKind kind,
+               const char *key,
+               const char *filename,
+               const char *content_type,
+               const char *transfer_encoding,
+               const char *data,
+               uint64_t off,
+               size_t size)
+{
+  (void) cls; (void) kind; (void) key; (void) filename;
+  (void) content_type; (void) transfer_encoding; (void) data; (void) off;
+  (void) size;
+  return MHD_YES;
+}
+#endif
+
+
+static ssize_t
+chunked_reader (void *cls,
+                uint64_t pos,
+                char *buf,
+                size_t max)
+{
+  (void) cls;
+  if (pos >= CHUNKED_BLOCKS * 1024)
+    return MHD_CONTENT_READER_END_OF_STREAM;
+  if (max > 1024)
+    max = 1024;
+  memset (buf, 'c', max);
+  return max;
+}
+
+
+/**
+ * Main function of the thread echoing on an upgraded connection.
+ *
+ * @param cls the `struct MHD_UpgradeResponseHandle`
+ * @return NULL
+ */
+static void *
+run_echo (void *cls)
+{
+  struct MHD_UpgradeResponseHandle *urh = cls;
+  char buf[ECHO_SIZE];
+  ssize_t got;
+  ssize_t sent;
+  ssize_t off;
+
+  while (1)
+    {
+      got = MHD_upgrade_recv (urh, buf, sizeof (buf));
+      if ( (-1 == got) &&
+           (EAGAIN == errno) )
+        continue;
+      if (got <= 0)
+        break;
+      for (off = 0; off < got; off += sent)
+        {
+          sent = MHD_upgrade_send (urh, &buf[off], got - off);
+          if ( (-1 == sent) &&
+               (EAGAIN == errno) )
+            sent = 0;
+          else if (sent <= 0)
+            break;
+        }
+      if (off < got)
+        break;
+    }
+  MHD_upgrade_action (urh, MHD_UPGRADE_ACTION_CLOSE);
+  pthread_mutex_lock (&echo_lock);
+  echo_threads--;
+  pthread_mutex_unlock (&echo_lock);
+  return NULL;
+}
+
+
+static void
+upgrade_cb (void *cls,
+            struct MHD_Connection *connection,
+            void *con_cls,
+            const char *extra_in,
+            size_t extra_in_size,
+            MHD_socket sock,
+            struct MHD_UpgradeResponseHandle *urh)
+{
+  pthread_t pt;
+  int flags;
+
+  (void) cls; (void) connection; (void) con_cls; (void) extra_in;
+  /* the clients wait for the 101 before sending */
+  if (0 != extra_in_size)
+    abort ();
+  flags = fcntl (sock, F_GETFL);
+  if (-1 != flags)
+    (void) fcntl (sock, F_SETFL, flags & ~O_NONBLOCK);
+  pthread_mutex_lock (&echo_lock);
+  echo_threads++;
+  pthread_mutex_unlock (&echo_lock);
+  if ( (0 != pthread_create (&pt, NULL, &run_echo, urh)) ||
+       (0 != pthread_detach (pt)) )
+    abort ();
+}
+
+
+static int
+ahc_bench (void *cls,
+           struct MHD_Connection *connection,
+           const char *url,
+           const char *method,
+           const char *version,
+           const char *upload_data,
+           size_t *upload_data_size,
+           void **con_cls)
+{
+  struct Upload *up = *con_cls;
+  struct MHD_Response *response;
+  int ret;
+
+  (void) cls; (void) version;
+  if (0 == strcmp (url, "/upload"))
+    {
+      if (NULL == up)
+        {
+          up = calloc (1, sizeof (struct Upload));
+          if (NULL == up)
+            return MHD_NO;
+#ifdef HAVE_POSTPROCESSOR
+          if (0 == strcmp (method, MHD_HTTP_METHOD_POST))
+            up->pp = MHD_create_post_processor (connection,
+                                                1024,
+                                                &post_iterator,
+                                                up);
+#endif
+          *con_cls = up;
+          return MHD_YES;
+        }
+      if (0 != *upload_data_size)
+        {
+#ifdef HAVE_POSTPROCESSOR
+          if ( (NULL != up->pp) &&
+               (MHD_YES != MHD_post_process (up->pp,
+                                             upload_data,
+                                             *upload_data_size)) )
+            return MHD_NO;
+#endif
+          up->size += *upload_data_size;
+          *upload_data_size = 0;
+          return MHD_YES;
+        }
+      return MHD_queue_response (connection, MHD_HTTP_OK, small_response);
+    }
+  if (0 == strcmp (url, "/file"))
+    return MHD_queue_response (connection, MHD_HTTP_OK, file_response);
+  if (0 == strcmp (url, "/chunked"))
+    {
+      response = MHD_create_response_from_callback (MHD_SIZE_UNKNOWN,
+                                                    1024,
+                                                    &chunked_reader,
+                                                    NULL,
+                                                    NULL);
+      ret = MHD_queue_response (connection, MHD_HTTP_OK, response);
+      MHD_destroy_response (response);
+      return ret;
+    }
+  if (0 == strcmp (url, "/echo"))
+    {
+      response = MHD_create_response_for_upgrade (&upgrade_cb, NULL);
+      MHD_add_response_header (response,
+                               MHD_HTTP_HEADER_UPGRADE,
+                               "echo");
+      ret = MHD_queue_response (connection,
+                                MHD_HTTP_SWITCHING_PROTOCOLS,
+                                response);
+      MHD_destroy_response (response);
+      return ret;
+    }
+  return MHD_queue_response (connection, MHD_HTTP_OK, small_response);
+}
+
+
+static void
+completed_cb (void *cls,
+              struct MHD_Connection *connection,
+              void **con_cls,
+              enum MHD_RequestTerminationCode toe)
+{
+  struct Upload *up = *con_cls;
+
+  (void) cls; (void) connection; (void) toe;
+  if (NULL == up)
+    return;
+#ifdef HAVE_POSTPROCESSOR
+  if (NULL != up->pp)
+    MHD_destroy_post_processor (up->pp);
+#endif
+  free (up);
+  *con_cls = NULL;
+}
+
+
+/**
+ * Create the responses shared by all requests.
+ *
+ * @return 0 on success
+ */
+static int
+create_responses (void)
+{
+  static const char *page = "Hello";
+  char tmpl[] = "/tmp/mhd-bench-XXXXXX";
+  char buf[4096];
+  unsigned int i;
+  int fd;
+
+  small_response = MHD_create_response_from_buffer (strlen (page),
+                                                    (void *) page,
+                                                    MHD_RESPMEM_PERSISTENT);
+  if (NULL == small_response)
+    return -1;
+  fd = mkstemp (tmpl);
+  if (-1 == fd)
+    return -1;
+  (void) unlink (tmpl);
+  memset (buf, 'f', sizeof (buf));
+  for (i = 0; i < FILE_SIZE / sizeof (buf); i++)
+    if (sizeof (buf) != write (fd, buf, sizeof (buf)))
+      {
+        close (fd);
+        return -1;
+      }
+  file_response = MHD_create_response_from_fd (FILE_SIZE, fd);
+  if (NULL == file_response)
+    {
+      close (fd);
+      return -1;
+    }
+  return 0;
+}
+
+
+/**
+ * Build a request with a body.
+ *
+ * @param head request line and headers, without "Content-Length"
+ * @param body the body
+ * @param body_size number of bytes in @a body
+ * @param include_body non-zero to append @a body to the request
+ * @param[out] size set to the size of the request
+ * @return the request, NULL if out of memory
+ */
+static char *
+build_request (const char *head,
+               const char *body,
+               size_t body_size,
+               int include_body,
+               size_t *size)
+{
+  char *req;
+  int len;
+
+  req = malloc (strlen (head) + 64 + (include_body ? body_size : 0));
+  if (NULL == req)
+    return NULL;
+  len = sprintf (req,
+                 "%sContent-Length: %u\r\n\r\n",
+                 head,
+                 (unsigned int) body_size);
+  if (include_body)
+    memcpy (&req[len], body, body_size);
+  *size = len + (include_body ? body_size : 0);
+  return req;
+}
+
+
+/**
+ * Build the multipart body of the upload scenario.
+ *
+ * @param[out] size set to the size of the body
+ * @return the body, NULL if out of memory
+ */
+static char *
+build_multipart (size_t *size)
+{
+  static const char head[] =
+    "--" BOUNDARY "\r\n"
+    "Content-Disposition: form-data; name=\"file\"; filename=\"data.bin\"\r\n"
+    "Content-Type: application/octet-stream\r\n\r\n";
+  static const char tail[] = "\r\n--" BOUNDARY "--\r\n";
+  char *body;
+
+  *size = strlen (head) + MULTIPART_SIZE + strlen (tail);
+  body = malloc (*size);
+  if (NULL == body)
+    return NULL;
+  memcpy (body, head, strlen (head));
+  memset (&body[strlen (head)], 'u', MULTIPART_SIZE);
+  memcpy (&body[strlen (head) + MULTIPART_SIZE], tail, strlen (tail));
+  return body;
+}
+
+
+/**
+ * Print the result of one run as a JSON object.
+ */
+static void
+print_result (const char *scenario,
+              const char *mode,
+              unsigned int connections,
+              const struct LoadResult *res,
+              int first)
+{
+  double seconds = (res->seconds > 0) ? res->seconds : 1;
+
+  printf ("%s  {\"scenario\": \"%s\", \"mode\": \"%s\", \"connections\": %u, "
+          "\"requests\": %llu, \"errors\": %llu, \"seconds\": %.3f, "
+          "\"requests_per_sec\": %.1f, \"bytes_per_sec\": %.1f, "
+          "\"p50_us\": %llu, \"p99_us\": %llu, \"p999_us\": %llu}",
+          first ? "" : ",\n",
+          scenario,
+          mode,
+          connections,
+          (unsigned long long) res->requests,
+          (unsigned long long) res->errors,
+          res->seconds,
+          res->requests / seconds,
+          res->bytes / seconds,
+          (unsigned long long) load_percentile (res, 50),
+          (unsigned long long) load_percentile (res, 99),
+          (unsigned long long) load_percentile (res, 99.9));
+  fflush (stdout);
+}
+
+
+/**
+ * Wait until all upgraded connections of a run are closed.
+ */
+static void
+wait_echo_threads (void)
+{
+  unsigned int i;
+  unsigned int left;
+
+  for (i = 0; i < 500; i++)
+    {
+      pthread_mutex_lock (&echo_lock);
+      left = echo_threads;
+      pthread_mutex_unlock (&echo_lock);
+      if (0 == left)
+        return;
+      usleep (10000);
+    }
+  fprintf (stderr, "%u upgraded connections did not close\n", left);
+}
+
+
+/**
+ * Start a daemon in the given mode.
+ *
+ * @param mode the threading mode
+ * @param port the port
+ * @param tls non-zero for HTTPS
+ * @return NULL on error
+ */
+static struct MHD_Daemon *
+start_daemon (const struct Mode *mode,
+              uint16_t port,
+              int tls)
+{
+  unsigned int flags = mode->flags;
+
+  if (0 == (flags & MHD_USE_THREAD_PER_CONNECTION))
+    flags |= MHD_USE_SUSPEND_RESUME;
+  if (tls)
+    {
+#ifdef HTTPS_SUPPORT
+      return MHD_start_daemon (flags | MHD_USE_TLS,
+                               port, NULL, NULL, &ahc_bench, NULL,
+                               MHD_OPTION_THREAD_POOL_SIZE, mode->pool,
+                               MHD_OPTION_NOTIFY_COMPLETED, &completed_cb, NULL,
+                               MHD_OPTION_HTTPS_MEM_KEY, srv_key_pem,
+                               MHD_OPTION_HTTPS_MEM_CERT, srv_self_signed_cert_pem,
+                               MHD_OPTION_END);
+#else
+      return NULL;
+#endif
+    }
+  return MHD_start_daemon (flags,
+                           port, NULL, NULL, &ahc_bench, NULL,
+                           MHD_OPTION_THREAD_POOL_SIZE, mode->pool,
+                           MHD_OPTION_NOTIFY_COMPLETED, &completed_cb, NULL,
+                           MHD_OPTION_END);
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  static const char get_small[] =
+    "GET /small HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+  static const char get_file[] =
+    "GET /file HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+  static const char get_chunked[] =
+    "GET /chunked HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+  static const char get_close[] =
+    "GET /small HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+  static const char get_echo[] =
+    "GET /echo HTTP/1.1\r\nHost: 127.0.0.1\r\n"
+    "Connection: Upgrade\r\nUpgrade: echo\r\n\r\n";
+  struct Scenario scenarios[8];
+  struct LoadConfig base;
+  struct LoadResult res;
+  struct MHD_Daemon *d;
+  const char *scenario_filter = NULL;
+  const char *mode_filter = NULL;
+  char *multipart;
+  char *continue_body;
+  size_t multipart_size;
+  unsigned int num_scenarios;
+  unsigned int i;
+  unsigned int j;
+  int first;
+  int opt;
+  int ret;
+
+  memset (&base, 0, sizeof (base));
+  base.port = 1099;
+  base.connections = 32;
+  base.threads = 2;
+  base.seconds = 2;
+  base.pipeline = 1;
+  while (-1 != (opt = getopt (argc, argv, "d:c:t:s:m:p:")))
+    {
+      switch (opt)
+        {
+        case 'd':
+          base.seconds = atof (optarg);
+          break;
+        case 'c':
+          base.connections = (unsigned int) atoi (optarg);
+          break;
+        case 't':
+          base.threads = (unsigned int) atoi (optarg);
+          break;
+        case 's':
+          scenario_filter = optarg;
+          break;
+        case 'm':
+          mode_filter = optarg;
+          break;
+        case 'p':
+          base.port = (uint16_t) atoi (optarg);
+          break;
+        default:
+          fprintf (stderr,
+                   "Usage: %s [-d SECONDS] [-c CONNECTIONS] [-t THREADS] "
+                   "[-s SCENARIO] [-m MODE] [-p PORT]\n",
+                   argv[0]);
+          return 2;
+        }
+    }
+  if ( (base.seconds <= 0) ||
+       (0 == base.connections) ||
+       (0 != create_responses ()) )
+    return 2;
+  multipart = build_multipart (&multipart_size);
+  continue_body = malloc (CONTINUE_SIZE);
+  if ( (NULL == multipart) ||
+       (NULL == continue_body) )
+    return 2;
+  memset (continue_body, 'p', CONTINUE_SIZE);
+
+  num_scenarios = 0;
+#define ADD_SCENARIO(n) \
+  scenarios[num_scenarios].name = (n); \
+  scenarios[num_scenarios].cfg = base
+  ADD_SCENARIO ("keepalive_get");
+  scenarios[num_scenarios].cfg.request = get_small;
+  scenarios[num_scenarios++].cfg.request_size = strlen (get_small);
+  ADD_SCENARIO ("pipelined_get");
+  scenarios[num_scenarios].cfg.request = get_small;
+  scenarios[num_scenarios].cfg.request_size = strlen (get_small);
+  scenarios[num_scenarios++].cfg.pipeline = 8;
+  ADD_SCENARIO ("sendfile_download");
+  scenarios[num_scenarios].cfg.request = get_file;
+  scenarios[num_scenarios++].cfg.request_size = strlen (get_file);
+  ADD_SCENARIO ("chunked_stream");
+  scenarios[num_scenarios].cfg.request = get_chunked;
+  scenarios[num_scenarios++].cfg.request_size = strlen (get_chunked);
+  ADD_SCENARIO ("multipart_upload");
+  scenarios[num_scenarios].cfg.request =
+    build_request ("POST /upload HTTP/1.1\r\nHost: 127.0.0.1\r\n"
+                   "Content-Type: multipart/form-data; boundary=" BOUNDARY "\r\n",
+                   multipart,
+                   multipart_size,
+                   1,
+                   &scenarios[num_scenarios].cfg.request_size);
+  if (NULL == scenarios[num_scenarios++].cfg.request)
+    return 2;
+  ADD_SCENARIO ("continue_upload");
+  scenarios[num_scenarios].cfg.request =
+    build_request ("PUT /upload HTTP/1.1\r\nHost: 127.0.0.1\r\n"
+                   "Expect: 100-continue\r\n",
+                   continue_body,
+                   CONTINUE_SIZE,
+                   0,
+                   &scenarios[num_scenarios].cfg.request_size);
+  scenarios[num_scenarios].cfg.body = continue_body;
+  scenarios[num_scenarios].cfg.body_size = CONTINUE_SIZE;
+  scenarios[num_scenarios].cfg.expect_continue = 1;
+  if (NULL == scenarios[num_scenarios++].cfg.request)
+    return 2;
+#ifdef HTTPS_SUPPORT
+  ADD_SCENARIO ("https_handshake");
+  scenarios[num_scenarios].cfg.request = get_close;
+  scenarios[num_scenarios].cfg.request_size = strlen (get_close);
+  scenarios[num_scenarios].cfg.close_after_response = 1;
+  scenarios[num_scenarios++].cfg.tls = 1;
+#else
+  (void) get_close;
+#endif
+  ADD_SCENARIO ("upgrade_echo");
+  scenarios[num_scenarios].cfg.request = get_echo;
+  scenarios[num_scenarios].cfg.request_size = strlen (get_echo);
+  scenarios[num_scenarios++].cfg.echo_size = ECHO_SIZE;
+#undef ADD_SCENARIO
+
+  ret = 0;
+  first = 1;
+  printf ("[\n");
+  for (i = 0; i < num_scenarios; i++)
+    {
+      if ( (NULL != scenario_filter) &&
+           (0 != strcmp (scenario_filter, scenarios[i].name)) )
+        continue;
+      for (j = 0; NULL != modes[j].name; j++)
+        {
+          if ( (NULL != mode_filter) &&
+               (0 != strcmp (mode_filter, modes[j].name)) )
+            continue;
+          if (MHD_YES != MHD_is_feature_supported (modes[j].feature))
+            continue;
+          d = start_daemon (&modes[j], base.port, scenarios[i].cfg.tls);
+          if (NULL == d)
+            {
+              fprintf (stderr,
+                       "Failed to start daemon for %s in mode %s\n",
+                       scenarios[i].name,
+                       modes[j].name);
+              ret = 1;
+              continue;
+            }
+          if (0 != load_run (&scenarios[i].cfg, &res))
+            {
+              fprintf (stderr,
+                       "Failed to run %s in mode %s\n",
+                       scenarios[i].name,
+                       modes[j].name);
+              ret = 1;
+            }
+          else
+            {
+              print_result (scenarios[i].name,
+                            modes[j].name,
+                            scenarios[i].cfg.connections,
+                            &res,
+                            first);
+              first = 0;
+            }
+          load_result_free (&res);
+          wait_echo_threads ();
+          MHD_stop_daemon (d);
+        }
+    }
+  printf ("\n]\n");
+  free ((void *) scenarios[4].cfg.request);
+  free ((void *) scenarios[5].cfg.request);
+  free (multipart);
+  free (continue_body);
+  MHD_destroy_response (small_response);
+  MHD_destroy_response (file_response);
+  return ret;
+}
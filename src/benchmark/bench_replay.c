@@ -0,0 +1,606 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file benchmark/bench_replay.c
+ * @brief  Replay of a trace recorded with #MHD_OPTION_TRACE_FILE
+ * @author libmicrohttpd contributors
+ *
+ * Each connection of the trace becomes a socketpair whose server end
+ * is given to a daemon in this process with #MHD_add_connection(), so
+ * no network is involved.  The recorded bytes are sent on the client
+ * end at the recorded times divided by the speed (or as fast as
+ * possible with speed 0), keeping the header sizes, pipelining and
+ * slow clients of the recorded traffic.  The handler discards uploads
+ * and answers every request with a response of a fixed size.
+ *
+ * The daemon has no listen socket and is driven with #MHD_run() (in
+ * the select, poll or epoll mode) by the thread that sends the
+ * records, as #MHD_add_connection() is not safe to call while a
+ * thread of the daemon processes its connections.
+ *
+ * The result is a JSON object with the wall time, the time spent in
+ * #MHD_run(), how late the records were sent compared to the
+ * schedule (a daemon that keeps up has little lag), the bytes sent
+ * and received and the number of connections the daemon had not
+ * closed at the end.
+ *
+ * Usage: bench_replay [-s SPEED] [-m MODE] [-r BYTES] TRACEFILE
+ */
+#include "MHD_config.h"
+#include "platform.h"
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "mhd_trace.h"
+
+/**
+ * How long to wait for further responses after the last record,
+ * in microseconds.
+ */
+#define DRAIN_USEC 200000
+
+
+/**
+ * A record of the trace.
+ */
+struct Record
+{
+  /**
+   * When it was recorded, in microseconds since the trace started.
+   */
+  uint64_t usec;
+
+  /**
+   * Number of the connection.
+   */
+  uint32_t connection;
+
+  /**
+   * Type of the record.
+   */
+  enum MHD_TraceRecordType type;
+
+  /**
+   * Number of bytes in @e data.
+   */
+  size_t size;
+
+  /**
+   * The data, points into the loaded trace.
+   */
+  const char *data;
+};
+
+
+/**
+ * Client end of a connection.
+ */
+struct Client
+{
+  /**
+   * The socket, -1 if not open.
+   */
+  int fd;
+
+  /**
+   * Non-zero if the daemon closed its end.
+   */
+  int closed;
+
+  /**
+   * Non-zero if the client shut down its end in the trace.
+   */
+  int eof;
+};
+
+
+/**
+ * Clients indexed by connection number.
+ */
+static struct Client *clients;
+
+/**
+ * Number of entries in @e clients.
+ */
+static uint32_t num_clients;
+
+/**
+ * Bytes received from the daemon.
+ */
+static uint64_t bytes_received;
+
+/**
+ * Time spent in #MHD_run(), in microseconds.
+ */
+static uint64_t daemon_usec;
+
+/**
+ * Response of all requests.
+ */
+static struct MHD_Response *response;
+
+
+/**
+ * Get the time from a monotonic clock.
+ *
+ * @return time in microseconds
+ */
+static uint64_t
+now_usec (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/**
+ * Read a little endian 32 bit number.
+ *
+ * @param buf where to read from
+ * @return the number
+ */
+static uint32_t
+get_le32 (const unsigned char *buf)
+{
+  return (uint32_t) buf[0]
+    | ((uint32_t) buf[1] << 8)
+    | ((uint32_t) buf[2] << 16)
+    | ((uint32_t) buf[3] << 24);
+}
+
+
+/**
+ * Load a trace file.
+ *
+ * @param filename name of the file
+ * @param[out] buf set to the contents of the file, to be freed
+ * @param[out] num set to the number of records
+ * @return the records, NULL on error
+ */
+static struct Record *
+load_trace (const char *filename,
+            char **buf,
+            size_t *num)
+{
+  FILE *f;
+  struct Record *records;
+  const unsigned char *pos;
+  long size;
+  size_t off;
+  size_t n;
+  uint32_t word;
+
+  if (NULL == (f = fopen (filename, "rb")))
+    return NULL;
+  if ( (0 != fseek (f, 0, SEEK_END)) ||
+       (0 > (size = ftell (f))) ||
+       (0 != fseek (f, 0, SEEK_SET)) ||
+       (NULL == (*buf = malloc (size + 1))) )
+    {
+      fclose (f);
+      return NULL;
+    }
+  if ( ((size_t) size != fread (*buf, 1, size, f)) ||
+       (size < MHD_TRACE_HEADER_SIZE) ||
+       (0 != memcmp (*buf, MHD_TRACE_MAGIC, 8)) ||
+       (MHD_TRACE_VERSION != get_le32 ((unsigned char *) *buf + 8)) )
+    {
+      fprintf (stderr, "%s is not a trace file\n", filename);
+      fclose (f);
+      free (*buf);
+      return NULL;
+    }
+  fclose (f);
+  /* at most one record per header */
+  records = malloc (sizeof (struct Record)
+                    * (size / MHD_TRACE_RECORD_SIZE + 1));
+  if (NULL == records)
+    {
+      free (*buf);
+      return NULL;
+    }
+  n = 0;
+  off = MHD_TRACE_HEADER_SIZE;
+  while (off + MHD_TRACE_RECORD_SIZE <= (size_t) size)
+    {
+      pos = (const unsigned char *) *buf + off;
+      word = get_le32 (&pos[12]);
+      records[n].usec = (uint64_t) get_le32 (pos)
+        | ((uint64_t) get_le32 (&pos[4]) << 32);
+      records[n].connection = get_le32 (&pos[8]);
+      records[n].type = (enum MHD_TraceRecordType) (word >> 24);
+      records[n].size = word & MHD_TRACE_MAX_DATA;
+      records[n].data = (const char *) pos + MHD_TRACE_RECORD_SIZE;
+      off += MHD_TRACE_RECORD_SIZE + records[n].size;
+      if (off > (size_t) size)
+        break; /* truncated, the daemon did not shut down */
+      if (records[n].connection >= num_clients)
+        num_clients = records[n].connection + 1;
+      n++;
+    }
+  *num = n;
+  return records;
+}
+
+
+static int
+ahc_replay (void *cls,
+            struct MHD_Connection *connection,
+            const char *url,
+            const char *method,
+            const char *version,
+            const char *upload_data,
+            size_t *upload_data_size,
+            void **con_cls)
+{
+  static int marker;
+
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data;
+  if (&marker != *con_cls)
+    {
+      *con_cls = &marker;
+      return MHD_YES;
+    }
+  if (0 != *upload_data_size)
+    {
+      *upload_data_size = 0;
+      return MHD_YES;
+    }
+  return MHD_queue_response (connection, MHD_HTTP_OK, response);
+}
+
+
+/**
+ * Read the responses from the clients.
+ *
+ * @return number of bytes read
+ */
+static uint64_t
+drain (void)
+{
+  static char buf[65536];
+  uint64_t total = 0;
+  uint32_t c;
+  ssize_t got;
+
+  for (c = 0; c < num_clients; c++)
+    {
+      if ( (-1 == clients[c].fd) ||
+           (clients[c].closed) )
+        continue;
+      while (0 < (got = recv (clients[c].fd, buf, sizeof (buf), 0)))
+        total += got;
+      if ( (0 == got) ||
+           ( (EAGAIN != errno) && (EWOULDBLOCK != errno) ) )
+        clients[c].closed = 1;
+    }
+  bytes_received += total;
+  return total;
+}
+
+
+/**
+ * Count the clients whose connection the daemon did not close.
+ *
+ * @return number of open connections
+ */
+static unsigned int
+count_open (void)
+{
+  unsigned int n = 0;
+  uint32_t c;
+
+  for (c = 0; c < num_clients; c++)
+    if ( (-1 != clients[c].fd) &&
+         (! clients[c].closed) )
+      n++;
+  return n;
+}
+
+
+/**
+ * Run the daemon and read the responses until @a until, waiting
+ * for at most a millisecond at a time while nothing happens.
+ *
+ * @param d the daemon
+ * @param start start of the replay
+ * @param until when to return, relative to @a start; 0 to return
+ *        after one iteration
+ * @return #MHD_YES if something was received
+ */
+static int
+run_until (struct MHD_Daemon *d,
+           uint64_t start,
+           uint64_t until)
+{
+  uint64_t before;
+  uint64_t now;
+  int ret = MHD_NO;
+
+  do
+    {
+      before = now_usec ();
+      MHD_run (d);
+      now = now_usec ();
+      daemon_usec += now - before;
+      if (0 != drain ())
+        {
+          ret = MHD_YES;
+          continue;
+        }
+      if (now - start + 1000 < until)
+        usleep (1000);
+      else if (now - start < until)
+        usleep ((useconds_t) (until - (now - start)));
+    }
+  while (now_usec () - start < until);
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  static const struct
+  {
+    const char *name;
+    unsigned int flags;
+  } modes[] = {
+    { "select", 0 },
+    { "poll", MHD_USE_POLL },
+    { "epoll", MHD_USE_EPOLL },
+    { NULL, 0 }
+  };
+  struct MHD_Daemon *d;
+  struct sockaddr_in sa;
+  struct Record *records;
+  struct rlimit rl;
+  char *trace;
+  char *body;
+  const char *mode = "epoll";
+  double speed = 1.0;
+  size_t response_size = 128;
+  size_t num_records;
+  size_t i;
+  size_t off;
+  uint64_t start;
+  uint64_t due;
+  uint64_t now;
+  uint64_t lag_sum = 0;
+  uint64_t lag_max = 0;
+  uint64_t bytes_sent = 0;
+  unsigned int flags = 0;
+  unsigned int open_left;
+  uint64_t idle_since;
+  unsigned int connections = 0;
+  unsigned int m;
+  int found = 0;
+  ssize_t sent;
+  int sv[2];
+  int opt;
+
+  while (-1 != (opt = getopt (argc, argv, "s:m:r:")))
+    {
+      switch (opt)
+        {
+        case 's':
+          speed = atof (optarg);
+          break;
+        case 'm':
+          mode = optarg;
+          break;
+        case 'r':
+          response_size = (size_t) atol (optarg);
+          break;
+        default:
+          fprintf (stderr,
+                   "Usage: %s [-s SPEED] [-m MODE] [-r BYTES] TRACEFILE\n",
+                   argv[0]);
+          return 2;
+        }
+    }
+  if (optind + 1 != argc)
+    {
+      fprintf (stderr,
+               "Usage: %s [-s SPEED] [-m MODE] [-r BYTES] TRACEFILE\n",
+               argv[0]);
+      return 2;
+    }
+  for (m = 0; NULL != modes[m].name; m++)
+    if (0 == strcmp (mode, modes[m].name))
+      {
+        flags = modes[m].flags;
+        found = 1;
+      }
+  if (! found)
+    {
+      fprintf (stderr, "Unknown mode `%s'\n", mode);
+      return 2;
+    }
+  if (NULL == (records = load_trace (argv[optind],
+                                     &trace,
+                                     &num_records)))
+    {
+      fprintf (stderr, "Failed to load %s\n", argv[optind]);
+      return 2;
+    }
+  clients = malloc (sizeof (struct Client) * (num_clients + 1));
+  body = malloc (response_size + 1);
+  if ( (NULL == clients) ||
+       (NULL == body) )
+    return 2;
+  for (i = 0; i < num_clients; i++)
+    {
+      clients[i].fd = -1;
+      clients[i].closed = 0;
+      clients[i].eof = 0;
+    }
+  memset (body, 'x', response_size);
+  response = MHD_create_response_from_buffer (response_size,
+                                              body,
+                                              MHD_RESPMEM_PERSISTENT);
+  if (0 == getrlimit (RLIMIT_NOFILE, &rl))
+    {
+      rl.rlim_cur = rl.rlim_max;
+      (void) setrlimit (RLIMIT_NOFILE, &rl);
+    }
+  d = MHD_start_daemon (flags | MHD_USE_NO_LISTEN_SOCKET,
+                        0, NULL, NULL, &ahc_replay, NULL,
+                        MHD_OPTION_CONNECTION_LIMIT, (unsigned int) num_clients + 16,
+                        MHD_OPTION_END);
+  if ( (NULL == response) ||
+       (NULL == d) )
+    {
+      fprintf (stderr, "Failed to start the daemon\n");
+      return 2;
+    }
+  memset (&sa, 0, sizeof (sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  start = now_usec ();
+  for (i = 0; i < num_records; i++)
+    {
+      struct Client *c = &clients[records[i].connection];
+
+      if (speed > 0)
+        {
+          due = (uint64_t) (records[i].usec / speed);
+          (void) run_until (d, start, due);
+          now = now_usec () - start;
+          lag_sum += now - due;
+          if (now - due > lag_max)
+            lag_max = now - due;
+        }
+      else
+        (void) run_until (d, start, 0);
+      switch (records[i].type)
+        {
+        case MHD_TRACE_OPEN:
+          if (0 != socketpair (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv))
+            {
+              fprintf (stderr, "socketpair: %s\n", strerror (errno));
+              break;
+            }
+          sa.sin_port = htons ((uint16_t) records[i].connection);
+          if (MHD_YES != MHD_add_connection (d,
+                                             sv[1],
+                                             (const struct sockaddr *) &sa,
+                                             sizeof (sa)))
+            {
+              close (sv[0]);
+              break;
+            }
+          c->fd = sv[0];
+          connections++;
+          break;
+        case MHD_TRACE_DATA:
+          off = 0;
+          while ( (-1 != c->fd) &&
+                  (! c->closed) &&
+                  (off < records[i].size) )
+            {
+              sent = send (c->fd,
+                           &records[i].data[off],
+                           records[i].size - off,
+                           MSG_NOSIGNAL);
+              if (0 < sent)
+                {
+                  off += sent;
+                  bytes_sent += sent;
+                  continue;
+                }
+              if ( (EAGAIN != errno) && (EWOULDBLOCK != errno) )
+                break;
+              /* the daemon is busy sending us responses */
+              (void) run_until (d, start, 0);
+            }
+          break;
+        case MHD_TRACE_EOF:
+          c->eof = 1;
+          if (-1 != c->fd)
+            shutdown (c->fd, SHUT_WR);
+          break;
+        case MHD_TRACE_CLOSE:
+          /* Without an EOF before, either the daemon closed the
+             connection, which it does again when replaying, or the
+             client reset it, which we do here. */
+          if ( (-1 == c->fd) ||
+               (c->eof) ||
+               (c->closed) )
+            break;
+          (void) run_until (d, start, 0);
+          close (c->fd);
+          c->fd = -1;
+          break;
+        }
+    }
+  /* collect the remaining responses */
+  idle_since = now_usec ();
+  while ( (0 != (open_left = count_open ())) &&
+          (now_usec () - idle_since < DRAIN_USEC) )
+    {
+      if (MHD_YES == run_until (d, start, 0))
+        idle_since = now_usec ();
+      else
+        usleep (1000);
+    }
+  now = now_usec () - start;
+  printf ("{\"mode\": \"%s\", \"speed\": %.2f, "
+          "\"records\": %llu, \"connections\": %u, "
+          "\"trace_usec\": %llu, \"wall_usec\": %llu, "
+          "\"daemon_usec\": %llu, "
+          "\"lag_mean_usec\": %.1f, \"lag_max_usec\": %llu, "
+          "\"bytes_sent\": %llu, \"bytes_received\": %llu, "
+          "\"open_at_end\": %u}\n",
+          mode,
+          speed,
+          (unsigned long long) num_records,
+          connections,
+          (unsigned long long) ((0 != num_records)
+                                ? records[num_records - 1].usec
+                                : 0),
+          (unsigned long long) now,
+          (unsigned long long) daemon_usec,
+          (0 != num_records) ? (double) lag_sum / num_records : 0.0,
+          (unsigned long long) lag_max,
+          (unsigned long long) bytes_sent,
+          (unsigned long long) bytes_received,
+          open_left);
+  for (i = 0; i < num_clients; i++)
+    if (-1 != clients[i].fd)
+      close (clients[i].fd);
+  MHD_stop_daemon (d);
+  MHD_destroy_response (response);
+  free (body);
+  free (clients);
+  free (records);
+  free (trace);
+  return 0;
+}
@@ -0,0 +1,490 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file benchmark/bench_scale.c
+ * @brief  Cost of the event loop with many connections
+ * @author libmicrohttpd contributors
+ *
+ * Connections are socketpairs whose server end is given to the daemon
+ * with #MHD_add_connection(), so neither ports nor the network limit
+ * their number (only RLIMIT_NOFILE, which is raised as far as
+ * allowed).  The daemon runs without a listen socket and is driven
+ * with #MHD_run() in the select, poll and epoll modes.
+ *
+ * Of the connections, a percentage is active (a request is sent
+ * whenever the previous response arrived), a percentage is suspended
+ * by the handler and resumed by each iteration, and the rest is idle.
+ * For each mode, the program reports as a JSON object:
+ *  - the resident memory per connection,
+ *  - the duration of #MHD_run() (mean, p50, p99) and of
+ *    #MHD_get_timeout() per iteration,
+ *  - the duration of the two iterations that close and clean up the
+ *    idle connections once their timeout expired ("sweep").
+ *
+ * Usage: bench_scale [-n CONNECTIONS] [-a ACTIVE%] [-s SUSPENDED%]
+ *                    [-i ITERATIONS] [-T TIMEOUT] [-m MODE]
+ */
+#include "MHD_config.h"
+#include "platform.h"
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+
+/**
+ * A mode of the event loop.
+ */
+struct Mode
+{
+  /**
+   * Name in the output.
+   */
+  const char *name;
+
+  /**
+   * Flags for #MHD_start_daemon().
+   */
+  unsigned int flags;
+
+  /**
+   * Feature the mode needs, or #MHD_FEATURE_MESSGES (always there).
+   */
+  enum MHD_FEATURE feature;
+};
+
+
+static const struct Mode modes[] = {
+  { "select", 0, MHD_FEATURE_MESSGES },
+  { "poll", MHD_USE_POLL, MHD_FEATURE_POLL },
+  { "epoll", MHD_USE_EPOLL, MHD_FEATURE_EPOLL },
+  { NULL, 0, MHD_FEATURE_MESSGES }
+};
+
+
+/**
+ * Response of all requests.
+ */
+static struct MHD_Response *response;
+
+/**
+ * Connections suspended by the handler, to be resumed.
+ */
+static struct MHD_Connection **suspended;
+
+/**
+ * Number of entries in @e suspended.
+ */
+static unsigned int num_suspended;
+
+/**
+ * Set once the handler should no longer suspend connections.
+ */
+static int draining;
+
+
+/**
+ * Get the time from a monotonic clock.
+ *
+ * @return time in microseconds
+ */
+static uint64_t
+now_usec (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/**
+ * Get the resident memory of the process.
+ *
+ * @return resident memory in bytes, 0 if unknown
+ */
+static uint64_t
+rss_bytes (void)
+{
+  unsigned long size;
+  unsigned long resident;
+  FILE *f;
+
+  f = fopen ("/proc/self/statm", "r");
+  if (NULL == f)
+    return 0;
+  if (2 != fscanf (f, "%lu %lu", &size, &resident))
+    resident = 0;
+  fclose (f);
+  return (uint64_t) resident * sysconf (_SC_PAGESIZE);
+}
+
+
+static int
+cmp_u64 (const void *a,
+         const void *b)
+{
+  const uint64_t x = *(const uint64_t *) a;
+  const uint64_t y = *(const uint64_t *) b;
+
+  return (x < y) ? -1 : (x > y);
+}
+
+
+static int
+ahc_scale (void *cls,
+           struct MHD_Connection *connection,
+           const char *url,
+           const char *method,
+           const char *version,
+           const char *upload_data,
+           size_t *upload_data_size,
+           void **con_cls)
+{
+  (void) cls; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size; (void) con_cls;
+  if ( (! draining) &&
+       (0 == strcmp (url, "/suspend")) )
+    {
+      /* only called from MHD_run(), no locking needed */
+      suspended[num_suspended++] = connection;
+      MHD_suspend_connection (connection);
+      return MHD_YES;
+    }
+  return MHD_queue_response (connection, MHD_HTTP_OK, response);
+}
+
+
+/**
+ * Send a request on the client end of a connection.
+ *
+ * @param fd client end
+ * @param url URL to request
+ * @return 0 on success
+ */
+static int
+send_request (int fd,
+              const char *url)
+{
+  char req[128];
+  int len;
+
+  len = snprintf (req,
+                  sizeof (req),
+                  "GET %s HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n",
+                  url);
+  return (len == send (fd, req, len, MSG_NOSIGNAL)) ? 0 : -1;
+}
+
+
+/**
+ * Run the benchmark for one mode and print the result.
+ *
+ * @param mode the mode of the event loop
+ * @param connections number of connections to open
+ * @param active_pct percentage of active connections
+ * @param suspended_pct percentage of suspended connections
+ * @param iterations number of iterations to measure
+ * @param timeout connection timeout in seconds
+ * @param first non-zero if this is the first result printed
+ * @return 0 on success
+ */
+static int
+run_mode (const struct Mode *mode,
+          unsigned int connections,
+          unsigned int active_pct,
+          unsigned int suspended_pct,
+          unsigned int iterations,
+          unsigned int timeout,
+          int first)
+{
+  struct MHD_Daemon *d;
+  const union MHD_DaemonInfo *info;
+  struct sockaddr_in sa;
+  MHD_UNSIGNED_LONG_LONG to;
+  uint64_t *loop;
+  uint64_t rss_before;
+  uint64_t rss_after;
+  uint64_t get_timeout_sum;
+  uint64_t loop_sum;
+  uint64_t responses;
+  uint64_t sweep;
+  uint64_t start;
+  unsigned int num_active;
+  unsigned int num_susp;
+  unsigned int added;
+  unsigned int open_before;
+  unsigned int open_after;
+  unsigned int i;
+  unsigned int j;
+  int *fds;
+  char *busy;
+  char buf[1024];
+  int sv[2];
+  int ret;
+
+  fds = malloc (connections * sizeof (int));
+  busy = calloc (connections, 1);
+  loop = malloc ((0 == iterations ? 1 : iterations) * sizeof (uint64_t));
+  suspended = malloc ((connections + 1) * sizeof (struct MHD_Connection *));
+  num_suspended = 0;
+  draining = 0;
+  if ( (NULL == fds) ||
+       (NULL == busy) ||
+       (NULL == loop) ||
+       (NULL == suspended) )
+    {
+      free (fds);
+      free (busy);
+      free (loop);
+      free (suspended);
+      return -1;
+    }
+  d = MHD_start_daemon (mode->flags | MHD_USE_NO_LISTEN_SOCKET
+                        | MHD_USE_SUSPEND_RESUME,
+                        0, NULL, NULL, &ahc_scale, NULL,
+                        MHD_OPTION_CONNECTION_LIMIT, connections + 16,
+                        MHD_OPTION_CONNECTION_TIMEOUT, timeout,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    {
+      free (fds);
+      free (busy);
+      free (loop);
+      free (suspended);
+      return -1;
+    }
+  memset (&sa, 0, sizeof (sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  rss_before = rss_bytes ();
+
+  /* select is limited by FD_SETSIZE; stop at the first failure */
+  for (added = 0; added < connections; added++)
+    {
+      if (0 != socketpair (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv))
+        break;
+      sa.sin_port = htons ((uint16_t) (1024 + added % 60000));
+      if (MHD_YES != MHD_add_connection (d,
+                                         sv[1],
+                                         (const struct sockaddr *) &sa,
+                                         sizeof (sa)))
+        {
+          close (sv[0]);
+          break;
+        }
+      fds[added] = sv[0];
+    }
+  num_active = (unsigned int) ((uint64_t) added * active_pct / 100);
+  num_susp = (unsigned int) ((uint64_t) added * suspended_pct / 100);
+  if (num_active + num_susp > added)
+    num_susp = added - num_active;
+  for (i = num_active; i < num_active + num_susp; i++)
+    (void) send_request (fds[i], "/suspend");
+  /* let the daemon see all connections (and suspend some) once */
+  MHD_run (d);
+  MHD_run (d);
+  rss_after = rss_bytes ();
+
+  loop_sum = 0;
+  get_timeout_sum = 0;
+  responses = 0;
+  for (i = 0; i < iterations; i++)
+    {
+      for (j = 0; j < num_active; j++)
+        if ( (! busy[j]) &&
+             (0 == send_request (fds[j], "/")) )
+          busy[j] = 1;
+      for (j = 0; j < num_suspended; j++)
+        MHD_resume_connection (suspended[j]);
+      num_suspended = 0;
+      start = now_usec ();
+      MHD_run (d);
+      loop[i] = now_usec () - start;
+      loop_sum += loop[i];
+      start = now_usec ();
+      (void) MHD_get_timeout (d, &to);
+      get_timeout_sum += now_usec () - start;
+      for (j = 0; j < num_active; j++)
+        if (recv (fds[j], buf, sizeof (buf), 0) > 0)
+          {
+            busy[j] = 0;
+            responses++;
+          }
+    }
+
+  /* suspended connections would not time out (and must not remain
+     at MHD_stop_daemon()); let them finish their request */
+  draining = 1;
+  for (j = 0; j < num_suspended; j++)
+    MHD_resume_connection (suspended[j]);
+  num_suspended = 0;
+  MHD_run (d);
+  info = MHD_get_daemon_info (d, MHD_DAEMON_INFO_CURRENT_CONNECTIONS);
+  open_before = (NULL == info) ? 0 : info->num_connections;
+  if (0 != timeout)
+    sleep (timeout + 1);
+  /* the first pass closes the expired connections, the second one
+     cleans them up */
+  start = now_usec ();
+  MHD_run (d);
+  MHD_run (d);
+  sweep = now_usec () - start;
+  info = MHD_get_daemon_info (d, MHD_DAEMON_INFO_CURRENT_CONNECTIONS);
+  open_after = (NULL == info) ? 0 : info->num_connections;
+
+  if (0 != iterations)
+    qsort (loop, iterations, sizeof (uint64_t), &cmp_u64);
+  printf ("%s  {\"mode\": \"%s\", \"connections\": %u, \"active\": %u, "
+          "\"suspended\": %u, \"iterations\": %u, "
+          "\"rss_per_connection\": %llu, \"loop_usec_mean\": %.1f, "
+          "\"loop_usec_p50\": %llu, \"loop_usec_p99\": %llu, "
+          "\"get_timeout_usec_mean\": %.2f, \"responses\": %llu, "
+          "\"sweep_usec\": %llu, \"swept\": %u}",
+          first ? "" : ",\n",
+          mode->name,
+          added,
+          num_active,
+          num_susp,
+          iterations,
+          (unsigned long long) ( (0 == added) || (rss_after < rss_before)
+                                 ? 0
+                                 : (rss_after - rss_before) / added),
+          (0 == iterations) ? 0.0 : (double) loop_sum / iterations,
+          (unsigned long long) ((0 == iterations) ? 0 : loop[iterations / 2]),
+          (unsigned long long) ((0 == iterations) ? 0 : loop[(uint64_t) iterations * 99 / 100]),
+          (0 == iterations) ? 0.0 : (double) get_timeout_sum / iterations,
+          (unsigned long long) responses,
+          (unsigned long long) sweep,
+          (open_before > open_after) ? open_before - open_after : 0);
+  fflush (stdout);
+  ret = (added == connections) ? 0 : 1;
+  MHD_stop_daemon (d);
+  for (i = 0; i < added; i++)
+    close (fds[i]);
+  free (fds);
+  free (busy);
+  free (loop);
+  free (suspended);
+  suspended = NULL;
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  static const char *page = "ok";
+  const char *mode_filter = NULL;
+  unsigned int connections = 10000;
+  unsigned int active_pct = 1;
+  unsigned int suspended_pct = 1;
+  unsigned int iterations = 100;
+  unsigned int timeout = 2;
+  struct rlimit rl;
+  unsigned int i;
+  int first;
+  int opt;
+
+  while (-1 != (opt = getopt (argc, argv, "n:a:s:i:T:m:")))
+    {
+      switch (opt)
+        {
+        case 'n':
+          connections = (unsigned int) atoi (optarg);
+          break;
+        case 'a':
+          active_pct = (unsigned int) atoi (optarg);
+          break;
+        case 's':
+          suspended_pct = (unsigned int) atoi (optarg);
+          break;
+        case 'i':
+          iterations = (unsigned int) atoi (optarg);
+          break;
+        case 'T':
+          timeout = (unsigned int) atoi (optarg);
+          break;
+        case 'm':
+          mode_filter = optarg;
+          break;
+        default:
+          fprintf (stderr,
+                   "Usage: %s [-n CONNECTIONS] [-a ACTIVE%%] [-s SUSPENDED%%] "
+                   "[-i ITERATIONS] [-T TIMEOUT] [-m MODE]\n",
+                   argv[0]);
+          return 2;
+        }
+    }
+  if ( (0 == connections) ||
+       (active_pct > 100) ||
+       (suspended_pct > 100) )
+    return 2;
+  /* two descriptors per connection */
+  if (0 == getrlimit (RLIMIT_NOFILE, &rl))
+    {
+      rl.rlim_cur = rl.rlim_max;
+      (void) setrlimit (RLIMIT_NOFILE, &rl);
+      if ( (RLIM_INFINITY != rl.rlim_cur) &&
+           ((uint64_t) connections * 2 + 64 > rl.rlim_cur) )
+        {
+          connections = (unsigned int) ((rl.rlim_cur - 64) / 2);
+          fprintf (stderr,
+                   "RLIMIT_NOFILE allows only %u connections\n",
+                   connections);
+        }
+    }
+  response = MHD_create_response_from_buffer (strlen (page),
+                                              (void *) page,
+                                              MHD_RESPMEM_PERSISTENT);
+  if (NULL == response)
+    return 2;
+  first = 1;
+  printf ("[\n");
+  for (i = 0; NULL != modes[i].name; i++)
+    {
+      if ( (NULL != mode_filter) &&
+           (0 != strcmp (mode_filter, modes[i].name)) )
+        continue;
+      if (MHD_YES != MHD_is_feature_supported (modes[i].feature))
+        continue;
+      if (-1 == run_mode (&modes[i],
+                          connections,
+                          active_pct,
+                          suspended_pct,
+                          iterations,
+                          timeout,
+                          first))
+        {
+          fprintf (stderr, "Failed to run mode %s\n", modes[i].name);
+          continue;
+        }
+      first = 0;
+    }
+  printf ("\n]\n");
+  MHD_destroy_response (response);
+  return 0;
+}
@@ -0,0 +1,1116 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file benchmark/loadgen.c
+ * @brief  epoll-based HTTP load generator for the benchmarks
+ * @author libmicrohttpd contributors
+ *
+ * Each client thread drives its share of the connections with one
+ * edge-triggered epoll set.  A connection is a small state machine
+ * that sends a batch of (pipelined) requests and parses the
+ * responses just enough to find their end: the status line,
+ * "Content-Length" or chunked encoding.  Every operation is retried
+ * until it would block, as required with edge-triggered events.
+ */
+#include "loadgen.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#ifdef HTTPS_SUPPORT
+#include <gnutls/gnutls.h>
+#endif
+
+/**
+ * Size of the receive buffer of a connection; response headers must
+ * fit.
+ */
+#define IN_BUFFER_SIZE 16384
+
+/**
+ * Maximum number of events handled per epoll_wait().
+ */
+#define MAX_EVENTS 128
+
+
+/**
+ * What a connection is doing.
+ */
+enum ConnState
+{
+  /**
+   * Waiting for connect() to finish.
+   */
+  CS_CONNECTING,
+
+  /**
+   * Running the TLS handshake.
+   */
+  CS_HANDSHAKE,
+
+  /**
+   * Sending the request(s).
+   */
+  CS_SEND,
+
+  /**
+   * Sending the body after "100 Continue".
+   */
+  CS_SEND_BODY,
+
+  /**
+   * Receiving the response(s).
+   */
+  CS_READ,
+
+  /**
+   * Sending an echo message on an upgraded connection.
+   */
+  CS_ECHO_SEND,
+
+  /**
+   * Waiting for the echo of the message.
+   */
+  CS_ECHO_READ,
+
+  /**
+   * Closed at the end of the run.
+   */
+  CS_DONE
+};
+
+
+/**
+ * Where the response parser is.
+ */
+enum ParseState
+{
+  /**
+   * Waiting for the complete header.
+   */
+  PS_HEADER,
+
+  /**
+   * In a body with "Content-Length".
+   */
+  PS_BODY,
+
+  /**
+   * Waiting for the size line of a chunk.
+   */
+  PS_CHUNK_SIZE,
+
+  /**
+   * In the data of a chunk.
+   */
+  PS_CHUNK_DATA,
+
+  /**
+   * Waiting for the CRLF after the data of a chunk.
+   */
+  PS_CHUNK_END,
+
+  /**
+   * In the footer after the last chunk.
+   */
+  PS_TRAILER
+};
+
+
+struct LoadThread;
+
+
+/**
+ * State of one client connection.
+ */
+struct LoadConn
+{
+  /**
+   * Thread driving this connection.
+   */
+  struct LoadThread *t;
+
+  /**
+   * Socket, -1 if closed.
+   */
+  int fd;
+
+#ifdef HTTPS_SUPPORT
+  /**
+   * TLS session, NULL without TLS.
+   */
+  gnutls_session_t tls;
+#endif
+
+  /**
+   * What the connection is doing.
+   */
+  enum ConnState state;
+
+  /**
+   * Data being sent.
+   */
+  const char *out;
+
+  /**
+   * Number of bytes in @e out.
+   */
+  size_t out_size;
+
+  /**
+   * Number of bytes of @e out already sent.
+   */
+  size_t out_off;
+
+  /**
+   * Where the response parser is.
+   */
+  enum ParseState ps;
+
+  /**
+   * Bytes left in the current body or chunk.
+   */
+  uint64_t left;
+
+  /**
+   * Number of responses still expected for the current batch.
+   */
+  unsigned int pending;
+
+  /**
+   * When the current batch (or connection) was started, in
+   * microseconds.
+   */
+  uint64_t start;
+
+  /**
+   * Number of bytes in @e in.
+   */
+  size_t in_off;
+
+  /**
+   * Received bytes not yet parsed.
+   */
+  char in[IN_BUFFER_SIZE];
+};
+
+
+/**
+ * State of one client thread.
+ */
+struct LoadThread
+{
+  /**
+   * What to send.
+   */
+  const struct LoadConfig *cfg;
+
+  /**
+   * The pipelined requests of one batch.
+   */
+  const char *batch;
+
+  /**
+   * Number of bytes in @e batch.
+   */
+  size_t batch_size;
+
+  /**
+   * Message for echo round trips.
+   */
+  const char *echo;
+
+  /**
+   * The thread.
+   */
+  pthread_t pt;
+
+  /**
+   * epoll set of the thread.
+   */
+  int epfd;
+
+  /**
+   * Connections of this thread.
+   */
+  struct LoadConn *conns;
+
+  /**
+   * Number of entries in @e conns.
+   */
+  unsigned int num_conns;
+
+  /**
+   * When to stop, in microseconds.
+   */
+  uint64_t deadline;
+
+  /**
+   * Set once @e deadline passed.
+   */
+  int stopping;
+
+  /**
+   * Completed requests.
+   */
+  uint64_t requests;
+
+  /**
+   * Failed connections.
+   */
+  uint64_t errors;
+
+  /**
+   * Received bytes.
+   */
+  uint64_t bytes;
+
+  /**
+   * Latencies of the completed requests.
+   */
+  uint64_t *latency;
+
+  /**
+   * Number of entries allocated at @e latency.
+   */
+  size_t latency_alloc;
+
+#ifdef HTTPS_SUPPORT
+  /**
+   * Credentials of the TLS sessions (none, we do not verify the
+   * server).
+   */
+  gnutls_certificate_credentials_t cred;
+#endif
+};
+
+
+/**
+ * Get the time from a monotonic clock.
+ *
+ * @return time in microseconds
+ */
+static uint64_t
+now_usec (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/**
+ * Remember the latency of a completed request.
+ *
+ * @param t thread of the request
+ * @param usec the latency
+ */
+static void
+record (struct LoadThread *t,
+        uint64_t usec)
+{
+  if (t->requests == t->latency_alloc)
+    {
+      size_t n = (0 == t->latency_alloc) ? 4096 : 2 * t->latency_alloc;
+      uint64_t *l = realloc (t->latency, n * sizeof (uint64_t));
+
+      if (NULL == l)
+        {
+          t->errors++;
+          return;
+        }
+      t->latency = l;
+      t->latency_alloc = n;
+    }
+  t->latency[t->requests++] = usec;
+}
+
+
+static void
+conn_open (struct LoadConn *c);
+
+
+/**
+ * Close a connection.
+ *
+ * @param c the connection
+ */
+static void
+conn_close (struct LoadConn *c)
+{
+#ifdef HTTPS_SUPPORT
+  if (NULL != c->tls)
+    {
+      gnutls_deinit (c->tls);
+      c->tls = NULL;
+    }
+#endif
+  if (-1 != c->fd)
+    close (c->fd);
+  c->fd = -1;
+  c->state = CS_DONE;
+}
+
+
+/**
+ * A connection failed; count it and start a new one.
+ *
+ * @param c the connection
+ */
+static void
+conn_fail (struct LoadConn *c)
+{
+  c->t->errors++;
+  conn_close (c);
+  if (! c->t->stopping)
+    conn_open (c);
+}
+
+
+/**
+ * Start sending the next batch of requests.
+ *
+ * @param c the connection
+ * @param start when the batch started
+ */
+static void
+start_batch (struct LoadConn *c,
+             uint64_t start)
+{
+  const struct LoadConfig *cfg = c->t->cfg;
+
+  c->out = c->t->batch;
+  c->out_size = c->t->batch_size;
+  c->out_off = 0;
+  c->pending = cfg->pipeline;
+  c->ps = PS_HEADER;
+  c->start = start;
+  c->state = CS_SEND;
+}
+
+
+/**
+ * Open a new connection.
+ *
+ * @param c the connection to (re)initialize
+ */
+static void
+conn_open (struct LoadConn *c)
+{
+  struct LoadThread *t = c->t;
+  struct sockaddr_in sa;
+  struct epoll_event ev;
+  int one = 1;
+
+  c->in_off = 0;
+  c->ps = PS_HEADER;
+  c->start = now_usec ();
+  c->state = CS_CONNECTING;
+  c->fd = socket (AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  if (-1 == c->fd)
+    {
+      t->errors++;
+      c->state = CS_DONE;
+      return;
+    }
+  (void) setsockopt (c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+  memset (&sa, 0, sizeof (sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons (t->cfg->port);
+  sa.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  if ( (0 != connect (c->fd, (struct sockaddr *) &sa, sizeof (sa))) &&
+       (EINPROGRESS != errno) )
+    {
+      t->errors++;
+      conn_close (c);
+      return;
+    }
+#ifdef HTTPS_SUPPORT
+  if (t->cfg->tls)
+    {
+      if (GNUTLS_E_SUCCESS != gnutls_init (&c->tls,
+                                           GNUTLS_CLIENT | GNUTLS_NONBLOCK))
+        {
+          c->tls = NULL;
+          t->errors++;
+          conn_close (c);
+          return;
+        }
+      gnutls_set_default_priority (c->tls);
+      gnutls_credentials_set (c->tls, GNUTLS_CRD_CERTIFICATE, t->cred);
+      gnutls_transport_set_int (c->tls, c->fd);
+    }
+#endif
+  ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+  ev.data.ptr = c;
+  if (0 != epoll_ctl (t->epfd, EPOLL_CTL_ADD, c->fd, &ev))
+    {
+      t->errors++;
+      conn_close (c);
+    }
+}
+
+
+/**
+ * Receive data on a connection.
+ *
+ * @return number of bytes received, 0 on close, -1 on error (with
+ *         @e errno EAGAIN if no data is available)
+ */
+static ssize_t
+conn_recv (struct LoadConn *c,
+           void *buf,
+           size_t size)
+{
+#ifdef HTTPS_SUPPORT
+  if (NULL != c->tls)
+    {
+      ssize_t ret = gnutls_record_recv (c->tls, buf, size);
+
+      if ( (GNUTLS_E_AGAIN == ret) ||
+           (GNUTLS_E_INTERRUPTED == ret) )
+        {
+          errno = EAGAIN;
+          return -1;
+        }
+      if (ret < 0)
+        {
+          errno = EIO;
+          return -1;
+        }
+      return ret;
+    }
+#endif
+  return recv (c->fd, buf, size, 0);
+}
+
+
+/**
+ * Send data on a connection.
+ *
+ * @return number of bytes sent, -1 on error (with @e errno EAGAIN if
+ *         the socket is not writable)
+ */
+static ssize_t
+conn_send (struct LoadConn *c,
+           const void *buf,
+           size_t size)
+{
+#ifdef HTTPS_SUPPORT
+  if (NULL != c->tls)
+    {
+      ssize_t ret = gnutls_record_send (c->tls, buf, size);
+
+      if ( (GNUTLS_E_AGAIN == ret) ||
+           (GNUTLS_E_INTERRUPTED == ret) )
+        {
+          errno = EAGAIN;
+          return -1;
+        }
+      if (ret < 0)
+        {
+          errno = EIO;
+          return -1;
+        }
+      return ret;
+    }
+#endif
+  return send (c->fd, buf, size, MSG_NOSIGNAL);
+}
+
+
+/**
+ * Drop parsed bytes from the receive buffer.
+ *
+ * @param c the connection
+ * @param n number of bytes to drop
+ */
+static void
+consume (struct LoadConn *c,
+         size_t n)
+{
+  memmove (c->in, &c->in[n], c->in_off - n);
+  c->in_off -= n;
+}
+
+
+/**
+ * Find the end of a line in the receive buffer.
+ *
+ * @param c the connection
+ * @return offset of the CRLF, -1 if there is none yet
+ */
+static ssize_t
+find_crlf (const struct LoadConn *c)
+{
+  size_t i;
+
+  for (i = 0; i + 1 < c->in_off; i++)
+    if ( ('\r' == c->in[i]) &&
+         ('\n' == c->in[i + 1]) )
+      return (ssize_t) i;
+  return -1;
+}
+
+
+/**
+ * Find a header in a response header.
+ *
+ * @param hdr the response header, 0-terminated
+ * @param name name of the header with the colon
+ * @return the value of the header, NULL if it is missing
+ */
+static const char *
+find_header (const char *hdr,
+             const char *name)
+{
+  size_t len = strlen (name);
+  const char *pos;
+
+  for (pos = strstr (hdr, "\r\n"); NULL != pos; pos = strstr (pos, "\r\n"))
+    {
+      pos += 2;
+      if (0 == strncasecmp (pos, name, len))
+        {
+          pos += len;
+          while (' ' == *pos)
+            pos++;
+          return pos;
+        }
+    }
+  return NULL;
+}
+
+
+/**
+ * A response (or echo) was completed; start the next one.
+ *
+ * @param c the connection
+ * @return 1 if @a c may be processed further, 0 if it was closed
+ */
+static int
+complete (struct LoadConn *c)
+{
+  struct LoadThread *t = c->t;
+  uint64_t now;
+
+  now = now_usec ();
+  if (now <= t->deadline)
+    record (t, now - c->start);
+  if (now >= t->deadline)
+    t->stopping = 1;
+  if (CS_ECHO_READ == c->state)
+    {
+      c->out_off = 0;
+      c->start = now;
+      c->state = CS_ECHO_SEND;
+      return 1;
+    }
+  c->ps = PS_HEADER;
+  if (0 != --c->pending)
+    return 1;
+  if (t->stopping)
+    {
+      conn_close (c);
+      return 0;
+    }
+  if (t->cfg->close_after_response)
+    {
+      conn_close (c);
+      conn_open (c);
+      return 0;
+    }
+  start_batch (c, now);
+  return 1;
+}
+
+
+/**
+ * Parse the received data.
+ *
+ * @param c the connection
+ * @return 1 if the state of the connection changed, 0 if more data
+ *         is needed, -1 on errors
+ */
+static int
+parse (struct LoadConn *c)
+{
+  const struct LoadConfig *cfg = c->t->cfg;
+  char hdr[IN_BUFFER_SIZE + 1];
+  const char *val;
+  ssize_t pos;
+  size_t n;
+  unsigned int status;
+
+  if (CS_ECHO_READ == c->state)
+    {
+      if (c->in_off < cfg->echo_size)
+        return 0;
+      consume (c, cfg->echo_size);
+      (void) complete (c);
+      return 1;
+    }
+  while (1)
+    {
+      switch (c->ps)
+        {
+        case PS_HEADER:
+          for (pos = 0; pos + 3 < (ssize_t) c->in_off; pos++)
+            if (0 == memcmp (&c->in[pos], "\r\n\r\n", 4))
+              break;
+          if (pos + 3 >= (ssize_t) c->in_off)
+            return (IN_BUFFER_SIZE == c->in_off) ? -1 : 0;
+          n = (size_t) pos + 4;
+          memcpy (hdr, c->in, n);
+          hdr[n] = '\0';
+          if ( (0 != strncmp (hdr, "HTTP/1.", 7)) ||
+               (n < 12) )
+            return -1;
+          status = (unsigned int) strtoul (&hdr[9], NULL, 10);
+          consume (c, n);
+          if (100 == status)
+            {
+              if ( (! cfg->expect_continue) ||
+                   (CS_READ != c->state) ||
+                   (c->out != c->t->batch) )
+                return -1;
+              c->out = cfg->body;
+              c->out_size = cfg->body_size;
+              c->out_off = 0;
+              c->state = CS_SEND_BODY;
+              return 1;
+            }
+          if ( (101 == status) &&
+               (0 != cfg->echo_size) )
+            {
+              c->out = c->t->echo;
+              c->out_size = cfg->echo_size;
+              c->out_off = 0;
+              c->start = now_usec ();
+              c->state = CS_ECHO_SEND;
+              return 1;
+            }
+          if (200 != status)
+            return -1;
+          if (NULL != (val = find_header (hdr, "Content-Length:")))
+            {
+              c->left = strtoull (val, NULL, 10);
+              c->ps = PS_BODY;
+            }
+          else if ( (NULL != (val = find_header (hdr, "Transfer-Encoding:"))) &&
+                    (0 == strncasecmp (val, "chunked", 7)) )
+            c->ps = PS_CHUNK_SIZE;
+          else
+            return -1;
+          break;
+        case PS_BODY:
+          n = (size_t) ((c->left < c->in_off) ? c->left : c->in_off);
+          consume (c, n);
+          c->left -= n;
+          if (0 != c->left)
+            return 0;
+          if (! complete (c))
+            return 1;
+          if (CS_READ != c->state)
+            return 1;
+          break;
+        case PS_CHUNK_SIZE:
+          if (-1 == (pos = find_crlf (c)))
+            return (IN_BUFFER_SIZE == c->in_off) ? -1 : 0;
+          c->left = strtoull (c->in, NULL, 16);
+          consume (c, (size_t) pos + 2);
+          c->ps = (0 == c->left) ? PS_TRAILER : PS_CHUNK_DATA;
+          break;
+        case PS_CHUNK_DATA:
+          n = (size_t) ((c->left < c->in_off) ? c->left : c->in_off);
+          consume (c, n);
+          c->left -= n;
+          if (0 != c->left)
+            return 0;
+          c->ps = PS_CHUNK_END;
+          break;
+        case PS_CHUNK_END:
+          if (c->in_off < 2)
+            return 0;
+          if (0 != memcmp (c->in, "\r\n", 2))
+            return -1;
+          consume (c, 2);
+          c->ps = PS_CHUNK_SIZE;
+          break;
+        case PS_TRAILER:
+          if (-1 == (pos = find_crlf (c)))
+            return (IN_BUFFER_SIZE == c->in_off) ? -1 : 0;
+          consume (c, (size_t) pos + 2);
+          if (0 != pos)
+            break;
+          if (! complete (c))
+            return 1;
+          if (CS_READ != c->state)
+            return 1;
+          break;
+        }
+    }
+}
+
+
+/**
+ * Make as much progress on a connection as possible without
+ * blocking.
+ *
+ * @param c the connection
+ */
+static void
+drive (struct LoadConn *c)
+{
+  struct LoadThread *t = c->t;
+  struct sockaddr_in sa;
+  ssize_t ret;
+  int err;
+  socklen_t len;
+
+  while (1)
+    {
+      switch (c->state)
+        {
+        case CS_CONNECTING:
+          /* events may still be pending for a previous socket */
+          len = sizeof (sa);
+          if ( (0 != getpeername (c->fd, (struct sockaddr *) &sa, &len)) &&
+               (ENOTCONN == errno) )
+            {
+              err = 0;
+              len = sizeof (err);
+              if ( (0 == getsockopt (c->fd, SOL_SOCKET, SO_ERROR, &err, &len)) &&
+                   (0 == err) )
+                return;
+              conn_fail (c);
+              return;
+            }
+          err = 0;
+          len = sizeof (err);
+          if ( (0 != getsockopt (c->fd, SOL_SOCKET, SO_ERROR, &err, &len)) ||
+               (0 != err) )
+            {
+              conn_fail (c);
+              return;
+            }
+#ifdef HTTPS_SUPPORT
+          if (NULL != c->tls)
+            {
+              c->state = CS_HANDSHAKE;
+              break;
+            }
+#endif
+          start_batch (c, c->start);
+          break;
+        case CS_HANDSHAKE:
+#ifdef HTTPS_SUPPORT
+          ret = gnutls_handshake (c->tls);
+          if ( (GNUTLS_E_AGAIN == ret) ||
+               (GNUTLS_E_INTERRUPTED == ret) )
+            return;
+          if (GNUTLS_E_SUCCESS != ret)
+            {
+              conn_fail (c);
+              return;
+            }
+#endif
+          start_batch (c, c->start);
+          break;
+        case CS_SEND:
+        case CS_SEND_BODY:
+        case CS_ECHO_SEND:
+          ret = conn_send (c,
+                           &c->out[c->out_off],
+                           c->out_size - c->out_off);
+          if (ret < 0)
+            {
+              if (EAGAIN == errno)
+                return;
+              conn_fail (c);
+              return;
+            }
+          c->out_off += ret;
+          if (c->out_off < c->out_size)
+            break;
+          c->state = (CS_ECHO_SEND == c->state) ? CS_ECHO_READ : CS_READ;
+          break;
+        case CS_READ:
+        case CS_ECHO_READ:
+          switch (parse (c))
+            {
+            case 1:
+              if ( (CS_DONE == c->state) ||
+                   (CS_CONNECTING == c->state) )
+                return;
+              continue;
+            case -1:
+              conn_fail (c);
+              return;
+            default:
+              break;
+            }
+          ret = conn_recv (c,
+                           &c->in[c->in_off],
+                           IN_BUFFER_SIZE - c->in_off);
+          if (ret <= 0)
+            {
+              if ( (ret < 0) &&
+                   (EAGAIN == errno) )
+                return;
+              conn_fail (c);
+              return;
+            }
+          c->in_off += ret;
+          t->bytes += ret;
+          break;
+        case CS_DONE:
+          return;
+        }
+    }
+}
+
+
+/**
+ * Main function of a client thread.
+ *
+ * @param cls the `struct LoadThread`
+ * @return NULL
+ */
+static void *
+run_thread (void *cls)
+{
+  struct LoadThread *t = cls;
+  struct epoll_event events[MAX_EVENTS];
+  unsigned int i;
+  uint64_t now;
+  int num;
+
+  for (i = 0; i < t->num_conns; i++)
+    conn_open (&t->conns[i]);
+  while (! t->stopping)
+    {
+      now = now_usec ();
+      if (now >= t->deadline)
+        break;
+      num = epoll_wait (t->epfd,
+                        events,
+                        MAX_EVENTS,
+                        (int) ((t->deadline - now) / 1000) + 1);
+      for (i = 0; i < (unsigned int) num; i++)
+        drive (events[i].data.ptr);
+    }
+  for (i = 0; i < t->num_conns; i++)
+    conn_close (&t->conns[i]);
+  return NULL;
+}
+
+
+static int
+cmp_u64 (const void *a,
+         const void *b)
+{
+  const uint64_t x = *(const uint64_t *) a;
+  const uint64_t y = *(const uint64_t *) b;
+
+  return (x < y) ? -1 : (x > y);
+}
+
+
+/**
+ * Run the clients described by @a cfg until @a cfg->seconds passed.
+ *
+ * @param cfg what to send
+ * @param[out] res set to what was measured; free with #load_result_free()
+ * @return 0 on success, -1 if the clients could not be set up
+ */
+int
+load_run (const struct LoadConfig *cfg,
+          struct LoadResult *res)
+{
+  struct LoadThread *threads;
+  char *batch;
+  char *echo;
+  unsigned int num_threads;
+  unsigned int started;
+  unsigned int i;
+  unsigned int j;
+  uint64_t start;
+  uint64_t n;
+  int ret;
+
+  memset (res, 0, sizeof (*res));
+  num_threads = (0 == cfg->threads) ? 1 : cfg->threads;
+  if (num_threads > cfg->connections)
+    num_threads = cfg->connections;
+  if ( (0 == num_threads) ||
+       (0 == cfg->pipeline) ||
+       ( (cfg->pipeline > 1) &&
+         (cfg->expect_continue) ) )
+    return -1;
+#ifndef HTTPS_SUPPORT
+  if (cfg->tls)
+    return -1;
+#endif
+  batch = malloc (cfg->request_size * cfg->pipeline);
+  echo = malloc (cfg->echo_size + 1);
+  threads = calloc (num_threads, sizeof (struct LoadThread));
+  if ( (NULL == batch) ||
+       (NULL == echo) ||
+       (NULL == threads) )
+    {
+      free (batch);
+      free (echo);
+      free (threads);
+      return -1;
+    }
+  for (i = 0; i < cfg->pipeline; i++)
+    memcpy (&batch[i * cfg->request_size], cfg->request, cfg->request_size);
+  memset (echo, 'e', cfg->echo_size);
+  ret = 0;
+  start = now_usec ();
+  for (i = 0; i < num_threads; i++)
+    threads[i].epfd = -1;
+  for (started = 0; started < num_threads; started++)
+    {
+      struct LoadThread *t = &threads[started];
+
+      t->cfg = cfg;
+      t->batch = batch;
+      t->batch_size = cfg->expect_continue
+        ? cfg->request_size
+        : cfg->request_size * cfg->pipeline;
+      t->echo = echo;
+      t->deadline = start + (uint64_t) (cfg->seconds * 1000000);
+      t->num_conns = cfg->connections / num_threads
+        + ((started < cfg->connections % num_threads) ? 1 : 0);
+      t->conns = calloc (t->num_conns, sizeof (struct LoadConn));
+      t->epfd = epoll_create1 (EPOLL_CLOEXEC);
+#ifdef HTTPS_SUPPORT
+      if (cfg->tls)
+        gnutls_certificate_allocate_credentials (&t->cred);
+#endif
+      if ( (NULL == t->conns) ||
+           (-1 == t->epfd) )
+        {
+          ret = -1;
+          break;
+        }
+      for (j = 0; j < t->num_conns; j++)
+        {
+          t->conns[j].t = t;
+          t->conns[j].fd = -1;
+          t->conns[j].state = CS_DONE;
+        }
+      if (0 != pthread_create (&t->pt, NULL, &run_thread, t))
+        {
+          ret = -1;
+          break;
+        }
+    }
+  n = 0;
+  for (i = 0; i < started; i++)
+    {
+      pthread_join (threads[i].pt, NULL);
+      n += threads[i].requests;
+    }
+  res->seconds = (now_usec () - start) / 1000000.0;
+  if (res->seconds > cfg->seconds)
+    res->seconds = cfg->seconds;
+  res->latency = malloc ((0 == n ? 1 : n) * sizeof (uint64_t));
+  for (i = 0; i < started; i++)
+    {
+      struct LoadThread *t = &threads[i];
+
+      if (NULL != res->latency)
+        memcpy (&res->latency[res->requests],
+                t->latency,
+                t->requests * sizeof (uint64_t));
+      res->requests += t->requests;
+      res->errors += t->errors;
+      res->bytes += t->bytes;
+    }
+  for (i = 0; i < num_threads; i++)
+    {
+      struct LoadThread *t = &threads[i];
+
+      free (t->latency);
+      free (t->conns);
+      if (-1 != t->epfd)
+        close (t->epfd);
+#ifdef HTTPS_SUPPORT
+      if (NULL != t->cred)
+        gnutls_certificate_free_credentials (t->cred);
+#endif
+    }
+  if (NULL == res->latency)
+    ret = -1;
+  else
+    qsort (res->latency, res->requests, sizeof (uint64_t), &cmp_u64);
+  free (threads);
+  free (batch);
+  free (echo);
+  return ret;
+}
+
+
+/**
+ * Get a percentile of the latencies of a run.
+ *
+ * @param res result of #load_run()
+ * @param percentile the percentile, from 0 to 100
+ * @return latency in microseconds, 0 if no request completed
+ */
+uint64_t
+load_percentile (const struct LoadResult *res,
+                 double percentile)
+{
+  uint64_t idx;
+
+  if (0 == res->requests)
+    return 0;
+  idx = (uint64_t) (percentile / 100 * res->requests);
+  if (idx >= res->requests)
+    idx = res->requests - 1;
+  return res->latency[idx];
+}
+
+
+/**
+ * Release the memory of a result.
+ *
+ * @param res result of #load_run()
+ */
+void
+load_result_free (struct LoadResult *res)
+{
+  free (res->latency);
+  res->latency = NULL;
+}
@@ -0,0 +1,177 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file benchmark/loadgen.h
+ * @brief  epoll-based HTTP load generator for the benchmarks
+ * @author libmicrohttpd contributors
+ */
+#ifndef LOADGEN_H
+#define LOADGEN_H
+
+#include "MHD_config.h"
+#include <stdint.h>
+#include <stddef.h>
+
+
+/**
+ * What the clients of a load run send.
+ */
+struct LoadConfig
+{
+  /**
+   * Port of the server on 127.0.0.1.
+   */
+  uint16_t port;
+
+  /**
+   * Number of client connections kept open at the same time.
+   */
+  unsigned int connections;
+
+  /**
+   * Number of client threads (each with its own epoll set).
+   */
+  unsigned int threads;
+
+  /**
+   * How long to send requests, in seconds.
+   */
+  double seconds;
+
+  /**
+   * The request (header and body) to send, repeated for each request.
+   * With @e expect_continue, only the header.
+   */
+  const char *request;
+
+  /**
+   * Number of bytes in @e request.
+   */
+  size_t request_size;
+
+  /**
+   * With @e expect_continue, the body to send after the
+   * "100 Continue" of the server.
+   */
+  const char *body;
+
+  /**
+   * Number of bytes in @e body.
+   */
+  size_t body_size;
+
+  /**
+   * Non-zero to wait for "100 Continue" before sending @e body.
+   */
+  int expect_continue;
+
+  /**
+   * Number of requests sent back to back before reading the
+   * responses (1 for no pipelining).
+   */
+  unsigned int pipeline;
+
+  /**
+   * Non-zero to open a new connection for each request (the request
+   * should then carry "Connection: close").
+   */
+  int close_after_response;
+
+  /**
+   * Non-zero to speak TLS (without verifying the server).
+   */
+  int tls;
+
+  /**
+   * If non-zero, the request is an upgrade; after the "101" response
+   * the clients send messages of this size and wait for their echo,
+   * each round trip counting as one request.
+   */
+  size_t echo_size;
+};
+
+
+/**
+ * What a load run measured.
+ */
+struct LoadResult
+{
+  /**
+   * Number of requests (or echo round trips) completed in time.
+   */
+  uint64_t requests;
+
+  /**
+   * Number of connections that failed (connect, protocol errors or
+   * unexpected status codes).
+   */
+  uint64_t errors;
+
+  /**
+   * Number of bytes received, including headers.
+   */
+  uint64_t bytes;
+
+  /**
+   * Duration of the run in seconds.
+   */
+  double seconds;
+
+  /**
+   * Latency of each completed request in microseconds, sorted.
+   */
+  uint64_t *latency;
+};
+
+
+/**
+ * Run the clients described by @a cfg until @a cfg->seconds passed.
+ *
+ * @param cfg what to send
+ * @param[out] res set to what was measured; free with #load_result_free()
+ * @return 0 on success, -1 if the clients could not be set up
+ */
+int
+load_run (const struct LoadConfig *cfg,
+          struct LoadResult *res);
+
+
+/**
+ * Get a percentile of the latencies of a run.
+ *
+ * @param res result of #load_run()
+ * @param percentile the percentile, from 0 to 100
+ * @return latency in microseconds, 0 if no request completed
+ */
+uint64_t
+load_percentile (const struct LoadResult *res,
+                 double percentile);
+
+
+/**
+ * Release the memory of a result.
+ *
+ * @param res result of #load_run()
+ */
+void
+load_result_free (struct LoadResult *res);
+
+#endif
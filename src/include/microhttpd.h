@@ -126,7 +126,7 @@ typedef intptr_t ssize_t;
  * Current version of the library.
  * 0x01093001 = 1.9.30-1.
  */
-#define MHD_VERSION 0x00095102
+#define MHD_VERSION 0x00095103
 
 /**
  * MHD-internal return code for "YES".
@@ -143,6 +143,12 @@ typedef intptr_t ssize_t;
  */
 #define MHD_INVALID_NONCE -1
 
+
+/**
+ * Length of the binary output of the MD5 hash function.
+ */
+#define MHD_MD5_DIGEST_SIZE 16
+
 /**
  * Constant used to indicate unknown size (use when
  * creating a response).
@@ -442,6 +448,9 @@ MHD_get_reason_phrase_for (unsigned int code);
 #define MHD_HTTP_HEADER_WWW_AUTHENTICATE "WWW-Authenticate"
 #define MHD_HTTP_HEADER_ACCESS_CONTROL_ALLOW_ORIGIN "Access-Control-Allow-Origin"
 #define MHD_HTTP_HEADER_CONTENT_DISPOSITION "Content-Disposition"
+#define MHD_HTTP_HEADER_SEC_WEBSOCKET_ACCEPT "Sec-WebSocket-Accept"
+#define MHD_HTTP_HEADER_SEC_WEBSOCKET_KEY "Sec-WebSocket-Key"
+#define MHD_HTTP_HEADER_SEC_WEBSOCKET_VERSION "Sec-WebSocket-Version"
 
 /** @} */ /* end of group headers */
 
@@ -921,7 +930,9 @@ enum MHD_OPTION
   /**
    * Size of the internal array holding the map of the nonce and
    * the nonce counter. This option should be followed by an `unsigend int`
-   * argument.
+   * argument.  If not given, the size is chosen from the connection
+   * limit of the daemon.  If you do not use digest authentication
+   * at all, you can specify zero to save the memory of the map.
    */
   MHD_OPTION_NONCE_NC_SIZE = 18,
 
@@ -1011,7 +1022,168 @@ enum MHD_OPTION
    * value is used. This option should be followed by an `unsigned int`
    * argument.
    */
-  MHD_OPTION_LISTEN_BACKLOG_SIZE = 28
+  MHD_OPTION_LISTEN_BACKLOG_SIZE = 28,
+
+  /**
+   * Enable transparent gzip/deflate compression of response bodies.
+   * The content coding is negotiated from the "Accept-Encoding"
+   * header of the request and the compressed body is always sent
+   * using chunked encoding (so only HTTP/1.1 clients benefit).
+   * Responses created from a file descriptor, responses that
+   * already have a "Content-Encoding" header (use "identity" to
+   * opt a response out), responses with an already-compressed
+   * "Content-Type" (images, audio, video, archives) and responses
+   * whose known size is below the given threshold are sent
+   * unmodified.  This option should be followed by a `size_t`
+   * argument giving the threshold in bytes.
+   * @sa ::MHD_FEATURE_COMPRESSION
+   */
+  MHD_OPTION_RESPONSE_COMPRESSION = 29,
+
+  /**
+   * Enable transparent decompression of request bodies sent with
+   * "Content-Encoding: gzip" (or "x-gzip" or "deflate").  The
+   * #MHD_AccessHandlerCallback (and thus any #MHD_PostProcessor)
+   * receives the decompressed data in @a upload_data; the request
+   * headers (including "Content-Encoding" and "Content-Length")
+   * are left unchanged.  Other content codings are passed on
+   * as-is.  If the decompressed body grows beyond the given limit,
+   * or the compressed data is corrupt or truncated, the connection
+   * is closed.  This option should be followed by a `size_t`
+   * argument giving the limit in bytes (must not be zero).
+   * @sa ::MHD_FEATURE_COMPRESSION
+   */
+  MHD_OPTION_REQUEST_DECOMPRESSION = 30,
+
+  /**
+   * Count connections from IPv6 clients for
+   * #MHD_OPTION_PER_IP_CONNECTION_LIMIT by address prefix
+   * instead of by full address.  Clients usually get a whole
+   * /64 network, so a limit per address is easily circumvented.
+   * This option should be followed by an `unsigned int` giving
+   * the prefix length in bits (at most 128, which is also the
+   * default).  IPv4 clients (also on dual-stack sockets) are
+   * always counted per address.
+   */
+  MHD_OPTION_PER_IP_CONNECTION_IPV6_PREFIX = 31,
+
+  /**
+   * Check the address of every accepted connection against a
+   * table of address ranges, created with #MHD_ip_filter_create().
+   * Connections from denied or rate-limited ranges are closed
+   * right after `accept()`, before any memory is allocated for
+   * them and before the #MHD_AcceptPolicyCallback is called.
+   * This option should be followed by a `struct MHD_IPFilter *`.
+   * If #MHD_start_daemon() succeeds, the daemon owns the filter.
+   * The filter of a running daemon can be replaced with
+   * #MHD_set_ip_filter() (only if this option was given, a NULL
+   * filter is fine).  Connections given to #MHD_add_connection()
+   * are not checked.
+   */
+  MHD_OPTION_IP_FILTER = 32,
+
+  /**
+   * Number of Basic authentication headers to remember after the
+   * application verified them with #MHD_basic_auth_set_verified(),
+   * so that #MHD_basic_auth_get_verified() can skip decoding and
+   * checking them again.  Only keyed hashes of the headers are
+   * kept.  This option should be followed by an `unsigned int`;
+   * the default of 0 disables the cache.
+   */
+  MHD_OPTION_BASIC_AUTH_CACHE_SIZE = 33,
+
+  /**
+   * Number of seconds after which a header remembered for
+   * #MHD_OPTION_BASIC_AUTH_CACHE_SIZE has to be verified again.
+   * This option should be followed by an `unsigned int`; the
+   * default is 60.
+   */
+  MHD_OPTION_BASIC_AUTH_CACHE_TIMEOUT = 34,
+
+  /**
+   * Number of TLS sessions to remember, so that clients that
+   * reconnect with the session ID of an earlier connection can
+   * resume the session with an abbreviated handshake.  One cache
+   * is shared by all threads of the daemon; if it is full, the
+   * least recently used sessions are forgotten first.  Session IDs
+   * are only used up to TLS 1.2, TLS 1.3 clients can only resume
+   * with session tickets (see
+   * #MHD_OPTION_HTTPS_SESSION_TICKET_KEY).  This option should be
+   * followed by an `unsigned int`; the default of 0 disables the
+   * cache.
+   */
+  MHD_OPTION_HTTPS_SESSION_CACHE = 35,
+
+  /**
+   * Enable session tickets: the server hands the encrypted session
+   * parameters to the client, which can present them to resume the
+   * session, without the server having to remember anything.  This
+   * option should be followed by a `size_t` with the size of the key
+   * and a `const void *` with the key to encrypt the tickets with
+   * (created with `gnutls_session_ticket_key_generate()`; all
+   * servers that should accept each other's tickets need the same
+   * key).  If the key is NULL, a random key is generated.  The key
+   * can be replaced with #MHD_set_https_session_ticket_key().
+   * Using this option requires GnuTLS 3.6.3 or higher.
+   */
+  MHD_OPTION_HTTPS_SESSION_TICKET_KEY = 36,
+
+  /**
+   * Number of threads that run the public key operations of TLS
+   * handshakes, so that full handshakes do not delay the other
+   * connections of the event loops.  While a handshake step runs,
+   * its connection is parked internally (this does not require
+   * #MHD_USE_SUSPEND_RESUME).  This option requires
+   * #MHD_USE_SELECT_INTERNALLY (with or without a thread pool).
+   * It is ignored with
+   * #MHD_USE_THREAD_PER_CONNECTION.  This option should be followed
+   * by an `unsigned int`; the default of 0 runs handshakes in the
+   * event loops.
+   */
+  MHD_OPTION_HTTPS_HANDSHAKE_THREADS = 37,
+
+  /**
+   * Measure how long the phases of each request take (see
+   * `enum MHD_RequestPhase`), for #MHD_CONNECTION_INFO_REQUEST_TIMING
+   * and #MHD_get_phase_histogram().  This option should be
+   * followed by an `unsigned int`, #MHD_YES to enable the
+   * measurements; by default, they are disabled to avoid reading the
+   * clock several times per request.
+   */
+  MHD_OPTION_REQUEST_TIMING = 38,
+
+  /**
+   * Watch for calls that block an event loop: time each iteration
+   * of the event loops run by MHD (not #MHD_run_from_select()) and
+   * each call to the #MHD_AccessHandlerCallback, the
+   * #MHD_ContentReaderCallback and the #MHD_RequestCompletedCallback,
+   * and report those that take longer than the given threshold to
+   * the #MHD_OPTION_STALL_CALLBACK (or log them).  Also enables the
+   * loop lag in `struct MHD_DaemonStats`.  This option should be
+   * followed by an `unsigned int` with the threshold in
+   * microseconds; the default of zero disables the watchdog.
+   */
+  MHD_OPTION_STALL_THRESHOLD = 39,
+
+  /**
+   * Function to call for each stall found with
+   * #MHD_OPTION_STALL_THRESHOLD, instead of logging it.  This option
+   * should be followed by TWO pointers: a #MHD_StallCallback and its
+   * closure.  The callback is called by the thread that stalled.
+   */
+  MHD_OPTION_STALL_CALLBACK = 40,
+
+  /**
+   * Record the bytes received on each connection, with the time
+   * they arrived, in a binary trace file (created or truncated).
+   * The trace can be fed back into a daemon with the replayer in
+   * src/benchmark to benchmark with the recorded traffic.  With
+   * TLS, the decrypted bytes are recorded.  The file contains
+   * whatever the clients sent, including credentials, so it must be
+   * treated as confidential.  This option should be followed by a
+   * `const char *` with the name of the file.
+   */
+  MHD_OPTION_TRACE_FILE = 41
 };
 
 
@@ -1168,6 +1340,141 @@ enum MHD_ConnectionNotificationCode
 };
 
 
+/**
+ * What took longer than #MHD_OPTION_STALL_THRESHOLD.
+ */
+enum MHD_StallSource
+{
+  /**
+   * One iteration of an event loop, not counting the time spent
+   * waiting for activity.
+   */
+  MHD_STALL_EVENT_LOOP = 0,
+
+  /**
+   * A call to the #MHD_AccessHandlerCallback.
+   */
+  MHD_STALL_ACCESS_HANDLER = 1,
+
+  /**
+   * A call to the #MHD_ContentReaderCallback of a response.
+   */
+  MHD_STALL_CONTENT_READER = 2,
+
+  /**
+   * A call to the #MHD_RequestCompletedCallback.
+   */
+  MHD_STALL_REQUEST_COMPLETED = 3
+};
+
+
+/**
+ * Phases of a request measured with #MHD_OPTION_REQUEST_TIMING.
+ */
+enum MHD_RequestPhase
+{
+  /**
+   * From accepting the connection (or finishing the previous request
+   * on it) to receiving the first byte of the request.
+   */
+  MHD_REQUEST_PHASE_WAIT = 0,
+
+  /**
+   * From the first byte of the request to the end of its header.
+   */
+  MHD_REQUEST_PHASE_HEADERS = 1,
+
+  /**
+   * From the end of the header to the application queueing a
+   * response, including the upload of the body and the time the
+   * connection was suspended.
+   */
+  MHD_REQUEST_PHASE_HANDLER = 2,
+
+  /**
+   * From queueing the response to sending its header.
+   */
+  MHD_REQUEST_PHASE_SEND_HEADERS = 3,
+
+  /**
+   * From sending the header of the response to sending its body.
+   */
+  MHD_REQUEST_PHASE_SEND_BODY = 4,
+
+  /**
+   * From the first byte of the request to sending the body of the
+   * response.
+   */
+  MHD_REQUEST_PHASE_TOTAL = 5
+};
+
+/**
+ * Number of values of `enum MHD_RequestPhase`.
+ */
+#define MHD_REQUEST_PHASE_COUNT 6
+
+
+/**
+ * Number of buckets of a `struct MHD_Histogram`.
+ */
+#define MHD_HISTOGRAM_BUCKETS 256
+
+
+/**
+ * Log-linear histogram of durations in microseconds.  Values below 8
+ * have a bucket each; above, every power of two is split into eight
+ * buckets, so values are known within 12.5%.  The last bucket also
+ * takes all values of 2^34 microseconds (about 4.8 hours) and more.
+ */
+struct MHD_Histogram
+{
+  /**
+   * Number of values recorded.
+   */
+  uint64_t count;
+
+  /**
+   * Sum of the values recorded.
+   */
+  uint64_t sum;
+
+  /**
+   * Largest value recorded.
+   */
+  uint64_t max;
+
+  /**
+   * Number of values recorded per bucket.
+   */
+  uint64_t buckets[MHD_HISTOGRAM_BUCKETS];
+};
+
+
+/**
+ * Add the values of the histogram @a src to @a dst, for example to
+ * combine the histograms of several daemons.
+ *
+ * @param dst histogram to update
+ * @param src histogram to add
+ */
+_MHD_EXTERN void
+MHD_histogram_merge (struct MHD_Histogram *dst,
+                     const struct MHD_Histogram *src);
+
+
+/**
+ * Estimate a percentile of the values in a histogram.
+ *
+ * @param h the histogram
+ * @param percentile the percentile, from 0 to 100 (i.e. 99.9)
+ * @return upper limit of the bucket with the percentile (at most the
+ *         largest value recorded), 0 if @a h is empty
+ */
+_MHD_EXTERN uint64_t
+MHD_histogram_percentile (const struct MHD_Histogram *h,
+                          double percentile);
+
+
 /**
  * Information about a connection.
  */
@@ -1220,6 +1527,12 @@ union MHD_ConnectionInfo
    * the "socket_context" of the #MHD_NotifyConnectionCallback.
    */
   void *socket_context;
+
+  /**
+   * Duration of each `enum MHD_RequestPhase` of the last completed
+   * request, in microseconds, for #MHD_CONNECTION_INFO_REQUEST_TIMING.
+   */
+  uint64_t phase_usec[MHD_REQUEST_PHASE_COUNT];
 };
 
 
@@ -1294,7 +1607,16 @@ enum MHD_ConnectionInfoType
    * Check wheter the connection is suspended.
    * @ingroup request
    */
-  MHD_CONNECTION_INFO_CONNECTION_SUSPENDED
+  MHD_CONNECTION_INFO_CONNECTION_SUSPENDED,
+
+  /**
+   * Get the duration of the phases of the last completed request,
+   * for example for access logging from the
+   * #MHD_RequestCompletedCallback.  Only available with
+   * #MHD_OPTION_REQUEST_TIMING.
+   * @ingroup request
+   */
+  MHD_CONNECTION_INFO_REQUEST_TIMING
 };
 
 
@@ -1459,6 +1781,30 @@ typedef void
                                  enum MHD_ConnectionNotificationCode toe);
 
 
+/**
+ * Signature of the callback used by MHD to report a call or an event
+ * loop iteration that took longer than #MHD_OPTION_STALL_THRESHOLD.
+ *
+ * @param cls client-defined closure
+ * @param source what stalled
+ * @param method HTTP method of the request being processed, NULL for
+ *        #MHD_STALL_EVENT_LOOP or if not yet known
+ * @param url URL of the request being processed, NULL for
+ *        #MHD_STALL_EVENT_LOOP or if not yet known
+ * @param worker index of the worker thread in the thread pool, 0
+ *        without a pool
+ * @param duration_usec how long it took, in microseconds
+ * @see #MHD_OPTION_STALL_CALLBACK
+ */
+typedef void
+(*MHD_StallCallback) (void *cls,
+                      enum MHD_StallSource source,
+                      const char *method,
+                      const char *url,
+                      unsigned int worker,
+                      uint64_t duration_usec);
+
+
 /**
  * Iterator over key-value pairs.  This iterator
  * can be used to iterate over all of the cookies,
@@ -1695,6 +2041,124 @@ MHD_add_connection (struct MHD_Daemon *daemon,
 		    socklen_t addrlen);
 
 
+/**
+ * Decision of an #MHD_IPFilter for an address range.
+ */
+enum MHD_IPFilterAction
+{
+  /**
+   * Accept connections (subject to the rate limit of the range).
+   */
+  MHD_IP_FILTER_ALLOW = 0,
+
+  /**
+   * Close connections right after they were accepted.
+   */
+  MHD_IP_FILTER_DENY = 1
+};
+
+
+/**
+ * Set of address ranges with allow/deny decisions and rate
+ * limits, see #MHD_OPTION_IP_FILTER.
+ */
+struct MHD_IPFilter;
+
+
+/**
+ * Create an empty filter.  Add ranges with #MHD_ip_filter_add() and
+ * pass it to #MHD_start_daemon() with #MHD_OPTION_IP_FILTER or to
+ * #MHD_set_ip_filter().
+ *
+ * @param default_action what to do with connections from
+ *        addresses that are not in any range of the filter
+ * @return NULL on error (out of memory)
+ * @ingroup specialized
+ */
+_MHD_EXTERN struct MHD_IPFilter *
+MHD_ip_filter_create (enum MHD_IPFilterAction default_action);
+
+
+/**
+ * Add a range of addresses to a filter that is not (yet) used
+ * by a daemon.  If the same range was added before, its rule is
+ * replaced.  Connections are checked against the most specific
+ * (longest) range that contains the client's address.
+ *
+ * @param filter the filter to modify
+ * @param addr first address of the range, a `struct sockaddr_in`
+ *        or `struct sockaddr_in6`; only the address is used
+ * @param addrlen number of bytes in @a addr
+ * @param prefix_len number of leading bits of @a addr that
+ *        define the range (at most 32 for IPv4, 128 for IPv6)
+ * @param action what to do with connections from the range
+ * @param rate if @a action is #MHD_IP_FILTER_ALLOW, maximum number
+ *        of new connections per second from the range as a whole
+ *        (0 for no limit); connections beyond the limit are closed
+ *        right after they were accepted
+ * @param burst number of connections that may be accepted at
+ *        once after the range was idle (0 to use @a rate)
+ * @return #MHD_YES on success, #MHD_NO on error (out of memory
+ *         or invalid address or prefix length)
+ * @ingroup specialized
+ */
+_MHD_EXTERN int
+MHD_ip_filter_add (struct MHD_IPFilter *filter,
+                   const struct sockaddr *addr,
+                   socklen_t addrlen,
+                   unsigned int prefix_len,
+                   enum MHD_IPFilterAction action,
+                   unsigned int rate,
+                   unsigned int burst);
+
+
+/**
+ * Destroy a filter that is not used by a daemon.
+ *
+ * @param filter the filter to destroy
+ * @ingroup specialized
+ */
+_MHD_EXTERN void
+MHD_ip_filter_destroy (struct MHD_IPFilter *filter);
+
+
+/**
+ * Replace the filter of a running daemon.  Connections accepted
+ * after this call are checked against @a filter only.  The
+ * daemon takes ownership of @a filter and destroys the previous
+ * one, after waiting for the checks of connections that are being
+ * accepted right now.
+ *
+ * @param daemon daemon started with #MHD_OPTION_IP_FILTER
+ * @param filter the new filter, NULL to accept all connections
+ * @return #MHD_YES on success, #MHD_NO if @a daemon was not
+ *         started with #MHD_OPTION_IP_FILTER (the caller keeps
+ *         ownership of @a filter in this case)
+ * @ingroup specialized
+ */
+_MHD_EXTERN int
+MHD_set_ip_filter (struct MHD_Daemon *daemon,
+                   struct MHD_IPFilter *filter);
+
+
+/**
+ * Replace the key that session tickets are encrypted with, for
+ * example once a day.  Tickets issued with the old key can no
+ * longer be used to resume sessions.
+ *
+ * @param daemon daemon started with #MHD_OPTION_HTTPS_SESSION_TICKET_KEY
+ * @param key the new key, NULL to generate a random key
+ * @param key_size number of bytes in @a key
+ * @return #MHD_YES on success, #MHD_NO if session tickets are not
+ *         enabled, @a key_size is wrong or on error (out of memory)
+ * @ingroup specialized
+ */
+_MHD_EXTERN int
+MHD_set_https_session_ticket_key (struct MHD_Daemon *daemon,
+                                  const void *key,
+                                  size_t key_size);
+
+
 /**
  * Obtain the `select()` sets for this daemon.
  * Daemon's FDs will be added to fd_sets. To get only
@@ -2012,6 +2476,36 @@ _MHD_EXTERN void
 MHD_resume_connection (struct MHD_Connection *connection);
 
 
+/**
+ * Queue the same @a response for many suspended connections of one
+ * daemon and resume them, for example to publish an event to all
+ * clients of a long poll.  This is equivalent to calling
+ * #MHD_resume_connection() on each connection and then
+ * #MHD_queue_response() from the #MHD_AccessHandlerCallback, but
+ * the response is attached directly and each worker thread is woken
+ * up only once, without calling the access handler again.
+ *
+ * The connections must have been suspended from the access handler
+ * (which must have returned) and not be resumed otherwise.
+ * Connections that are not suspended or already have a response
+ * are skipped.  As with #MHD_resume_connection(), in ``external''
+ * select mode #MHD_run() must be called afterwards.
+ *
+ * @param connections the suspended connections
+ * @param num_connections number of entries in @a connections
+ * @param status_code HTTP status code (i.e. #MHD_HTTP_OK)
+ * @param response response to transmit; the application keeps its
+ *        own reference and should destroy it as usual
+ * @return number of connections the response was queued for
+ * @ingroup response
+ */
+_MHD_EXTERN unsigned int
+MHD_broadcast_response (struct MHD_Connection *const *connections,
+                        unsigned int num_connections,
+                        unsigned int status_code,
+                        struct MHD_Response *response);
+
+
 /* **************** Response manipulation functions ***************** */
 
 
@@ -2030,7 +2524,18 @@ enum MHD_ResponseFlags
    * do not (automatically) sent "Connection" headers and always
    * close the connection after generating the response.
    */
-  MHD_RF_HTTP_VERSION_1_0_ONLY = 1
+  MHD_RF_HTTP_VERSION_1_0_ONLY = 1,
+
+  /**
+   * For responses created with #MHD_create_response_for_upgrade():
+   * with TLS, do not give the application a socketpair() to which
+   * MHD copies the decrypted data, but the socket of the client
+   * itself; the application then has to use #MHD_upgrade_recv()
+   * and #MHD_upgrade_send(), which encrypt and decrypt the data
+   * in the buffers of the application.  Without TLS, the flag makes
+   * no difference.
+   */
+  MHD_RF_UPGRADE_DIRECT = 2
 
 };
 
@@ -2290,6 +2795,47 @@ MHD_upgrade_action (struct MHD_UpgradeResponseHandle *urh,
                     ...);
 
 
+/**
+ * Receive data from the client of an upgraded connection.  With
+ * TLS and #MHD_RF_UPGRADE_DIRECT, the data is decrypted directly
+ * into @a buf; otherwise, this is a recv() on the socket given to
+ * the #MHD_UpgradeHandler.  The socket is non-blocking (unless
+ * #MHD_USE_THREAD_PER_CONNECTION is used); wait for it to become
+ * readable and call this function until it fails with `EAGAIN`, as
+ * data may be buffered in the TLS session.
+ *
+ * @param urh the upgraded connection
+ * @param buf where to store the data
+ * @param size size of @a buf
+ * @return number of bytes received, 0 if the client closed the
+ *         connection, -1 on error (with `errno` set, `EAGAIN`
+ *         if no data is available yet)
+ */
+_MHD_EXTERN ssize_t
+MHD_upgrade_recv (struct MHD_UpgradeResponseHandle *urh,
+                  void *buf,
+                  size_t size);
+
+
+/**
+ * Send data to the client of an upgraded connection.  With TLS and
+ * #MHD_RF_UPGRADE_DIRECT, the data is encrypted directly from
+ * @a buf; otherwise, this is a send() on the socket given to the
+ * #MHD_UpgradeHandler.  If the call fails with `EAGAIN`, wait for
+ * the socket to become writable and repeat the call with the same
+ * data (TLS may already have taken it into a record).
+ *
+ * @param urh the upgraded connection
+ * @param buf the data to send
+ * @param size number of bytes in @a buf
+ * @return number of bytes sent, -1 on error (with `errno` set)
+ */
+_MHD_EXTERN ssize_t
+MHD_upgrade_send (struct MHD_UpgradeResponseHandle *urh,
+                  const void *buf,
+                  size_t size);
+
+
 /**
  * Function called after a protocol "upgrade" response was sent
  * successfully and the socket should now be controlled by some
@@ -2386,6 +2932,168 @@ MHD_create_response_for_upgrade (MHD_UpgradeHandler upgrade_handler,
 				 void *upgrade_handler_cls);
 
 
+/**
+ * Create a response that accepts the WebSocket (RFC 6455) handshake
+ * of the request on @a connection.  The request must be a GET with
+ * "Upgrade: websocket", "Connection: Upgrade", "Sec-WebSocket-Version: 13"
+ * and a valid "Sec-WebSocket-Key"; the response carries the matching
+ * "Sec-WebSocket-Accept" and is specific to @a connection.  Queue it
+ * with #MHD_HTTP_SWITCHING_PROTOCOLS.
+ *
+ * The response is created with #MHD_RF_UPGRADE_DIRECT, so the
+ * @a upgrade_handler must use #MHD_upgrade_recv() and
+ * #MHD_upgrade_send() for the frames; see #MHD_websocket_decode()
+ * and #MHD_websocket_encode_header().
+ *
+ * @param connection the connection with the handshake request
+ * @param upgrade_handler function to call with the upgraded connection
+ * @param upgrade_handler_cls closure for @a upgrade_handler
+ * @return NULL if the request is not a valid WebSocket handshake
+ *         (reply with #MHD_HTTP_BAD_REQUEST) or out of memory
+ */
+_MHD_EXTERN struct MHD_Response *
+MHD_create_response_for_websocket (struct MHD_Connection *connection,
+                                   MHD_UpgradeHandler upgrade_handler,
+                                   void *upgrade_handler_cls);
+
+
+/**
+ * Maximum size of the header of a WebSocket frame sent by the
+ * server (frames from the server are not masked).
+ */
+#define MHD_WEBSOCKET_MAX_HEADER_SIZE 10
+
+
+/**
+ * Opcodes of WebSocket frames.
+ */
+enum MHD_WebSocketOpcode
+{
+  /**
+   * Continuation of a fragmented message.
+   */
+  MHD_WEBSOCKET_OPCODE_CONTINUATION = 0,
+
+  /**
+   * Text message (UTF-8; MHD does not validate the encoding).
+   */
+  MHD_WEBSOCKET_OPCODE_TEXT = 1,
+
+  /**
+   * Binary message.
+   */
+  MHD_WEBSOCKET_OPCODE_BINARY = 2,
+
+  /**
+   * Close frame; the payload is an optional status code and reason.
+   */
+  MHD_WEBSOCKET_OPCODE_CLOSE = 8,
+
+  /**
+   * Ping frame; answer with a pong carrying the same payload.
+   */
+  MHD_WEBSOCKET_OPCODE_PING = 9,
+
+  /**
+   * Pong frame.
+   */
+  MHD_WEBSOCKET_OPCODE_PONG = 10
+};
+
+
+/**
+ * Decoder for the frames sent by a WebSocket client.
+ */
+struct MHD_WebSocket;
+
+
+/**
+ * Function called by #MHD_websocket_decode() with the messages of
+ * the client.  Data messages (#MHD_WEBSOCKET_OPCODE_TEXT and
+ * #MHD_WEBSOCKET_OPCODE_BINARY) are passed in chunks as they arrive,
+ * without copying: @a data points into the buffer given to
+ * #MHD_websocket_decode() and is only valid during the call.
+ * Control frames are always passed in one call, in between the chunks
+ * of a fragmented message if the client sent them that way.
+ *
+ * @param cls closure
+ * @param opcode the type of the message
+ * @param data the (unmasked) payload, NULL if @a size is 0
+ * @param size number of bytes in @a data
+ * @param last #MHD_YES if this is the last chunk of the message
+ * @return #MHD_YES to continue decoding, #MHD_NO to stop (the
+ *         decoder then fails)
+ */
+typedef int
+(*MHD_WebSocketMessageCallback)(void *cls,
+                                enum MHD_WebSocketOpcode opcode,
+                                const char *data,
+                                size_t size,
+                                int last);
+
+
+/**
+ * Create a decoder for the frames a WebSocket client sends.
+ *
+ * @param max_message_size maximum size of a (data) message,
+ *        0 for no limit
+ * @param cb function to call with the messages
+ * @param cb_cls closure for @a cb
+ * @return NULL on error (out of memory)
+ */
+_MHD_EXTERN struct MHD_WebSocket *
+MHD_websocket_create (uint64_t max_message_size,
+                      MHD_WebSocketMessageCallback cb,
+                      void *cb_cls);
+
+
+/**
+ * Decode data received from a WebSocket client.  Frames may be split
+ * over any number of calls.  The payload is unmasked in place, so
+ * @a data is modified.
+ *
+ * @param ws the decoder
+ * @param data the data received
+ * @param size number of bytes in @a data
+ * @return #MHD_YES on success, #MHD_NO if the connection should be
+ *         closed (protocol error, message larger than allowed, data
+ *         after a close frame, or the callback returned #MHD_NO)
+ */
+_MHD_EXTERN int
+MHD_websocket_decode (struct MHD_WebSocket *ws,
+                      char *data,
+                      size_t size);
+
+
+/**
+ * Destroy a decoder.
+ *
+ * @param ws the decoder, may be NULL
+ */
+_MHD_EXTERN void
+MHD_websocket_destroy (struct MHD_WebSocket *ws);
+
+
+/**
+ * Write the header of a frame from the server into @a buf.  The
+ * payload follows the header as is; as frames from the server are
+ * not masked, a frame built once can be sent to any number of
+ * clients.
+ *
+ * @param buf where to write the header, at least
+ *        #MHD_WEBSOCKET_MAX_HEADER_SIZE bytes
+ * @param opcode opcode of the frame
+ * @param last #MHD_YES if this is the last frame of the message
+ * @param payload_size size of the payload that follows the header
+ * @return size of the header
+ */
+_MHD_EXTERN size_t
+MHD_websocket_encode_header (char *buf,
+                             enum MHD_WebSocketOpcode opcode,
+                             int last,
+                             uint64_t payload_size);
+
+
 /**
  * Destroy a response object and associated resources.  Note that
  * libmicrohttpd may keep some of the resources around if the response
@@ -2582,6 +3290,28 @@ MHD_digest_auth_check (struct MHD_Connection *connection,
 		       unsigned int nonce_timeout);
 
 
+/**
+ * Authenticates the authorization header sent by the client, using
+ * the stored hash of the credentials instead of the password.
+ *
+ * @param connection The MHD connection structure
+ * @param realm The realm presented to the client
+ * @param username The username needs to be authenticated
+ * @param digest H(A1), the binary MD5 hash of "username:realm:password"
+ * @param nonce_timeout The amount of time for a nonce to be
+ * 			invalid in seconds
+ * @return #MHD_YES if authenticated, #MHD_NO if not,
+ * 			#MHD_INVALID_NONCE if nonce is invalid
+ * @ingroup authentication
+ */
+_MHD_EXTERN int
+MHD_digest_auth_check_digest (struct MHD_Connection *connection,
+			      const char *realm,
+			      const char *username,
+			      const uint8_t digest[MHD_MD5_DIGEST_SIZE],
+			      unsigned int nonce_timeout);
+
+
 /**
  * Queues a response to request authentication from the client
  *
@@ -2635,6 +3365,45 @@ MHD_queue_basic_auth_fail_response (struct MHD_Connection *connection,
 				    const char *realm,
 				    struct MHD_Response *response);
 
+
+/**
+ * Check if the application recently verified the Basic
+ * authentication header of the request with
+ * #MHD_basic_auth_set_verified().  This neither decodes the header
+ * nor allocates memory.
+ *
+ * @param connection The MHD connection structure
+ * @param[out] username set to the 0-terminated name of the user the
+ *        header was verified as, may be NULL
+ * @param username_size number of bytes in @a username
+ * @return #MHD_YES if the header was verified and has not timed out
+ *         (see #MHD_OPTION_BASIC_AUTH_CACHE_TIMEOUT), #MHD_NO if not,
+ *         if the name does not fit into @a username or if the daemon
+ *         has no cache (see #MHD_OPTION_BASIC_AUTH_CACHE_SIZE)
+ * @ingroup authentication
+ */
+_MHD_EXTERN int
+MHD_basic_auth_get_verified (struct MHD_Connection *connection,
+			     char *username,
+			     size_t username_size);
+
+
+/**
+ * Tell MHD that the application verified the Basic authentication
+ * header of the request, so that further requests with the same
+ * header are reported by #MHD_basic_auth_get_verified().
+ *
+ * @param connection The MHD connection structure
+ * @param username name of the user the header was verified as
+ * @return #MHD_YES on success, #MHD_NO if the request has no Basic
+ *         authentication header, the name is empty or too long, or
+ *         the daemon has no cache
+ * @ingroup authentication
+ */
+_MHD_EXTERN int
+MHD_basic_auth_set_verified (struct MHD_Connection *connection,
+			     const char *username);
+
 /* ********************** generic query functions ********************** */
 
 
@@ -2686,6 +3455,79 @@ MHD_set_connection_option (struct MHD_Connection *connection,
 			   ...);
 
 
+/**
+ * Runtime statistics of a daemon, returned by
+ * #MHD_get_daemon_stats().  The counters are updated without locks by
+ * the threads that handle the connections and read without stopping
+ * them, so a snapshot is not exact while requests are processed.
+ * With #MHD_USE_THREAD_PER_CONNECTION, the counters of a connection
+ * are only added once it was closed.
+ */
+struct MHD_DaemonStats
+{
+  /**
+   * Number of connections accepted (or added with
+   * #MHD_add_connection()).
+   */
+  uint64_t connections_accepted;
+
+  /**
+   * Number of requests for which the response was sent completely.
+   */
+  uint64_t requests_completed;
+
+  /**
+   * Number of times a connection was kept alive for another request.
+   */
+  uint64_t keepalive_reuses;
+
+  /**
+   * Number of bytes received from clients (after TLS decryption).
+   */
+  uint64_t bytes_received;
+
+  /**
+   * Number of bytes sent to clients (before TLS encryption),
+   * including @e bytes_sendfile.
+   */
+  uint64_t bytes_sent;
+
+  /**
+   * Number of bytes of @e bytes_sent that were sent with sendfile().
+   */
+  uint64_t bytes_sendfile;
+
+  /**
+   * Number of connections that are currently suspended.
+   */
+  uint64_t connections_suspended;
+
+  /**
+   * Number of closed connections, indexed by the
+   * #MHD_RequestTerminationCode of the close.
+   */
+  uint64_t connections_closed[MHD_REQUEST_TERMINATED_CLIENT_ABORT + 1];
+
+  /**
+   * With #MHD_OPTION_STALL_THRESHOLD, the longest time (in
+   * microseconds) a worker spent processing in its last event loop
+   * iteration, not counting the time spent waiting for activity.
+   */
+  uint64_t loop_lag_usec;
+
+  /**
+   * With #MHD_OPTION_STALL_THRESHOLD, the longest event loop
+   * iteration seen so far, in microseconds.
+   */
+  uint64_t loop_lag_max_usec;
+
+  /**
+   * Number of stalls found with #MHD_OPTION_STALL_THRESHOLD.
+   */
+  uint64_t stalls;
+};
+
+
 /**
  * Information about an MHD daemon.
  */
@@ -2733,6 +3575,37 @@ MHD_get_daemon_info (struct MHD_Daemon *daemon,
 		     ...);
 
 
+/**
+ * Obtain the runtime statistics of a daemon, summed over all
+ * worker threads.
+ *
+ * @param daemon daemon to get the statistics of
+ * @param[out] stats set to the statistics
+ * @return #MHD_YES on success, #MHD_NO if @a stats is NULL
+ * @ingroup specialized
+ */
+_MHD_EXTERN int
+MHD_get_daemon_stats (struct MHD_Daemon *daemon,
+                      struct MHD_DaemonStats *stats);
+
+
+/**
+ * Obtain the histogram of the durations of one phase of the
+ * requests, merged over all worker threads.
+ *
+ * @param daemon daemon started with #MHD_OPTION_REQUEST_TIMING
+ * @param phase the phase
+ * @param[out] histogram set to the histogram
+ * @return #MHD_YES on success, #MHD_NO if the request timing is
+ *         not enabled or @a phase is invalid
+ * @ingroup specialized
+ */
+_MHD_EXTERN int
+MHD_get_phase_histogram (struct MHD_Daemon *daemon,
+                         enum MHD_RequestPhase phase,
+                         struct MHD_Histogram *histogram);
+
+
 /**
  * Obtain the version of this library
  *
@@ -2827,8 +3700,9 @@ enum MHD_FEATURE
   /**
    * Get whether HTTP Digest authorization is supported. If
    * supported then options #MHD_OPTION_DIGEST_AUTH_RANDOM,
-   * #MHD_OPTION_NONCE_NC_SIZE and
-   * #MHD_digest_auth_check() can be used.
+   * #MHD_OPTION_NONCE_NC_SIZE,
+   * #MHD_digest_auth_check() and #MHD_digest_auth_check_digest()
+   * can be used.
    */
   MHD_FEATURE_DIGEST_AUTH = 12,
 
@@ -2860,7 +3734,15 @@ enum MHD_FEATURE
   /**
    * Get whether MHD set names on generated threads.
    */
-  MHD_THREAD_NAMES = 16
+  MHD_THREAD_NAMES = 16,
+
+  /**
+   * Get whether gzip/deflate compression of HTTP bodies is
+   * supported.  If supported then options
+   * #MHD_OPTION_RESPONSE_COMPRESSION and
+   * #MHD_OPTION_REQUEST_DECOMPRESSION can be used.
+   */
+  MHD_FEATURE_COMPRESSION = 17
 };
 
 
@@ -0,0 +1,336 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/authcache.c
+ * @brief  cache of verified basic authentication credentials
+ * @author libmicrohttpd contributors
+ *
+ * Header values are not stored, only two independently keyed
+ * SipHash values of them, so the cache does not keep credentials
+ * in memory; to be taken for another user, a client would have
+ * to find a header value that matches both 64-bit hashes of that
+ * user's header value.  Like the
+ * nonce table, the cache is set-associative with striped locks; a
+ * new entry replaces an unused or expired entry of its set, or the
+ * one that expires first.
+ */
+#include "authcache.h"
+#include "mhd_locks.h"
+#include "mhd_mono_clock.h"
+#include "mhd_siphash.h"
+
+
+/**
+ * Number of entries per set.
+ */
+#define AUTH_CACHE_WAYS 4
+
+/**
+ * Number of locks, must be a power of two.
+ */
+#define AUTH_CACHE_LOCKS 16
+
+/**
+ * Maximum length of a user name in the cache, including the
+ * terminating 0.
+ */
+#define AUTH_CACHE_MAX_USERNAME 128
+
+
+/**
+ * A verified header value.
+ */
+struct AuthCacheEntry
+{
+  /**
+   * Hashes of the header value.
+   */
+  uint64_t hash[2];
+
+  /**
+   * Time (of the monotonic clock) when the entry expires.
+   */
+  time_t expires;
+
+  /**
+   * Name of the user, empty if the entry is unused.
+   */
+  char username[AUTH_CACHE_MAX_USERNAME];
+};
+
+
+/**
+ * Cache of verified header values.
+ */
+struct MHD_AuthCache
+{
+  /**
+   * Locks, set N uses lock N modulo #AUTH_CACHE_LOCKS.
+   */
+  MHD_mutex_ locks[AUTH_CACHE_LOCKS];
+
+  /**
+   * The entries, #AUTH_CACHE_WAYS consecutive entries per set.
+   */
+  struct AuthCacheEntry *entries;
+
+  /**
+   * Number of sets.
+   */
+  uint32_t num_sets;
+
+  /**
+   * Number of seconds to keep an entry.
+   */
+  unsigned int timeout;
+
+  /**
+   * Keys for the two hashes.
+   */
+  uint64_t key[2][2];
+};
+
+
+/**
+ * Create a cache of verified credentials.
+ *
+ * @param size number of header values to remember
+ * @param timeout number of seconds to remember a header value
+ * @return NULL on error; errno is ENOSYS if no random bytes
+ *         were available for the hash key, otherwise we ran out
+ *         of memory
+ */
+struct MHD_AuthCache *
+MHD_auth_cache_create_ (unsigned int size,
+                        unsigned int timeout)
+{
+  struct MHD_AuthCache *cache;
+  uint32_t num_sets;
+  unsigned int i;
+  unsigned int j;
+
+  num_sets = (size + AUTH_CACHE_WAYS - 1) / AUTH_CACHE_WAYS;
+  if (0 == num_sets)
+    num_sets = 1;
+  if (NULL == (cache = malloc (sizeof (struct MHD_AuthCache))))
+    return NULL;
+  if (NULL == (cache->entries = calloc ((size_t) num_sets * AUTH_CACHE_WAYS,
+                                        sizeof (struct AuthCacheEntry))))
+    {
+      free (cache);
+      return NULL;
+    }
+  for (i = 0; i < AUTH_CACHE_LOCKS; i++)
+    {
+      if (! MHD_mutex_init_ (&cache->locks[i]))
+        {
+          for (j = 0; j < i; j++)
+            MHD_mutex_destroy_chk_ (&cache->locks[j]);
+          free (cache->entries);
+          free (cache);
+          return NULL;
+        }
+    }
+  cache->num_sets = num_sets;
+  cache->timeout = timeout;
+  if ( (MHD_YES != MHD_siphash_key_ (cache->key[0],
+                                     NULL,
+                                     0)) ||
+       (MHD_YES != MHD_siphash_key_ (cache->key[1],
+                                     NULL,
+                                     0)) )
+    {
+      MHD_auth_cache_destroy_ (cache);
+      errno = ENOSYS; /* destroy may have changed it */
+      return NULL;
+    }
+  return cache;
+}
+
+
+/**
+ * Destroy a cache created with #MHD_auth_cache_create_().
+ *
+ * @param cache the cache to destroy, may be NULL
+ */
+void
+MHD_auth_cache_destroy_ (struct MHD_AuthCache *cache)
+{
+  unsigned int i;
+
+  if (NULL == cache)
+    return;
+  for (i = 0; i < AUTH_CACHE_LOCKS; i++)
+    MHD_mutex_destroy_chk_ (&cache->locks[i]);
+  free (cache->entries);
+  free (cache);
+}
+
+
+/**
+ * Find the set of a header value and lock it.
+ *
+ * @param cache the cache
+ * @param header the header value
+ * @param header_len number of bytes in @a header
+ * @param[out] hash set to the hashes of @a header
+ * @param[out] set set to the first entry of the set
+ * @return the lock that was locked
+ */
+static MHD_mutex_ *
+lock_set (struct MHD_AuthCache *cache,
+          const char *header,
+          size_t header_len,
+          uint64_t hash[2],
+          struct AuthCacheEntry **set)
+{
+  uint32_t set_idx;
+
+  hash[0] = MHD_siphash24_ (cache->key[0],
+                            header,
+                            header_len);
+  hash[1] = MHD_siphash24_ (cache->key[1],
+                            header,
+                            header_len);
+  set_idx = (uint32_t) hash[0] % cache->num_sets;
+  *set = &cache->entries[(size_t) set_idx * AUTH_CACHE_WAYS];
+  MHD_mutex_lock_chk_ (&cache->locks[set_idx & (AUTH_CACHE_LOCKS - 1)]);
+  return &cache->locks[set_idx & (AUTH_CACHE_LOCKS - 1)];
+}
+
+
+/**
+ * Check if a header value was verified recently.
+ *
+ * @param cache the cache
+ * @param header the Authorization header value
+ * @param header_len number of bytes in @a header
+ * @param[out] username set to the 0-terminated name of the user
+ *        the header was verified as, may be NULL
+ * @param username_size number of bytes in @a username
+ * @return #MHD_YES if the header was verified and the name of the
+ *         user fits into @a username, #MHD_NO if not
+ */
+int
+MHD_auth_cache_lookup_ (struct MHD_AuthCache *cache,
+                        const char *header,
+                        size_t header_len,
+                        char *username,
+                        size_t username_size)
+{
+  struct AuthCacheEntry *set;
+  MHD_mutex_ *lock;
+  uint64_t hash[2];
+  time_t now;
+  size_t len;
+  unsigned int i;
+  int ret;
+
+  now = MHD_monotonic_sec_counter ();
+  lock = lock_set (cache,
+                   header,
+                   header_len,
+                   hash,
+                   &set);
+  ret = MHD_NO;
+  for (i = 0; i < AUTH_CACHE_WAYS; i++)
+    {
+      if ( ('\0' == set[i].username[0]) ||
+           (hash[0] != set[i].hash[0]) ||
+           (hash[1] != set[i].hash[1]) ||
+           (now >= set[i].expires) )
+        continue;
+      len = strlen (set[i].username);
+      if (NULL == username)
+        ret = MHD_YES;
+      else if (len < username_size)
+        {
+          memcpy (username,
+                  set[i].username,
+                  len + 1);
+          ret = MHD_YES;
+        }
+      break;
+    }
+  MHD_mutex_unlock_chk_ (lock);
+  return ret;
+}
+
+
+/**
+ * Remember that a header value was verified.
+ *
+ * @param cache the cache
+ * @param header the Authorization header value
+ * @param header_len number of bytes in @a header
+ * @param username name of the user the header was verified as
+ * @return #MHD_YES on success, #MHD_NO if @a username is too long
+ */
+int
+MHD_auth_cache_store_ (struct MHD_AuthCache *cache,
+                       const char *header,
+                       size_t header_len,
+                       const char *username)
+{
+  struct AuthCacheEntry *set;
+  struct AuthCacheEntry *e;
+  MHD_mutex_ *lock;
+  uint64_t hash[2];
+  time_t now;
+  size_t len;
+  unsigned int i;
+
+  len = strlen (username);
+  if ( (0 == len) ||
+       (AUTH_CACHE_MAX_USERNAME <= len) )
+    return MHD_NO;
+  now = MHD_monotonic_sec_counter ();
+  lock = lock_set (cache,
+                   header,
+                   header_len,
+                   hash,
+                   &set);
+  e = NULL;
+  for (i = 0; i < AUTH_CACHE_WAYS; i++)
+    {
+      if ( (hash[0] == set[i].hash[0]) &&
+           (hash[1] == set[i].hash[1]) )
+        {
+          e = &set[i];
+          break;
+        }
+      if ( ('\0' == set[i].username[0]) ||
+           (now >= set[i].expires) )
+        e = &set[i];
+      else if ( (NULL == e) ||
+                ( ('\0' != e->username[0]) &&
+                  (now < e->expires) &&
+                  (set[i].expires < e->expires) ) )
+        e = &set[i];
+    }
+  e->hash[0] = hash[0];
+  e->hash[1] = hash[1];
+  e->expires = now + cache->timeout;
+  memcpy (e->username,
+          username,
+          len + 1);
+  MHD_mutex_unlock_chk_ (lock);
+  return MHD_YES;
+}
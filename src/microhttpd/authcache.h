@@ -0,0 +1,96 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/authcache.h
+ * @brief  cache of verified basic authentication credentials
+ * @author libmicrohttpd contributors
+ */
+#ifndef AUTHCACHE_H
+#define AUTHCACHE_H
+
+#include "internal.h"
+
+
+/**
+ * Cache of Authorization header values that the application
+ * verified, and the users they were verified as.
+ */
+struct MHD_AuthCache;
+
+
+/**
+ * Create a cache of verified credentials.
+ *
+ * @param size number of header values to remember
+ * @param timeout number of seconds to remember a header value
+ * @return NULL on error; errno is ENOSYS if no random bytes
+ *         were available for the hash key, otherwise we ran out
+ *         of memory
+ */
+struct MHD_AuthCache *
+MHD_auth_cache_create_ (unsigned int size,
+                        unsigned int timeout);
+
+
+/**
+ * Destroy a cache created with #MHD_auth_cache_create_().
+ *
+ * @param cache the cache to destroy, may be NULL
+ */
+void
+MHD_auth_cache_destroy_ (struct MHD_AuthCache *cache);
+
+
+/**
+ * Check if a header value was verified recently.
+ *
+ * @param cache the cache
+ * @param header the Authorization header value
+ * @param header_len number of bytes in @a header
+ * @param[out] username set to the 0-terminated name of the user
+ *        the header was verified as, may be NULL
+ * @param username_size number of bytes in @a username
+ * @return #MHD_YES if the header was verified and the name of the
+ *         user fits into @a username, #MHD_NO if not
+ */
+int
+MHD_auth_cache_lookup_ (struct MHD_AuthCache *cache,
+                        const char *header,
+                        size_t header_len,
+                        char *username,
+                        size_t username_size);
+
+
+/**
+ * Remember that a header value was verified.
+ *
+ * @param cache the cache
+ * @param header the Authorization header value
+ * @param header_len number of bytes in @a header
+ * @param username name of the user the header was verified as
+ * @return #MHD_YES on success, #MHD_NO if @a username is too long
+ */
+int
+MHD_auth_cache_store_ (struct MHD_AuthCache *cache,
+                       const char *header,
+                       size_t header_len,
+                       const char *username);
+
+#endif
@@ -26,6 +26,7 @@
 #include <limits.h>
 #include "internal.h"
 #include "base64.h"
+#include "authcache.h"
 #include "mhd_compat.h"
 
 /**
@@ -161,4 +162,95 @@ MHD_queue_basic_auth_fail_response (struct MHD_Connection *connection,
   return ret;
 }
 
+
+/**
+ * Get the value of the Basic authorization header, if any.
+ *
+ * @param connection The MHD connection structure
+ * @param[out] len set to the length of the value
+ * @return NULL if there is no Basic authorization header
+ */
+static const char *
+get_basic_header (struct MHD_Connection *connection,
+                  size_t *len)
+{
+  const char *header;
+
+  if ( (NULL == (header = MHD_lookup_connection_value (connection,
+						       MHD_HEADER_KIND,
+						       MHD_HTTP_HEADER_AUTHORIZATION))) ||
+       (0 != strncmp (header,
+                      _BASIC_BASE,
+                      strlen (_BASIC_BASE))) )
+    return NULL;
+  *len = strlen (header);
+  return header;
+}
+
+
+/**
+ * Check if the application recently verified the Basic
+ * authentication header of the request with
+ * #MHD_basic_auth_set_verified().  This neither decodes the header
+ * nor allocates memory.
+ *
+ * @param connection The MHD connection structure
+ * @param[out] username set to the 0-terminated name of the user the
+ *        header was verified as, may be NULL
+ * @param username_size number of bytes in @a username
+ * @return #MHD_YES if the header was verified and has not timed out
+ *         (see #MHD_OPTION_BASIC_AUTH_CACHE_TIMEOUT), #MHD_NO if not,
+ *         if the name does not fit into @a username or if the daemon
+ *         has no cache (see #MHD_OPTION_BASIC_AUTH_CACHE_SIZE)
+ * @ingroup authentication
+ */
+int
+MHD_basic_auth_get_verified (struct MHD_Connection *connection,
+			     char *username,
+			     size_t username_size)
+{
+  const char *header;
+  size_t len;
+
+  if ( (NULL == connection->daemon->basic_auth_cache) ||
+       (NULL == (header = get_basic_header (connection,
+                                            &len))) )
+    return MHD_NO;
+  return MHD_auth_cache_lookup_ (connection->daemon->basic_auth_cache,
+                                 header,
+                                 len,
+                                 username,
+                                 username_size);
+}
+
+
+/**
+ * Tell MHD that the application verified the Basic authentication
+ * header of the request, so that further requests with the same
+ * header are reported by #MHD_basic_auth_get_verified().
+ *
+ * @param connection The MHD connection structure
+ * @param username name of the user the header was verified as
+ * @return #MHD_YES on success, #MHD_NO if the request has no Basic
+ *         authentication header, the name is empty or too long, or
+ *         the daemon has no cache
+ * @ingroup authentication
+ */
+int
+MHD_basic_auth_set_verified (struct MHD_Connection *connection,
+			     const char *username)
+{
+  const char *header;
+  size_t len;
+
+  if ( (NULL == connection->daemon->basic_auth_cache) ||
+       (NULL == (header = get_basic_header (connection,
+                                            &len))) )
+    return MHD_NO;
+  return MHD_auth_cache_store_ (connection->daemon->basic_auth_cache,
+                                header,
+                                len,
+                                username);
+}
+
 /* end of basicauth.c */
@@ -0,0 +1,470 @@
+/*
+  This file is part of libmicrohttpd
+  Copyright (C) 2026 libmicrohttpd contributors
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/**
+ * @file microhttpd/bench_micro.c
+ * @brief  Microbenchmarks of the string, parser and pool primitives
+ * @author libmicrohttpd contributors
+ *
+ * Like the unit tests of mhd_str.c, this program is linked with the
+ * sources of the primitives instead of the library, so each primitive
+ * is timed on its own.  The inputs come from benchmark/corpus.h.
+ * Results are written to stdout as a JSON array with ns/op and
+ * ns/byte for each primitive and input; the time of copying the
+ * input for primitives that modify it is subtracted.
+ *
+ * Usage: bench_micro [MILLISECONDS_PER_BENCHMARK]
+ */
+#include "internal.h"
+#include "mhd_str.h"
+#include "memorypool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "corpus.h"
+
+/**
+ * Number of operations between two reads of the clock.
+ */
+#define BATCH 1024
+
+
+/**
+ * Minimum duration of each benchmark, in microseconds.
+ */
+static uint64_t min_usec = 200000;
+
+/**
+ * Keeps the compiler from dropping results.
+ */
+static volatile size_t sink;
+
+/**
+ * Set once the first result was printed.
+ */
+static int printed;
+
+/**
+ * Content type returned by our #MHD_lookup_connection_value().
+ */
+static const char *content_type;
+
+
+/**
+ * Replacement for the panic handler of the library.
+ */
+static void
+bench_panic (void *cls,
+             const char *file,
+             unsigned int line,
+             const char *reason)
+{
+  (void) cls;
+  fprintf (stderr,
+           "Fatal error in %s:%u: %s\n",
+           file,
+           line,
+           (NULL != reason) ? reason : "");
+  abort ();
+}
+
+MHD_PanicCallback mhd_panic = &bench_panic;
+
+void *mhd_panic_cls = NULL;
+
+
+/**
+ * Replacement for the header lookup of connection.c, used by the
+ * post processor for the content type.
+ */
+const char *
+MHD_lookup_connection_value (struct MHD_Connection *connection,
+                             enum MHD_ValueKind kind,
+                             const char *key)
+{
+  (void) connection; (void) kind; (void) key;
+  return content_type;
+}
+
+
+/**
+ * Get the time from a monotonic clock.
+ *
+ * @return time in microseconds
+ */
+static uint64_t
+now_usec (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/**
+ * Run @a body in batches until #min_usec passed.
+ *
+ * @param ops set to the number of times @a body ran
+ * @param usec set to the time it took
+ * @param body statement to time, may use `i_` (index in the batch)
+ */
+#define BENCH_LOOP(ops,usec,body) do {          \
+    uint64_t start_ = now_usec ();              \
+    (ops) = 0;                                  \
+    do {                                        \
+      unsigned int i_;                          \
+      for (i_ = 0; i_ < BATCH; i_++)            \
+        { body; }                               \
+      (ops) += BATCH;                           \
+      (usec) = now_usec () - start_;            \
+    } while ((usec) < min_usec);                \
+  } while (0)
+
+
+/**
+ * Print the result of a benchmark.
+ *
+ * @param name name of the primitive
+ * @param input name of the input
+ * @param ops number of operations
+ * @param bytes_per_op input bytes per operation
+ * @param usec time of all operations
+ * @param overhead_ns time per operation to subtract (copying)
+ */
+static void
+report (const char *name,
+        const char *input,
+        uint64_t ops,
+        double bytes_per_op,
+        uint64_t usec,
+        double overhead_ns)
+{
+  double ns = usec * 1000.0 / ops - overhead_ns;
+
+  if (ns < 0)
+    ns = 0;
+  printf ("%s  {\"primitive\": \"%s\", \"input\": \"%s\", \"ops\": %llu, "
+          "\"bytes_per_op\": %.1f, \"ns_per_op\": %.2f, \"ns_per_byte\": %.3f}",
+          printed ? ",\n" : "",
+          name,
+          input,
+          (unsigned long long) ops,
+          bytes_per_op,
+          ns,
+          (bytes_per_op > 0) ? ns / bytes_per_op : 0.0);
+  printed = 1;
+  fflush (stdout);
+}
+
+
+/**
+ * Time copying @a len bytes, to be subtracted from primitives that
+ * need a fresh copy of their input.
+ *
+ * @return nanoseconds per copy
+ */
+static double
+copy_cost (char *buf,
+           const char *src,
+           size_t len)
+{
+  uint64_t ops;
+  uint64_t usec;
+
+  BENCH_LOOP (ops, usec,
+              memcpy (buf, src, len + 1);
+              sink += (unsigned char) buf[i_ % (len + 1)]);
+  return usec * 1000.0 / ops;
+}
+
+
+static void
+bench_str (void)
+{
+  static const char *known[] = {
+    MHD_HTTP_HEADER_HOST,
+    MHD_HTTP_HEADER_CONNECTION,
+    MHD_HTTP_HEADER_CONTENT_LENGTH,
+    MHD_HTTP_HEADER_CONTENT_TYPE,
+    MHD_HTTP_HEADER_TRANSFER_ENCODING,
+    MHD_HTTP_HEADER_COOKIE,
+    MHD_HTTP_HEADER_EXPECT,
+    MHD_HTTP_HEADER_UPGRADE
+  };
+  static const char *decimal[] = {
+    "0", "17", "1024", "65536", "4294967296", "18446744073709551615"
+  };
+  static const char *hex[] = {
+    "0", "a", "1f4", "2000", "ffff", "7fffffff"
+  };
+  char names[64][64];
+  size_t name_len[64];
+  unsigned int num_names;
+  unsigned int num_known = sizeof (known) / sizeof (known[0]);
+  unsigned int i;
+  const char *line;
+  const char *colon;
+  uint64_t ops;
+  uint64_t usec;
+  uint64_t u64;
+  size_t sz;
+  size_t bytes;
+
+  /* the header names of all request heads */
+  num_names = 0;
+  bytes = 0;
+  for (i = 0; NULL != corpus_heads[i].name; i++)
+    for (line = strstr (corpus_heads[i].data, "\r\n");
+         NULL != line;
+         line = strstr (line, "\r\n"))
+      {
+        line += 2;
+        colon = strchr (line, ':');
+        if ( (NULL == colon) ||
+             (colon - line >= 64) ||
+             (num_names == 64) ||
+             (NULL != memchr (line, '\r', colon - line)) )
+          continue;
+        memcpy (names[num_names], line, colon - line);
+        names[num_names][colon - line] = '\0';
+        name_len[num_names] = colon - line;
+        bytes += name_len[num_names];
+        num_names++;
+      }
+  if (0 == num_names)
+    return;
+  BENCH_LOOP (ops, usec,
+              sink += MHD_str_equal_caseless_ (names[i_ % num_names],
+                                               known[i_ % num_known]));
+  report ("MHD_str_equal_caseless_", "header_names", ops,
+          (double) bytes / num_names, usec, 0);
+
+  bytes = 0;
+  for (i = 0; i < 6; i++)
+    bytes += strlen (decimal[i]);
+  BENCH_LOOP (ops, usec,
+              sink += MHD_str_to_uint64_n_ (decimal[i_ % 6],
+                                            20,
+                                            &u64);
+              sink += (size_t) u64);
+  report ("MHD_str_to_uint64_n_", "content_lengths", ops,
+          bytes / 6.0, usec, 0);
+
+  bytes = 0;
+  for (i = 0; i < 6; i++)
+    bytes += strlen (hex[i]);
+  BENCH_LOOP (ops, usec,
+              sink += MHD_strx_to_sizet_n_ (hex[i_ % 6],
+                                            16,
+                                            &sz);
+              sink += sz);
+  report ("MHD_strx_to_sizet_n_", "chunk_sizes", ops,
+          bytes / 6.0, usec, 0);
+}
+
+
+static int
+count_argument (struct MHD_Connection *connection,
+                const char *key,
+                const char *value,
+                enum MHD_ValueKind kind)
+{
+  (void) connection; (void) kind;
+  sink += (unsigned char) key[0];
+  if (NULL != value)
+    sink += (unsigned char) value[0];
+  return MHD_YES;
+}
+
+
+static void
+bench_arguments (void)
+{
+  struct MHD_Daemon daemon;
+  struct MHD_Connection connection;
+  char buf[1024];
+  unsigned int num;
+  unsigned int i;
+  size_t len;
+  uint64_t ops;
+  uint64_t usec;
+  double copy;
+
+  memset (&daemon, 0, sizeof (daemon));
+  memset (&connection, 0, sizeof (connection));
+  daemon.unescape_callback = &MHD_unescape_wrapper_;
+  connection.daemon = &daemon;
+  for (i = 0; NULL != corpus_queries[i].name; i++)
+    {
+      len = strlen (corpus_queries[i].data);
+      if (len >= sizeof (buf))
+        continue;
+      copy = copy_cost (buf, corpus_queries[i].data, len);
+      BENCH_LOOP (ops, usec,
+                  memcpy (buf, corpus_queries[i].data, len + 1);
+                  sink += MHD_http_unescape (buf));
+      report ("MHD_http_unescape", corpus_queries[i].name, ops,
+              len, usec, copy);
+      BENCH_LOOP (ops, usec,
+                  memcpy (buf, corpus_queries[i].data, len + 1);
+                  MHD_parse_arguments_ (&connection,
+                                        MHD_GET_ARGUMENT_KIND,
+                                        buf,
+                                        &count_argument,
+                                        &num);
+                  sink += num);
+      report ("MHD_parse_arguments_", corpus_queries[i].name, ops,
+              len, usec, copy);
+    }
+}
+
+
+#ifdef HAVE_POSTPROCESSOR
+static int
+count_post_data (void *cls,
+                 enum MHD_ValueKind kind,
+                 const char *key,
+                 const char *filename,
+                 const char *content_type,
+                 const char *transfer_encoding,
+                 const char *data,
+                 uint64_t off,
+                 size_t size)
+{
+  (void) cls; (void) kind; (void) key; (void) filename;
+  (void) content_type; (void) transfer_encoding; (void) data; (void) off;
+  sink += size;
+  return MHD_YES;
+}
+
+
+/**
+ * Parse a POST body once.
+ *
+ * @param body the body
+ * @param len size of @a body
+ * @param segment size of the parts the body is given in
+ */
+static void
+post_once (const char *body,
+           size_t len,
+           size_t segment)
+{
+  struct MHD_Connection connection;
+  struct MHD_PostProcessor *pp;
+  size_t off;
+  size_t n;
+
+  pp = MHD_create_post_processor (&connection,
+                                  1024,
+                                  &count_post_data,
+                                  NULL);
+  if (NULL == pp)
+    abort ();
+  for (off = 0; off < len; off += n)
+    {
+      n = (len - off < segment) ? len - off : segment;
+      MHD_post_process (pp, &body[off], n);
+    }
+  MHD_destroy_post_processor (pp);
+}
+
+
+static void
+bench_post (void)
+{
+  uint64_t ops;
+  uint64_t usec;
+
+  content_type = MHD_HTTP_POST_ENCODING_FORM_URLENCODED;
+  BENCH_LOOP (ops, usec,
+              post_once (corpus_urlencoded,
+                         strlen (corpus_urlencoded),
+                         SIZE_MAX));
+  report ("MHD_post_process", "urlencoded", ops,
+          strlen (corpus_urlencoded), usec, 0);
+  content_type = MHD_HTTP_POST_ENCODING_MULTIPART_FORMDATA
+    "; boundary=" CORPUS_BOUNDARY;
+  BENCH_LOOP (ops, usec,
+              post_once (corpus_multipart,
+                         strlen (corpus_multipart),
+                         SIZE_MAX));
+  report ("MHD_post_process", "multipart", ops,
+          strlen (corpus_multipart), usec, 0);
+  /* as received in small TCP segments */
+  BENCH_LOOP (ops, usec,
+              post_once (corpus_multipart,
+                         strlen (corpus_multipart),
+                         64));
+  report ("MHD_post_process", "multipart_64", ops,
+          strlen (corpus_multipart), usec, 0);
+}
+#endif
+
+
+static void
+bench_pool (void)
+{
+  struct MemoryPool *pool;
+  char *read_buffer;
+  size_t size = 32 * 1024;
+  unsigned int j;
+  uint64_t ops;
+  uint64_t usec;
+
+  pool = MHD_pool_create (size);
+  if (NULL == pool)
+    return;
+  read_buffer = MHD_pool_allocate (pool, size / 2, MHD_NO);
+  /* one request on a connection: header entries from the end, the
+     read buffer grows once, then the reset for keep-alive */
+  BENCH_LOOP (ops, usec,
+              for (j = 0; j < 12; j++)
+                sink += (size_t) MHD_pool_allocate (pool, 48, MHD_YES);
+              read_buffer = MHD_pool_reallocate (pool,
+                                                 read_buffer,
+                                                 size / 2,
+                                                 size / 2 + 4096);
+              read_buffer = MHD_pool_reset (pool,
+                                            read_buffer,
+                                            64,
+                                            size / 2));
+  report ("MHD_pool_allocate/reallocate/reset", "request_cycle", ops,
+          12 * 48 + 4096 + 64, usec, 0);
+  MHD_pool_destroy (pool);
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  if (argc > 1)
+    min_usec = (uint64_t) strtoul (argv[1], NULL, 10) * 1000;
+  printf ("[\n");
+  bench_str ();
+  bench_arguments ();
+#ifdef HAVE_POSTPROCESSOR
+  bench_post ();
+#endif
+  bench_pool ();
+  printf ("\n]\n");
+  return 0;
+}
@@ -0,0 +1,926 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file compression.c
+ * @brief gzip/deflate content coding of HTTP bodies; this file is
+ *        only compiled if ENABLE_COMPRESSION is set
+ * @author libmicrohttpd contributors
+ */
+
+#include "compression.h"
+#include "connection.h"
+#include "mhd_str.h"
+#include "mhd_locks.h"
+#include "mhd_limits.h"
+#include <zlib.h>
+
+/**
+ * Content codings we can produce.  Used as index
+ * into `zstream_pool` of `struct MHD_Daemon`.
+ */
+enum MHD_ContentCoding
+{
+  MHD_CODING_GZIP = 0,
+  MHD_CODING_DEFLATE = 1,
+  MHD_CODING_NONE = 2
+};
+
+/**
+ * Maximum number of idle streams each daemon (or worker) keeps
+ * around for reuse.  A deflate stream takes about 256 KiB, so we
+ * do not want to keep the peak number forever.
+ */
+#define MHD_ZSTREAM_POOL_MAX 32
+
+/**
+ * Size of the buffer for data from the content reader callback.
+ */
+#define MHD_ZSTREAM_INPUT_SIZE (16 * 1024)
+
+
+/**
+ * A reusable deflate stream.
+ */
+struct MHD_ZStream
+{
+  /**
+   * Next stream in the daemon's free list.
+   */
+  struct MHD_ZStream *next;
+
+  /**
+   * The zlib state.
+   */
+  z_stream zs;
+
+  /**
+   * Content coding produced by @e zs.
+   */
+  enum MHD_ContentCoding coding;
+
+  /**
+   * #MHD_YES once all input was handed to zlib.
+   */
+  int input_done;
+
+  /**
+   * #MHD_YES once zlib emitted the trailer.
+   */
+  int finished;
+
+  /**
+   * Buffer for data obtained from the content reader callback.
+   * Data of buffer-based responses is compressed in place.
+   */
+  Bytef in_buf[MHD_ZSTREAM_INPUT_SIZE];
+};
+
+
+/**
+ * Size of the buffer for inflated request body data.
+ */
+#define MHD_ZINFLATE_OUTPUT_SIZE (16 * 1024)
+
+
+/**
+ * An inflate stream for a compressed request body.
+ */
+struct MHD_ZInflate
+{
+  /**
+   * The zlib state.
+   */
+  z_stream zs;
+
+  /**
+   * Total number of bytes inflated so far.
+   */
+  uint64_t total;
+
+  /**
+   * Offset of the first byte in @e out_buf the application
+   * did not process yet.
+   */
+  size_t out_off;
+
+  /**
+   * Number of valid bytes in @e out_buf.
+   */
+  size_t out_len;
+
+  /**
+   * #MHD_YES if zlib reported the end of the compressed data.
+   */
+  int finished;
+
+  /**
+   * Inflated data for the application.
+   */
+  Bytef out_buf[MHD_ZINFLATE_OUTPUT_SIZE];
+};
+
+
+/**
+ * Lock the stream pool of @a daemon if other threads may use it.
+ *
+ * @param daemon daemon owning the pool
+ */
+static void
+zstream_pool_lock (struct MHD_Daemon *daemon)
+{
+  if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
+}
+
+
+/**
+ * Unlock the stream pool of @a daemon.
+ *
+ * @param daemon daemon owning the pool
+ */
+static void
+zstream_pool_unlock (struct MHD_Daemon *daemon)
+{
+  if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
+}
+
+
+/**
+ * Get a deflate stream for @a coding, reusing a pooled one if
+ * possible.
+ *
+ * @param daemon daemon to take the stream from
+ * @param coding desired content coding
+ * @return NULL on error (out of memory)
+ */
+static struct MHD_ZStream *
+zstream_acquire (struct MHD_Daemon *daemon,
+                 enum MHD_ContentCoding coding)
+{
+  struct MHD_ZStream *zs;
+
+  zstream_pool_lock (daemon);
+  zs = daemon->zstream_pool[coding];
+  if (NULL != zs)
+    {
+      daemon->zstream_pool[coding] = zs->next;
+      daemon->zstream_pool_size--;
+    }
+  zstream_pool_unlock (daemon);
+  if (NULL != zs)
+    {
+      if (Z_OK != deflateReset (&zs->zs))
+        {
+          deflateEnd (&zs->zs);
+          free (zs);
+          return NULL;
+        }
+    }
+  else
+    {
+      zs = malloc (sizeof (struct MHD_ZStream));
+      if (NULL == zs)
+        return NULL;
+      memset (&zs->zs,
+              0,
+              sizeof (z_stream));
+      /* windowBits + 16 makes zlib write a gzip header and trailer */
+      if (Z_OK != deflateInit2 (&zs->zs,
+                                Z_DEFAULT_COMPRESSION,
+                                Z_DEFLATED,
+                                (MHD_CODING_GZIP == coding) ? 15 + 16 : 15,
+                                8,
+                                Z_DEFAULT_STRATEGY))
+        {
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (daemon,
+                    _("Failed to initialize deflate stream\n"));
+#endif
+          free (zs);
+          return NULL;
+        }
+      zs->coding = coding;
+    }
+  zs->next = NULL;
+  zs->input_done = MHD_NO;
+  zs->finished = MHD_NO;
+  return zs;
+}
+
+
+/**
+ * Return @a zs to the pool of @a daemon (or free it if the
+ * pool is full).
+ *
+ * @param daemon daemon to return the stream to
+ * @param zs stream to release
+ */
+static void
+zstream_release (struct MHD_Daemon *daemon,
+                 struct MHD_ZStream *zs)
+{
+  zstream_pool_lock (daemon);
+  if (daemon->zstream_pool_size < MHD_ZSTREAM_POOL_MAX)
+    {
+      zs->next = daemon->zstream_pool[zs->coding];
+      daemon->zstream_pool[zs->coding] = zs;
+      daemon->zstream_pool_size++;
+      zs = NULL;
+    }
+  zstream_pool_unlock (daemon);
+  if (NULL != zs)
+    {
+      deflateEnd (&zs->zs);
+      free (zs);
+    }
+}
+
+
+/**
+ * Check if a "q" parameter value means "not acceptable",
+ * that is if it is zero ("0", "0.", "0.0", ...).
+ *
+ * @param q the value, not 0-terminated
+ * @param len number of characters in @a q
+ * @return #MHD_YES if @a q is zero
+ */
+static int
+qvalue_is_zero (const char *q,
+                size_t len)
+{
+  size_t i;
+
+  if ( (0 == len) ||
+       ('0' != q[0]) )
+    return MHD_NO;
+  if (1 == len)
+    return MHD_YES;
+  if ('.' != q[1])
+    return MHD_NO;
+  for (i = 2; i < len; i++)
+    if ('0' != q[i])
+      return MHD_NO;
+  return MHD_YES;
+}
+
+
+/**
+ * Pick the content coding to use based on the value
+ * of the "Accept-Encoding" header of the request.
+ * We prefer "gzip" over "deflate".
+ *
+ * @param header value of the "Accept-Encoding" header
+ * @return the coding to use, #MHD_CODING_NONE if neither
+ *         is acceptable to the client
+ */
+static enum MHD_ContentCoding
+parse_accept_encoding (const char *header)
+{
+  /* -1: not mentioned, 0: refused, 1: accepted */
+  int gzip = -1;
+  int deflate = -1;
+  int any = -1;
+  const char *pos = header;
+
+  while ('\0' != *pos)
+    {
+      const char *coding;
+      size_t coding_len;
+      int accepted;
+
+      while ( (' ' == *pos) ||
+              ('\t' == *pos) ||
+              (',' == *pos) )
+        pos++;
+      if ('\0' == *pos)
+        break;
+      coding = pos;
+      while ( ('\0' != *pos) &&
+              (',' != *pos) &&
+              (';' != *pos) &&
+              (' ' != *pos) &&
+              ('\t' != *pos) )
+        pos++;
+      coding_len = pos - coding;
+      accepted = 1;
+      /* parameters, we only care about "q" */
+      while ( ('\0' != *pos) &&
+              (',' != *pos) )
+        {
+          const char *val;
+
+          if ( (';' != *pos) &&
+               (' ' != *pos) &&
+               ('\t' != *pos) )
+            {
+              pos++;
+              continue;
+            }
+          pos++;
+          while ( (' ' == *pos) ||
+                  ('\t' == *pos) )
+            pos++;
+          if ( ( ('q' != *pos) &&
+                 ('Q' != *pos) ) ||
+               ('=' != pos[1]) )
+            continue;
+          pos += 2;
+          val = pos;
+          while ( ('\0' != *pos) &&
+                  (',' != *pos) &&
+                  (';' != *pos) &&
+                  (' ' != *pos) &&
+                  ('\t' != *pos) )
+            pos++;
+          if (MHD_YES == qvalue_is_zero (val,
+                                         pos - val))
+            accepted = 0;
+        }
+      if ( ( (4 == coding_len) &&
+             (MHD_str_equal_caseless_n_ (coding,
+                                         "gzip",
+                                         4)) ) ||
+           ( (6 == coding_len) &&
+             (MHD_str_equal_caseless_n_ (coding,
+                                         "x-gzip",
+                                         6)) ) )
+        gzip = accepted;
+      else if ( (7 == coding_len) &&
+                (MHD_str_equal_caseless_n_ (coding,
+                                            "deflate",
+                                            7)) )
+        deflate = accepted;
+      else if ( (1 == coding_len) &&
+                ('*' == coding[0]) )
+        any = accepted;
+    }
+  if (-1 == gzip)
+    gzip = (1 == any) ? 1 : 0;
+  if (-1 == deflate)
+    deflate = (1 == any) ? 1 : 0;
+  if (1 == gzip)
+    return MHD_CODING_GZIP;
+  if (1 == deflate)
+    return MHD_CODING_DEFLATE;
+  return MHD_CODING_NONE;
+}
+
+
+/**
+ * Check if the given content type denotes data that is already
+ * compressed, so that compressing it again would only waste CPU.
+ *
+ * @param ctype value of the "Content-Type" header
+ * @return #MHD_YES if the data is (most likely) compressed
+ */
+static int
+is_precompressed_type (const char *ctype)
+{
+  static const char *const prefixes[] = {
+    "image/",
+    "audio/",
+    "video/",
+    "font/woff",
+    "application/zip",
+    "application/gzip",
+    "application/x-gzip",
+    "application/x-bzip2",
+    "application/x-xz",
+    "application/x-7z-compressed",
+    "application/x-rar-compressed",
+    "application/zstd",
+    "application/font-woff",
+    NULL
+  };
+  unsigned int i;
+
+  for (i = 0; NULL != prefixes[i]; i++)
+    {
+      const size_t len = strlen (prefixes[i]);
+
+      if (MHD_str_equal_caseless_n_ (ctype,
+                                     prefixes[i],
+                                     len))
+        {
+          /* SVG is plain XML and compresses well */
+          if ( (0 == i) &&
+               (MHD_str_equal_caseless_n_ (ctype,
+                                           "image/svg+xml",
+                                           strlen ("image/svg+xml"))) )
+            return MHD_NO;
+          return MHD_YES;
+        }
+    }
+  return MHD_NO;
+}
+
+
+/**
+ * Decide whether the body of the response queued for @a connection
+ * should be compressed and if so, take a deflate stream from the
+ * daemon's pool and attach it to the connection.
+ *
+ * @param connection connection with a queued response
+ * @param[out] vary set to #MHD_YES if the response is eligible for
+ *        compression (and thus depends on "Accept-Encoding"),
+ *        #MHD_NO otherwise
+ * @return #MHD_YES if the body will be compressed
+ */
+int
+MHD_compression_start_ (struct MHD_Connection *connection,
+                        int *vary)
+{
+  struct MHD_Daemon *daemon = connection->daemon;
+  struct MHD_Response *response = connection->response;
+  const uint32_t rc = connection->responseCode & (~MHD_ICY_FLAG);
+  const char *ctype;
+  const char *accept;
+  enum MHD_ContentCoding coding;
+
+  *vary = MHD_NO;
+  EXTRA_CHECK (NULL == connection->zstream);
+  if ( (MHD_YES != daemon->compress_responses) ||
+       (NULL != response->upgrade_handler) ||
+       (-1 != response->fd) ||
+       (0 != (connection->responseCode & MHD_ICY_FLAG)) ||
+       (MHD_HTTP_OK > rc) ||
+       (MHD_HTTP_NO_CONTENT == rc) ||
+       (MHD_HTTP_PARTIAL_CONTENT == rc) ||
+       (MHD_HTTP_NOT_MODIFIED == rc) ||
+       (0 == response->total_size) ||
+       ( (MHD_SIZE_UNKNOWN != response->total_size) &&
+         (response->total_size < daemon->compress_min_size) ) ||
+       (NULL != MHD_get_response_header (response,
+                                         MHD_HTTP_HEADER_CONTENT_ENCODING)) )
+    return MHD_NO;
+  ctype = MHD_get_response_header (response,
+                                   MHD_HTTP_HEADER_CONTENT_TYPE);
+  if ( (NULL != ctype) &&
+       (MHD_YES == is_precompressed_type (ctype)) )
+    return MHD_NO;
+  *vary = MHD_YES;
+  /* HEAD requests: body is never sent */
+  if (connection->response_write_position == response->total_size)
+    return MHD_NO;
+  /* compressed bodies are delimited with chunked encoding */
+  if ( (NULL == connection->version) ||
+       (! MHD_str_equal_caseless_ (connection->version,
+                                   MHD_HTTP_VERSION_1_1)) )
+    return MHD_NO;
+  accept = MHD_lookup_connection_value (connection,
+                                        MHD_HEADER_KIND,
+                                        MHD_HTTP_HEADER_ACCEPT_ENCODING);
+  if (NULL == accept)
+    return MHD_NO;
+  coding = parse_accept_encoding (accept);
+  if (MHD_CODING_NONE == coding)
+    return MHD_NO;
+  connection->zstream = zstream_acquire (daemon,
+                                         coding);
+  if (NULL == connection->zstream)
+    return MHD_NO; /* send uncompressed */
+  return MHD_YES;
+}
+
+
+/**
+ * Return the deflate stream of @a connection (if any) to the
+ * daemon's pool.
+ *
+ * @param connection connection to detach the stream from
+ */
+void
+MHD_compression_stop_ (struct MHD_Connection *connection)
+{
+  if (NULL == connection->zstream)
+    return;
+  zstream_release (connection->daemon,
+                   connection->zstream);
+  connection->zstream = NULL;
+}
+
+
+/**
+ * Name of the content coding produced by @a zs, for the
+ * "Content-Encoding" header.
+ *
+ * @param zs stream to inspect
+ * @return "gzip" or "deflate"
+ */
+const char *
+MHD_compression_coding_ (const struct MHD_ZStream *zs)
+{
+  return (MHD_CODING_GZIP == zs->coding) ? "gzip" : "deflate";
+}
+
+
+/**
+ * Hand the next piece of the response body to zlib.  Buffer-based
+ * responses are passed without copying, for responses created
+ * with a content reader callback the callback writes into the
+ * stream's input buffer.
+ *
+ * @param connection connection to read the response of
+ * @return number of bytes made available to zlib (0 if the
+ *         application has no data right now),
+ *         #MHD_CONTENT_READER_END_OF_STREAM or
+ *         #MHD_CONTENT_READER_END_WITH_ERROR
+ */
+static ssize_t
+zstream_fill (struct MHD_Connection *connection)
+{
+  struct MHD_Response *response = connection->response;
+  struct MHD_ZStream *zs = connection->zstream;
+  uint64_t left;
+  ssize_t ret;
+
+  if (MHD_SIZE_UNKNOWN != response->total_size)
+    {
+      left = response->total_size - connection->response_write_position;
+      if (0 == left)
+        return MHD_CONTENT_READER_END_OF_STREAM;
+    }
+  else
+    left = UINT64_MAX;
+  if (NULL == response->crc)
+    {
+      /* data is all in memory, zlib can read it directly; feed it
+         in pieces so that zlib's 'uInt' counters cannot overflow */
+      const size_t off = (size_t) (connection->response_write_position -
+                                   response->data_start);
+
+      ret = (ssize_t) MHD_MIN (left,
+                               (uint64_t) (1024 * 1024 * 1024));
+      zs->zs.next_in = (Bytef *) &response->data[off];
+    }
+  else
+    {
+      const uint64_t start = MHD_stall_timer_start_ (connection->daemon);
+
+      ret = response->crc (response->crc_cls,
+                           connection->response_write_position,
+                           (char *) zs->in_buf,
+                           (size_t) MHD_MIN (left,
+                                             (uint64_t) sizeof (zs->in_buf)));
+      MHD_stall_timer_check_ (connection,
+                              MHD_STALL_CONTENT_READER,
+                              start);
+      if ( (((ssize_t) MHD_CONTENT_READER_END_OF_STREAM) == ret) ||
+           (((ssize_t) MHD_CONTENT_READER_END_WITH_ERROR) == ret) )
+        {
+          response->total_size = connection->response_write_position;
+          return ret;
+        }
+      zs->zs.next_in = zs->in_buf;
+    }
+  zs->zs.avail_in = (uInt) ret;
+  connection->response_write_position += ret;
+  return ret;
+}
+
+
+/**
+ * Produce the next piece of the compressed body.  Reads the
+ * response data (calling the content reader callback if needed,
+ * the response mutex must be held in this case) and compresses it
+ * into @a out.
+ *
+ * @param connection connection with an attached deflate stream
+ * @param out where to write compressed data
+ * @param out_size number of bytes available in @a out
+ * @param[out] produced set to the number of bytes written to @a out
+ * @return #MHD_COMPRESSION_OK on success
+ */
+enum MHD_CompressionResult
+MHD_compression_deflate_ (struct MHD_Connection *connection,
+                          char *out,
+                          size_t out_size,
+                          size_t *produced)
+{
+  struct MHD_ZStream *zs = connection->zstream;
+  int stalled;
+  int flush;
+  int zret;
+
+  EXTRA_CHECK (MHD_NO == zs->finished);
+  zs->zs.next_out = (Bytef *) out;
+  zs->zs.avail_out = (uInt) out_size;
+  stalled = MHD_NO;
+  while (1)
+    {
+      if ( (0 == zs->zs.avail_in) &&
+           (MHD_NO == zs->input_done) )
+        {
+          ssize_t ret;
+
+          ret = zstream_fill (connection);
+          if (((ssize_t) MHD_CONTENT_READER_END_WITH_ERROR) == ret)
+            return MHD_COMPRESSION_ERROR;
+          if (((ssize_t) MHD_CONTENT_READER_END_OF_STREAM) == ret)
+            zs->input_done = MHD_YES;
+          else if (0 == ret)
+            stalled = MHD_YES;
+          else if ( (MHD_SIZE_UNKNOWN != connection->response->total_size) &&
+                    (connection->response_write_position ==
+                     connection->response->total_size) )
+            zs->input_done = MHD_YES;
+        }
+      if (MHD_YES == zs->input_done)
+        flush = Z_FINISH;
+      else if (MHD_YES == stalled)
+        flush = Z_SYNC_FLUSH; /* push out what we have while we wait */
+      else
+        flush = Z_NO_FLUSH;
+      zret = deflate (&zs->zs,
+                      flush);
+      if (Z_STREAM_END == zret)
+        {
+          zs->finished = MHD_YES;
+          break;
+        }
+      if ( (Z_OK != zret) &&
+           (Z_BUF_ERROR != zret) )
+        {
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (connection->daemon,
+                    _("Failed to compress response data: %s\n"),
+                    (NULL != zs->zs.msg) ? zs->zs.msg : "?");
+#endif
+          return MHD_COMPRESSION_ERROR;
+        }
+      if ( (0 == zs->zs.avail_out) ||
+           (MHD_YES == stalled) )
+        break;
+    }
+  *produced = out_size - zs->zs.avail_out;
+  if ( (0 == *produced) &&
+       (MHD_NO == zs->finished) )
+    return MHD_COMPRESSION_AGAIN;
+  return MHD_COMPRESSION_OK;
+}
+
+
+/**
+ * Check if the stream has emitted all compressed data,
+ * including the trailer.
+ *
+ * @param zs stream to check
+ * @return #MHD_YES if done
+ */
+int
+MHD_compression_finished_ (const struct MHD_ZStream *zs)
+{
+  return zs->finished;
+}
+
+
+/**
+ * Set up inflating of the request body of @a connection if the
+ * client sent it with a "Content-Encoding" we can decode and
+ * #MHD_OPTION_REQUEST_DECOMPRESSION is enabled.
+ *
+ * @param connection connection that has received the request headers
+ * @return #MHD_NO on error (out of memory), #MHD_YES otherwise
+ */
+int
+MHD_compression_inflate_start_ (struct MHD_Connection *connection)
+{
+  struct MHD_ZInflate *zi;
+  const char *enc;
+
+  EXTRA_CHECK (NULL == connection->zinflate);
+  if (0 == connection->daemon->inflate_max_size)
+    return MHD_YES;
+  enc = MHD_lookup_connection_value (connection,
+                                     MHD_HEADER_KIND,
+                                     MHD_HTTP_HEADER_CONTENT_ENCODING);
+  if ( (NULL == enc) ||
+       ( (! MHD_str_equal_caseless_ (enc,
+                                     "gzip")) &&
+         (! MHD_str_equal_caseless_ (enc,
+                                     "x-gzip")) &&
+         (! MHD_str_equal_caseless_ (enc,
+                                     "deflate")) ) )
+    return MHD_YES; /* pass body to the application as-is */
+  zi = malloc (sizeof (struct MHD_ZInflate));
+  if (NULL == zi)
+    return MHD_NO;
+  memset (&zi->zs,
+          0,
+          sizeof (z_stream));
+  /* windowBits + 32 makes zlib detect gzip and zlib headers */
+  if (Z_OK != inflateInit2 (&zi->zs,
+                            15 + 32))
+    {
+#ifdef HAVE_MESSAGES
+      MHD_DLOG (connection->daemon,
+                _("Failed to initialize inflate stream\n"));
+#endif
+      free (zi);
+      return MHD_NO;
+    }
+  zi->total = 0;
+  zi->out_off = 0;
+  zi->out_len = 0;
+  zi->finished = MHD_NO;
+  connection->zinflate = zi;
+  return MHD_YES;
+}
+
+
+/**
+ * Release the inflate stream of @a connection (if any).
+ *
+ * @param connection connection to detach the stream from
+ */
+void
+MHD_compression_inflate_stop_ (struct MHD_Connection *connection)
+{
+  if (NULL == connection->zinflate)
+    return;
+  inflateEnd (&connection->zinflate->zs);
+  free (connection->zinflate);
+  connection->zinflate = NULL;
+}
+
+
+/**
+ * Get the next piece of the decompressed request body.  If data
+ * inflated earlier was not yet consumed (see
+ * #MHD_compression_inflate_consumed_()) it is returned again and
+ * no input is used, otherwise compressed data from @a in is
+ * inflated.
+ *
+ * @param connection connection with an attached inflate stream
+ * @param in compressed request body data
+ * @param[in,out] in_size number of bytes at @a in, set to the
+ *        number of bytes that were not used
+ * @param[out] out set to the decompressed data
+ * @param[out] out_size set to the number of bytes at @a out
+ * @return #MHD_COMPRESSION_OK if data was returned,
+ *         #MHD_COMPRESSION_AGAIN if more input is needed,
+ *         #MHD_COMPRESSION_ERROR if the data is corrupt or
+ *         inflates to more than the configured limit
+ */
+enum MHD_CompressionResult
+MHD_compression_inflate_ (struct MHD_Connection *connection,
+                          const char *in,
+                          size_t *in_size,
+                          const char **out,
+                          size_t *out_size)
+{
+  struct MHD_ZInflate *zi = connection->zinflate;
+  const size_t limit = connection->daemon->inflate_max_size;
+  size_t avail;
+  int zret;
+
+  if (zi->out_off < zi->out_len)
+    {
+      *out = (const char *) &zi->out_buf[zi->out_off];
+      *out_size = zi->out_len - zi->out_off;
+      return MHD_COMPRESSION_OK;
+    }
+  zi->out_off = 0;
+  zi->out_len = 0;
+  while (0 != *in_size)
+    {
+      if (MHD_YES == zi->finished)
+        {
+          /* another gzip member follows */
+          if (Z_OK != inflateReset (&zi->zs))
+            return MHD_COMPRESSION_ERROR;
+          zi->finished = MHD_NO;
+        }
+      /* never inflate more than one byte past the limit */
+      avail = sizeof (zi->out_buf);
+      if (limit - zi->total < (uint64_t) avail)
+        avail = (size_t) (limit - zi->total) + 1;
+      zi->zs.next_in = (Bytef *) in;
+      zi->zs.avail_in = (uInt) MHD_MIN (*in_size,
+                                        (size_t) UINT_MAX);
+      zi->zs.next_out = zi->out_buf;
+      zi->zs.avail_out = (uInt) avail;
+      zret = inflate (&zi->zs,
+                      Z_NO_FLUSH);
+      *in_size -= (const char *) zi->zs.next_in - in;
+      in = (const char *) zi->zs.next_in;
+      zi->out_len = avail - zi->zs.avail_out;
+      zi->total += zi->out_len;
+      if (Z_STREAM_END == zret)
+        zi->finished = MHD_YES;
+      else if ( (Z_OK != zret) &&
+                (Z_BUF_ERROR != zret) )
+        {
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (connection->daemon,
+                    _("Failed to inflate request body: %s\n"),
+                    (NULL != zi->zs.msg) ? zi->zs.msg : "?");
+#endif
+          return MHD_COMPRESSION_ERROR;
+        }
+      if (zi->total > (uint64_t) limit)
+        {
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (connection->daemon,
+                    _("Decompressed request body exceeds limit of %llu bytes\n"),
+                    (unsigned long long) limit);
+#endif
+          return MHD_COMPRESSION_ERROR;
+        }
+      if (0 != zi->out_len)
+        {
+          *out = (const char *) zi->out_buf;
+          *out_size = zi->out_len;
+          return MHD_COMPRESSION_OK;
+        }
+    }
+  return MHD_COMPRESSION_AGAIN;
+}
+
+
+/**
+ * Mark @a size bytes of the data returned by the last call to
+ * #MHD_compression_inflate_() as processed by the application.
+ *
+ * @param zi inflate stream to update
+ * @param size number of bytes processed
+ */
+void
+MHD_compression_inflate_consumed_ (struct MHD_ZInflate *zi,
+                                   size_t size)
+{
+  EXTRA_CHECK (zi->out_off + size <= zi->out_len);
+  zi->out_off += size;
+}
+
+
+/**
+ * Check if @a zi holds decompressed data the application did
+ * not process yet.
+ *
+ * @param zi stream to check
+ * @return #MHD_YES if data is pending
+ */
+int
+MHD_compression_inflate_pending_ (const struct MHD_ZInflate *zi)
+{
+  return (zi->out_off < zi->out_len) ? MHD_YES : MHD_NO;
+}
+
+
+/**
+ * Check if @a zi has seen the end of the compressed data.
+ *
+ * @param zi stream to check
+ * @return #MHD_YES if the compressed body was complete
+ */
+int
+MHD_compression_inflate_finished_ (const struct MHD_ZInflate *zi)
+{
+  return zi->finished;
+}
+
+
+/**
+ * Release all pooled streams of the given daemon.  Must only be
+ * called once no connection of @a daemon uses a stream anymore.
+ *
+ * @param daemon daemon to clean up
+ */
+void
+MHD_compression_daemon_cleanup_ (struct MHD_Daemon *daemon)
+{
+  struct MHD_ZStream *zs;
+  unsigned int i;
+
+  for (i = 0; i < sizeof (daemon->zstream_pool) / sizeof (daemon->zstream_pool[0]); i++)
+    {
+      while (NULL != (zs = daemon->zstream_pool[i]))
+        {
+          daemon->zstream_pool[i] = zs->next;
+          deflateEnd (&zs->zs);
+          free (zs);
+        }
+    }
+  daemon->zstream_pool_size = 0;
+}
+
+/* end of compression.c */
@@ -0,0 +1,215 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file compression.h
+ * @brief gzip/deflate content coding of HTTP bodies; this file is
+ *        only compiled if ENABLE_COMPRESSION is set
+ * @author libmicrohttpd contributors
+ */
+
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include "internal.h"
+
+#ifdef COMPRESSION_SUPPORT
+
+/**
+ * Result of #MHD_compression_deflate_().
+ */
+enum MHD_CompressionResult
+{
+  /**
+   * Compressed data was produced (or the stream just finished).
+   */
+  MHD_COMPRESSION_OK = 0,
+
+  /**
+   * No output is available right now, the application has no
+   * new data for us yet.
+   */
+  MHD_COMPRESSION_AGAIN = 1,
+
+  /**
+   * The application or zlib reported an error.
+   */
+  MHD_COMPRESSION_ERROR = 2
+};
+
+
+/**
+ * Decide whether the body of the response queued for @a connection
+ * should be compressed and if so, take a deflate stream from the
+ * daemon's pool and attach it to the connection.
+ *
+ * @param connection connection with a queued response
+ * @param[out] vary set to #MHD_YES if the response is eligible for
+ *        compression (and thus depends on "Accept-Encoding"),
+ *        #MHD_NO otherwise
+ * @return #MHD_YES if the body will be compressed
+ */
+int
+MHD_compression_start_ (struct MHD_Connection *connection,
+                        int *vary);
+
+
+/**
+ * Return the deflate stream of @a connection (if any) to the
+ * daemon's pool.
+ *
+ * @param connection connection to detach the stream from
+ */
+void
+MHD_compression_stop_ (struct MHD_Connection *connection);
+
+
+/**
+ * Name of the content coding produced by @a zs, for the
+ * "Content-Encoding" header.
+ *
+ * @param zs stream to inspect
+ * @return "gzip" or "deflate"
+ */
+const char *
+MHD_compression_coding_ (const struct MHD_ZStream *zs);
+
+
+/**
+ * Produce the next piece of the compressed body.  Reads the
+ * response data (calling the content reader callback if needed,
+ * the response mutex must be held in this case) and compresses it
+ * into @a out.
+ *
+ * @param connection connection with an attached deflate stream
+ * @param out where to write compressed data
+ * @param out_size number of bytes available in @a out
+ * @param[out] produced set to the number of bytes written to @a out
+ * @return #MHD_COMPRESSION_OK on success
+ */
+enum MHD_CompressionResult
+MHD_compression_deflate_ (struct MHD_Connection *connection,
+                          char *out,
+                          size_t out_size,
+                          size_t *produced);
+
+
+/**
+ * Check if the stream has emitted all compressed data,
+ * including the trailer.
+ *
+ * @param zs stream to check
+ * @return #MHD_YES if done
+ */
+int
+MHD_compression_finished_ (const struct MHD_ZStream *zs);
+
+
+/**
+ * Set up inflating of the request body of @a connection if the
+ * client sent it with a "Content-Encoding" we can decode and
+ * #MHD_OPTION_REQUEST_DECOMPRESSION is enabled.
+ *
+ * @param connection connection that has received the request headers
+ * @return #MHD_NO on error (out of memory), #MHD_YES otherwise
+ */
+int
+MHD_compression_inflate_start_ (struct MHD_Connection *connection);
+
+
+/**
+ * Release the inflate stream of @a connection (if any).
+ *
+ * @param connection connection to detach the stream from
+ */
+void
+MHD_compression_inflate_stop_ (struct MHD_Connection *connection);
+
+
+/**
+ * Get the next piece of the decompressed request body.  If data
+ * inflated earlier was not yet consumed (see
+ * #MHD_compression_inflate_consumed_()) it is returned again and
+ * no input is used, otherwise compressed data from @a in is
+ * inflated.
+ *
+ * @param connection connection with an attached inflate stream
+ * @param in compressed request body data
+ * @param[in,out] in_size number of bytes at @a in, set to the
+ *        number of bytes that were not used
+ * @param[out] out set to the decompressed data
+ * @param[out] out_size set to the number of bytes at @a out
+ * @return #MHD_COMPRESSION_OK if data was returned,
+ *         #MHD_COMPRESSION_AGAIN if more input is needed,
+ *         #MHD_COMPRESSION_ERROR if the data is corrupt or
+ *         inflates to more than the configured limit
+ */
+enum MHD_CompressionResult
+MHD_compression_inflate_ (struct MHD_Connection *connection,
+                          const char *in,
+                          size_t *in_size,
+                          const char **out,
+                          size_t *out_size);
+
+
+/**
+ * Mark @a size bytes of the data returned by the last call to
+ * #MHD_compression_inflate_() as processed by the application.
+ *
+ * @param zi inflate stream to update
+ * @param size number of bytes processed
+ */
+void
+MHD_compression_inflate_consumed_ (struct MHD_ZInflate *zi,
+                                   size_t size);
+
+
+/**
+ * Check if @a zi holds decompressed data the application did
+ * not process yet.
+ *
+ * @param zi stream to check
+ * @return #MHD_YES if data is pending
+ */
+int
+MHD_compression_inflate_pending_ (const struct MHD_ZInflate *zi);
+
+
+/**
+ * Check if @a zi has seen the end of the compressed data.
+ *
+ * @param zi stream to check
+ * @return #MHD_YES if the compressed body was complete
+ */
+int
+MHD_compression_inflate_finished_ (const struct MHD_ZInflate *zi);
+
+
+/**
+ * Release all pooled streams of the given daemon.  Must only be
+ * called once no connection of @a daemon uses a stream anymore.
+ *
+ * @param daemon daemon to clean up
+ */
+void
+MHD_compression_daemon_cleanup_ (struct MHD_Daemon *daemon);
+
+#endif
+
+#endif
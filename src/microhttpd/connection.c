@@ -35,6 +35,12 @@
 #include "mhd_sockets.h"
 #include "mhd_compat.h"
 #include "mhd_itc.h"
+#include "mhd_probes.h"
+#include "mhd_trace.h"
+#include "histogram.h"
+#ifdef COMPRESSION_SUPPORT
+#include "compression.h"
+#endif
 
 
 /**
@@ -490,6 +496,113 @@ need_100_continue (struct MHD_Connection *connection)
 }
 
 
+/**
+ * Start timing a call for #MHD_OPTION_STALL_THRESHOLD.
+ *
+ * @param daemon daemon making the call
+ * @return current time in microseconds, 0 if the watchdog is disabled
+ */
+uint64_t
+MHD_stall_timer_start_ (const struct MHD_Daemon *daemon)
+{
+  if (0 == daemon->stall_threshold)
+    return 0;
+  return MHD_monotonic_usec_counter ();
+}
+
+
+/**
+ * Finish timing a call for #MHD_OPTION_STALL_THRESHOLD and report it
+ * if it took too long.
+ *
+ * @param connection connection the call was made for
+ * @param source which callback was called
+ * @param start result of #MHD_stall_timer_start_()
+ */
+void
+MHD_stall_timer_check_ (struct MHD_Connection *connection,
+                        enum MHD_StallSource source,
+                        uint64_t start)
+{
+  uint64_t duration;
+
+  if (0 == start)
+    return;
+  duration = MHD_monotonic_usec_counter () - start;
+  if (duration < connection->daemon->stall_threshold)
+    return;
+  MHD_stall_report_ (connection->daemon,
+                     connection,
+                     source,
+                     duration);
+}
+
+
+/**
+ * Report a stall to the application (or log it).
+ *
+ * @param daemon daemon (worker) that stalled
+ * @param connection connection being processed, NULL for
+ *        #MHD_STALL_EVENT_LOOP
+ * @param source what stalled
+ * @param duration how long it took, in microseconds
+ */
+void
+MHD_stall_report_ (struct MHD_Daemon *daemon,
+                   struct MHD_Connection *connection,
+                   enum MHD_StallSource source,
+                   uint64_t duration)
+{
+  const char *method;
+  const char *url;
+  unsigned int worker;
+
+  if (NULL != connection)
+    {
+      method = connection->method;
+      url = connection->url;
+      MHD_connection_stats_ (connection)->stalls++;
+    }
+  else
+    {
+      method = NULL;
+      url = NULL;
+      if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+        MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
+      daemon->stats.stalls++;
+      if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+        MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
+    }
+  worker = (NULL != daemon->master)
+    ? (unsigned int) (daemon - daemon->master->worker_pool)
+    : 0;
+  if (NULL != daemon->stall_cb)
+    {
+      daemon->stall_cb (daemon->stall_cb_cls,
+                        source,
+                        method,
+                        url,
+                        worker,
+                        duration);
+      return;
+    }
+#ifdef HAVE_MESSAGES
+  if (MHD_STALL_EVENT_LOOP == source)
+    MHD_DLOG (daemon,
+              _("Event loop of worker %u stalled for %llu us\n"),
+              worker,
+              (unsigned long long) duration);
+  else
+    MHD_DLOG (daemon,
+              _("Callback for %s %s stalled worker %u for %llu us\n"),
+              (NULL != method) ? method : "-",
+              (NULL != url) ? url : "-",
+              worker,
+              (unsigned long long) duration);
+#endif
+}
+
+
 /**
  * Close the given connection and give the
  * specified termination code to the user.
@@ -507,14 +620,36 @@ MHD_connection_close_ (struct MHD_Connection *connection,
   if (0 == (connection->daemon->options & MHD_USE_EPOLL_TURBO))
     shutdown (connection->socket_fd,
               SHUT_WR);
+  MHD_PROBE2 (close, connection, (int) termination_code);
+  if ( (MHD_CONNECTION_CLOSED != connection->state) &&
+       ((unsigned int) termination_code <= MHD_REQUEST_TERMINATED_CLIENT_ABORT) )
+    MHD_connection_stats_ (connection)->connections_closed[termination_code]++;
+  if ( (MHD_CONNECTION_CLOSED != connection->state) &&
+       (NULL != daemon->trace) )
+    MHD_trace_record_ (daemon->trace,
+                       connection->cold->trace_id,
+                       MHD_TRACE_CLOSE,
+                       NULL,
+                       0);
   connection->state = MHD_CONNECTION_CLOSED;
   connection->event_loop_info = MHD_EVENT_LOOP_INFO_CLEANUP;
+#ifdef COMPRESSION_SUPPORT
+  MHD_compression_stop_ (connection);
+  MHD_compression_inflate_stop_ (connection);
+#endif
   if ( (NULL != daemon->notify_completed) &&
        (MHD_YES == connection->client_aware) )
-    daemon->notify_completed (daemon->notify_completed_cls,
-			      connection,
-			      &connection->client_context,
-			      termination_code);
+    {
+      const uint64_t start = MHD_stall_timer_start_ (daemon);
+
+      daemon->notify_completed (daemon->notify_completed_cls,
+                                connection,
+                                &connection->cold->client_context,
+                                termination_code);
+      MHD_stall_timer_check_ (connection,
+                              MHD_STALL_REQUEST_COMPLETED,
+                              start);
+    }
   connection->client_aware = MHD_NO;
 
   /* if we were at the connection limit before and are in
@@ -580,6 +715,7 @@ static int
 try_ready_normal_body (struct MHD_Connection *connection)
 {
   ssize_t ret;
+  uint64_t start;
   struct MHD_Response *response;
 
   response = connection->response;
@@ -602,12 +738,16 @@ try_ready_normal_body (struct MHD_Connection *connection)
     }
 #endif
 
+  start = MHD_stall_timer_start_ (connection->daemon);
   ret = response->crc (response->crc_cls,
                        connection->response_write_position,
                        response->data,
                        (size_t) MHD_MIN ((uint64_t)response->data_buffer_size,
                                          response->total_size -
                                          connection->response_write_position));
+  MHD_stall_timer_check_ (connection,
+                          MHD_STALL_CONTENT_READER,
+                          start);
   if ( (((ssize_t) MHD_CONTENT_READER_END_OF_STREAM) == ret) ||
        (((ssize_t) MHD_CONTENT_READER_END_WITH_ERROR) == ret) )
     {
@@ -634,6 +774,98 @@ try_ready_normal_body (struct MHD_Connection *connection)
 }
 
 
+#ifdef COMPRESSION_SUPPORT
+/**
+ * Prepare the next chunk of a compressed response body in the
+ * (already allocated) write buffer of this connection.  Assumes that
+ * the response mutex is already held.  The last chunk is directly
+ * followed by the terminating zero-length chunk.
+ *
+ * @param connection the connection
+ * @return #MHD_NO if readying the response failed
+ */
+static int
+try_ready_compressed_body (struct MHD_Connection *connection)
+{
+  size_t produced;
+  char cbuf[10];                /* 10: max strlen of "%x\r\n" */
+  int cblen;
+  size_t off;
+
+  /* reserve space for the CRLF after the data and for "0\r\n" */
+  switch (MHD_compression_deflate_ (connection,
+                                    &connection->write_buffer[sizeof (cbuf)],
+                                    MHD_MIN (connection->write_buffer_size
+                                             - sizeof (cbuf) - 2 - 3,
+                                             0xFFFFFF),
+                                    &produced))
+    {
+    case MHD_COMPRESSION_OK:
+      break;
+    case MHD_COMPRESSION_AGAIN:
+      connection->state = MHD_CONNECTION_CHUNKED_BODY_UNREADY;
+      return MHD_NO;
+    case MHD_COMPRESSION_ERROR:
+    default:
+      CONNECTION_CLOSE_ERROR (connection,
+                              _("Closing connection (error compressing response)\n"));
+      return MHD_NO;
+    }
+  off = sizeof (cbuf);
+  connection->write_buffer_send_offset = sizeof (cbuf);
+  if (0 != produced)
+    {
+      cblen = MHD_snprintf_(cbuf,
+                            sizeof (cbuf),
+                            "%X\r\n",
+                            (unsigned int) produced);
+      EXTRA_CHECK(cblen > 0);
+      EXTRA_CHECK(cblen < sizeof(cbuf));
+      memcpy (&connection->write_buffer[sizeof (cbuf) - cblen],
+              cbuf,
+              cblen);
+      memcpy (&connection->write_buffer[sizeof (cbuf) + produced],
+              "\r\n",
+              2);
+      off += produced + 2;
+      connection->write_buffer_send_offset = sizeof (cbuf) - cblen;
+    }
+  if (MHD_YES == MHD_compression_finished_ (connection->zstream))
+    {
+      /* end of message, signal other side! */
+      memcpy (&connection->write_buffer[off],
+              "0\r\n",
+              3);
+      off += 3;
+    }
+  connection->write_buffer_append_offset = off;
+  return MHD_YES;
+}
+#endif
+
+
+/**
+ * Check if the complete body of a chunked response has been
+ * put into the write buffer.
+ *
+ * @param connection the connection
+ * @return #MHD_YES if there is no more body data to prepare
+ */
+static int
+chunked_body_done (struct MHD_Connection *connection)
+{
+#ifdef COMPRESSION_SUPPORT
+  if (NULL != connection->zstream)
+    return MHD_compression_finished_ (connection->zstream);
+#endif
+  if ( (0 == connection->response->total_size) ||
+       (connection->response_write_position ==
+        connection->response->total_size) )
+    return MHD_YES;
+  return MHD_NO;
+}
+
+
 /**
  * Prepare the response buffer of this connection for sending.
  * Assumes that the response mutex is already held.  If the
@@ -676,6 +908,10 @@ try_ready_chunked_body (struct MHD_Connection *connection)
       connection->write_buffer_size = size;
       connection->write_buffer = buf;
     }
+#ifdef COMPRESSION_SUPPORT
+  if (NULL != connection->zstream)
+    return try_ready_compressed_body (connection);
+#endif
 
   if (0 == response->total_size)
     ret = 0; /* response must be empty, don't bother calling crc */
@@ -699,10 +935,15 @@ try_ready_chunked_body (struct MHD_Connection *connection)
   else
     {
       /* buffer not in range, try to fill it */
+      const uint64_t start = MHD_stall_timer_start_ (connection->daemon);
+
       ret = response->crc (response->crc_cls,
                            connection->response_write_position,
                            &connection->write_buffer[sizeof (cbuf)],
                            connection->write_buffer_size - sizeof (cbuf) - 2);
+      MHD_stall_timer_check_ (connection,
+                              MHD_STALL_CONTENT_READER,
+                              start);
     }
   if ( ((ssize_t) MHD_CONTENT_READER_END_WITH_ERROR) == ret)
     {
@@ -924,6 +1165,11 @@ build_header_response (struct MHD_Connection *connection)
   int must_add_chunked_encoding;
   int must_add_keep_alive;
   int must_add_content_length;
+  int must_add_vary;
+  int compress;
+#ifdef COMPRESSION_SUPPORT
+  char content_encoding_buf[64];
+#endif
 
   EXTRA_CHECK (NULL != connection->version);
   if (0 == connection->version[0])
@@ -977,6 +1223,8 @@ build_header_response (struct MHD_Connection *connection)
   must_add_chunked_encoding = MHD_NO;
   must_add_keep_alive = MHD_NO;
   must_add_content_length = MHD_NO;
+  must_add_vary = MHD_NO;
+  compress = MHD_NO;
   switch (connection->state)
     {
     case MHD_CONNECTION_FOOTERS_RECEIVED:
@@ -1001,8 +1249,18 @@ build_header_response (struct MHD_Connection *connection)
 
       /* now analyze chunked encoding situation */
       connection->have_chunked_upload = MHD_NO;
+#ifdef COMPRESSION_SUPPORT
+      compress = MHD_compression_start_ (connection,
+                                         &must_add_vary);
+      if ( (MHD_YES == must_add_vary) &&
+           (NULL != MHD_get_response_header (connection->response,
+                                             MHD_HTTP_HEADER_VARY)) )
+        must_add_vary = MHD_NO; /* application knows better */
+#endif
 
-      if ( (MHD_SIZE_UNKNOWN == connection->response->total_size) &&
+      /* a compressed body has no known size and needs chunking */
+      if ( ( (MHD_SIZE_UNKNOWN == connection->response->total_size) ||
+             (MHD_YES == compress) ) &&
            (NULL == response_has_close) &&
            (NULL == client_requested_close) )
         {
@@ -1042,6 +1300,18 @@ build_header_response (struct MHD_Connection *connection)
             }
         }
 
+#ifdef COMPRESSION_SUPPORT
+      if ( (MHD_YES == compress) &&
+           (MHD_NO == connection->have_chunked_upload) )
+        {
+          /* cannot delimit the compressed body, send it as-is */
+          MHD_compression_stop_ (connection);
+          compress = MHD_NO;
+          if (MHD_SIZE_UNKNOWN != connection->response->total_size)
+            must_add_close = MHD_NO;
+        }
+#endif
+
       /* check for other reasons to add 'close' header */
       if ( ( (NULL != client_requested_close) ||
              (MHD_YES == connection->read_closed) ) &&
@@ -1057,6 +1327,7 @@ build_header_response (struct MHD_Connection *connection)
          codes SHOULD NOT have a Content-Length according to spec;
          also chunked encoding / unknown length or CONNECT... */
       if ( (MHD_SIZE_UNKNOWN != connection->response->total_size) &&
+           (MHD_NO == compress) &&
            (MHD_HTTP_NO_CONTENT != rc) &&
            (MHD_HTTP_NOT_MODIFIED != rc) &&
            (MHD_HTTP_OK <= rc) &&
@@ -1110,6 +1381,14 @@ build_header_response (struct MHD_Connection *connection)
     size += strlen ("Transfer-Encoding: chunked\r\n");
   if (must_add_content_length)
     size += content_length_len;
+#ifdef COMPRESSION_SUPPORT
+  if (compress)
+    size += sprintf (content_encoding_buf,
+                     MHD_HTTP_HEADER_CONTENT_ENCODING ": %s\r\n",
+                     MHD_compression_coding_ (connection->zstream));
+#endif
+  if (must_add_vary)
+    size += strlen (MHD_HTTP_HEADER_VARY ": " MHD_HTTP_HEADER_ACCEPT_ENCODING "\r\n");
   EXTRA_CHECK (! (must_add_close && must_add_keep_alive) );
   EXTRA_CHECK (! (must_add_chunked_encoding && must_add_content_length) );
 
@@ -1170,6 +1449,23 @@ build_header_response (struct MHD_Connection *connection)
 	      content_length_len);
       off += content_length_len;
     }
+#ifdef COMPRESSION_SUPPORT
+  if (compress)
+    {
+      /* we compress the body, tell the client how */
+      strcpy (&data[off],
+              content_encoding_buf);
+      off += strlen (content_encoding_buf);
+    }
+#endif
+  if (must_add_vary)
+    {
+      /* body depends on 'Accept-Encoding', tell caches */
+      memcpy (&data[off],
+              MHD_HTTP_HEADER_VARY ": " MHD_HTTP_HEADER_ACCEPT_ENCODING "\r\n",
+              strlen (MHD_HTTP_HEADER_VARY ": " MHD_HTTP_HEADER_ACCEPT_ENCODING "\r\n"));
+      off += strlen (MHD_HTTP_HEADER_VARY ": " MHD_HTTP_HEADER_ACCEPT_ENCODING "\r\n");
+    }
   for (pos = connection->response->first_header; NULL != pos; pos = pos->next)
     if ( (pos->kind == kind) &&
          (! ( (pos->value == response_has_keepalive) &&
@@ -1279,7 +1575,7 @@ MHD_connection_update_event_loop_info (struct MHD_Connection *connection)
         {
 #if HTTPS_SUPPORT
 	case MHD_TLS_CONNECTION_INIT:
-	  if (0 == gnutls_record_get_direction (connection->tls_session))
+	  if (0 == gnutls_record_get_direction (connection->cold->tls_session))
             connection->event_loop_info = MHD_EVENT_LOOP_INFO_READ;
 	  else
             connection->event_loop_info = MHD_EVENT_LOOP_INFO_WRITE;
@@ -1680,7 +1976,7 @@ parse_initial_message_line (struct MHD_Connection *connection,
     }
   if (NULL != daemon->uri_log_callback)
     {
-      connection->client_context
+      connection->cold->client_context
         = daemon->uri_log_callback (daemon->uri_log_callback_cls,
   				    curi,
                                     connection);
@@ -1706,6 +2002,127 @@ parse_initial_message_line (struct MHD_Connection *connection,
 }
 
 
+/**
+ * Call the #MHD_AccessHandlerCallback of the application for the
+ * current request, timing it for #MHD_OPTION_STALL_THRESHOLD.
+ *
+ * @param connection connection we're processing
+ * @param upload_data request body data to pass, NULL for none
+ * @param[in,out] upload_data_size number of bytes at @a upload_data,
+ *        set to the number of bytes that the application did not use
+ * @return return value of the callback
+ */
+static int
+call_access_handler (struct MHD_Connection *connection,
+                     const char *upload_data,
+                     size_t *upload_data_size)
+{
+  struct MHD_Daemon *daemon = connection->daemon;
+  const uint64_t start = MHD_stall_timer_start_ (daemon);
+  int ret;
+
+  ret = daemon->default_handler (daemon->default_handler_cls,
+                                 connection,
+                                 connection->url,
+                                 connection->method,
+                                 connection->version,
+                                 upload_data,
+                                 upload_data_size,
+                                 &connection->cold->client_context);
+  MHD_stall_timer_check_ (connection,
+                          MHD_STALL_ACCESS_HANDLER,
+                          start);
+  return ret;
+}
+
+
+#ifdef COMPRESSION_SUPPORT
+/**
+ * Decompress (part of) the request body and give it to the
+ * handler of the application.  Stops once the application
+ * leaves some of the decompressed data unprocessed.
+ *
+ * @param connection connection we're processing
+ * @param data compressed request body data
+ * @param[in,out] data_size number of bytes at @a data, set
+ *        to the number of bytes that were not used
+ * @return #MHD_YES on success, #MHD_NO if the connection was closed
+ */
+static int
+inflate_request_body (struct MHD_Connection *connection,
+                      const char *data,
+                      size_t *data_size)
+{
+  const size_t total = *data_size;
+  const char *out;
+  size_t out_size;
+  size_t left;
+
+  while (1)
+    {
+      switch (MHD_compression_inflate_ (connection,
+                                        &data[total - *data_size],
+                                        data_size,
+                                        &out,
+                                        &out_size))
+        {
+        case MHD_COMPRESSION_OK:
+          break;
+        case MHD_COMPRESSION_AGAIN:
+          return MHD_YES;
+        default:
+          CONNECTION_CLOSE_ERROR (connection,
+                                  _("Received malformed compressed HTTP request body. Closing connection.\n"));
+          return MHD_NO;
+        }
+      left = out_size;
+      if (MHD_NO == call_access_handler (connection,
+                                         out,
+                                         &left))
+        {
+          /* serious internal error, close connection */
+          CONNECTION_CLOSE_ERROR (connection,
+                                  _("Application reported internal error, closing connection.\n"));
+          return MHD_NO;
+        }
+      if (left > out_size)
+        mhd_panic (mhd_panic_cls,
+                   __FILE__,
+                   __LINE__
+#ifdef HAVE_MESSAGES
+                   , _("libmicrohttpd API violation")
+#else
+                   , NULL
+#endif
+                   );
+      MHD_compression_inflate_consumed_ (connection->zinflate,
+                                         out_size - left);
+      if (0 != left)
+        return MHD_YES; /* application did not process everything */
+    }
+}
+#endif
+
+
+/**
+ * Check if decompressed request body data is waiting to be
+ * processed by the application.  Such data is no longer in
+ * the read buffer.
+ *
+ * @param connection connection to check
+ * @return #MHD_YES if such data is pending
+ */
+static int
+have_inflated_body_data (struct MHD_Connection *connection)
+{
+#ifdef COMPRESSION_SUPPORT
+  if (NULL != connection->zinflate)
+    return MHD_compression_inflate_pending_ (connection->zinflate);
+#endif
+  return MHD_NO;
+}
+
+
 /**
  * Call the handler of the application for this
  * connection.  Handles chunking of the upload
@@ -1722,15 +2139,9 @@ call_connection_handler (struct MHD_Connection *connection)
     return;                     /* already queued a response */
   processed = 0;
   connection->client_aware = MHD_YES;
-  if (MHD_NO ==
-      connection->daemon->default_handler (connection->daemon-> default_handler_cls,
-					   connection,
-                                           connection->url,
-					   connection->method,
-					   connection->version,
-					   NULL,
-                                           &processed,
-					   &connection->client_context))
+  if (MHD_NO == call_access_handler (connection,
+                                     NULL,
+                                     &processed))
     {
       /* serious internal error, close connection */
       CONNECTION_CLOSE_ERROR (connection,
@@ -1764,6 +2175,24 @@ process_request_body (struct MHD_Connection *connection)
 
   buffer_head = connection->read_buffer;
   available = connection->read_buffer_offset;
+#ifdef COMPRESSION_SUPPORT
+  if (MHD_YES == have_inflated_body_data (connection))
+    {
+      /* first deliver what the application left over last time */
+      processed = 0;
+      connection->client_aware = MHD_YES;
+      if (MHD_NO == inflate_request_body (connection,
+                                          buffer_head,
+                                          &processed))
+        return;
+      if ( (NULL != connection->response) ||
+           (MHD_YES == have_inflated_body_data (connection)) )
+        return;
+    }
+  if ( (0 == available) ||
+       (0 == connection->remaining_upload_size) )
+    return; /* anything left in the buffer is not part of the body */
+#endif
   do
     {
       instant_retry = MHD_NO;
@@ -1884,15 +2313,19 @@ process_request_body (struct MHD_Connection *connection)
         }
       used = processed;
       connection->client_aware = MHD_YES;
-      if (MHD_NO ==
-          connection->daemon->default_handler (connection->daemon->default_handler_cls,
-                                               connection,
-                                               connection->url,
-                                               connection->method,
-                                               connection->version,
-                                               buffer_head,
-                                               &processed,
-                                               &connection->client_context))
+#ifdef COMPRESSION_SUPPORT
+      if (NULL != connection->zinflate)
+        {
+          if (MHD_NO == inflate_request_body (connection,
+                                              buffer_head,
+                                              &processed))
+            return;
+        }
+      else
+#endif
+      if (MHD_NO == call_access_handler (connection,
+                                         buffer_head,
+                                         &processed))
         {
           /* serious internal error, close connection */
 	  CONNECTION_CLOSE_ERROR (connection,
@@ -1983,11 +2416,27 @@ do_read (struct MHD_Connection *connection)
       /* other side closed connection; RFC 2616, section 8.1.4 suggests
 	 we should then shutdown ourselves as well. */
       connection->read_closed = MHD_YES;
+      if (NULL != connection->daemon->trace)
+        MHD_trace_record_ (connection->daemon->trace,
+                           connection->cold->trace_id,
+                           MHD_TRACE_EOF,
+                           NULL,
+                           0);
       MHD_connection_close_ (connection,
                              MHD_REQUEST_TERMINATED_CLIENT_ABORT);
       return MHD_YES;
     }
+  if (NULL != connection->daemon->trace)
+    MHD_trace_record_ (connection->daemon->trace,
+                       connection->cold->trace_id,
+                       MHD_TRACE_DATA,
+                       &connection->read_buffer[connection->read_buffer_offset],
+                       bytes_read);
   connection->read_buffer_offset += bytes_read;
+  MHD_connection_stats_ (connection)->bytes_received += bytes_read;
+  if ( (MHD_YES == connection->daemon->request_timing) &&
+       (0 == connection->cold->phase_first_byte) )
+    connection->cold->phase_first_byte = MHD_monotonic_usec_counter ();
   return MHD_YES;
 }
 
@@ -2269,6 +2718,15 @@ parse_connection_headers (struct MHD_Connection *connection)
             }
         }
     }
+#ifdef COMPRESSION_SUPPORT
+  if ( (0 != connection->remaining_upload_size) &&
+       (MHD_NO == MHD_compression_inflate_start_ (connection)) )
+    {
+      CONNECTION_CLOSE_ERROR (connection,
+                              _("Failed to set up decompression of request body. Closing connection.\n"));
+      return;
+    }
+#endif
 }
 
 
@@ -2443,6 +2901,9 @@ MHD_connection_handle_write (struct MHD_Connection *connection)
  	     break;
           check_write_done (connection,
                             MHD_CONNECTION_HEADERS_SENT);
+          if ( (MHD_YES == connection->daemon->request_timing) &&
+               (MHD_CONNECTION_HEADERS_SENT == connection->state) )
+            connection->cold->phase_headers_sent = MHD_monotonic_usec_counter ();
           break;
         case MHD_CONNECTION_HEADERS_SENT:
           EXTRA_CHECK (0);
@@ -2511,8 +2972,7 @@ MHD_connection_handle_write (struct MHD_Connection *connection)
 	  if (MHD_CONNECTION_CHUNKED_BODY_READY != connection->state)
 	     break;
           check_write_done (connection,
-                            (connection->response->total_size ==
-                             connection->response_write_position) ?
+                            (MHD_YES == chunked_body_done (connection)) ?
                             MHD_CONNECTION_BODY_SENT :
                             MHD_CONNECTION_CHUNKED_BODY_UNREADY);
           break;
@@ -2550,6 +3010,91 @@ MHD_connection_handle_write (struct MHD_Connection *connection)
 }
 
 
+/**
+ * Compute the duration between two timestamps of a request.
+ *
+ * @param start beginning of the phase
+ * @param end end of the phase
+ * @param[out] duration set to the duration in microseconds, 0 if
+ *             one of the timestamps was not taken
+ * @return #MHD_YES if both timestamps were taken, #MHD_NO if the
+ *         request never reached the phase (or never left it)
+ */
+static int
+phase_duration (uint64_t start,
+                uint64_t end,
+                uint64_t *duration)
+{
+  *duration = 0;
+  if ( (0 == start) ||
+       (0 == end) )
+    return MHD_NO;
+  if (end > start)
+    *duration = end - start;
+  return MHD_YES;
+}
+
+
+/**
+ * A request was completed with #MHD_OPTION_REQUEST_TIMING; compute
+ * the duration of its phases, add them to the histograms of the
+ * daemon and start timing the next request on the connection.
+ * Phases the request did not go through are not added.
+ *
+ * @param connection connection that completed a request
+ */
+static void
+record_request_timing (struct MHD_Connection *connection)
+{
+  struct MHD_Daemon *daemon = connection->daemon;
+  uint64_t *phase = connection->cold->phase_usec;
+  int timed[MHD_REQUEST_PHASE_COUNT];
+  uint64_t now;
+  unsigned int i;
+
+  now = MHD_monotonic_usec_counter ();
+  timed[MHD_REQUEST_PHASE_WAIT]
+    = phase_duration (connection->cold->phase_start,
+                      connection->cold->phase_first_byte,
+                      &phase[MHD_REQUEST_PHASE_WAIT]);
+  timed[MHD_REQUEST_PHASE_HEADERS]
+    = phase_duration (connection->cold->phase_first_byte,
+                      connection->cold->phase_headers,
+                      &phase[MHD_REQUEST_PHASE_HEADERS]);
+  timed[MHD_REQUEST_PHASE_HANDLER]
+    = phase_duration (connection->cold->phase_headers,
+                      connection->cold->phase_response,
+                      &phase[MHD_REQUEST_PHASE_HANDLER]);
+  timed[MHD_REQUEST_PHASE_SEND_HEADERS]
+    = phase_duration (connection->cold->phase_response,
+                      connection->cold->phase_headers_sent,
+                      &phase[MHD_REQUEST_PHASE_SEND_HEADERS]);
+  timed[MHD_REQUEST_PHASE_SEND_BODY]
+    = phase_duration (connection->cold->phase_headers_sent,
+                      now,
+                      &phase[MHD_REQUEST_PHASE_SEND_BODY]);
+  timed[MHD_REQUEST_PHASE_TOTAL]
+    = phase_duration (connection->cold->phase_first_byte,
+                      now,
+                      &phase[MHD_REQUEST_PHASE_TOTAL]);
+  if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
+  for (i = 0; i < MHD_REQUEST_PHASE_COUNT; i++)
+    if (MHD_YES == timed[i])
+      MHD_histogram_add_ (&daemon->phase_histograms[i],
+                          phase[i]);
+  if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
+  connection->cold->phase_start = now;
+  /* a pipelined request may already be (partially) in the buffer */
+  connection->cold->phase_first_byte
+    = (0 != connection->read_buffer_offset) ? now : 0;
+  connection->cold->phase_headers = 0;
+  connection->cold->phase_response = 0;
+  connection->cold->phase_headers_sent = 0;
+}
+
+
 /**
  * Clean up the state of the given connection and move it into the
  * clean up queue for final disposal.
@@ -2626,6 +3171,13 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
                 _("In function %s handling connection at state: %s\n"),
                 __FUNCTION__,
                 MHD_state_to_string (connection->state));
+#endif
+#ifdef MHD_USDT_PROBES
+      if (connection->state != connection->cold->probed_state)
+        {
+          connection->cold->probed_state = connection->state;
+          MHD_PROBE2 (state, connection, (int) connection->state);
+        }
 #endif
       switch (connection->state)
         {
@@ -2714,6 +3266,8 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
             }
           continue;
         case MHD_CONNECTION_HEADERS_RECEIVED:
+          if (MHD_YES == daemon->request_timing)
+            connection->cold->phase_headers = MHD_monotonic_usec_counter ();
           parse_connection_headers (connection);
           if (MHD_CONNECTION_CLOSED == connection->state)
             continue;
@@ -2765,17 +3319,29 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
             }
           break;
         case MHD_CONNECTION_CONTINUE_SENT:
-          if (0 != connection->read_buffer_offset)
+          if ( (0 != connection->read_buffer_offset) ||
+               (MHD_YES == have_inflated_body_data (connection)) )
             {
               process_request_body (connection);     /* loop call */
               if (MHD_CONNECTION_CLOSED == connection->state)
                 continue;
             }
-          if ( (0 == connection->remaining_upload_size) ||
-               ( (MHD_SIZE_UNKNOWN == connection->remaining_upload_size) &&
-                 (0 == connection->read_buffer_offset) &&
-                 (MHD_YES == connection->read_closed) ) )
+          if ( (MHD_NO == have_inflated_body_data (connection)) &&
+               ( (0 == connection->remaining_upload_size) ||
+                 ( (MHD_SIZE_UNKNOWN == connection->remaining_upload_size) &&
+                   (0 == connection->read_buffer_offset) &&
+                   (MHD_YES == connection->read_closed) ) ) )
             {
+#ifdef COMPRESSION_SUPPORT
+              if ( (NULL != connection->zinflate) &&
+                   (NULL == connection->response) &&
+                   (MHD_NO == MHD_compression_inflate_finished_ (connection->zinflate)) )
+                {
+                  CONNECTION_CLOSE_ERROR (connection,
+                                          _("Received truncated compressed HTTP request body. Closing connection.\n"));
+                  continue;
+                }
+#endif
               if ((MHD_YES == connection->have_chunked_upload) &&
                   (MHD_NO == connection->read_closed))
                 connection->state = MHD_CONNECTION_BODY_RECEIVED;
@@ -2852,6 +3418,8 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
             continue;
           if (NULL == connection->response)
             break;              /* try again next time */
+          if (MHD_YES == daemon->request_timing)
+            connection->cold->phase_response = MHD_monotonic_usec_counter ();
           if (MHD_NO == build_header_response (connection))
             {
               /* oops - close! */
@@ -2932,9 +3500,7 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
         case MHD_CONNECTION_CHUNKED_BODY_UNREADY:
           if (NULL != connection->response->crc)
             MHD_mutex_lock_chk_ (&connection->response->mutex);
-          if ( (0 == connection->response->total_size) ||
-               (connection->response_write_position ==
-                connection->response->total_size) )
+          if (MHD_YES == chunked_body_done (connection))
             {
               if (NULL != connection->response->crc)
                 MHD_mutex_unlock_chk_ (&connection->response->mutex);
@@ -2984,15 +3550,27 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
           client_close = ( (NULL != end) &&
                            (MHD_str_equal_caseless_(end,
                                                     "close")));
+#ifdef COMPRESSION_SUPPORT
+          MHD_compression_stop_ (connection);
+          MHD_compression_inflate_stop_ (connection);
+#endif
           MHD_destroy_response (connection->response);
           connection->response = NULL;
+          MHD_connection_stats_ (connection)->requests_completed++;
+          if (MHD_YES == daemon->request_timing)
+            record_request_timing (connection);
           if ( (NULL != daemon->notify_completed) &&
                (MHD_YES == connection->client_aware) )
           {
+            const uint64_t start = MHD_stall_timer_start_ (daemon);
+
 	    daemon->notify_completed (daemon->notify_completed_cls,
 				      connection,
-				      &connection->client_context,
+				      &connection->cold->client_context,
 				      MHD_REQUEST_TERMINATED_COMPLETED_OK);
+            MHD_stall_timer_check_ (connection,
+                                    MHD_STALL_REQUEST_COMPLETED,
+                                    start);
             connection->client_aware = MHD_NO;
           }
           end =
@@ -3024,6 +3602,7 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
           else
             {
               /* can try to keep-alive */
+              MHD_connection_stats_ (connection)->keepalive_reuses++;
               if (MHD_NO != socket_flush_possible (connection))
                 socket_start_normal_buffering (connection);
               connection->version = NULL;
@@ -3039,7 +3618,7 @@ MHD_connection_handle_idle (struct MHD_Connection *connection)
                 = connection->daemon->pool_size / 2;
             }
 	  connection->client_aware = MHD_NO;
-          connection->client_context = NULL;
+          connection->cold->client_context = NULL;
           connection->continue_message_write_offset = 0;
           connection->responseCode = 0;
           connection->headers_received = NULL;
@@ -3209,30 +3788,34 @@ MHD_get_connection_info (struct MHD_Connection *connection,
     {
 #if HTTPS_SUPPORT
     case MHD_CONNECTION_INFO_CIPHER_ALGO:
-      if (NULL == connection->tls_session)
+      if (NULL == connection->cold->tls_session)
 	return NULL;
-      connection->cipher = gnutls_cipher_get (connection->tls_session);
-      return (const union MHD_ConnectionInfo *) &connection->cipher;
+      connection->cold->cipher = gnutls_cipher_get (connection->cold->tls_session);
+      return (const union MHD_ConnectionInfo *) &connection->cold->cipher;
     case MHD_CONNECTION_INFO_PROTOCOL:
-      if (NULL == connection->tls_session)
+      if (NULL == connection->cold->tls_session)
 	return NULL;
-      connection->protocol = gnutls_protocol_get_version (connection->tls_session);
-      return (const union MHD_ConnectionInfo *) &connection->protocol;
+      connection->cold->protocol = gnutls_protocol_get_version (connection->cold->tls_session);
+      return (const union MHD_ConnectionInfo *) &connection->cold->protocol;
     case MHD_CONNECTION_INFO_GNUTLS_SESSION:
-      if (NULL == connection->tls_session)
+      if (NULL == connection->cold->tls_session)
 	return NULL;
-      return (const union MHD_ConnectionInfo *) &connection->tls_session;
+      return (const union MHD_ConnectionInfo *) &connection->cold->tls_session;
 #endif
     case MHD_CONNECTION_INFO_CLIENT_ADDRESS:
-      return (const union MHD_ConnectionInfo *) &connection->addr;
+      return (const union MHD_ConnectionInfo *) &connection->cold->addr;
     case MHD_CONNECTION_INFO_DAEMON:
       return (const union MHD_ConnectionInfo *) &connection->daemon;
     case MHD_CONNECTION_INFO_CONNECTION_FD:
       return (const union MHD_ConnectionInfo *) &connection->socket_fd;
     case MHD_CONNECTION_INFO_SOCKET_CONTEXT:
-      return (const union MHD_ConnectionInfo *) &connection->socket_context;
+      return (const union MHD_ConnectionInfo *) &connection->cold->socket_context;
     case MHD_CONNECTION_INFO_CONNECTION_SUSPENDED:
       return (const union MHD_ConnectionInfo *) &connection->suspended;
+    case MHD_CONNECTION_INFO_REQUEST_TIMING:
+      if (MHD_YES != connection->daemon->request_timing)
+        return NULL;
+      return (const union MHD_ConnectionInfo *) &connection->cold->phase_usec;
     default:
       return NULL;
     };
@@ -3296,20 +3879,19 @@ MHD_set_connection_option (struct MHD_Connection *connection,
 
 
 /**
- * Queue a response to be transmitted to the client (as soon as
- * possible but after #MHD_AccessHandlerCallback returns).
+ * Attach a response to the connection, without taking a reference
+ * on it and without running the state machine.
  *
  * @param connection the connection identifying the client
  * @param status_code HTTP status code (i.e. #MHD_HTTP_OK)
  * @param response response to transmit
  * @return #MHD_NO on error (i.e. reply already sent),
- *         #MHD_YES on success or if message has been queued
- * @ingroup response
+ *         #MHD_YES if the response was attached
  */
 int
-MHD_queue_response (struct MHD_Connection *connection,
-                    unsigned int status_code,
-                    struct MHD_Response *response)
+MHD_connection_set_response_ (struct MHD_Connection *connection,
+                              unsigned int status_code,
+                              struct MHD_Response *response)
 {
   struct MHD_Daemon *daemon;
 
@@ -3340,6 +3922,7 @@ MHD_queue_response (struct MHD_Connection *connection,
       return MHD_NO;
     }
   if ( (NULL != response->upgrade_handler) &&
+       (0 == (response->flags & MHD_RF_UPGRADE_DIRECT)) &&
        (0 != (MHD_USE_EPOLL & daemon->options)) &&
        (0 != (MHD_USE_TLS & daemon->options)) &&
        (MHD_USE_TLS_EPOLL_UPGRADE != (MHD_USE_TLS_EPOLL_UPGRADE & daemon->options)) )
@@ -3350,7 +3933,6 @@ MHD_queue_response (struct MHD_Connection *connection,
 #endif
       return MHD_NO;
     }
-  MHD_increment_response_rc (response);
   connection->response = response;
   connection->responseCode = status_code;
   if ( ( (NULL != connection->method) &&
@@ -3377,6 +3959,31 @@ MHD_queue_response (struct MHD_Connection *connection,
       connection->read_closed = MHD_YES;
       connection->state = MHD_CONNECTION_FOOTERS_RECEIVED;
     }
+  return MHD_YES;
+}
+
+
+/**
+ * Queue a response to be transmitted to the client (as soon as
+ * possible but after #MHD_AccessHandlerCallback returns).
+ *
+ * @param connection the connection identifying the client
+ * @param status_code HTTP status code (i.e. #MHD_HTTP_OK)
+ * @param response response to transmit
+ * @return #MHD_NO on error (i.e. reply already sent),
+ *         #MHD_YES on success or if message has been queued
+ * @ingroup response
+ */
+int
+MHD_queue_response (struct MHD_Connection *connection,
+                    unsigned int status_code,
+                    struct MHD_Response *response)
+{
+  if (MHD_NO == MHD_connection_set_response_ (connection,
+                                              status_code,
+                                              response))
+    return MHD_NO;
+  MHD_increment_response_rc (response);
   if (MHD_NO == connection->in_idle)
     (void) MHD_connection_handle_idle (connection);
   return MHD_YES;
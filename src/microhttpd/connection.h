@@ -93,6 +93,62 @@ MHD_connection_close_ (struct MHD_Connection *connection,
                        enum MHD_RequestTerminationCode termination_code);
 
 
+/**
+ * Attach a response to the connection, without taking a reference
+ * on it and without running the state machine.
+ *
+ * @param connection the connection identifying the client
+ * @param status_code HTTP status code (i.e. #MHD_HTTP_OK)
+ * @param response response to transmit
+ * @return #MHD_NO on error (i.e. reply already sent),
+ *         #MHD_YES if the response was attached
+ */
+int
+MHD_connection_set_response_ (struct MHD_Connection *connection,
+                              unsigned int status_code,
+                              struct MHD_Response *response);
+
+
+/**
+ * Start timing a call for #MHD_OPTION_STALL_THRESHOLD.
+ *
+ * @param daemon daemon making the call
+ * @return current time in microseconds, 0 if the watchdog is disabled
+ */
+uint64_t
+MHD_stall_timer_start_ (const struct MHD_Daemon *daemon);
+
+
+/**
+ * Finish timing a call for #MHD_OPTION_STALL_THRESHOLD and report it
+ * if it took too long.
+ *
+ * @param connection connection the call was made for
+ * @param source which callback was called
+ * @param start result of #MHD_stall_timer_start_()
+ */
+void
+MHD_stall_timer_check_ (struct MHD_Connection *connection,
+                        enum MHD_StallSource source,
+                        uint64_t start);
+
+
+/**
+ * Report a stall to the application (or log it).
+ *
+ * @param daemon daemon (worker) that stalled
+ * @param connection connection being processed, NULL for
+ *        #MHD_STALL_EVENT_LOOP
+ * @param source what stalled
+ * @param duration how long it took, in microseconds
+ */
+void
+MHD_stall_report_ (struct MHD_Daemon *daemon,
+                   struct MHD_Connection *connection,
+                   enum MHD_StallSource source,
+                   uint64_t duration);
+
+
 #ifdef EPOLL_SUPPORT
 /**
  * Perform epoll processing, possibly moving the connection back into
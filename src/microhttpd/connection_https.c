@@ -32,6 +32,7 @@
 #include "memorypool.h"
 #include "response.h"
 #include "mhd_mono_clock.h"
+#include "tlshandshake.h"
 #include <gnutls/gnutls.h>
 
 
@@ -51,7 +52,21 @@ run_tls_handshake (struct MHD_Connection *connection)
   connection->last_activity = MHD_monotonic_sec_counter();
   if (MHD_TLS_CONNECTION_INIT == connection->state)
     {
-      ret = gnutls_handshake (connection->tls_session);
+      if (MHD_YES == connection->cold->tls_handshake_queued)
+        {
+          if (MHD_YES == connection->suspended)
+            return MHD_YES; /* step still running in the thread pool */
+          /* process the result of the step, but do not queue the
+             next one before the client sent more data */
+          connection->cold->tls_handshake_queued = MHD_NO;
+          ret = connection->cold->tls_handshake_ret;
+        }
+      else if ( (NULL != connection->daemon->tls_handshake_pool) &&
+                (MHD_YES == MHD_tls_handshake_pool_submit_ (connection->daemon->tls_handshake_pool,
+                                                            connection)) )
+        return MHD_YES;
+      else
+        ret = gnutls_handshake (connection->cold->tls_session);
       if (ret == GNUTLS_E_SUCCESS)
 	{
 	  /* set connection state to enable HTTP processing */
@@ -134,6 +149,15 @@ MHD_tls_connection_handle_idle (struct MHD_Connection *connection)
 {
   unsigned int timeout;
 
+  if ( (MHD_TLS_CONNECTION_INIT == connection->state) &&
+       (MHD_YES == connection->cold->tls_handshake_queued) )
+    {
+      /* the read handler may not run again before the client
+         needs the result of the step run by the thread pool */
+      if (MHD_YES == connection->suspended)
+        return MHD_YES;
+      run_tls_handshake (connection);
+    }
 #if DEBUG_STATES
   MHD_DLOG (connection->daemon,
             _("In function %s handling connection at state: %s\n"),
@@ -152,11 +176,11 @@ MHD_tls_connection_handle_idle (struct MHD_Connection *connection)
       break;
       /* close connection if necessary */
     case MHD_CONNECTION_CLOSED:
-      gnutls_bye (connection->tls_session,
+      gnutls_bye (connection->cold->tls_session,
                   GNUTLS_SHUT_RDWR);
       return MHD_connection_handle_idle (connection);
     default:
-      if ( (0 != gnutls_record_check_pending (connection->tls_session)) &&
+      if ( (0 != gnutls_record_check_pending (connection->cold->tls_session)) &&
 	   (MHD_YES != MHD_tls_connection_handle_read (connection)) )
 	return MHD_YES;
       return MHD_connection_handle_idle (connection);
@@ -37,15 +37,26 @@
 #include "mhd_sockets.h"
 #include "mhd_itc.h"
 #include "mhd_compat.h"
+#include "mhd_probes.h"
+#include "mhd_trace.h"
+#include "histogram.h"
+#ifdef COMPRESSION_SUPPORT
+#include "compression.h"
+#endif
 
-#if HAVE_SEARCH_H
-#include <search.h>
-#else
-#include "tsearch.h"
+#include "ipcount.h"
+#include "ipfilter.h"
+#ifdef DAUTH_SUPPORT
+#include "noncetable.h"
+#endif
+#ifdef BAUTH_SUPPORT
+#include "authcache.h"
 #endif
 
 #if HTTPS_SUPPORT
 #include "connection_https.h"
+#include "tlscache.h"
+#include "tlshandshake.h"
 #include <gcrypt.h>
 #endif
 
@@ -74,6 +85,15 @@
  */
 #define MHD_POOL_SIZE_DEFAULT (32 * 1024)
 
+/**
+ * Offset of the `struct MHD_ConnectionCold` in the allocation of a
+ * connection: after the `struct MHD_Connection`, rounded up to a
+ * cache line.
+ */
+#define CONNECTION_COLD_OFFSET \
+  ( (sizeof (struct MHD_Connection) + MHD_CACHE_LINE_SIZE - 1) \
+    / MHD_CACHE_LINE_SIZE * MHD_CACHE_LINE_SIZE )
+
 /**
  * Print extra messages with reasons for closing
  * sockets? (only adds non-error messages).
@@ -153,132 +173,6 @@ MHD_get_master (struct MHD_Daemon *daemon)
 }
 
 
-/**
- * Maintain connection count for single address.
- */
-struct MHD_IPCount
-{
-  /**
-   * Address family. AF_INET or AF_INET6 for now.
-   */
-  int family;
-
-  /**
-   * Actual address.
-   */
-  union
-  {
-    /**
-     * IPv4 address.
-     */
-    struct in_addr ipv4;
-#if HAVE_INET6
-    /**
-     * IPv6 address.
-     */
-    struct in6_addr ipv6;
-#endif
-  } addr;
-
-  /**
-   * Counter.
-   */
-  unsigned int count;
-};
-
-
-/**
- * Lock shared structure for IP connection counts and connection DLLs.
- *
- * @param daemon handle to daemon where lock is
- */
-static void
-MHD_ip_count_lock (struct MHD_Daemon *daemon)
-{
-  MHD_mutex_lock_chk_(&daemon->per_ip_connection_mutex);
-}
-
-
-/**
- * Unlock shared structure for IP connection counts and connection DLLs.
- *
- * @param daemon handle to daemon where lock is
- */
-static void
-MHD_ip_count_unlock (struct MHD_Daemon *daemon)
-{
-  MHD_mutex_unlock_chk_(&daemon->per_ip_connection_mutex);
-}
-
-
-/**
- * Tree comparison function for IP addresses (supplied to tsearch() family).
- * We compare everything in the struct up through the beginning of the
- * 'count' field.
- *
- * @param a1 first address to compare
- * @param a2 second address to compare
- * @return -1, 0 or 1 depending on result of compare
- */
-static int
-MHD_ip_addr_compare (const void *a1,
-                     const void *a2)
-{
-  return memcmp (a1,
-                 a2,
-                 offsetof (struct MHD_IPCount,
-                           count));
-}
-
-
-/**
- * Parse address and initialize @a key using the address.
- *
- * @param addr address to parse
- * @param addrlen number of bytes in @a addr
- * @param key where to store the parsed address
- * @return #MHD_YES on success and #MHD_NO otherwise (e.g., invalid address type)
- */
-static int
-MHD_ip_addr_to_key (const struct sockaddr *addr,
-		    socklen_t addrlen,
-		    struct MHD_IPCount *key)
-{
-  memset(key,
-         0,
-         sizeof(*key));
-
-  /* IPv4 addresses */
-  if (sizeof (struct sockaddr_in) == addrlen)
-    {
-      const struct sockaddr_in *addr4 = (const struct sockaddr_in*) addr;
-
-      key->family = AF_INET;
-      memcpy (&key->addr.ipv4,
-              &addr4->sin_addr,
-              sizeof(addr4->sin_addr));
-      return MHD_YES;
-    }
-
-#if HAVE_INET6
-  /* IPv6 addresses */
-  if (sizeof (struct sockaddr_in6) == addrlen)
-    {
-      const struct sockaddr_in6 *addr6 = (const struct sockaddr_in6*) addr;
-
-      key->family = AF_INET6;
-      memcpy (&key->addr.ipv6,
-              &addr6->sin6_addr,
-              sizeof(addr6->sin6_addr));
-      return MHD_YES;
-    }
-#endif
-
-  /* Some other address */
-  return MHD_NO;
-}
-
-
 /**
  * Check if IP address is over its limit in terms of the number
  * of allowed concurrent connections.  If the IP is still allowed,
@@ -288,69 +182,26 @@ MHD_ip_addr_to_key (const struct sockaddr *addr,
  * @param addr address to add (or increment counter)
  * @param addrlen number of bytes in @a addr
  * @return Return #MHD_YES if IP below limit, #MHD_NO if IP has surpassed limit.
- *   Also returns #MHD_NO if fails to allocate memory.
+ *   Also returns #MHD_NO if the table of addresses is full.
  */
 static int
 MHD_ip_limit_add (struct MHD_Daemon *daemon,
 		  const struct sockaddr *addr,
 		  socklen_t addrlen)
 {
-  struct MHD_IPCount *key;
-  void **nodep;
-  void *node;
-  int result;
-
-  daemon = MHD_get_master (daemon);
-  /* Ignore if no connection limit assigned */
+  /* Workers use their own copies of the limit and of the table
+     pointer, so the master's structure is not touched here */
   if (0 == daemon->per_ip_connection_limit)
     return MHD_YES;
-
-  if (NULL == (key = malloc (sizeof(*key))))
-    return MHD_NO;
-
-  /* Initialize key */
-  if (MHD_NO == MHD_ip_addr_to_key (addr,
-                                    addrlen,
-                                    key))
-    {
-      /* Allow unhandled address types through */
-      free (key);
-      return MHD_YES;
-    }
-  MHD_ip_count_lock (daemon);
-
-  /* Search for the IP address */
-  if (NULL == (nodep = tsearch (key,
-				&daemon->per_ip_connection_count,
-				&MHD_ip_addr_compare)))
-    {
-#ifdef HAVE_MESSAGES
-      MHD_DLOG (daemon,
-		_("Failed to add IP connection count node\n"));
-#endif
-      MHD_ip_count_unlock (daemon);
-      free (key);
-      return MHD_NO;
-    }
-  node = *nodep;
-  /* If we got an existing node back, free the one we created */
-  if (node != key)
-    free(key);
-  key = (struct MHD_IPCount *) node;
-  /* Test if there is room for another connection; if so,
-   * increment count */
-  result = (key->count < daemon->per_ip_connection_limit) ? MHD_YES : MHD_NO;
-  if (MHD_YES == result)
-    ++key->count;
-
-  MHD_ip_count_unlock (daemon);
-  return result;
+  return MHD_ipcount_add_ (daemon->per_ip_connection_count,
+                           addr,
+                           addrlen,
+                           daemon->per_ip_connection_limit);
 }
 
 
 /**
- * Decrement connection count for IP address, removing from table
- * count reaches 0.
+ * Decrement connection count for IP address.
  *
  * @param daemon handle to daemon where connection counts are tracked
  * @param addr address to remove (or decrement counter)
@@ -361,47 +212,12 @@ MHD_ip_limit_del (struct MHD_Daemon *daemon,
 		  const struct sockaddr *addr,
 		  socklen_t addrlen)
 {
-  struct MHD_IPCount search_key;
-  struct MHD_IPCount *found_key;
-  void **nodep;
-
-  daemon = MHD_get_master (daemon);
   /* Ignore if no connection limit assigned */
   if (0 == daemon->per_ip_connection_limit)
     return;
-  /* Initialize search key */
-  if (MHD_NO == MHD_ip_addr_to_key (addr,
-                                    addrlen,
-                                    &search_key))
-    return;
-
-  MHD_ip_count_lock (daemon);
-
-  /* Search for the IP address */
-  if (NULL == (nodep = tfind (&search_key,
-			      &daemon->per_ip_connection_count,
-			      &MHD_ip_addr_compare)))
-    {
-      /* Something's wrong if we couldn't find an IP address
-       * that was previously added */
-      MHD_PANIC (_("Failed to find previously-added IP address\n"));
-    }
-  found_key = (struct MHD_IPCount *) *nodep;
-  /* Validate existing count for IP address */
-  if (0 == found_key->count)
-    {
-      MHD_PANIC (_("Previously-added IP address had counter of zero\n"));
-    }
-  /* Remove the node entirely if count reduces to 0 */
-  if (0 == --found_key->count)
-    {
-      tdelete (found_key,
-	       &daemon->per_ip_connection_count,
-	       &MHD_ip_addr_compare);
-      free (found_key);
-    }
-
-  MHD_ip_count_unlock (daemon);
+  MHD_ipcount_del_ (daemon->per_ip_connection_count,
+                    addr,
+                    addrlen);
 }
 
 
@@ -426,7 +242,7 @@ recv_tls_adapter (struct MHD_Connection *connection,
       connection->daemon->num_tls_read_ready--;
       connection->tls_read_ready = MHD_NO;
     }
-  res = gnutls_record_recv (connection->tls_session,
+  res = gnutls_record_recv (connection->cold->tls_session,
                             other,
                             i);
   if ( (GNUTLS_E_AGAIN == res) ||
@@ -470,7 +286,7 @@ send_tls_adapter (struct MHD_Connection *connection,
 {
   int res;
 
-  res = gnutls_record_send (connection->tls_session,
+  res = gnutls_record_send (connection->cold->tls_session,
                             other,
                             i);
   if ( (GNUTLS_E_AGAIN == res) ||
@@ -491,6 +307,7 @@ send_tls_adapter (struct MHD_Connection *connection,
       MHD_socket_set_error_ (MHD_SCKT_ECONNRESET_);
       return -1;
     }
+  MHD_connection_stats_ (connection)->bytes_sent += res;
   return res;
 }
 
@@ -612,7 +429,107 @@ MHD_TLS_init (struct MHD_Daemon *daemon)
       return -1;
     }
 }
+
+
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+/**
+ * Create a key for encrypting session tickets.
+ *
+ * @param key the key to use, NULL to generate a random key
+ * @param key_size number of bytes in @a key
+ * @param[out] ticket_key set to the key, allocated by GnuTLS
+ * @return #MHD_YES on success, #MHD_NO if @a key_size is wrong
+ *         or on error (out of memory)
+ */
+static int
+make_ticket_key (const void *key,
+                 size_t key_size,
+                 gnutls_datum_t *ticket_key)
+{
+  if (GNUTLS_E_SUCCESS !=
+      gnutls_session_ticket_key_generate (ticket_key))
+    return MHD_NO;
+  if (NULL == key)
+    return MHD_YES;
+  /* GnuTLS does not tell the size of a key otherwise */
+  if (key_size != ticket_key->size)
+    {
+      gnutls_memset (ticket_key->data,
+                     0,
+                     ticket_key->size);
+      gnutls_free (ticket_key->data);
+      ticket_key->data = NULL;
+      return MHD_NO;
+    }
+  memcpy (ticket_key->data,
+          key,
+          key_size);
+  return MHD_YES;
+}
+
+
+/**
+ * Free a key created with #make_ticket_key().
+ *
+ * @param ticket_key the key to free, may be empty
+ */
+static void
+free_ticket_key (gnutls_datum_t *ticket_key)
+{
+  if (NULL == ticket_key->data)
+    return;
+  gnutls_memset (ticket_key->data,
+                 0,
+                 ticket_key->size);
+  gnutls_free (ticket_key->data);
+  ticket_key->data = NULL;
+  ticket_key->size = 0;
+}
 #endif
+#endif
+
+
+/**
+ * Replace the key that session tickets are encrypted with.  Tickets
+ * issued with the old key can no longer be used to resume sessions.
+ * Only possible if the daemon was started with
+ * #MHD_OPTION_HTTPS_SESSION_TICKET_KEY.
+ *
+ * @param daemon daemon to change the key of
+ * @param key the new key, NULL to generate a random key
+ * @param key_size number of bytes in @a key
+ * @return #MHD_YES on success, #MHD_NO if tickets are not enabled,
+ *         @a key_size is wrong or on error (out of memory)
+ * @ingroup specialized
+ */
+int
+MHD_set_https_session_ticket_key (struct MHD_Daemon *daemon,
+                                  const void *key,
+                                  size_t key_size)
+{
+#if HTTPS_SUPPORT && (GNUTLS_VERSION_NUMBER >= 0x030603)
+  gnutls_datum_t fresh;
+  gnutls_datum_t old;
+
+  daemon = MHD_get_master (daemon);
+  if ( (0 == (daemon->options & MHD_USE_TLS)) ||
+       (MHD_YES != daemon->use_session_tickets) )
+    return MHD_NO;
+  if (MHD_YES != make_ticket_key (key,
+                                  key_size,
+                                  &fresh))
+    return MHD_NO;
+  MHD_mutex_lock_chk_ (&daemon->ticket_key_lock);
+  old = daemon->ticket_key;
+  daemon->ticket_key = fresh;
+  MHD_mutex_unlock_chk_ (&daemon->ticket_key_lock);
+  free_ticket_key (&old);
+  return MHD_YES;
+#else
+  (void) daemon; (void) key; (void) key_size;
+  return MHD_NO;
+#endif
+}
 
 
 #undef MHD_get_fdset
@@ -988,7 +905,7 @@ process_urh (struct MHD_UpgradeResponseHandle *urh)
     {
       ssize_t res;
 
-      res = gnutls_record_recv (urh->connection->tls_session,
+      res = gnutls_record_recv (urh->connection->cold->tls_session,
                                 &urh->in_buffer[urh->in_buffer_off],
                                 urh->in_buffer_size - urh->in_buffer_off);
       if ( (GNUTLS_E_AGAIN == res) ||
@@ -1079,7 +996,7 @@ process_urh (struct MHD_UpgradeResponseHandle *urh)
     {
       ssize_t res;
 
-      res = gnutls_record_send (urh->connection->tls_session,
+      res = gnutls_record_send (urh->connection->cold->tls_session,
                                 urh->out_buffer,
                                 urh->out_buffer_off);
       if ( (GNUTLS_E_AGAIN == res) ||
@@ -1126,7 +1043,7 @@ process_urh (struct MHD_UpgradeResponseHandle *urh)
 static void
 thread_main_connection_upgrade (struct MHD_Connection *con)
 {
-  struct MHD_UpgradeResponseHandle *urh = con->urh;
+  struct MHD_UpgradeResponseHandle *urh = con->cold->urh;
 #if HTTPS_SUPPORT
   struct MHD_Daemon *daemon = con->daemon;
 
@@ -1134,7 +1051,8 @@ thread_main_connection_upgrade (struct MHD_Connection *con)
      until the application tells us that it is done
      with the socket; */
   if ( (0 != (daemon->options & MHD_USE_TLS)) &&
-      (0 == (daemon->options & MHD_USE_POLL)))
+       (MHD_NO == urh->direct_io) &&
+       (0 == (daemon->options & MHD_USE_POLL)))
     {
       while (MHD_CONNECTION_UPGRADE == con->state)
         {
@@ -1193,7 +1111,8 @@ thread_main_connection_upgrade (struct MHD_Connection *con)
         }
     }
 #ifdef HAVE_POLL
-  else if (0 != (daemon->options & MHD_USE_TLS))
+  else if ( (0 != (daemon->options & MHD_USE_TLS)) &&
+            (MHD_NO == urh->direct_io) )
     {
       /* use poll() */
       const unsigned int timeout = UINT_MAX;
@@ -1253,13 +1172,43 @@ thread_main_connection_upgrade (struct MHD_Connection *con)
 
   /* Here, we need to block until the application
      signals us that it is done with the socket */
-  MHD_semaphore_down (con->upgrade_sem);
-  MHD_semaphore_destroy (con->upgrade_sem);
-  con->upgrade_sem = NULL;
+  MHD_semaphore_down (con->cold->upgrade_sem);
+  MHD_semaphore_destroy (con->cold->upgrade_sem);
+  con->cold->upgrade_sem = NULL;
   free (urh);
 }
 
 
+/**
+ * Add the statistics @a src to @a dst.
+ *
+ * @param dst statistics to update
+ * @param src statistics to add
+ */
+static void
+add_stats (struct MHD_DaemonStats *dst,
+           const struct MHD_DaemonStats *src)
+{
+  unsigned int i;
+
+  dst->connections_accepted += src->connections_accepted;
+  dst->requests_completed += src->requests_completed;
+  dst->keepalive_reuses += src->keepalive_reuses;
+  dst->bytes_received += src->bytes_received;
+  dst->bytes_sent += src->bytes_sent;
+  dst->bytes_sendfile += src->bytes_sendfile;
+  dst->connections_suspended += src->connections_suspended;
+  for (i = 0; i < sizeof (dst->connections_closed) / sizeof (dst->connections_closed[0]); i++)
+    dst->connections_closed[i] += src->connections_closed[i];
+  /* the loop lag is a gauge of the slowest worker */
+  if (src->loop_lag_usec > dst->loop_lag_usec)
+    dst->loop_lag_usec = src->loop_lag_usec;
+  if (src->loop_lag_max_usec > dst->loop_lag_max_usec)
+    dst->loop_lag_max_usec = src->loop_lag_max_usec;
+  dst->stalls += src->stalls;
+}
+
+
 /**
  * Main function of the thread that handles an individual
  * connection when #MHD_USE_THREAD_PER_CONNECTION is set.
@@ -1528,7 +1477,7 @@ exit:
   if (NULL != daemon->notify_connection)
     con->daemon->notify_connection (daemon->notify_connection_cls,
                                     con,
-                                    &con->socket_context,
+                                    &con->cold->socket_context,
                                     MHD_CONNECTION_NOTIFY_CLOSED);
   if (MHD_INVALID_SOCKET != con->socket_fd)
     {
@@ -1537,6 +1486,11 @@ exit:
       MHD_socket_close_chk_ (con->socket_fd);
       con->socket_fd = MHD_INVALID_SOCKET;
     }
+  /* the statistics of this connection are complete now */
+  MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
+  add_stats (&daemon->stats,
+             &con->cold->stats);
+  MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
   return (MHD_THRD_RTRN_TYPE_) 0;
 }
 
@@ -1574,6 +1528,7 @@ recv_param_adapter (struct MHD_Connection *connection,
                         other,
                         (MHD_SCKT_SEND_SIZE_) i,
                         MSG_NOSIGNAL);
+  MHD_PROBE3 (recv, connection, i, ret);
 #ifdef EPOLL_SUPPORT
   if ( (0 > ret) &&
        (MHD_SCKT_ERR_IS_EAGAIN_ (MHD_socket_get_error_ ())) )
@@ -1659,8 +1614,12 @@ send_param_adapter (struct MHD_Connection *connection,
 #endif /* HAVE_SENDFILE64 */
         {
           /* write successful */
+          MHD_PROBE3 (sendfile, connection, left, ret);
+          MHD_connection_stats_ (connection)->bytes_sent += ret;
+          MHD_connection_stats_ (connection)->bytes_sendfile += ret;
           return ret;
         }
+      MHD_PROBE3 (sendfile, connection, left, ret);
       err = MHD_socket_get_error_();
 #ifdef EPOLL_SUPPORT
       if ( (0 > ret) && (MHD_SCKT_ERR_IS_EAGAIN_(err)) )
@@ -1686,6 +1645,7 @@ send_param_adapter (struct MHD_Connection *connection,
                         other,
                         (MHD_SCKT_SEND_SIZE_) i,
                         MSG_NOSIGNAL);
+  MHD_PROBE3 (send, connection, i, ret);
   err = MHD_socket_get_error_();
 #ifdef EPOLL_SUPPORT
   if ( (0 > ret) &&
@@ -1701,6 +1661,8 @@ send_param_adapter (struct MHD_Connection *connection,
   if ( (0 > ret) &&
        (0 == err) )
     MHD_socket_set_error_ (MHD_SCKT_ECONNRESET_);
+  if (0 < ret)
+    MHD_connection_stats_ (connection)->bytes_sent += ret;
   return ret;
 }
 
@@ -1856,7 +1818,9 @@ internal_add_connection (struct MHD_Daemon *daemon,
 #endif
 #endif
 
-  if (NULL == (connection = malloc (sizeof (struct MHD_Connection))))
+  /* the cold part follows on its own cache lines */
+  if (NULL == (connection = MHD_aligned_malloc_ (CONNECTION_COLD_OFFSET
+                                                 + sizeof (struct MHD_ConnectionCold))))
     {
       eno = errno;
 #ifdef HAVE_MESSAGES
@@ -1873,7 +1837,9 @@ internal_add_connection (struct MHD_Daemon *daemon,
     }
   memset (connection,
           0,
-          sizeof (struct MHD_Connection));
+          CONNECTION_COLD_OFFSET + sizeof (struct MHD_ConnectionCold));
+  connection->cold = (struct MHD_ConnectionCold *)
+    ((char *) connection + CONNECTION_COLD_OFFSET);
   connection->pool = MHD_pool_create (daemon->pool_size);
   if (NULL == connection->pool)
     {
@@ -1886,7 +1852,7 @@ internal_add_connection (struct MHD_Daemon *daemon,
       MHD_ip_limit_del (daemon,
                         addr,
                         addrlen);
-      free (connection);
+      MHD_aligned_free_ (connection);
 #if ENOMEM
       errno = ENOMEM;
 #endif
@@ -1894,7 +1860,7 @@ internal_add_connection (struct MHD_Daemon *daemon,
     }
 
   connection->connection_timeout = daemon->connection_timeout;
-  if (NULL == (connection->addr = malloc (addrlen)))
+  if (NULL == (connection->cold->addr = malloc (addrlen)))
     {
       eno = errno;
 #ifdef HAVE_MESSAGES
@@ -1907,17 +1873,19 @@ internal_add_connection (struct MHD_Daemon *daemon,
                         addr,
                         addrlen);
       MHD_pool_destroy (connection->pool);
-      free (connection);
+      MHD_aligned_free_ (connection);
       errno = eno;
       return MHD_NO;
     }
-  memcpy (connection->addr,
+  memcpy (connection->cold->addr,
           addr,
           addrlen);
-  connection->addr_len = addrlen;
+  connection->cold->addr_len = addrlen;
   connection->socket_fd = client_socket;
   connection->daemon = daemon;
   connection->last_activity = MHD_monotonic_sec_counter();
+  if (MHD_YES == daemon->request_timing)
+    connection->cold->phase_start = MHD_monotonic_usec_counter ();
 
   /* set default connection handlers  */
   MHD_set_http_callbacks_ (connection);
@@ -1945,15 +1913,15 @@ internal_add_connection (struct MHD_Daemon *daemon,
       connection->send_cls = &send_tls_adapter;
       connection->state = MHD_TLS_CONNECTION_INIT;
       MHD_set_https_callbacks (connection);
-      gnutls_init (&connection->tls_session,
+      gnutls_init (&connection->cold->tls_session,
                    GNUTLS_SERVER);
-      gnutls_priority_set (connection->tls_session,
+      gnutls_priority_set (connection->cold->tls_session,
 			   daemon->priority_cache);
       switch (daemon->cred_type)
         {
           /* set needed credentials for certificate authentication. */
         case GNUTLS_CRD_CERTIFICATE:
-          gnutls_credentials_set (connection->tls_session,
+          gnutls_credentials_set (connection->cold->tls_session,
 				  GNUTLS_CRD_CERTIFICATE,
 				  daemon->x509_cred);
           break;
@@ -1967,27 +1935,48 @@ internal_add_connection (struct MHD_Daemon *daemon,
           MHD_ip_limit_del (daemon,
                             addr,
                             addrlen);
-          free (connection->addr);
-          free (connection);
+          free (connection->cold->addr);
+          MHD_aligned_free_ (connection);
           MHD_PANIC (_("Unknown credential type"));
 #if EINVAL
 	  errno = EINVAL;
 #endif
  	  return MHD_NO;
         }
-      gnutls_transport_set_ptr (connection->tls_session,
+      if (NULL != daemon->tls_session_cache)
+        MHD_tls_session_cache_attach_ (daemon->tls_session_cache,
+                                       connection->cold->tls_session);
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+      if (MHD_YES == daemon->use_session_tickets)
+        {
+          struct MHD_Daemon *master = MHD_get_master (daemon);
+
+          /* GnuTLS copies the key */
+          MHD_mutex_lock_chk_ (&master->ticket_key_lock);
+          gnutls_session_ticket_enable_server (connection->cold->tls_session,
+                                               &master->ticket_key);
+          MHD_mutex_unlock_chk_ (&master->ticket_key_lock);
+        }
+#endif
+      gnutls_transport_set_ptr (connection->cold->tls_session,
 				(gnutls_transport_ptr_t) connection);
-      gnutls_transport_set_pull_function (connection->tls_session,
+      gnutls_transport_set_pull_function (connection->cold->tls_session,
 					  (gnutls_pull_func) &recv_param_adapter);
-      gnutls_transport_set_push_function (connection->tls_session,
+      gnutls_transport_set_push_function (connection->cold->tls_session,
 					  (gnutls_push_func) &send_param_adapter);
 
       if (daemon->https_mem_trust)
-	  gnutls_certificate_server_set_request (connection->tls_session,
+	  gnutls_certificate_server_set_request (connection->cold->tls_session,
 						 GNUTLS_CERT_REQUEST);
     }
 #endif
 
+  /* before other threads can see the connection, so that its
+     'accept' probe and its trace record come first; if adding the
+     connection fails below, 'reject' and a close record follow */
+  MHD_PROBE2 (accept, connection, client_socket);
+  if (NULL != daemon->trace)
+    connection->cold->trace_id = MHD_trace_connection_ (daemon->trace);
   if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
   {
     MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
@@ -2007,13 +1996,13 @@ internal_add_connection (struct MHD_Daemon *daemon,
   if (NULL != daemon->notify_connection)
     daemon->notify_connection (daemon->notify_connection_cls,
                                connection,
-                               &connection->socket_context,
+                               &connection->cold->socket_context,
                                MHD_CONNECTION_NOTIFY_STARTED);
 
   /* attempt to create handler thread */
   if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
     {
-      if (! MHD_create_named_thread_ (&connection->pid,
+      if (! MHD_create_named_thread_ (&connection->cold->pid,
                                       "MHD-connection",
                                       daemon->thread_stack_size,
                                       &thread_main_handle_connection,
@@ -2073,12 +2062,24 @@ internal_add_connection (struct MHD_Daemon *daemon,
     }
 #endif
   daemon->connections++;
+  if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
+  daemon->stats.connections_accepted++;
+  if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
   return MHD_YES;
  cleanup:
+  MHD_PROBE2 (reject, connection, eno);
+  if (NULL != daemon->trace)
+    MHD_trace_record_ (daemon->trace,
+                       connection->cold->trace_id,
+                       MHD_TRACE_CLOSE,
+                       NULL,
+                       0);
   if (NULL != daemon->notify_connection)
     daemon->notify_connection (daemon->notify_connection_cls,
                                connection,
-                               &connection->socket_context,
+                               &connection->cold->socket_context,
                                MHD_CONNECTION_NOTIFY_CLOSED);
   MHD_socket_close_chk_ (client_socket);
   MHD_ip_limit_del (daemon,
@@ -2100,8 +2101,8 @@ internal_add_connection (struct MHD_Daemon *daemon,
   if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
     MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
   MHD_pool_destroy (connection->pool);
-  free (connection->addr);
-  free (connection);
+  free (connection->cold->addr);
+  MHD_aligned_free_ (connection);
   errno = eno;
   return MHD_NO;
 }
@@ -2136,12 +2137,33 @@ internal_add_connection (struct MHD_Daemon *daemon,
  */
 void
 MHD_suspend_connection (struct MHD_Connection *connection)
+{
+  if (MHD_USE_SUSPEND_RESUME != (connection->daemon->options & MHD_USE_SUSPEND_RESUME))
+    MHD_PANIC (_("Cannot suspend connections without enabling MHD_USE_SUSPEND_RESUME!\n"));
+  MHD_suspend_connection_ (connection,
+                           MHD_NO);
+}
+
+
+/**
+ * Suspend handling of network data for @a connection, like
+ * #MHD_suspend_connection().  MHD itself uses this (with
+ * @a internally set) to park connections, for example while a step
+ * of their TLS handshake runs in another thread; this works without
+ * #MHD_USE_SUSPEND_RESUME and is neither counted in the statistics
+ * nor reported to the probes.
+ *
+ * @param connection the connection to suspend
+ * @param internally #MHD_YES if MHD suspends the connection,
+ *        #MHD_NO if the application does
+ */
+void
+MHD_suspend_connection_ (struct MHD_Connection *connection,
+                         int internally)
 {
   struct MHD_Daemon *daemon;
 
   daemon = connection->daemon;
-  if (MHD_USE_SUSPEND_RESUME != (daemon->options & MHD_USE_SUSPEND_RESUME))
-    MHD_PANIC (_("Cannot suspend connections without enabling MHD_USE_SUSPEND_RESUME!\n"));
   if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
     {
       MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
@@ -2163,6 +2185,8 @@ MHD_suspend_connection (struct MHD_Connection *connection)
   DLL_insert (daemon->suspended_connections_head,
               daemon->suspended_connections_tail,
               connection);
+  if (MHD_NO == internally)
+    MHD_PROBE1 (suspend, connection);
 #ifdef EPOLL_SUPPORT
   if (0 != (daemon->options & MHD_USE_EPOLL))
     {
@@ -2186,6 +2210,9 @@ MHD_suspend_connection (struct MHD_Connection *connection)
     }
 #endif
   connection->suspended = MHD_YES;
+  connection->suspended_internally = internally;
+  if (MHD_NO == internally)
+    daemon->stats.connections_suspended++;
   if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
     MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
 }
@@ -2201,12 +2228,26 @@ MHD_suspend_connection (struct MHD_Connection *connection)
  */
 void
 MHD_resume_connection (struct MHD_Connection *connection)
+{
+  if (MHD_USE_SUSPEND_RESUME != (connection->daemon->options & MHD_USE_SUSPEND_RESUME))
+    MHD_PANIC (_("Cannot resume connections without enabling MHD_USE_SUSPEND_RESUME!\n"));
+  MHD_resume_connection_ (connection);
+}
+
+
+/**
+ * Resume handling of network data for @a connection, suspended with
+ * #MHD_suspend_connection_() (by the application or internally).
+ * Does not require #MHD_USE_SUSPEND_RESUME.
+ *
+ * @param connection the connection to resume
+ */
+void
+MHD_resume_connection_ (struct MHD_Connection *connection)
 {
   struct MHD_Daemon *daemon;
 
   daemon = connection->daemon;
-  if (MHD_USE_SUSPEND_RESUME != (daemon->options & MHD_USE_SUSPEND_RESUME))
-    MHD_PANIC (_("Cannot resume connections without enabling MHD_USE_SUSPEND_RESUME!\n"));
   if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
     MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
   connection->resuming = MHD_YES;
@@ -2224,6 +2265,133 @@ MHD_resume_connection (struct MHD_Connection *connection)
 }
 
 
+/**
+ * Queue the same @a response for many suspended connections of one
+ * daemon and resume them, waking up each worker thread only once.
+ *
+ * @param connections the suspended connections
+ * @param num_connections number of entries in @a connections
+ * @param status_code HTTP status code (i.e. #MHD_HTTP_OK)
+ * @param response response to transmit
+ * @return number of connections the response was queued for
+ */
+unsigned int
+MHD_broadcast_response (struct MHD_Connection *const *connections,
+                        unsigned int num_connections,
+                        unsigned int status_code,
+                        struct MHD_Response *response)
+{
+  struct MHD_Daemon *master;
+  struct MHD_Daemon *daemon;
+  struct MHD_Connection *connection;
+  unsigned int num_daemons;
+  unsigned int queued;
+  unsigned int i;
+  char *woken;
+
+  if ( (NULL == response) ||
+       (0 == num_connections) )
+    return 0;
+  master = connections[0]->daemon;
+  if (NULL != master->master)
+    master = master->master;
+  if (MHD_USE_SUSPEND_RESUME != (master->options & MHD_USE_SUSPEND_RESUME))
+    MHD_PANIC (_("Cannot resume connections without enabling MHD_USE_SUSPEND_RESUME!\n"));
+  num_daemons = (NULL != master->worker_pool) ? master->worker_pool_size : 1;
+  /* if this fails, we simply wake up all workers */
+  woken = calloc (num_daemons, 1);
+  if (0 != (master->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_lock_chk_ (&master->cleanup_connection_mutex);
+
+  /* attach the response; nobody looks at suspended connections */
+  queued = 0;
+  for (i = 0; i < num_connections; i++)
+    {
+      connection = connections[i];
+      if ( ( (connection->daemon != master) &&
+             (connection->daemon->master != master) ) ||
+           (MHD_YES != connection->suspended) ||
+           (MHD_NO != connection->resuming) ||
+           (MHD_NO == MHD_connection_set_response_ (connection,
+                                                    status_code,
+                                                    response)) )
+        continue;
+      queued++;
+    }
+  if (0 == queued)
+    {
+      if (0 != (master->options & MHD_USE_THREAD_PER_CONNECTION))
+        MHD_mutex_unlock_chk_ (&master->cleanup_connection_mutex);
+      free (woken);
+      return 0;
+    }
+  /* take all references at once, before any worker may finish */
+  MHD_mutex_lock_chk_ (&response->mutex);
+  response->reference_count += queued;
+  MHD_mutex_unlock_chk_ (&response->mutex);
+
+  /* mark the connections for resumption */
+  for (i = 0; i < num_connections; i++)
+    {
+      connection = connections[i];
+      daemon = connection->daemon;
+      if ( ( (daemon != master) &&
+             (daemon->master != master) ) ||
+           (MHD_YES != connection->suspended) ||
+           (MHD_NO != connection->resuming) ||
+           (response != connection->response) )
+        continue;
+      connection->resuming = MHD_YES;
+      daemon->resuming = MHD_YES;
+      if (NULL != woken)
+        woken[(daemon == master) ? 0 : (daemon - master->worker_pool)] = 1;
+    }
+  if (0 != (master->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_unlock_chk_ (&master->cleanup_connection_mutex);
+
+  /* and signal each affected worker once */
+  for (i = 0; i < num_daemons; i++)
+    {
+      if ( (NULL != woken) &&
+           (0 == woken[i]) )
+        continue;
+      daemon = (NULL != master->worker_pool) ? &master->worker_pool[i] : master;
+      if ( (MHD_ITC_IS_VALID_(daemon->itc)) &&
+           (! MHD_itc_activate_ (daemon->itc, "r")) )
+        {
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (daemon,
+                    _("Failed to signal resume via inter-thread communication channel."));
+#endif
+        }
+    }
+  free (woken);
+  return queued;
+}
+
+
+/**
+ * Check if connections of @a daemon may get suspended, by the
+ * application (#MHD_USE_SUSPEND_RESUME) or internally while a step
+ * of their TLS handshake runs in another thread, so that the event
+ * loops have to resume them.
+ *
+ * @param daemon daemon to check
+ * @return #MHD_YES if connections may get suspended
+ */
+static int
+may_suspend (const struct MHD_Daemon *daemon)
+{
+  if (MHD_USE_SUSPEND_RESUME == (daemon->options & MHD_USE_SUSPEND_RESUME))
+    return MHD_YES;
+#if HTTPS_SUPPORT
+  if (0 != daemon->tls_handshake_threads)
+    return MHD_YES;
+#endif
+  return MHD_NO;
+}
+
+
 /**
  * Run through the suspended connections and move any that are no
  * longer suspended back to the active state.
@@ -2260,6 +2428,8 @@ resume_suspended_connections (struct MHD_Daemon *daemon)
       if (MHD_NO == pos->resuming)
         continue;
       ret = MHD_YES;
+      if (MHD_NO == pos->suspended_internally)
+        MHD_PROBE1 (resume, pos);
       DLL_remove (daemon->suspended_connections_head,
                   daemon->suspended_connections_tail,
                   pos);
@@ -2291,7 +2461,10 @@ resume_suspended_connections (struct MHD_Daemon *daemon)
           pos->epoll_state &= ~MHD_EPOLL_STATE_SUSPENDED;
         }
 #endif
+      if (MHD_NO == pos->suspended_internally)
+        daemon->stats.connections_suspended--;
       pos->suspended = MHD_NO;
+      pos->suspended_internally = MHD_NO;
       pos->resuming = MHD_NO;
     }
   if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
@@ -2451,6 +2624,15 @@ MHD_accept_connection (struct MHD_Daemon *daemon)
         }
       return MHD_NO;
     }
+  if ( (MHD_YES == daemon->ip_filter_enabled) &&
+       (MHD_NO == MHD_ip_filter_check_ (MHD_get_master (daemon),
+                                        addr,
+                                        addrlen)) )
+    {
+      /* shed the connection before anything is allocated for it */
+      MHD_socket_close_chk_ (s);
+      return MHD_YES;
+    }
 #if !defined(USE_ACCEPT4) || !defined(HAVE_SOCK_NONBLOCK)
   if (! MHD_socket_nonblocking_ (s))
     {
@@ -2486,6 +2668,51 @@ MHD_accept_connection (struct MHD_Daemon *daemon)
 }
 
 
+/**
+ * The event loop of @a daemon stopped waiting for activity; start
+ * timing the iteration for #MHD_OPTION_STALL_THRESHOLD.
+ *
+ * @param daemon daemon (worker) running the event loop
+ */
+static void
+loop_woken (struct MHD_Daemon *daemon)
+{
+  if ( (0 != daemon->stall_threshold) &&
+       (0 == daemon->loop_wake) )
+    daemon->loop_wake = MHD_monotonic_usec_counter ();
+}
+
+
+/**
+ * An iteration of the event loop of @a daemon is done; update the
+ * loop lag and report the iteration if it took too long.
+ *
+ * @param daemon daemon (worker) running the event loop
+ */
+static void
+loop_done (struct MHD_Daemon *daemon)
+{
+  uint64_t lag;
+
+  if (0 == daemon->loop_wake)
+    return;
+  lag = MHD_monotonic_usec_counter () - daemon->loop_wake;
+  daemon->loop_wake = 0;
+  if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
+  daemon->stats.loop_lag_usec = lag;
+  if (lag > daemon->stats.loop_lag_max_usec)
+    daemon->stats.loop_lag_max_usec = lag;
+  if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
+  if (lag >= daemon->stall_threshold)
+    MHD_stall_report_ (daemon,
+                       NULL,
+                       MHD_STALL_EVENT_LOOP,
+                       lag);
+}
+
+
 /**
  * Free resources associated with all closed connections.
  * (destroy responses, free buffers, etc.).  All closed
@@ -2506,17 +2733,17 @@ MHD_cleanup_connections (struct MHD_Daemon *daemon)
 		  daemon->cleanup_tail,
 		  pos);
       if ( (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION)) &&
-	   (MHD_NO == pos->thread_joined) )
+	   (MHD_NO == pos->cold->thread_joined) )
 	{
-	  if (! MHD_join_thread_ (pos->pid))
+	  if (! MHD_join_thread_ (pos->cold->pid))
 	    {
 	      MHD_PANIC (_("Failed to join a thread\n"));
 	    }
 	}
       MHD_pool_destroy (pos->pool);
 #if HTTPS_SUPPORT
-      if (NULL != pos->tls_session)
-	gnutls_deinit (pos->tls_session);
+      if (NULL != pos->cold->tls_session)
+	gnutls_deinit (pos->cold->tls_session);
 #endif
       daemon->connections--;
       daemon->at_limit = MHD_NO;
@@ -2525,11 +2752,11 @@ MHD_cleanup_connections (struct MHD_Daemon *daemon)
       if (NULL != daemon->notify_connection)
         daemon->notify_connection (daemon->notify_connection_cls,
                                    pos,
-                                   &pos->socket_context,
+                                   &pos->cold->socket_context,
                                    MHD_CONNECTION_NOTIFY_CLOSED);
       MHD_ip_limit_del (daemon,
-                        pos->addr,
-                        pos->addr_len);
+                        pos->cold->addr,
+                        pos->cold->addr_len);
 #ifdef EPOLL_SUPPORT
       if (0 != (daemon->options & MHD_USE_EPOLL))
         {
@@ -2567,9 +2794,9 @@ MHD_cleanup_connections (struct MHD_Daemon *daemon)
 	{
 	  MHD_socket_close_chk_ (pos->socket_fd);
 	}
-      if (NULL != pos->addr)
-	free (pos->addr);
-      free (pos);
+      if (NULL != pos->cold->addr)
+	free (pos->cold->addr);
+      MHD_aligned_free_ (pos);
     }
   if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
     MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
@@ -2629,7 +2856,7 @@ MHD_get_timeout (struct MHD_Daemon *daemon,
 	    earliest_deadline = pos->last_activity + pos->connection_timeout;
 #if HTTPS_SUPPORT
 	  if (  (0 != (daemon->options & MHD_USE_TLS)) &&
-		(0 != gnutls_record_check_pending (pos->tls_session)) )
+		(0 != gnutls_record_check_pending (pos->cold->tls_session)) )
 	    earliest_deadline = 0;
 #endif
 	  have_timeout = MHD_YES;
@@ -2645,7 +2872,7 @@ MHD_get_timeout (struct MHD_Daemon *daemon,
 	earliest_deadline = pos->last_activity + pos->connection_timeout;
 #if HTTPS_SUPPORT
       if (  (0 != (daemon->options & MHD_USE_TLS)) &&
-	    (0 != gnutls_record_check_pending (pos->tls_session)) )
+	    (0 != gnutls_record_check_pending (pos->cold->tls_session)) )
 	earliest_deadline = 0;
 #endif
       have_timeout = MHD_YES;
@@ -2806,7 +3033,7 @@ MHD_select (struct MHD_Daemon *daemon,
   err_state = MHD_NO;
   if (0 == (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
     {
-      if ( (MHD_USE_SUSPEND_RESUME == (daemon->options & MHD_USE_SUSPEND_RESUME)) &&
+      if ( (MHD_YES == may_suspend (daemon)) &&
            (MHD_YES == resume_suspended_connections (daemon)) )
         may_block = MHD_NO;
 
@@ -2926,6 +3153,7 @@ MHD_select (struct MHD_Daemon *daemon,
 #endif
       return MHD_NO;
     }
+  loop_woken (daemon);
   if (MHD_YES == MHD_run_from_select (daemon,
                                       &rs,
                                       &ws,
@@ -2956,7 +3184,7 @@ MHD_poll_all (struct MHD_Daemon *daemon,
   struct MHD_UpgradeResponseHandle *urhn;
 #endif
 
-  if ( (MHD_USE_SUSPEND_RESUME == (daemon->options & MHD_USE_SUSPEND_RESUME)) &&
+  if ( (MHD_YES == may_suspend (daemon)) &&
        (MHD_YES == resume_suspended_connections (daemon)) )
     may_block = MHD_NO;
 
@@ -3085,6 +3313,7 @@ MHD_poll_all (struct MHD_Daemon *daemon,
         free(p);
 	return MHD_NO;
       }
+    loop_woken (daemon);
     /* handle ITC FD */
     /* do it before any other processing so
        new signals will be processed in next loop */
@@ -3474,6 +3703,7 @@ MHD_epoll (struct MHD_Daemon *daemon,
 #endif
 	  return MHD_NO;
 	}
+      loop_woken (daemon);
       for (i=0;i<(unsigned int) num_events;i++)
 	{
           /* First, check for the values of `ptr` that would indicate
@@ -3549,7 +3779,7 @@ MHD_epoll (struct MHD_Daemon *daemon,
 
   /* we handle resumes here because we may have ready connections
      that will not be placed into the epoll list immediately. */
-  if ( (MHD_USE_SUSPEND_RESUME == (daemon->options & MHD_USE_SUSPEND_RESUME)) &&
+  if ( (MHD_YES == may_suspend (daemon)) &&
        (MHD_YES == resume_suspended_connections (daemon)) )
     may_block = MHD_NO;
 
@@ -3640,6 +3870,7 @@ MHD_run (struct MHD_Daemon *daemon)
     MHD_select (daemon, MHD_NO);
     /* MHD_select does MHD_cleanup_connections already */
   }
+  loop_done (daemon);
   return MHD_YES;
 }
 
@@ -3667,31 +3898,12 @@ MHD_select_thread (void *cls)
       else
 	MHD_select (daemon, MHD_YES);
       MHD_cleanup_connections (daemon);
+      loop_done (daemon);
     }
   return (MHD_THRD_RTRN_TYPE_)0;
 }
 
 
-/**
- * Process escape sequences ('%HH') Updates val in place; the
- * result should be UTF-8 encoded and cannot be larger than the input.
- * The result must also still be 0-terminated.
- *
- * @param cls closure (use NULL)
- * @param connection handle to connection, not used
- * @param val value to unescape (modified in the process)
- * @return length of the resulting val (strlen(val) maybe
- *  shorter afterwards due to elimination of escape sequences)
- */
-static size_t
-unescape_wrapper (void *cls,
-                  struct MHD_Connection *connection,
-                  char *val)
-{
-  return MHD_http_unescape (val);
-}
-
-
 /**
  * Start a webserver on the given port.  Variadic version of
  * #MHD_start_daemon_va.
@@ -3930,6 +4142,23 @@ parse_options_va (struct MHD_Daemon *daemon,
           daemon->per_ip_connection_limit = va_arg (ap,
                                                     unsigned int);
           break;
+        case MHD_OPTION_IP_FILTER:
+          daemon->ip_filter = va_arg (ap,
+                                      struct MHD_IPFilter *);
+          daemon->ip_filter_enabled = MHD_YES;
+          break;
+        case MHD_OPTION_PER_IP_CONNECTION_IPV6_PREFIX:
+          daemon->per_ip_ipv6_prefix = va_arg (ap,
+                                               unsigned int);
+          if (daemon->per_ip_ipv6_prefix > 128)
+            {
+#ifdef HAVE_MESSAGES
+              MHD_DLOG (daemon,
+                        _("IPv6 prefix length must not exceed 128\n"));
+#endif
+              return MHD_NO;
+            }
+          break;
         case MHD_OPTION_SOCK_ADDR:
           *servaddr = va_arg (ap,
                               const struct sockaddr *);
@@ -4074,6 +4303,48 @@ parse_options_va (struct MHD_Daemon *daemon,
             daemon->cert_callback = va_arg (ap,
                                             gnutls_certificate_retrieve_function2 *);
           break;
+#endif
+        case MHD_OPTION_HTTPS_SESSION_CACHE:
+          daemon->tls_session_cache_size = va_arg (ap,
+                                                   unsigned int);
+#ifdef HAVE_MESSAGES
+          if (0 == (daemon->options & MHD_USE_TLS))
+            MHD_DLOG (daemon,
+                      _("MHD HTTPS option %d passed to MHD but MHD_USE_TLS not set\n"),
+                      opt);
+#endif
+          break;
+        case MHD_OPTION_HTTPS_HANDSHAKE_THREADS:
+          daemon->tls_handshake_threads = va_arg (ap,
+                                                  unsigned int);
+#ifdef HAVE_MESSAGES
+          if (0 == (daemon->options & MHD_USE_TLS))
+            MHD_DLOG (daemon,
+                      _("MHD HTTPS option %d passed to MHD but MHD_USE_TLS not set\n"),
+                      opt);
+#endif
+          break;
+        case MHD_OPTION_HTTPS_SESSION_TICKET_KEY:
+#if GNUTLS_VERSION_NUMBER < 0x030603
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (daemon,
+                    _("MHD_OPTION_HTTPS_SESSION_TICKET_KEY requires building MHD with GnuTLS >= 3.6.3\n"));
+#endif
+          return MHD_NO;
+#else
+          daemon->https_mem_ticket_key_size = va_arg (ap,
+                                                      size_t);
+          daemon->https_mem_ticket_key = va_arg (ap,
+                                                 const void *);
+          if (0 != (daemon->options & MHD_USE_TLS))
+            daemon->use_session_tickets = MHD_YES;
+#ifdef HAVE_MESSAGES
+          else
+            MHD_DLOG (daemon,
+                      _("MHD HTTPS option %d passed to MHD but MHD_USE_TLS not set\n"),
+                      opt);
+#endif
+          break;
 #endif
 #endif
 #ifdef DAUTH_SUPPORT
@@ -4087,6 +4358,16 @@ parse_options_va (struct MHD_Daemon *daemon,
 	  daemon->nonce_nc_size = va_arg (ap,
                                           unsigned int);
 	  break;
+#endif
+#ifdef BAUTH_SUPPORT
+        case MHD_OPTION_BASIC_AUTH_CACHE_SIZE:
+          daemon->basic_auth_cache_size = va_arg (ap,
+                                                  unsigned int);
+          break;
+        case MHD_OPTION_BASIC_AUTH_CACHE_TIMEOUT:
+          daemon->basic_auth_cache_timeout = va_arg (ap,
+                                                     unsigned int);
+          break;
 #endif
 	case MHD_OPTION_LISTEN_SOCKET:
 	  daemon->socket_fd = va_arg (ap,
@@ -4123,6 +4404,59 @@ parse_options_va (struct MHD_Daemon *daemon,
 	  daemon->listen_backlog_size = va_arg (ap,
                                                 unsigned int);
 	  break;
+        case MHD_OPTION_REQUEST_TIMING:
+          daemon->request_timing = (0 != va_arg (ap,
+                                                 unsigned int))
+            ? MHD_YES
+            : MHD_NO;
+          break;
+        case MHD_OPTION_STALL_THRESHOLD:
+          daemon->stall_threshold = va_arg (ap,
+                                            unsigned int);
+          break;
+        case MHD_OPTION_STALL_CALLBACK:
+          daemon->stall_cb = va_arg (ap,
+                                     MHD_StallCallback);
+          daemon->stall_cb_cls = va_arg (ap,
+                                         void *);
+          break;
+        case MHD_OPTION_TRACE_FILE:
+          daemon->trace_filename = va_arg (ap,
+                                           const char *);
+          break;
+        case MHD_OPTION_RESPONSE_COMPRESSION:
+#ifdef COMPRESSION_SUPPORT
+          daemon->compress_responses = MHD_YES;
+          daemon->compress_min_size = va_arg (ap,
+                                              size_t);
+          break;
+#else
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (daemon,
+                    _("MHD_OPTION_RESPONSE_COMPRESSION requires building MHD with zlib\n"));
+#endif
+          return MHD_NO;
+#endif
+        case MHD_OPTION_REQUEST_DECOMPRESSION:
+#ifdef COMPRESSION_SUPPORT
+          daemon->inflate_max_size = va_arg (ap,
+                                             size_t);
+          if (0 == daemon->inflate_max_size)
+            {
+#ifdef HAVE_MESSAGES
+              MHD_DLOG (daemon,
+                        _("MHD_OPTION_REQUEST_DECOMPRESSION requires a non-zero limit\n"));
+#endif
+              return MHD_NO;
+            }
+          break;
+#else
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (daemon,
+                    _("MHD_OPTION_REQUEST_DECOMPRESSION requires building MHD with zlib\n"));
+#endif
+          return MHD_NO;
+#endif
 	case MHD_OPTION_ARRAY:
 	  oa = va_arg (ap, struct MHD_OptionItem*);
 	  i = 0;
@@ -4134,6 +4468,8 @@ parse_options_va (struct MHD_Daemon *daemon,
 		case MHD_OPTION_CONNECTION_MEMORY_LIMIT:
 		case MHD_OPTION_CONNECTION_MEMORY_INCREMENT:
 		case MHD_OPTION_THREAD_STACK_SIZE:
+		case MHD_OPTION_RESPONSE_COMPRESSION:
+		case MHD_OPTION_REQUEST_DECOMPRESSION:
 		  if (MHD_YES != parse_options (daemon,
 						servaddr,
 						opt,
@@ -4146,10 +4482,17 @@ parse_options_va (struct MHD_Daemon *daemon,
 		case MHD_OPTION_CONNECTION_LIMIT:
 		case MHD_OPTION_CONNECTION_TIMEOUT:
 		case MHD_OPTION_PER_IP_CONNECTION_LIMIT:
+		case MHD_OPTION_PER_IP_CONNECTION_IPV6_PREFIX:
+		case MHD_OPTION_BASIC_AUTH_CACHE_SIZE:
+		case MHD_OPTION_BASIC_AUTH_CACHE_TIMEOUT:
+		case MHD_OPTION_HTTPS_SESSION_CACHE:
+		case MHD_OPTION_HTTPS_HANDSHAKE_THREADS:
 		case MHD_OPTION_THREAD_POOL_SIZE:
                 case MHD_OPTION_TCP_FASTOPEN_QUEUE_SIZE:
 		case MHD_OPTION_LISTENING_ADDRESS_REUSE:
 		case MHD_OPTION_LISTEN_BACKLOG_SIZE:
+		case MHD_OPTION_REQUEST_TIMING:
+		case MHD_OPTION_STALL_THRESHOLD:
 		  if (MHD_YES != parse_options (daemon,
 						servaddr,
 						opt,
@@ -4185,6 +4528,8 @@ parse_options_va (struct MHD_Daemon *daemon,
 		case MHD_OPTION_HTTPS_PRIORITIES:
 		case MHD_OPTION_ARRAY:
                 case MHD_OPTION_HTTPS_CERT_CALLBACK:
+		case MHD_OPTION_IP_FILTER:
+		case MHD_OPTION_TRACE_FILE:
 		  if (MHD_YES != parse_options (daemon,
 						servaddr,
 						opt,
@@ -4198,6 +4543,7 @@ parse_options_va (struct MHD_Daemon *daemon,
 		case MHD_OPTION_URI_LOG_CALLBACK:
 		case MHD_OPTION_EXTERNAL_LOGGER:
 		case MHD_OPTION_UNESCAPE_CALLBACK:
+		case MHD_OPTION_STALL_CALLBACK:
 		  if (MHD_YES != parse_options (daemon,
 						servaddr,
 						opt,
@@ -4208,6 +4554,7 @@ parse_options_va (struct MHD_Daemon *daemon,
 		  break;
 		  /* options taking size_t-number followed by pointer */
 		case MHD_OPTION_DIGEST_AUTH_RANDOM:
+		case MHD_OPTION_HTTPS_SESSION_TICKET_KEY:
 		  if (MHD_YES != parse_options (daemon,
 						servaddr,
 						opt,
@@ -4232,7 +4579,10 @@ parse_options_va (struct MHD_Daemon *daemon,
 #ifdef HAVE_MESSAGES
           if ( ( (opt >= MHD_OPTION_HTTPS_MEM_KEY) &&
                  (opt <= MHD_OPTION_HTTPS_PRIORITIES) ) ||
-               (opt == MHD_OPTION_HTTPS_MEM_TRUST))
+               (opt == MHD_OPTION_HTTPS_MEM_TRUST) ||
+               (opt == MHD_OPTION_HTTPS_SESSION_CACHE) ||
+               (opt == MHD_OPTION_HTTPS_SESSION_TICKET_KEY) ||
+               (opt == MHD_OPTION_HTTPS_HANDSHAKE_THREADS) )
             {
               MHD_DLOG (daemon,
 			_("MHD HTTPS option %d passed to MHD compiled without HTTPS support\n"),
@@ -4325,7 +4675,7 @@ setup_epoll_to_listen (struct MHD_Daemon *daemon)
       return MHD_NO;
     }
   if ( (MHD_ITC_IS_VALID_(daemon->itc)) &&
-       (MHD_USE_SUSPEND_RESUME == (daemon->options & MHD_USE_SUSPEND_RESUME)) )
+       (MHD_YES == may_suspend (daemon)) )
     {
       event.events = EPOLLIN | EPOLLET;
       event.data.ptr = NULL;
@@ -4435,9 +4785,10 @@ MHD_start_daemon_va (unsigned int flags,
   daemon->default_handler_cls = dh_cls;
   daemon->connections = 0;
   daemon->connection_limit = MHD_MAX_CONNECTIONS_DEFAULT;
+  daemon->per_ip_ipv6_prefix = 128;
   daemon->pool_size = MHD_POOL_SIZE_DEFAULT;
   daemon->pool_increment = MHD_BUF_INC_SIZE;
-  daemon->unescape_callback = &unescape_wrapper;
+  daemon->unescape_callback = &MHD_unescape_wrapper_;
   daemon->connection_timeout = 0;       /* no timeout */
   MHD_itc_set_invalid_ (daemon->itc);
 #ifdef SOMAXCONN
@@ -4485,7 +4836,10 @@ MHD_start_daemon_va (unsigned int flags,
 #ifdef DAUTH_SUPPORT
   daemon->digest_auth_rand_size = 0;
   daemon->digest_auth_random = NULL;
-  daemon->nonce_nc_size = 4; /* tiny */
+  daemon->nonce_nc_size = UINT_MAX; /* chosen from the connection limit */
+#endif
+#ifdef BAUTH_SUPPORT
+  daemon->basic_auth_cache_timeout = 60;
 #endif
 #if HTTPS_SUPPORT
   if (0 != (flags & MHD_USE_TLS))
@@ -4507,56 +4861,91 @@ MHD_start_daemon_va (unsigned int flags,
       free (daemon);
       return NULL;
     }
-#ifdef DAUTH_SUPPORT
-  if (daemon->nonce_nc_size > 0)
+#if HTTPS_SUPPORT
+  /* the TLS handshake threads wake up the event loop through the
+     ITC once they are done with a step */
+  if ( (0 != (flags & MHD_USE_TLS)) &&
+       (0 != daemon->tls_handshake_threads) &&
+       (0 != (flags & MHD_USE_SELECT_INTERNALLY)) &&
+       (0 == (flags & MHD_USE_THREAD_PER_CONNECTION)) &&
+       (MHD_ITC_IS_INVALID_ (daemon->itc)) )
     {
-      if ( ( (size_t) (daemon->nonce_nc_size * sizeof (struct MHD_NonceNc))) /
-	   sizeof(struct MHD_NonceNc) != daemon->nonce_nc_size)
-	{
+      if (! MHD_itc_init_ (daemon->itc))
+        {
 #ifdef HAVE_MESSAGES
-	  MHD_DLOG (daemon,
-		    _("Specified value for NC_SIZE too large\n"));
-#endif
-#if HTTPS_SUPPORT
-	  if (0 != (flags & MHD_USE_TLS))
-	    gnutls_priority_deinit (daemon->priority_cache);
+          MHD_DLOG (daemon,
+                    _("Failed to create inter-thread communication channel: %s\n"),
+                    MHD_itc_last_strerror_ ());
 #endif
-	  free (daemon);
-	  return NULL;
-	}
-      daemon->nnc = malloc (daemon->nonce_nc_size * sizeof (struct MHD_NonceNc));
-      if (NULL == daemon->nnc)
-	{
+          MHD_itc_set_invalid_ (daemon->itc);
+        }
+      else if ( (0 == (flags & (MHD_USE_POLL | MHD_USE_EPOLL))) &&
+                (! MHD_SCKT_FD_FITS_FDSET_(MHD_itc_r_fd_ (daemon->itc),
+                                           NULL)) )
+        {
 #ifdef HAVE_MESSAGES
-	  MHD_DLOG (daemon,
-		    _("Failed to allocate memory for nonce-nc map: %s\n"),
-		    MHD_strerror_ (errno));
-#endif
-#if HTTPS_SUPPORT
-	  if (0 != (flags & MHD_USE_TLS))
-	    gnutls_priority_deinit (daemon->priority_cache);
+          MHD_DLOG (daemon,
+                    _("file descriptor for inter-thread communication channel exceeds maximum value\n"));
 #endif
-	  free (daemon);
-	  return NULL;
-	}
+          MHD_itc_destroy_chk_ (daemon->itc);
+          MHD_itc_set_invalid_ (daemon->itc);
+        }
+      if (MHD_ITC_IS_INVALID_ (daemon->itc))
+        {
+          if (NULL != daemon->priority_cache)
+            gnutls_priority_deinit (daemon->priority_cache);
+          free (daemon);
+          return NULL;
+        }
     }
-
-  if (! MHD_mutex_init_ (&daemon->nnc_lock))
+#endif
+#ifdef DAUTH_SUPPORT
+  if (UINT_MAX == daemon->nonce_nc_size)
+    {
+      /* about one nonce in use per connection; capped, as each
+         entry takes more than 150 bytes */
+      daemon->nonce_nc_size = daemon->connection_limit;
+      if (daemon->nonce_nc_size < 16)
+        daemon->nonce_nc_size = 16;
+      if (daemon->nonce_nc_size > 4096)
+        daemon->nonce_nc_size = 4096;
+    }
+  /* zero means digest authentication is not used */
+  if ( (0 != daemon->nonce_nc_size) &&
+       (NULL == (daemon->nonce_table
+                 = MHD_nonce_table_create_ (daemon->nonce_nc_size,
+                                            daemon->digest_auth_random,
+                                            daemon->digest_auth_rand_size))) )
     {
 #ifdef HAVE_MESSAGES
-      MHD_DLOG (daemon,
-		_("MHD failed to initialize nonce-nc mutex\n"));
+      if (ENOSYS == errno)
+        MHD_DLOG (daemon,
+                  _("No random bytes available for the nonce-nc map key\n"));
+      else
+        MHD_DLOG (daemon,
+                  _("Failed to allocate memory for nonce-nc map: %s\n"),
+                  MHD_strerror_ (errno));
 #endif
 #if HTTPS_SUPPORT
       if (0 != (flags & MHD_USE_TLS))
-	gnutls_priority_deinit (daemon->priority_cache);
+        gnutls_priority_deinit (daemon->priority_cache);
 #endif
-      free (daemon->nnc);
       free (daemon);
       return NULL;
     }
 #endif
 
+  if ( (MHD_YES == daemon->ip_filter_enabled) &&
+       (! MHD_mutex_init_ (&daemon->ip_filter_lock)) )
+    {
+#ifdef HAVE_MESSAGES
+      MHD_DLOG (daemon,
+		_("MHD failed to initialize IP filter mutex\n"));
+#endif
+      daemon->ip_filter_enabled = MHD_NO;
+      goto free_and_fail;
+    }
+
   /* Thread pooling currently works only with internal select thread model */
   if ( (0 == (flags & MHD_USE_SELECT_INTERNALLY)) &&
        (daemon->worker_pool_size > 0) )
@@ -4815,7 +5204,8 @@ MHD_start_daemon_va (unsigned int flags,
       socket_fd = daemon->socket_fd;
     }
 
-  if (!MHD_socket_nonblocking_ (socket_fd))
+  if ( (MHD_INVALID_SOCKET != socket_fd) &&
+       (! MHD_socket_nonblocking_ (socket_fd)) )
     {
 #ifdef HAVE_MESSAGES
       MHD_DLOG (daemon,
@@ -4832,7 +5222,8 @@ MHD_start_daemon_va (unsigned int flags,
           goto free_and_fail;
         }
     }
-  if ( (!MHD_SCKT_FD_FITS_FDSET_(socket_fd,
+  if ( (MHD_INVALID_SOCKET != socket_fd) &&
+       (!MHD_SCKT_FD_FITS_FDSET_(socket_fd,
                                  NULL)) &&
        (0 == (flags & (MHD_USE_POLL | MHD_USE_EPOLL)) ) )
     {
@@ -4848,8 +5239,7 @@ MHD_start_daemon_va (unsigned int flags,
 
 #ifdef EPOLL_SUPPORT
   if ( (0 != (flags & MHD_USE_EPOLL)) &&
-       (0 == daemon->worker_pool_size) &&
-       (0 == (daemon->options & MHD_USE_NO_LISTEN_SOCKET)) )
+       (0 == daemon->worker_pool_size) )
     {
       if (0 != (flags & MHD_USE_THREAD_PER_CONNECTION))
 	{
@@ -4873,16 +5263,105 @@ MHD_start_daemon_va (unsigned int flags,
     }
 #endif
 
-  if (! MHD_mutex_init_ (&daemon->per_ip_connection_mutex))
+  if ( (NULL != daemon->trace_filename) &&
+       (NULL == (daemon->trace = MHD_trace_open_ (daemon->trace_filename))) )
     {
 #ifdef HAVE_MESSAGES
       MHD_DLOG (daemon,
-                _("MHD failed to initialize IP connection limit mutex\n"));
+                _("Failed to open trace file `%s': %s\n"),
+                daemon->trace_filename,
+                MHD_strerror_ (errno));
 #endif
       if (MHD_INVALID_SOCKET != socket_fd)
         MHD_socket_close_chk_ (socket_fd);
       goto free_and_fail;
     }
+  if ( (0 != daemon->per_ip_connection_limit) &&
+       (NULL == (daemon->per_ip_connection_count
+                 = MHD_ipcount_create_ (daemon->connection_limit,
+                                        daemon->per_ip_ipv6_prefix))) )
+    {
+#ifdef HAVE_MESSAGES
+      if (ENOSYS == errno)
+        MHD_DLOG (daemon,
+                  _("No random bytes available for the IP connection limit table key\n"));
+      else
+        MHD_DLOG (daemon,
+                  _("MHD failed to initialize IP connection limit table\n"));
+#endif
+      if (MHD_INVALID_SOCKET != socket_fd)
+        MHD_socket_close_chk_ (socket_fd);
+      goto free_and_fail;
+    }
+#ifdef BAUTH_SUPPORT
+  if ( (0 != daemon->basic_auth_cache_size) &&
+       (NULL == (daemon->basic_auth_cache
+                 = MHD_auth_cache_create_ (daemon->basic_auth_cache_size,
+                                           daemon->basic_auth_cache_timeout))) )
+    {
+#ifdef HAVE_MESSAGES
+      if (ENOSYS == errno)
+        MHD_DLOG (daemon,
+                  _("No random bytes available for the basic authentication cache key\n"));
+      else
+        MHD_DLOG (daemon,
+                  _("Failed to allocate memory for basic authentication cache\n"));
+#endif
+      if (MHD_INVALID_SOCKET != socket_fd)
+        MHD_socket_close_chk_ (socket_fd);
+      goto free_and_fail;
+    }
+#endif
+#if HTTPS_SUPPORT
+  if ( (0 != (flags & MHD_USE_TLS)) &&
+       (0 != daemon->tls_session_cache_size) &&
+       (NULL == (daemon->tls_session_cache
+                 = MHD_tls_session_cache_create_ (daemon->tls_session_cache_size))) )
+    {
+#ifdef HAVE_MESSAGES
+      if (ENOSYS == errno)
+        MHD_DLOG (daemon,
+                  _("No random bytes available for the TLS session cache key\n"));
+      else
+        MHD_DLOG (daemon,
+                  _("Failed to allocate memory for TLS session cache\n"));
+#endif
+      if (MHD_INVALID_SOCKET != socket_fd)
+        MHD_socket_close_chk_ (socket_fd);
+      goto free_and_fail;
+    }
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+  if (MHD_YES == daemon->use_session_tickets)
+    {
+      gnutls_datum_t ticket_key;
+
+      if (MHD_YES != make_ticket_key (daemon->https_mem_ticket_key,
+                                      daemon->https_mem_ticket_key_size,
+                                      &ticket_key))
+        {
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (daemon,
+                    _("Failed to set up the session ticket key (wrong size?)\n"));
+#endif
+          if (MHD_INVALID_SOCKET != socket_fd)
+            MHD_socket_close_chk_ (socket_fd);
+          goto free_and_fail;
+        }
+      if (! MHD_mutex_init_ (&daemon->ticket_key_lock))
+        {
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (daemon,
+                    _("MHD failed to initialize session ticket key mutex\n"));
+#endif
+          free_ticket_key (&ticket_key);
+          if (MHD_INVALID_SOCKET != socket_fd)
+            MHD_socket_close_chk_ (socket_fd);
+          goto free_and_fail;
+        }
+      daemon->ticket_key = ticket_key;
+    }
+#endif
+#endif
   if (! MHD_mutex_init_ (&daemon->cleanup_connection_mutex))
     {
 #ifdef HAVE_MESSAGES
@@ -4907,9 +5386,38 @@ MHD_start_daemon_va (unsigned int flags,
       if (MHD_INVALID_SOCKET != socket_fd)
         MHD_socket_close_chk_ (socket_fd);
       MHD_mutex_destroy_chk_ (&daemon->cleanup_connection_mutex);
-      MHD_mutex_destroy_chk_ (&daemon->per_ip_connection_mutex);
       goto free_and_fail;
     }
+  if ( (0 != (flags & MHD_USE_TLS)) &&
+       (0 != daemon->tls_handshake_threads) &&
+       (0 == (flags & MHD_USE_THREAD_PER_CONNECTION)) )
+    {
+      if (0 == (flags & MHD_USE_SELECT_INTERNALLY))
+        {
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (daemon,
+                    _("MHD_OPTION_HTTPS_HANDSHAKE_THREADS requires MHD_USE_SELECT_INTERNALLY\n"));
+#endif
+          if (MHD_INVALID_SOCKET != socket_fd)
+            MHD_socket_close_chk_ (socket_fd);
+          MHD_mutex_destroy_chk_ (&daemon->cleanup_connection_mutex);
+          goto free_and_fail;
+        }
+      daemon->tls_handshake_pool
+        = MHD_tls_handshake_pool_create_ (daemon->tls_handshake_threads,
+                                          daemon->thread_stack_size);
+      if (NULL == daemon->tls_handshake_pool)
+        {
+#ifdef HAVE_MESSAGES
+          MHD_DLOG (daemon,
+                    _("Failed to create TLS handshake threads\n"));
+#endif
+          if (MHD_INVALID_SOCKET != socket_fd)
+            MHD_socket_close_chk_ (socket_fd);
+          MHD_mutex_destroy_chk_ (&daemon->cleanup_connection_mutex);
+          goto free_and_fail;
+        }
+    }
 #endif
   if ( ( (0 != (flags & MHD_USE_THREAD_PER_CONNECTION)) ||
 	 ( (0 != (flags & MHD_USE_SELECT_INTERNALLY)) &&
@@ -4928,7 +5436,6 @@ MHD_start_daemon_va (unsigned int flags,
 		MHD_strerror_ (errno));
 #endif
       MHD_mutex_destroy_chk_ (&daemon->cleanup_connection_mutex);
-      MHD_mutex_destroy_chk_ (&daemon->per_ip_connection_mutex);
       if (MHD_INVALID_SOCKET != socket_fd)
         MHD_socket_close_chk_ (socket_fd);
       goto free_and_fail;
@@ -4946,9 +5453,11 @@ MHD_start_daemon_va (unsigned int flags,
 
       i = 0; /* we need this in case fcntl or malloc fails */
 
-      /* Allocate memory for pooled objects */
-      daemon->worker_pool = malloc (sizeof (struct MHD_Daemon)
-                                    * daemon->worker_pool_size);
+      /* Allocate memory for pooled objects; cache-line aligned so
+         that the state of one worker does not share a cache line
+         with the configuration of its neighbour (see @e state_pad) */
+      daemon->worker_pool = MHD_aligned_malloc_ (sizeof (struct MHD_Daemon)
+                                                 * daemon->worker_pool_size);
       if (NULL == daemon->worker_pool)
         goto thread_failed;
 
@@ -5049,9 +5558,8 @@ thread_failed:
       if (MHD_INVALID_SOCKET != socket_fd)
         MHD_socket_close_chk_ (socket_fd);
       MHD_mutex_destroy_chk_ (&daemon->cleanup_connection_mutex);
-      MHD_mutex_destroy_chk_ (&daemon->per_ip_connection_mutex);
       if (NULL != daemon->worker_pool)
-        free (daemon->worker_pool);
+        MHD_aligned_free_ (daemon->worker_pool);
       goto free_and_fail;
     }
 
@@ -5060,12 +5568,14 @@ thread_failed:
      with a smaller number of threads than had been
      requested. */
   daemon->worker_pool_size = i;
+  daemon->ip_filter = NULL; /* still owned by the application */
   MHD_stop_daemon (daemon);
   return NULL;
 
  free_and_fail:
   /* clean up basic memory state in 'daemon' and return NULL to
      indicate failure */
+  MHD_trace_close_ (daemon->trace);
 #if HTTPS_SUPPORT
 #ifdef EPOLL_SUPPORT
   if (MHD_YES == daemon->upgrade_fd_in_epoll)
@@ -5085,14 +5595,28 @@ thread_failed:
 #endif
 #endif
 #endif
+  MHD_ipcount_destroy_ (daemon->per_ip_connection_count);
 #ifdef DAUTH_SUPPORT
-  free (daemon->nnc);
-  MHD_mutex_destroy_chk_ (&daemon->nnc_lock);
+  MHD_nonce_table_destroy_ (daemon->nonce_table);
+#endif
+#ifdef BAUTH_SUPPORT
+  MHD_auth_cache_destroy_ (daemon->basic_auth_cache);
 #endif
 #if HTTPS_SUPPORT
+  MHD_tls_handshake_pool_destroy_ (daemon->tls_handshake_pool);
+  MHD_tls_session_cache_destroy_ (daemon->tls_session_cache);
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+  if (NULL != daemon->ticket_key.data)
+    {
+      free_ticket_key (&daemon->ticket_key);
+      MHD_mutex_destroy_chk_ (&daemon->ticket_key_lock);
+    }
+#endif
   if (0 != (flags & MHD_USE_TLS))
     gnutls_priority_deinit (daemon->priority_cache);
 #endif
+  if (MHD_YES == daemon->ip_filter_enabled)
+    MHD_mutex_destroy_chk_ (&daemon->ip_filter_lock);
   if (MHD_ITC_IS_VALID_(daemon->itc))
     MHD_itc_destroy_chk_ (daemon->itc);
   free (daemon);
@@ -5175,11 +5699,11 @@ close_all_connections (struct MHD_Daemon *daemon)
       pos = daemon->connections_head;
       while (NULL != pos)
       {
-        if (MHD_YES != pos->thread_joined)
+        if (MHD_YES != pos->cold->thread_joined)
           {
-            if (! MHD_join_thread_ (pos->pid))
+            if (! MHD_join_thread_ (pos->cold->pid))
               MHD_PANIC (_("Failed to join a thread\n"));
-            pos->thread_joined = MHD_YES;
+            pos->cold->thread_joined = MHD_YES;
             /* The thread may have concurrently modified the DLL,
                need to restart from the beginning */
             pos = daemon->connections_head;
@@ -5192,7 +5716,7 @@ close_all_connections (struct MHD_Daemon *daemon)
   while (NULL != (pos = daemon->connections_head))
   {
     if ( (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION)) &&
-         (MHD_YES != pos->thread_joined) )
+         (MHD_YES != pos->cold->thread_joined) )
       MHD_PANIC (_("Failed to join a thread\n"));
     close_connection (pos);
   }
@@ -5242,7 +5766,12 @@ MHD_stop_daemon (struct MHD_Daemon *daemon)
   if (NULL == daemon)
     return;
 
-  if (0 != (MHD_USE_SUSPEND_RESUME & daemon->options))
+#if HTTPS_SUPPORT
+  /* resumes the connections in the handshake queue; afterwards,
+     handshakes run in the event loops */
+  MHD_tls_handshake_pool_stop_ (daemon->tls_handshake_pool);
+#endif
+  if (MHD_YES == may_suspend (daemon))
     resume_suspended_connections (daemon);
   daemon->shutdown = MHD_YES;
   fd = daemon->socket_fd;
@@ -5280,6 +5809,7 @@ MHD_stop_daemon (struct MHD_Daemon *daemon)
 #endif
 #ifdef EPOLL_SUPPORT
   if ( (0 != (daemon->options & MHD_USE_EPOLL)) &&
+       (0 != (daemon->options & MHD_USE_SELECT_INTERNALLY)) &&
        (-1 != daemon->epoll_fd) &&
        (MHD_INVALID_SOCKET == fd) )
     epoll_shutdown (daemon);
@@ -5307,6 +5837,9 @@ MHD_stop_daemon (struct MHD_Daemon *daemon)
 	  if (!MHD_join_thread_ (daemon->worker_pool[i].pid))
             MHD_PANIC (_("Failed to join a thread\n"));
 	  close_all_connections (&daemon->worker_pool[i]);
+#ifdef COMPRESSION_SUPPORT
+	  MHD_compression_daemon_cleanup_ (&daemon->worker_pool[i]);
+#endif
 	  MHD_mutex_destroy_chk_ (&daemon->worker_pool[i].cleanup_connection_mutex);
 #ifdef EPOLL_SUPPORT
 	  if (-1 != daemon->worker_pool[i].epoll_fd)
@@ -5325,7 +5858,7 @@ MHD_stop_daemon (struct MHD_Daemon *daemon)
                 }
 	    }
 	}
-      free (daemon->worker_pool);
+      MHD_aligned_free_ (daemon->worker_pool);
     }
   else
     {
@@ -5341,6 +5874,9 @@ MHD_stop_daemon (struct MHD_Daemon *daemon)
 	}
     }
   close_all_connections (daemon);
+#ifdef COMPRESSION_SUPPORT
+  MHD_compression_daemon_cleanup_ (daemon);
+#endif
   if (MHD_INVALID_SOCKET != fd)
     MHD_socket_close_chk_ (fd);
 
@@ -5357,6 +5893,15 @@ MHD_stop_daemon (struct MHD_Daemon *daemon)
       if (daemon->x509_cred)
         gnutls_certificate_free_credentials (daemon->x509_cred);
     }
+  MHD_tls_handshake_pool_destroy_ (daemon->tls_handshake_pool);
+  MHD_tls_session_cache_destroy_ (daemon->tls_session_cache);
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+  if (NULL != daemon->ticket_key.data)
+    {
+      free_ticket_key (&daemon->ticket_key);
+      MHD_mutex_destroy_chk_ (&daemon->ticket_key_lock);
+    }
+#endif
 #endif
 #ifdef EPOLL_SUPPORT
   if ( (0 != (daemon->options & MHD_USE_EPOLL)) &&
@@ -5370,11 +5915,19 @@ MHD_stop_daemon (struct MHD_Daemon *daemon)
 #endif
 
 #ifdef DAUTH_SUPPORT
-  free (daemon->nnc);
-  MHD_mutex_destroy_chk_ (&daemon->nnc_lock);
+  MHD_nonce_table_destroy_ (daemon->nonce_table);
 #endif
-  MHD_mutex_destroy_chk_ (&daemon->per_ip_connection_mutex);
+#ifdef BAUTH_SUPPORT
+  MHD_auth_cache_destroy_ (daemon->basic_auth_cache);
+#endif
+  MHD_ipcount_destroy_ (daemon->per_ip_connection_count);
+  MHD_trace_close_ (daemon->trace);
   MHD_mutex_destroy_chk_ (&daemon->cleanup_connection_mutex);
+  if (MHD_YES == daemon->ip_filter_enabled)
+    {
+      MHD_ip_filter_destroy (daemon->ip_filter);
+      MHD_mutex_destroy_chk_ (&daemon->ip_filter_lock);
+    }
 
   if (MHD_ITC_IS_VALID_(daemon->itc))
     MHD_itc_destroy_chk_ (daemon->itc);
@@ -5431,6 +5984,77 @@ MHD_get_daemon_info (struct MHD_Daemon *daemon,
 }
 
 
+/**
+ * Obtain the runtime statistics of a daemon, summed over all
+ * worker threads.
+ *
+ * @param daemon daemon to get the statistics of
+ * @param[out] stats set to the statistics
+ * @return #MHD_YES on success, #MHD_NO if @a stats is NULL
+ * @ingroup specialized
+ */
+int
+MHD_get_daemon_stats (struct MHD_Daemon *daemon,
+                      struct MHD_DaemonStats *stats)
+{
+  unsigned int i;
+
+  if (NULL == stats)
+    return MHD_NO;
+  /* with MHD_USE_THREAD_PER_CONNECTION, the connection threads
+     add their statistics under the lock when they exit */
+  if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
+  memcpy (stats,
+          &daemon->stats,
+          sizeof (struct MHD_DaemonStats));
+  if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
+  if (NULL != daemon->worker_pool)
+    for (i = 0; i < daemon->worker_pool_size; i++)
+      add_stats (stats,
+                 &daemon->worker_pool[i].stats);
+  return MHD_YES;
+}
+
+
+/**
+ * Obtain the histogram of the durations of one phase of the
+ * requests, merged over all worker threads.
+ *
+ * @param daemon daemon started with #MHD_OPTION_REQUEST_TIMING
+ * @param phase the phase
+ * @param[out] histogram set to the histogram
+ * @return #MHD_YES on success, #MHD_NO if the request timing is
+ *         not enabled or @a phase is invalid
+ * @ingroup specialized
+ */
+int
+MHD_get_phase_histogram (struct MHD_Daemon *daemon,
+                         enum MHD_RequestPhase phase,
+                         struct MHD_Histogram *histogram)
+{
+  unsigned int i;
+
+  if ( (MHD_YES != daemon->request_timing) ||
+       ((unsigned int) phase >= MHD_REQUEST_PHASE_COUNT) ||
+       (NULL == histogram) )
+    return MHD_NO;
+  if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_lock_chk_ (&daemon->cleanup_connection_mutex);
+  memcpy (histogram,
+          &daemon->phase_histograms[phase],
+          sizeof (struct MHD_Histogram));
+  if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION))
+    MHD_mutex_unlock_chk_ (&daemon->cleanup_connection_mutex);
+  if (NULL != daemon->worker_pool)
+    for (i = 0; i < daemon->worker_pool_size; i++)
+      MHD_histogram_merge (histogram,
+                           &daemon->worker_pool[i].phase_histograms[phase]);
+  return MHD_YES;
+}
+
+
 /**
  * Sets the global error handler to a different implementation.  @a cb
  * will only be called in the case of typically fatal, serious
@@ -5596,6 +6220,12 @@ MHD_is_feature_supported(enum MHD_FEATURE feature)
       return MHD_YES;
 #else
       return MHD_NO;
+#endif
+    case MHD_FEATURE_COMPRESSION:
+#ifdef COMPRESSION_SUPPORT
+      return MHD_YES;
+#else
+      return MHD_NO;
 #endif
     }
   return MHD_NO;
@@ -26,6 +26,7 @@
 #include <limits.h>
 #include "internal.h"
 #include "md5.h"
+#include "noncetable.h"
 #include "mhd_mono_clock.h"
 #include "mhd_str.h"
 #include "mhd_compat.h"
@@ -93,28 +94,21 @@ cvthex (const unsigned char *bin,
 
 
 /**
- * calculate H(A1) as per RFC2617 spec and store the
- * result in 'sessionkey'.
+ * calculate the hash of the credentials, the binary H(A1) for
+ * the "md5" algorithm, as per RFC2617 spec.
  *
- * @param alg The hash algorithm used, can be "md5" or "md5-sess"
  * @param username A `char *' pointer to the username value
  * @param realm A `char *' pointer to the realm value
  * @param password A `char *' pointer to the password value
- * @param nonce A `char *' pointer to the nonce value
- * @param cnonce A `char *' pointer to the cnonce value
- * @param sessionkey pointer to buffer of HASH_MD5_HEX_LEN+1 bytes
+ * @param[out] digest set to MD5(username:realm:password)
  */
 static void
-digest_calc_ha1 (const char *alg,
-		 const char *username,
-		 const char *realm,
-		 const char *password,
-		 const char *nonce,
-		 const char *cnonce,
-		 char sessionkey[HASH_MD5_HEX_LEN + 1])
+digest_calc_userdigest (const char *username,
+                        const char *realm,
+                        const char *password,
+                        uint8_t digest[MHD_MD5_DIGEST_SIZE])
 {
   struct MD5Context md5;
-  unsigned char ha1[MD5_DIGEST_SIZE];
 
   MD5Init (&md5);
   MD5Update (&md5,
@@ -132,8 +126,34 @@ digest_calc_ha1 (const char *alg,
   MD5Update (&md5,
              (const unsigned char *) password,
              strlen (password));
-  MD5Final (ha1,
+  MD5Final (digest,
             &md5);
+}
+
+
+/**
+ * calculate H(A1) as per RFC2617 spec from the hash of the
+ * credentials and store the result in 'sessionkey'.
+ *
+ * @param alg The hash algorithm used, can be "md5" or "md5-sess"
+ * @param digest MD5(username:realm:password)
+ * @param nonce A `char *' pointer to the nonce value
+ * @param cnonce A `char *' pointer to the cnonce value
+ * @param sessionkey pointer to buffer of HASH_MD5_HEX_LEN+1 bytes
+ */
+static void
+digest_calc_ha1_from_digest (const char *alg,
+                             const uint8_t digest[MHD_MD5_DIGEST_SIZE],
+                             const char *nonce,
+                             const char *cnonce,
+                             char sessionkey[HASH_MD5_HEX_LEN + 1])
+{
+  struct MD5Context md5;
+  unsigned char ha1[MD5_DIGEST_SIZE];
+
+  memcpy (ha1,
+          digest,
+          sizeof (ha1));
   if (MHD_str_equal_caseless_(alg,
                               "md5-sess"))
     {
@@ -380,78 +400,19 @@ check_nonce_nc (struct MHD_Connection *connection,
 		uint64_t nc)
 {
   struct MHD_Daemon *daemon = connection->daemon;
-  struct MHD_NonceNc *nn;
-  uint32_t off;
-  uint32_t mod;
-  const char *np;
-
-  if (MAX_NONCE_LENGTH <= strlen (nonce))
-    return MHD_NO; /* This should be impossible, but static analysis
-                      tools have a hard time with it *and* this also
-                      protects against unsafe modifications that may
-                      happen in the future... */
-  mod = daemon->nonce_nc_size;
-  if (0 == mod)
-    return MHD_NO; /* no array! */
-  /* super-fast xor-based "hash" function for HT lookup in nonce array */
-  off = 0;
-  np = nonce;
-  while ('\0' != *np)
-    {
-      off = (off << 8) | (*np ^ (off >> 24));
-      np++;
-    }
-  off = off % mod;
-  /*
-   * Look for the nonce, if it does exist and its corresponding
-   * nonce counter is less than the current nonce counter by 1,
-   * then only increase the nonce counter by one.
-   */
-  nn = &daemon->nnc[off];
-  MHD_mutex_lock_chk_ (&daemon->nnc_lock);
-  if (0 == nc)
-    {
-      /* Fresh nonce, reinitialize array */
-      strcpy (nn->nonce,
-              nonce);
-      nn->nc = 0;
-      nn->nmask = 0;
-      MHD_mutex_unlock_chk_ (&daemon->nnc_lock);
-      return MHD_YES;
-    }
-  /* Note that we use 64 here, as we do not store the
-     bit for 'nn->nc' itself in 'nn->nmask' */
-  if ( (nc < nn->nc) &&
-       (nc + 64 > nc /* checking for overflow */) &&
-       (nc + 64 >= nn->nc) &&
-       (0 == ((1LLU << (nn->nc - nc - 1)) & nn->nmask)) )
-    {
-      /* Out-of-order nonce, but within 64-bit bitmask, set bit */
-      nn->nmask |= (1LLU < (nn->nc - nc - 1));
-      MHD_mutex_unlock_chk_ (&daemon->nnc_lock);
-      return MHD_YES;
-    }
 
-  if ( (nc <= nn->nc) ||
-       (0 != strcmp (nn->nonce,
-                     nonce)) )
-    {
-      /* Nonce does not match, fail */
-      MHD_mutex_unlock_chk_ (&daemon->nnc_lock);
+  if (NULL == daemon->nonce_table)
+    return MHD_NO; /* no table! */
+  if (MHD_YES ==
+      MHD_nonce_table_check_ (daemon->nonce_table,
+                              nonce,
+                              nc))
+    return MHD_YES;
 #ifdef HAVE_MESSAGES
-      MHD_DLOG (daemon,
-		_("Stale nonce received.  If this happens a lot, you should probably increase the size of the nonce array.\n"));
+  MHD_DLOG (daemon,
+            _("Stale nonce received.  If this happens a lot, you should probably increase the size of the nonce array.\n"));
 #endif
-      return MHD_NO;
-    }
-  /* Nonce is larger, shift bitmask and bump limit */
-  if (64 > nc - nn->nc)
-    nn->nmask <<= (nc - nn->nc); /* small jump, less than mask width */
-  else
-    nn->nmask = 0; /* big jump, unset all bits in the mask */
-  nn->nc = nc;
-  MHD_mutex_unlock_chk_ (&daemon->nnc_lock);
-  return MHD_YES;
+  return MHD_NO;
 }
 
 
@@ -655,25 +616,80 @@ check_argument_match (struct MHD_Connection *connection,
 }
 
 
+/**
+ * Compute the hash that binds a cached authentication with a nonce
+ * to the request and credentials it was done for.
+ *
+ * @param table the nonce table
+ * @param connection The MHD connection structure
+ * @param realm The realm presented to the client
+ * @param username The username needs to be authenticated
+ * @param password The password used in the authentication, or NULL
+ * @param digest H(A1) used in the authentication if @a password is NULL
+ * @return the hash
+ */
+static uint64_t
+calculate_auth_bind (const struct MHD_NonceTable *table,
+                     struct MHD_Connection *connection,
+                     const char *realm,
+                     const char *username,
+                     const char *password,
+                     const uint8_t digest[MHD_MD5_DIGEST_SIZE])
+{
+  uint64_t bind;
+
+  bind = MHD_nonce_table_hash_ (table,
+                                0,
+                                connection->method,
+                                strlen (connection->method));
+  bind = MHD_nonce_table_hash_ (table,
+                                bind,
+                                connection->url,
+                                strlen (connection->url));
+  bind = MHD_nonce_table_hash_ (table,
+                                bind,
+                                realm,
+                                strlen (realm));
+  bind = MHD_nonce_table_hash_ (table,
+                                bind,
+                                username,
+                                strlen (username));
+  if (NULL != password)
+    return MHD_nonce_table_hash_ (table,
+                                  bind,
+                                  password,
+                                  strlen (password));
+  bind = MHD_nonce_table_hash_ (table,
+                                bind,
+                                "",
+                                0);
+  return MHD_nonce_table_hash_ (table,
+                                bind,
+                                digest,
+                                MHD_MD5_DIGEST_SIZE);
+}
+
+
 /**
  * Authenticates the authorization header sent by the client
  *
  * @param connection The MHD connection structure
  * @param realm The realm presented to the client
  * @param username The username needs to be authenticated
- * @param password The password used in the authentication
+ * @param password The password used in the authentication, or NULL
+ * @param digest H(A1) used in the authentication if @a password is NULL
  * @param nonce_timeout The amount of time for a nonce to be
  * 			invalid in seconds
  * @return #MHD_YES if authenticated, #MHD_NO if not,
  * 			#MHD_INVALID_NONCE if nonce is invalid
- * @ingroup authentication
  */
-int
-MHD_digest_auth_check (struct MHD_Connection *connection,
-		       const char *realm,
-		       const char *username,
-		       const char *password,
-		       unsigned int nonce_timeout)
+static int
+digest_auth_check_all (struct MHD_Connection *connection,
+                       const char *realm,
+                       const char *username,
+                       const char *password,
+                       const uint8_t digest[MHD_MD5_DIGEST_SIZE],
+                       unsigned int nonce_timeout)
 {
   struct MHD_Daemon *daemon = connection->daemon;
   size_t len;
@@ -687,10 +703,13 @@ MHD_digest_auth_check (struct MHD_Connection *connection,
   char ha1[HASH_MD5_HEX_LEN + 1];
   char respexp[HASH_MD5_HEX_LEN + 1];
   char noncehashexp[NONCE_STD_LEN + 1];
+  uint8_t userdigest[MHD_MD5_DIGEST_SIZE];
   uint32_t nonce_time;
   uint32_t t;
   size_t left; /* number of characters left in 'header' for 'uri' */
   uint64_t nci;
+  uint64_t bind;
+  int cached;
 
   header = MHD_lookup_connection_value (connection,
 					MHD_HEADER_KIND,
@@ -773,26 +792,48 @@ MHD_digest_auth_check (struct MHD_Connection *connection,
       return MHD_INVALID_NONCE;
     }
 
-  calculate_nonce (nonce_time,
-                   connection->method,
-                   daemon->digest_auth_random,
-                   daemon->digest_auth_rand_size,
-                   connection->url,
-                   realm,
-                   noncehashexp);
   /*
-   * Second level vetting for the nonce validity
-   * if the timestamp attached to the nonce is valid
-   * and possibly fabricated (in case of an attack)
-   * the attacker must also know the random seed to be
-   * able to generate a "sane" nonce, which if he does
-   * not, the nonce fabrication process going to be
-   * very hard to achieve.
+   * If this nonce was used before to authenticate the same
+   * credentials for the same request, it was already checked
+   * below and we also know H(A1) already.
    */
-
-  if (0 != strcmp (nonce, noncehashexp))
+  cached = MHD_NO;
+  bind = 0;
+  if (NULL != daemon->nonce_table)
     {
-      return MHD_INVALID_NONCE;
+      bind = calculate_auth_bind (daemon->nonce_table,
+                                  connection,
+                                  realm,
+                                  username,
+                                  password,
+                                  digest);
+      cached = MHD_nonce_table_get_auth_ (daemon->nonce_table,
+                                          nonce,
+                                          bind,
+                                          userdigest);
+    }
+  if (MHD_NO == cached)
+    {
+      calculate_nonce (nonce_time,
+                       connection->method,
+                       daemon->digest_auth_random,
+                       daemon->digest_auth_rand_size,
+                       connection->url,
+                       realm,
+                       noncehashexp);
+      /*
+       * Second level vetting for the nonce validity
+       * if the timestamp attached to the nonce is valid
+       * and possibly fabricated (in case of an attack)
+       * the attacker must also know the random seed to be
+       * able to generate a "sane" nonce, which if he does
+       * not, the nonce fabrication process going to be
+       * very hard to achieve.
+       */
+      if (0 != strcmp (nonce, noncehashexp))
+        {
+          return MHD_INVALID_NONCE;
+        }
     }
   if ( (0 == lookup_sub_value (cnonce,
                                sizeof (cnonce),
@@ -866,13 +907,23 @@ MHD_digest_auth_check (struct MHD_Connection *connection,
       return MHD_NO;
     }
 
-    digest_calc_ha1 ("md5",
-                     username,
-                     realm,
-                     password,
-                     nonce,
-                     cnonce,
-                     ha1);
+    if (MHD_NO == cached)
+      {
+        if (NULL != password)
+          digest_calc_userdigest (username,
+                                  realm,
+                                  password,
+                                  userdigest);
+        else
+          memcpy (userdigest,
+                  digest,
+                  sizeof (userdigest));
+      }
+    digest_calc_ha1_from_digest ("md5",
+                                 userdigest,
+                                 nonce,
+                                 cnonce,
+                                 ha1);
     digest_calc_response (ha1,
 			  nonce,
 			  nc,
@@ -920,14 +971,79 @@ MHD_digest_auth_check (struct MHD_Connection *connection,
       }
     }
     free (uri);
-    return (0 == strcmp(response,
-                        respexp))
-      ? MHD_YES
-      : MHD_NO;
+    if (0 != strcmp(response,
+                    respexp))
+      return MHD_NO;
+    if ( (MHD_NO == cached) &&
+         (NULL != daemon->nonce_table) )
+      MHD_nonce_table_set_auth_ (daemon->nonce_table,
+                                 nonce,
+                                 bind,
+                                 userdigest);
+    return MHD_YES;
   }
 }
 
 
+/**
+ * Authenticates the authorization header sent by the client
+ *
+ * @param connection The MHD connection structure
+ * @param realm The realm presented to the client
+ * @param username The username needs to be authenticated
+ * @param password The password used in the authentication
+ * @param nonce_timeout The amount of time for a nonce to be
+ * 			invalid in seconds
+ * @return #MHD_YES if authenticated, #MHD_NO if not,
+ * 			#MHD_INVALID_NONCE if nonce is invalid
+ * @ingroup authentication
+ */
+int
+MHD_digest_auth_check (struct MHD_Connection *connection,
+		       const char *realm,
+		       const char *username,
+		       const char *password,
+		       unsigned int nonce_timeout)
+{
+  return digest_auth_check_all (connection,
+                                realm,
+                                username,
+                                password,
+                                NULL,
+                                nonce_timeout);
+}
+
+
+/**
+ * Authenticates the authorization header sent by the client, using
+ * the stored hash of the credentials instead of the password.
+ *
+ * @param connection The MHD connection structure
+ * @param realm The realm presented to the client
+ * @param username The username needs to be authenticated
+ * @param digest H(A1), the binary MD5 hash of "username:realm:password"
+ * @param nonce_timeout The amount of time for a nonce to be
+ * 			invalid in seconds
+ * @return #MHD_YES if authenticated, #MHD_NO if not,
+ * 			#MHD_INVALID_NONCE if nonce is invalid
+ * @ingroup authentication
+ */
+int
+MHD_digest_auth_check_digest (struct MHD_Connection *connection,
+			      const char *realm,
+			      const char *username,
+			      const uint8_t digest[MHD_MD5_DIGEST_SIZE],
+			      unsigned int nonce_timeout)
+{
+  return digest_auth_check_all (connection,
+                                realm,
+                                username,
+                                NULL,
+                                digest,
+                                nonce_timeout);
+}
+
+
 /**
  * Queues a response to request authentication from the client
  *
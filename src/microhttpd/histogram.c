@@ -0,0 +1,170 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/histogram.c
+ * @brief  log-linear histograms of durations
+ * @author libmicrohttpd contributors
+ *
+ * Values below 8 have a bucket each.  A value with its highest bit
+ * at position e >= 3 goes to one of the eight buckets for [2^e,
+ * 2^(e+1)), selected by the three bits below the highest one.
+ */
+#include "histogram.h"
+
+/**
+ * Number of bits selecting the bucket within a power of two.
+ */
+#define SUB_BITS 3
+
+/**
+ * Number of buckets per power of two.
+ */
+#define SUB_BUCKETS (1 << SUB_BITS)
+
+
+/**
+ * Find the bucket of a value.
+ *
+ * @param value the value
+ * @return index of the bucket
+ */
+static unsigned int
+bucket_of (uint64_t value)
+{
+  unsigned int e;
+  unsigned int idx;
+
+  if (value < SUB_BUCKETS)
+    return (unsigned int) value;
+  e = SUB_BITS;
+  while ( (e < 63) &&
+          (0 != (value >> (e + 1))) )
+    e++;
+  idx = (e - SUB_BITS + 1) * SUB_BUCKETS
+    + (unsigned int) ((value >> (e - SUB_BITS)) & (SUB_BUCKETS - 1));
+  if (idx >= MHD_HISTOGRAM_BUCKETS)
+    return MHD_HISTOGRAM_BUCKETS - 1;
+  return idx;
+}
+
+
+/**
+ * Get the smallest value after the range of a bucket.
+ *
+ * @param idx index of the bucket
+ * @return upper limit (exclusive) of the bucket
+ */
+static uint64_t
+bucket_limit (unsigned int idx)
+{
+  unsigned int e;
+
+  if (idx < SUB_BUCKETS)
+    return idx + 1;
+  e = idx / SUB_BUCKETS + SUB_BITS - 1;
+  return ((uint64_t) (SUB_BUCKETS + idx % SUB_BUCKETS) + 1) << (e - SUB_BITS);
+}
+
+
+/**
+ * Record a value in a histogram.
+ *
+ * @param h the histogram
+ * @param value the value to record
+ */
+void
+MHD_histogram_add_ (struct MHD_Histogram *h,
+                    uint64_t value)
+{
+  h->buckets[bucket_of (value)]++;
+  h->count++;
+  h->sum += value;
+  if (value > h->max)
+    h->max = value;
+}
+
+
+/**
+ * Add the values of the histogram @a src to @a dst.
+ *
+ * @param dst histogram to update
+ * @param src histogram to add
+ */
+_MHD_EXTERN void
+MHD_histogram_merge (struct MHD_Histogram *dst,
+                     const struct MHD_Histogram *src)
+{
+  unsigned int i;
+
+  for (i = 0; i < MHD_HISTOGRAM_BUCKETS; i++)
+    dst->buckets[i] += src->buckets[i];
+  dst->count += src->count;
+  dst->sum += src->sum;
+  if (src->max > dst->max)
+    dst->max = src->max;
+}
+
+
+/**
+ * Estimate a percentile of the values in a histogram.
+ *
+ * @param h the histogram
+ * @param percentile the percentile, from 0 to 100
+ * @return upper limit of the bucket with the percentile (at most the
+ *         largest value recorded), 0 if @a h is empty
+ */
+_MHD_EXTERN uint64_t
+MHD_histogram_percentile (const struct MHD_Histogram *h,
+                          double percentile)
+{
+  uint64_t rank;
+  uint64_t seen;
+  uint64_t limit;
+  unsigned int i;
+
+  if (0 == h->count)
+    return 0;
+  if (percentile <= 0)
+    rank = 1;
+  else if (percentile >= 100)
+    rank = h->count;
+  else
+    {
+      rank = (uint64_t) (percentile / 100 * h->count);
+      if (rank < percentile / 100 * h->count)
+        rank++;
+      if (0 == rank)
+        rank = 1;
+    }
+  seen = 0;
+  for (i = 0; i < MHD_HISTOGRAM_BUCKETS - 1; i++)
+    {
+      seen += h->buckets[i];
+      if (seen >= rank)
+        break;
+    }
+  limit = bucket_limit (i) - 1;
+  if ( (MHD_HISTOGRAM_BUCKETS - 1 == i) ||
+       (limit > h->max) )
+    return h->max;
+  return limit;
+}
+
+/* end of histogram.c */
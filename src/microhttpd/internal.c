@@ -26,6 +26,9 @@
 
 #include "internal.h"
 #include "mhd_str.h"
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#include <malloc.h>
+#endif
 
 #ifdef HAVE_MESSAGES
 #if DEBUG_STATES
@@ -110,6 +113,54 @@ MHD_DLOG (const struct MHD_Daemon *daemon,
 #endif
 
 
+/**
+ * Allocate memory aligned to #MHD_CACHE_LINE_SIZE (where the
+ * platform allows it).
+ *
+ * @param size number of bytes to allocate
+ * @return NULL on error (with errno set)
+ */
+void *
+MHD_aligned_malloc_ (size_t size)
+{
+#if defined(HAVE_POSIX_MEMALIGN)
+  void *ptr;
+  int err;
+
+  err = posix_memalign (&ptr,
+                        MHD_CACHE_LINE_SIZE,
+                        size);
+  if (0 != err)
+    {
+      errno = err;
+      return NULL;
+    }
+  return ptr;
+#elif defined(_WIN32) && !defined(__CYGWIN__)
+  return _aligned_malloc (size,
+                          MHD_CACHE_LINE_SIZE);
+#else
+  return malloc (size);
+#endif
+}
+
+
+/**
+ * Free memory allocated with #MHD_aligned_malloc_().
+ *
+ * @param ptr memory to free, may be NULL
+ */
+void
+MHD_aligned_free_ (void *ptr)
+{
+#if defined(_WIN32) && !defined(__CYGWIN__) && !defined(HAVE_POSIX_MEMALIGN)
+  _aligned_free (ptr);
+#else
+  free (ptr);
+#endif
+}
+
+
 /**
  * Convert all occurrences of '+' to ' '.
  *
@@ -137,34 +188,59 @@ MHD_unescape_plus (char *arg)
 size_t
 MHD_http_unescape (char *val)
 {
-  char *rpos = val;
-  char *wpos = val;
+  return MHD_str_pct_decode_n_ (val,
+                                strlen (val));
+}
 
-  while ('\0' != *rpos)
+
+/**
+ * Process escape sequences ('%HH') Updates val in place; the
+ * result should be UTF-8 encoded and cannot be larger than the input.
+ * The result must also still be 0-terminated.  This is the default
+ * #UnescapeCallback of a daemon.
+ *
+ * @param cls closure (use NULL)
+ * @param connection handle to connection, not used
+ * @param val value to unescape (modified in the process)
+ * @return length of the resulting val (strlen(val) maybe
+ *  shorter afterwards due to elimination of escape sequences)
+ */
+size_t
+MHD_unescape_wrapper_ (void *cls,
+                       struct MHD_Connection *connection,
+                       char *val)
+{
+  (void) cls;
+  (void) connection;
+  return MHD_http_unescape (val);
+}
+
+
+/**
+ * Unescape a key or value of an URI argument in place.
+ *
+ * @param connection connection the argument belongs to
+ * @param arg 0-terminated argument to unescape
+ * @param len strlen(arg)
+ */
+static void
+unescape_argument (struct MHD_Connection *connection,
+                   char *arg,
+                   size_t len)
+{
+  struct MHD_Daemon *daemon = connection->daemon;
+
+  if (&MHD_unescape_wrapper_ == daemon->unescape_callback)
     {
-      uint32_t num;
-      switch (*rpos)
-	{
-	case '%':
-          if (2 == MHD_strx_to_uint32_n_ (rpos + 1,
-                                          2,
-                                          &num))
-	    {
-	      *wpos = (char)((unsigned char) num);
-	      wpos++;
-	      rpos += 3;
-	      break;
-	    }
-          /* TODO: add bad sequence handling */
-	  /* intentional fall through! */
-	default:
-	  *wpos = *rpos;
-	  wpos++;
-	  rpos++;
-	}
+      /* '+' and '%HH' in one pass */
+      MHD_str_form_decode_n_ (arg,
+                              len);
+      return;
     }
-  *wpos = '\0'; /* add 0-terminator */
-  return wpos - val; /* = strlen(val) */
+  MHD_unescape_plus (arg);
+  daemon->unescape_callback (daemon->unescape_callback_cls,
+                             connection,
+                             arg);
 }
 
 
@@ -189,93 +265,61 @@ MHD_parse_arguments_ (struct MHD_Connection *connection,
 		      MHD_ArgumentIterator_ cb,
 		      unsigned int *num_headers)
 {
-  struct MHD_Daemon *daemon = connection->daemon;
   char *equals;
-  char *amper;
+  size_t len;
+  size_t klen;
+  size_t amper;
 
   *num_headers = 0;
-  while ( (NULL != args) &&
-	  ('\0' != args[0]) )
+  if (NULL == args)
+    return MHD_YES;
+  len = strlen (args);
+  while (0 != len)
     {
-      equals = strchr (args, '=');
-      amper = strchr (args, '&');
-      if (NULL == amper)
-	{
-	  /* last argument */
-	  if (NULL == equals)
-	    {
-	      /* last argument, without '=' */
-              MHD_unescape_plus (args);
-	      daemon->unescape_callback (daemon->unescape_callback_cls,
-					 connection,
-					 args);
-	      if (MHD_YES != cb (connection,
-				 args,
-				 NULL,
-				 kind))
-		return MHD_NO;
-	      (*num_headers)++;
-	      break;
-	    }
-	  /* got 'foo=bar' */
-	  equals[0] = '\0';
-	  equals++;
-          MHD_unescape_plus (args);
-	  daemon->unescape_callback (daemon->unescape_callback_cls,
-				     connection,
-				     args);
-          MHD_unescape_plus (equals);
-	  daemon->unescape_callback (daemon->unescape_callback_cls,
-				     connection,
-				     equals);
-	  if (MHD_YES != cb (connection,
-			     args,
-			     equals,
-			     kind))
-	    return MHD_NO;
-	  (*num_headers)++;
-	  break;
-	}
-      /* amper is non-NULL here */
-      amper[0] = '\0';
-      amper++;
-      if ( (NULL == equals) ||
-	   (equals >= amper) )
-	{
-	  /* got 'foo&bar' or 'foo&bar=val', add key 'foo' with NULL for value */
-          MHD_unescape_plus (args);
-	  daemon->unescape_callback (daemon->unescape_callback_cls,
-				     connection,
-				     args);
-	  if (MHD_YES != cb (connection,
-			     args,
-			     NULL,
-			     kind))
-	    return MHD_NO;
-	  /* continue with 'bar' */
-	  (*num_headers)++;
-	  args = amper;
-	  continue;
-	}
-      /* equals and amper are non-NULL here, and equals < amper,
-	 so we got regular 'foo=value&bar...'-kind of argument */
-      equals[0] = '\0';
-      equals++;
-      MHD_unescape_plus (args);
-      daemon->unescape_callback (daemon->unescape_callback_cls,
-				 connection,
-				 args);
-      MHD_unescape_plus (equals);
-      daemon->unescape_callback (daemon->unescape_callback_cls,
-				 connection,
-				 equals);
+      /* find the end of the key ('=' or '&') */
+      klen = MHD_str_find_any3_n_ (args,
+                                   len,
+                                   '=',
+                                   '&',
+                                   '&');
+      if ( (klen < len) &&
+           ('=' == args[klen]) )
+        {
+          /* got 'foo=value', find the end of the value */
+          equals = &args[klen + 1];
+          amper = klen + 1 + MHD_str_find_any3_n_ (equals,
+                                                   len - klen - 1,
+                                                   '&',
+                                                   '&',
+                                                   '&');
+          args[klen] = '\0';
+        }
+      else
+        {
+          /* got 'foo&bar' or 'foo', add key 'foo' with NULL for value */
+          equals = NULL;
+          amper = klen;
+        }
+      if (amper < len)
+        args[amper] = '\0';
+      unescape_argument (connection,
+                         args,
+                         klen);
+      if (NULL != equals)
+        unescape_argument (connection,
+                           equals,
+                           amper - klen - 1);
       if (MHD_YES != cb (connection,
-			 args,
-			 equals,
-			 kind))
+                         args,
+                         equals,
+                         kind))
         return MHD_NO;
       (*num_headers)++;
-      args = amper;
+      if (amper == len)
+        break;
+      /* continue with 'bar' */
+      args += amper + 1;
+      len -= amper + 1;
     }
   return MHD_YES;
 }
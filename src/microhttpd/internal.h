@@ -61,6 +61,7 @@
 
 #include "mhd_threads.h"
 #include "mhd_locks.h"
+#include "mhd_atomic.h"
 #include "mhd_sockets.h"
 #include "mhd_itc_types.h"
 
@@ -84,6 +85,21 @@
  */
 #define MHD_BUF_INC_SIZE 1024
 
+/**
+ * Size of a cache line (or a multiple of it), used to keep data
+ * written by different threads apart.
+ */
+#define MHD_CACHE_LINE_SIZE 64
+
+/**
+ * Fail the compilation if @a cond is false.
+ *
+ * @param cond condition that must hold, a constant expression
+ * @param name name of the check, part of the error message
+ */
+#define MHD_STATIC_ASSERT_(cond,name) \
+  typedef char MHD_static_assert_ ## name[(cond) ? 1 : -1]
+
 
 /**
  * Handler for fatal errors.
@@ -182,32 +198,6 @@ enum MHD_ConnectionEventLoopInfo
 #define MAX_NONCE_LENGTH 129
 
 
-/**
- * A structure representing the internal holder of the
- * nonce-nc map.
- */
-struct MHD_NonceNc
-{
-
-  /**
-   * Nonce counter, a value that increases for each subsequent
-   * request for the same nonce.
-   */
-  uint64_t nc;
-
-  /**
-   * Bitmask over the nc-64 previous nonce values.  Used to
-   * allow out-of-order nonces.
-   */
-  uint64_t nmask;
-
-  /**
-   * Nonce value:
-   */
-  char nonce[MAX_NONCE_LENGTH];
-
-};
-
 #ifdef HAVE_MESSAGES
 /**
  * fprintf()-like helper function for logging debug
@@ -545,225 +535,245 @@ typedef ssize_t
 
 
 /**
- * State kept for each HTTP request.
+ * Parts of the state of a connection that are rarely used or only
+ * used by some requests; see `struct MHD_Connection`.
  */
-struct MHD_Connection
+struct MHD_ConnectionCold
 {
+  /**
+   * Foreign address (of length @e addr_len).  MALLOCED (not
+   * in pool!).
+   */
+  struct sockaddr *addr;
 
-#ifdef EPOLL_SUPPORT
   /**
-   * Next pointer for the EDLL listing connections that are epoll-ready.
+   * Length of the foreign address.
    */
-  struct MHD_Connection *nextE;
+  socklen_t addr_len;
 
   /**
-   * Previous pointer for the EDLL listing connections that are epoll-ready.
+   * We allow the main application to associate some pointer with the
+   * HTTP request, which is passed to each #MHD_AccessHandlerCallback
+   * and some other API calls.  Here is where we store it.  (MHD does
+   * not know or care what it is).
    */
-  struct MHD_Connection *prevE;
-#endif
+  void *client_context;
 
   /**
-   * Next pointer for the DLL describing our IO state.
+   * We allow the main application to associate some pointer with the
+   * TCP connection (which may span multiple HTTP requests).  Here is
+   * where we store it.  (MHD does not know or care what it is).
+   * The location is given to the #MHD_NotifyConnectionCallback and
+   * also accessible via #MHD_CONNECTION_INFO_SOCKET_CONTEXT.
    */
-  struct MHD_Connection *next;
+  void *socket_context;
 
   /**
-   * Previous pointer for the DLL describing our IO state.
+   * Thread handle for this connection (if we are using
+   * one thread per connection).
    */
-  struct MHD_Connection *prev;
+  MHD_thread_handle_ pid;
 
   /**
-   * Next pointer for the XDLL organizing connections by timeout.
-   * This DLL can be either the
-   * 'manual_timeout_head/manual_timeout_tail' or the
-   * 'normal_timeout_head/normal_timeout_tail', depending on whether a
-   * custom timeout is set for the connection.
+   * Set to #MHD_YES if the thread has been joined.
    */
-  struct MHD_Connection *nextX;
+  int thread_joined;
 
   /**
-   * Previous pointer for the XDLL organizing connections by timeout.
+   * If this connection was upgraded and if we are using
+   * #MHD_USE_THREAD_PER_CONNECTION, this points to the
+   * upgrade response details such that the
+   * #thread_main_connection_upgrade()-logic can perform
+   * the bi-directional forwarding.
    */
-  struct MHD_Connection *prevX;
+  struct MHD_UpgradeResponseHandle *urh;
 
   /**
-   * Reference to the MHD_Daemon struct.
+   * If this connection was upgraded and if we are using
+   * #MHD_USE_THREAD_PER_CONNECTION without encryption,
+   * this points to the semaphore we use to signal termination
+   * to the thread handling the connection.
    */
-  struct MHD_Daemon *daemon;
+  struct MHD_Semaphore *upgrade_sem;
 
+#if HTTPS_SUPPORT
   /**
-   * Linked list of parsed headers.
+   * State required for HTTPS/SSL/TLS support.
    */
-  struct MHD_HTTP_Header *headers_received;
+  gnutls_session_t tls_session;
 
   /**
-   * Tail of linked list of parsed headers.
+   * Memory location to return for protocol session info.
    */
-  struct MHD_HTTP_Header *headers_received_tail;
+  int protocol;
 
   /**
-   * Response to transmit (initially NULL).
+   * Memory location to return for protocol session info.
    */
-  struct MHD_Response *response;
+  int cipher;
 
   /**
-   * The memory pool is created whenever we first read from the TCP
-   * stream and destroyed at the end of each request (and re-created
-   * for the next request).  In the meantime, this pointer is NULL.
-   * The pool is used for all connection-related data except for the
-   * response (which maybe shared between connections) and the IP
-   * address (which persists across individual requests).
+   * Next connection in the queue of the handshake thread pool.
    */
-  struct MemoryPool *pool;
+  struct MHD_Connection *tls_handshake_next;
 
   /**
-   * We allow the main application to associate some pointer with the
-   * HTTP request, which is passed to each #MHD_AccessHandlerCallback
-   * and some other API calls.  Here is where we store it.  (MHD does
-   * not know or care what it is).
+   * Result of the last handshake step run by the handshake thread
+   * pool.
    */
-  void *client_context;
+  int tls_handshake_ret;
 
   /**
-   * We allow the main application to associate some pointer with the
-   * TCP connection (which may span multiple HTTP requests).  Here is
-   * where we store it.  (MHD does not know or care what it is).
-   * The location is given to the #MHD_NotifyConnectionCallback and
-   * also accessible via #MHD_CONNECTION_INFO_SOCKET_CONTEXT.
+   * #MHD_YES from queueing a handshake step in the thread pool
+   * until its @e tls_handshake_ret was processed by the event loop.
    */
-  void *socket_context;
+  int tls_handshake_queued;
+#endif
 
   /**
-   * Request method.  Should be GET/POST/etc.  Allocated in pool.
+   * Statistics of this connection; only used with
+   * #MHD_USE_THREAD_PER_CONNECTION, where they are added to the
+   * statistics of the daemon when the connection is cleaned up.
    */
-  char *method;
+  struct MHD_DaemonStats stats;
 
   /**
-   * Requested URL (everything after "GET" only).  Allocated
-   * in pool.
+   * With #MHD_OPTION_REQUEST_TIMING, when we started to wait for the
+   * current request: the time the connection was accepted or the
+   * previous request was finished (#MHD_monotonic_usec_counter()).
    */
-  const char *url;
+  uint64_t phase_start;
 
   /**
-   * HTTP version string (i.e. http/1.1).  Allocated
-   * in pool.
+   * When the first byte of the current request was received, 0 if
+   * not yet.
    */
-  char *version;
+  uint64_t phase_first_byte;
 
   /**
-   * Buffer for reading requests.  Allocated in pool.  Actually one
-   * byte larger than @e read_buffer_size (if non-NULL) to allow for
-   * 0-termination.
+   * When the header of the current request was received.
    */
-  char *read_buffer;
+  uint64_t phase_headers;
 
   /**
-   * Buffer for writing response (headers only).  Allocated
-   * in pool.
+   * When the response for the current request was queued.
    */
-  char *write_buffer;
+  uint64_t phase_response;
 
   /**
-   * Last incomplete header line during parsing of headers.
-   * Allocated in pool.  Only valid if state is
-   * either #MHD_CONNECTION_HEADER_PART_RECEIVED or
-   * #MHD_CONNECTION_FOOTER_PART_RECEIVED.
+   * When the header of the response was sent.
    */
-  char *last;
+  uint64_t phase_headers_sent;
 
   /**
-   * Position after the colon on the last incomplete header
-   * line during parsing of headers.
-   * Allocated in pool.  Only valid if state is
-   * either #MHD_CONNECTION_HEADER_PART_RECEIVED or
-   * #MHD_CONNECTION_FOOTER_PART_RECEIVED.
+   * Duration of the phases of the last completed request, returned
+   * for #MHD_CONNECTION_INFO_REQUEST_TIMING.
    */
-  char *colon;
+  uint64_t phase_usec[MHD_REQUEST_PHASE_COUNT];
 
   /**
-   * Foreign address (of length @e addr_len).  MALLOCED (not
-   * in pool!).
+   * Number of the connection in the #MHD_OPTION_TRACE_FILE.
    */
-  struct sockaddr *addr;
+  uint32_t trace_id;
 
+#ifdef MHD_USDT_PROBES
   /**
-   * Thread handle for this connection (if we are using
-   * one thread per connection).
+   * State last reported to the 'state' probe; the 'accept' probe
+   * stands for #MHD_CONNECTION_INIT.
    */
-  MHD_thread_handle_ pid;
+  enum MHD_CONNECTION_STATE probed_state;
+#endif
+};
 
+
+/**
+ * State kept for each HTTP request.
+ *
+ * The fields touched for every event (by #MHD_epoll(), call_handlers()
+ * and the handlers up to deciding there is nothing to do) and by the
+ * timeout sweep come first and must fit into two cache lines (see
+ * the check below); the connection is allocated aligned to a cache
+ * line.  Fields used while processing a request follow, and data
+ * needed only rarely is in @e cold.
+ */
+struct MHD_Connection
+{
+#ifdef EPOLL_SUPPORT
   /**
-   * Size of @e read_buffer (in bytes).  This value indicates
-   * how many bytes we're willing to read into the buffer;
-   * the real buffer is one byte longer to allow for
-   * adding zero-termination (when needed).
+   * Next pointer for the EDLL listing connections that are epoll-ready.
    */
-  size_t read_buffer_size;
+  struct MHD_Connection *nextE;
 
   /**
-   * Position where we currently append data in
-   * @e read_buffer (last valid position).
+   * Previous pointer for the EDLL listing connections that are epoll-ready.
    */
-  size_t read_buffer_offset;
+  struct MHD_Connection *prevE;
+#endif
 
   /**
-   * Size of @e write_buffer (in bytes).
+   * Next pointer for the XDLL organizing connections by timeout.
+   * This DLL can be either the
+   * 'manual_timeout_head/manual_timeout_tail' or the
+   * 'normal_timeout_head/normal_timeout_tail', depending on whether a
+   * custom timeout is set for the connection.
    */
-  size_t write_buffer_size;
+  struct MHD_Connection *nextX;
 
   /**
-   * Offset where we are with sending from @e write_buffer.
+   * Previous pointer for the XDLL organizing connections by timeout.
    */
-  size_t write_buffer_send_offset;
+  struct MHD_Connection *prevX;
 
   /**
-   * Last valid location in write_buffer (where do we
-   * append and up to where is it safe to send?)
+   * Reference to the MHD_Daemon struct.
    */
-  size_t write_buffer_append_offset;
+  struct MHD_Daemon *daemon;
 
   /**
-   * How many more bytes of the body do we expect
-   * to read? #MHD_SIZE_UNKNOWN for unknown.
+   * Last time this connection had any activity
+   * (reading or writing).
    */
-  uint64_t remaining_upload_size;
+  time_t last_activity;
 
   /**
-   * Current write position in the actual response
-   * (excluding headers, content only; should be 0
-   * while sending headers).
+   * Size of @e read_buffer (in bytes).  This value indicates
+   * how many bytes we're willing to read into the buffer;
+   * the real buffer is one byte longer to allow for
+   * adding zero-termination (when needed).
    */
-  uint64_t response_write_position;
+  size_t read_buffer_size;
 
   /**
-   * Position in the 100 CONTINUE message that
-   * we need to send when receiving http 1.1 requests.
+   * Position where we currently append data in
+   * @e read_buffer (last valid position).
    */
-  size_t continue_message_write_offset;
+  size_t read_buffer_offset;
 
   /**
-   * Length of the foreign address.
+   * Handler used for processing read connection operations
    */
-  socklen_t addr_len;
+  int (*read_handler) (struct MHD_Connection *connection);
 
   /**
-   * Last time this connection had any activity
-   * (reading or writing).
+   * Handler used for processing write connection operations
    */
-  time_t last_activity;
+  int (*write_handler) (struct MHD_Connection *connection);
 
   /**
-   * After how many seconds of inactivity should
-   * this connection time out?  Zero for no timeout.
+   * Handler used for processing idle connection operations
    */
-  unsigned int connection_timeout;
+  int (*idle_handler) (struct MHD_Connection *connection);
 
   /**
-   * Did we ever call the "default_handler" on this connection?  (this
-   * flag will determine if we call the #MHD_OPTION_NOTIFY_COMPLETED
-   * handler when the connection closes down).
+   * Response to transmit (initially NULL).
    */
-  int client_aware;
+  struct MHD_Response *response;
+
+  /**
+   * After how many seconds of inactivity should
+   * this connection time out?  Zero for no timeout.
+   */
+  unsigned int connection_timeout;
 
   /**
    * Socket for this connection.  Set to #MHD_INVALID_SOCKET if
@@ -773,23 +783,14 @@ struct MHD_Connection
   MHD_socket socket_fd;
 
   /**
-   * Has this socket been closed for reading (i.e.  other side closed
-   * the connection)?  If so, we must completely close the connection
-   * once we are done sending our response (and stop trying to read
-   * from this socket).
-   */
-  int read_closed;
-
-  /**
-   * Set to #MHD_YES if the thread has been joined.
+   * State in the FSM for this connection.
    */
-  int thread_joined;
+  enum MHD_CONNECTION_STATE state;
 
   /**
-   * Are we currently inside the "idle" handler (to avoid recursively
-   * invoking it).
+   * What is this connection waiting for?
    */
-  int in_idle;
+  enum MHD_ConnectionEventLoopInfo event_loop_info;
 
 #ifdef EPOLL_SUPPORT
   /**
@@ -798,131 +799,241 @@ struct MHD_Connection
   enum MHD_EpollState epoll_state;
 #endif
 
+#if HTTPS_SUPPORT
   /**
-   * State in the FSM for this connection.
+   * Could it be that we are ready to read due to TLS buffers
+   * even though the socket is not?
    */
-  enum MHD_CONNECTION_STATE state;
+  int tls_read_ready;
+#endif
 
   /**
-   * What is this connection waiting for?
+   * Are we currently inside the "idle" handler (to avoid recursively
+   * invoking it).
    */
-  enum MHD_ConnectionEventLoopInfo event_loop_info;
+  int in_idle;
 
   /**
-   * HTTP response code.  Only valid if response object
-   * is already set.
+   * Has this socket been closed for reading (i.e.  other side closed
+   * the connection)?  If so, we must completely close the connection
+   * once we are done sending our response (and stop trying to read
+   * from this socket).
    */
-  unsigned int responseCode;
+  int read_closed;
+
+  /* end of the fields in the first two cache lines */
 
   /**
-   * Set to #MHD_YES if the response's content reader
-   * callback failed to provide data the last time
-   * we tried to read from it.  In that case, the
-   * write socket should be marked as unready until
-   * the CRC call succeeds.
+   * Next pointer for the DLL describing our IO state.
    */
-  int response_unready;
+  struct MHD_Connection *next;
 
   /**
-   * Are we receiving with chunked encoding?  This will be set to
-   * #MHD_YES after we parse the headers and are processing the body
-   * with chunks.  After we are done with the body and we are
-   * processing the footers; once the footers are also done, this will
-   * be set to #MHD_NO again (before the final call to the handler).
+   * Previous pointer for the DLL describing our IO state.
    */
-  int have_chunked_upload;
+  struct MHD_Connection *prev;
 
   /**
-   * If we are receiving with chunked encoding, where are we right
-   * now?  Set to 0 if we are waiting to receive the chunk size;
-   * otherwise, this is the size of the current chunk.  A value of
-   * zero is also used when we're at the end of the chunks.
+   * Function used for reading HTTP request stream.
    */
-  size_t current_chunk_size;
+  ReceiveCallback recv_cls;
 
   /**
-   * If we are receiving with chunked encoding, where are we currently
-   * with respect to the current chunk (at what offset / position)?
+   * Function used for writing HTTP response stream.
    */
-  size_t current_chunk_offset;
+  TransmitCallback send_cls;
 
   /**
-   * Handler used for processing read connection operations
+   * Buffer for reading requests.  Allocated in pool.  Actually one
+   * byte larger than @e read_buffer_size (if non-NULL) to allow for
+   * 0-termination.
    */
-  int (*read_handler) (struct MHD_Connection *connection);
+  char *read_buffer;
 
   /**
-   * Handler used for processing write connection operations
+   * Buffer for writing response (headers only).  Allocated
+   * in pool.
    */
-  int (*write_handler) (struct MHD_Connection *connection);
+  char *write_buffer;
 
   /**
-   * Handler used for processing idle connection operations
+   * Size of @e write_buffer (in bytes).
    */
-  int (*idle_handler) (struct MHD_Connection *connection);
+  size_t write_buffer_size;
 
   /**
-   * Function used for reading HTTP request stream.
+   * Offset where we are with sending from @e write_buffer.
    */
-  ReceiveCallback recv_cls;
+  size_t write_buffer_send_offset;
 
   /**
-   * Function used for writing HTTP response stream.
+   * Last valid location in write_buffer (where do we
+   * append and up to where is it safe to send?)
    */
-  TransmitCallback send_cls;
+  size_t write_buffer_append_offset;
 
   /**
-   * If this connection was upgraded and if we are using
-   * #MHD_USE_THREAD_PER_CONNECTION, this points to the
-   * upgrade response details such that the
-   * #thread_main_connection_upgrade()-logic can perform
-   * the bi-directional forwarding.
+   * The memory pool is created whenever we first read from the TCP
+   * stream and destroyed at the end of each request (and re-created
+   * for the next request).  In the meantime, this pointer is NULL.
+   * The pool is used for all connection-related data except for the
+   * response (which maybe shared between connections) and the IP
+   * address (which persists across individual requests).
    */
-  struct MHD_UpgradeResponseHandle *urh;
+  struct MemoryPool *pool;
 
   /**
-   * If this connection was upgraded and if we are using
-   * #MHD_USE_THREAD_PER_CONNECTION without encryption,
-   * this points to the semaphore we use to signal termination
-   * to the thread handling the connection.
+   * Is the connection suspended?
    */
-  struct MHD_Semaphore *upgrade_sem;
+  int suspended;
 
-#if HTTPS_SUPPORT
+  /**
+   * Is the connection wanting to resume?
+   */
+  int resuming;
 
   /**
-   * State required for HTTPS/SSL/TLS support.
+   * #MHD_YES if MHD suspended the connection itself (while a step of
+   * its TLS handshake runs in another thread), not the application.
    */
-  gnutls_session_t tls_session;
+  int suspended_internally;
 
   /**
-   * Memory location to return for protocol session info.
+   * Data that is rarely used, or only for some requests, kept out of
+   * the cache lines above (allocated together with the connection).
    */
-  int protocol;
+  struct MHD_ConnectionCold *cold;
 
   /**
-   * Memory location to return for protocol session info.
+   * Linked list of parsed headers.
    */
-  int cipher;
+  struct MHD_HTTP_Header *headers_received;
 
   /**
-   * Could it be that we are ready to read due to TLS buffers
-   * even though the socket is not?
+   * Tail of linked list of parsed headers.
    */
-  int tls_read_ready;
-#endif
+  struct MHD_HTTP_Header *headers_received_tail;
 
   /**
-   * Is the connection suspended?
+   * Request method.  Should be GET/POST/etc.  Allocated in pool.
    */
-  int suspended;
+  char *method;
 
   /**
-   * Is the connection wanting to resume?
+   * Requested URL (everything after "GET" only).  Allocated
+   * in pool.
    */
-  int resuming;
+  const char *url;
+
+  /**
+   * HTTP version string (i.e. http/1.1).  Allocated
+   * in pool.
+   */
+  char *version;
+
+  /**
+   * Last incomplete header line during parsing of headers.
+   * Allocated in pool.  Only valid if state is
+   * either #MHD_CONNECTION_HEADER_PART_RECEIVED or
+   * #MHD_CONNECTION_FOOTER_PART_RECEIVED.
+   */
+  char *last;
+
+  /**
+   * Position after the colon on the last incomplete header
+   * line during parsing of headers.
+   * Allocated in pool.  Only valid if state is
+   * either #MHD_CONNECTION_HEADER_PART_RECEIVED or
+   * #MHD_CONNECTION_FOOTER_PART_RECEIVED.
+   */
+  char *colon;
+
+  /**
+   * How many more bytes of the body do we expect
+   * to read? #MHD_SIZE_UNKNOWN for unknown.
+   */
+  uint64_t remaining_upload_size;
+
+  /**
+   * Current write position in the actual response
+   * (excluding headers, content only; should be 0
+   * while sending headers).
+   */
+  uint64_t response_write_position;
+
+  /**
+   * Position in the 100 CONTINUE message that
+   * we need to send when receiving http 1.1 requests.
+   */
+  size_t continue_message_write_offset;
+
+  /**
+   * If we are receiving with chunked encoding, where are we right
+   * now?  Set to 0 if we are waiting to receive the chunk size;
+   * otherwise, this is the size of the current chunk.  A value of
+   * zero is also used when we're at the end of the chunks.
+   */
+  size_t current_chunk_size;
+
+  /**
+   * If we are receiving with chunked encoding, where are we currently
+   * with respect to the current chunk (at what offset / position)?
+   */
+  size_t current_chunk_offset;
+
+  /**
+   * Did we ever call the "default_handler" on this connection?  (this
+   * flag will determine if we call the #MHD_OPTION_NOTIFY_COMPLETED
+   * handler when the connection closes down).
+   */
+  int client_aware;
+
+  /**
+   * HTTP response code.  Only valid if response object
+   * is already set.
+   */
+  unsigned int responseCode;
+
+  /**
+   * Set to #MHD_YES if the response's content reader
+   * callback failed to provide data the last time
+   * we tried to read from it.  In that case, the
+   * write socket should be marked as unready until
+   * the CRC call succeeds.
+   */
+  int response_unready;
+
+  /**
+   * Are we receiving with chunked encoding?  This will be set to
+   * #MHD_YES after we parse the headers and are processing the body
+   * with chunks.  After we are done with the body and we are
+   * processing the footers; once the footers are also done, this will
+   * be set to #MHD_NO again (before the final call to the handler).
+   */
+  int have_chunked_upload;
+
+#ifdef COMPRESSION_SUPPORT
+  /**
+   * Deflate stream used to compress the body of the current
+   * response, NULL if the response is sent as-is.  Taken from
+   * (and returned to) the daemon's pool of streams.
+   */
+  struct MHD_ZStream *zstream;
+
+  /**
+   * Inflate stream used to decompress the body of the current
+   * request, NULL if the body is passed to the application as-is.
+   */
+  struct MHD_ZInflate *zinflate;
+#endif
 };
 
+/* do not let the fields used for every event spill into a third
+   cache line; on 32 bit platforms, they take less than one */
+MHD_STATIC_ASSERT_ (offsetof (struct MHD_Connection, read_closed)
+                    + sizeof (int) <= 2 * MHD_CACHE_LINE_SIZE,
+                    connection_hot_fields_in_two_cache_lines);
+
 
 /**
  * Buffer we use for upgrade response handling in the unlikely
@@ -1056,6 +1167,14 @@ struct MHD_UpgradeResponseHandle
    */
   int was_closed;
 
+  /**
+   * #MHD_YES if the application uses the TLS session through
+   * #MHD_upgrade_recv() and #MHD_upgrade_send()
+   * (#MHD_RF_UPGRADE_DIRECT); then there is no socketpair, and
+   * the buffers are unused.
+   */
+  int direct_io;
+
 #endif
 
 };
@@ -1095,6 +1214,11 @@ typedef size_t
  * connection in terms of what operations we are waiting for (read,
  * write, locally blocked, cleanup) whereas the second is about its
  * timeout state (default or custom).
+ *
+ * The read-mostly configuration comes first, followed (after
+ * @e state_pad) by the state written by the thread of the daemon
+ * and then by its statistics, so that the workers of a thread pool,
+ * which are kept in one array, do not write to shared cache lines.
  */
 struct MHD_Daemon
 {
@@ -1110,372 +1234,574 @@ struct MHD_Daemon
   void *default_handler_cls;
 
   /**
-   * Head of doubly-linked list of our current, active connections.
+   * Function to call to check if we should accept or reject an
+   * incoming request.  May be NULL.
    */
-  struct MHD_Connection *connections_head;
+  MHD_AcceptPolicyCallback apc;
 
   /**
-   * Tail of doubly-linked list of our current, active connections.
+   * Closure argument to apc.
    */
-  struct MHD_Connection *connections_tail;
+  void *apc_cls;
 
   /**
-   * Head of doubly-linked list of our current but suspended connections.
+   * Function to call when we are done processing
+   * a particular request.  May be NULL.
    */
-  struct MHD_Connection *suspended_connections_head;
+  MHD_RequestCompletedCallback notify_completed;
 
   /**
-   * Tail of doubly-linked list of our current but suspended connections.
+   * Closure argument to @e notify_completed.
    */
-  struct MHD_Connection *suspended_connections_tail;
+  void *notify_completed_cls;
 
   /**
-   * Head of doubly-linked list of connections to clean up.
+   * Function to call for calls and event loop iterations that take
+   * longer than @e stall_threshold.
    */
-  struct MHD_Connection *cleanup_head;
+  MHD_StallCallback stall_cb;
 
   /**
-   * Tail of doubly-linked list of connections to clean up.
+   * Closure argument to @e stall_cb.
    */
-  struct MHD_Connection *cleanup_tail;
+  void *stall_cb_cls;
+
+  /**
+   * Threshold for #MHD_OPTION_STALL_THRESHOLD in microseconds, 0 if
+   * the watchdog is disabled.
+   */
+  uint64_t stall_threshold;
+
+  /**
+   * Function to call when we are starting/stopping
+   * a connection.  May be NULL.
+   */
+  MHD_NotifyConnectionCallback notify_connection;
+
+  /**
+   * Closure argument to @e notify_connection.
+   */
+  void *notify_connection_cls;
+
+  /**
+   * Function to call with the full URI at the
+   * beginning of request processing.  May be NULL.
+   * <p>
+   * Returns the initial pointer to internal state
+   * kept by the client for the request.
+   */
+  LogCallback uri_log_callback;
+
+  /**
+   * Closure argument to @e uri_log_callback.
+   */
+  void *uri_log_callback_cls;
+
+  /**
+   * Function to call when we unescape escape sequences.
+   */
+  UnescapeCallback unescape_callback;
+
+  /**
+   * Closure for @e unescape_callback.
+   */
+  void *unescape_callback_cls;
+
+#ifdef HAVE_MESSAGES
+  /**
+   * Function for logging error messages (if we
+   * support error reporting).
+   */
+  void (*custom_error_log) (void *cls, const char *fmt, va_list va);
+
+  /**
+   * Closure argument to @e custom_error_log.
+   */
+  void *custom_error_log_cls;
+#endif
+
+  /**
+   * Pointer to master daemon (NULL if this is the master)
+   */
+  struct MHD_Daemon *master;
+
+  /**
+   * Worker daemons (one per thread)
+   */
+  struct MHD_Daemon *worker_pool;
+
+  /**
+   * Table storing number of connections per IP, NULL
+   * if @e per_ip_connection_limit is zero.
+   */
+  struct MHD_IPCountTable *per_ip_connection_count;
+
+  /**
+   * File given with #MHD_OPTION_TRACE_FILE, NULL if none.
+   */
+  const char *trace_filename;
+
+  /**
+   * Trace of the received bytes, shared by all workers; NULL if
+   * #MHD_OPTION_TRACE_FILE was not given.
+   */
+  struct MHD_Trace *trace;
+
+  /**
+   * Size of the per-connection memory pools.
+   */
+  size_t pool_size;
+
+  /**
+   * Increment for growth of the per-connection memory pools.
+   */
+  size_t pool_increment;
+
+  /**
+   * Size of threads created by MHD.
+   */
+  size_t thread_stack_size;
+
+  /**
+   * Number of worker daemons
+   */
+  unsigned int worker_pool_size;
+
+  /**
+   * The select thread handle (if we have internal select)
+   */
+  MHD_thread_handle_ pid;
+
+  /**
+   * Filter for the addresses of accepted connections, see
+   * #MHD_OPTION_IP_FILTER.  Read and replaced with atomic
+   * operations only.
+   */
+  struct MHD_IPFilter *ip_filter;
+
+  /**
+   * Number of checks using @e ip_filter, counted in the entry
+   * selected by @e ip_filter_epoch when they started.
+   */
+  MHD_atomic_counter_ ip_filter_readers[2];
+
+  /**
+   * Which of @e ip_filter_readers new checks use (0 or 1).
+   */
+  MHD_atomic_counter_ ip_filter_epoch;
+
+  /**
+   * Mutex serializing replacements of @e ip_filter.
+   */
+  MHD_mutex_ ip_filter_lock;
+
+  /**
+   * Listen socket.
+   */
+  MHD_socket socket_fd;
+
+  /**
+   * Whether to allow/disallow/ignore reuse of listening address.
+   * The semantics is the following:
+   * 0: ignore (user did not ask for neither allow/disallow, use SO_REUSEADDR)
+   * >0: allow (use SO_REUSEPORT on most platforms, SO_REUSEADDR on Windows)
+   * <0: disallow (mostly no action, SO_EXCLUSIVEADDRUSE on Windows)
+   */
+  int listening_address_reuse;
 
 #ifdef EPOLL_SUPPORT
   /**
-   * Head of EDLL of connections ready for processing (in epoll mode).
+   * File descriptor associated with our epoll loop.
    */
-  struct MHD_Connection *eready_head;
+  int epoll_fd;
 
   /**
-   * Tail of EDLL of connections ready for processing (in epoll mode)
+   * #MHD_YES if the listen socket is in the 'epoll' set,
+   * #MHD_NO if not.
    */
-  struct MHD_Connection *eready_tail;
+  int listen_socket_in_epoll;
+
+#if HTTPS_SUPPORT
+  /**
+   * File descriptor associated with the #run_epoll_for_upgrade() loop.
+   * Only available if #MHD_USE_HTTPS_EPOLL_UPGRADE is set.
+   */
+  int epoll_upgrade_fd;
+
+  /**
+   * #MHD_YES if @e epoll_upgrade_fd is in the 'epoll' set,
+   * #MHD_NO if not.
+   */
+  int upgrade_fd_in_epoll;
+#endif
+
 #endif
 
   /**
-   * Head of the XDLL of ALL connections with a default ('normal')
-   * timeout, sorted by timeout (earliest at the tail, most recently
-   * used connection at the head).  MHD can just look at the tail of
-   * this list to determine the timeout for all of its elements;
-   * whenever there is an event of a connection, the connection is
-   * moved back to the tail of the list.
-   *
-   * All connections by default start in this list; if a custom
-   * timeout that does not match @e connection_timeout is set, they
-   * are moved to the @e manual_timeout_head-XDLL.
-   * Not used in MHD_USE_THREAD_PER_CONNECTION mode as each thread
-   * needs only one connection-specific timeout.
+   * Inter-thread communication channel.
    */
-  struct MHD_Connection *normal_timeout_head;
+  MHD_itc_ itc;
 
   /**
-   * Tail of the XDLL of ALL connections with a default timeout,
-   * sorted by timeout (earliest timeout at the tail).
-   * Not used in MHD_USE_THREAD_PER_CONNECTION mode.
+   * Are we shutting down?
    */
-  struct MHD_Connection *normal_timeout_tail;
+  int shutdown;
 
   /**
-   * Head of the XDLL of ALL connections with a non-default/custom
-   * timeout, unsorted.  MHD will do a O(n) scan over this list to
-   * determine the current timeout.
-   * Not used in MHD_USE_THREAD_PER_CONNECTION mode.
+   * Limit on the number of parallel connections.
    */
-  struct MHD_Connection *manual_timeout_head;
+  unsigned int connection_limit;
 
   /**
-   * Tail of the XDLL of ALL connections with a non-default/custom
-   * timeout, unsorted.
-   * Not used in MHD_USE_THREAD_PER_CONNECTION mode.
+   * After how many seconds of inactivity should
+   * connections time out?  Zero for no timeout.
    */
-  struct MHD_Connection *manual_timeout_tail;
+  unsigned int connection_timeout;
 
   /**
-   * Function to call to check if we should accept or reject an
-   * incoming request.  May be NULL.
+   * Maximum number of connections per IP, or 0 for
+   * unlimited.
    */
-  MHD_AcceptPolicyCallback apc;
+  unsigned int per_ip_connection_limit;
 
   /**
-   * Closure argument to apc.
+   * #MHD_YES if the daemon was started with #MHD_OPTION_IP_FILTER
+   * (and @e ip_filter_lock was initialized).
    */
-  void *apc_cls;
+  int ip_filter_enabled;
 
   /**
-   * Function to call when we are done processing
-   * a particular request.  May be NULL.
+   * Number of leading bits of IPv6 addresses that are counted
+   * together for @e per_ip_connection_limit (128 for none).
    */
-  MHD_RequestCompletedCallback notify_completed;
+  unsigned int per_ip_ipv6_prefix;
 
   /**
-   * Closure argument to @e notify_completed.
+   * Daemon's flags (bitfield).
    */
-  void *notify_completed_cls;
+  enum MHD_FLAG options;
 
   /**
-   * Function to call when we are starting/stopping
-   * a connection.  May be NULL.
+   * Listen port.
    */
-  MHD_NotifyConnectionCallback notify_connection;
+  uint16_t port;
 
+#if HTTPS_SUPPORT
   /**
-   * Closure argument to @e notify_connection.
+   * Desired cipher algorithms.
    */
-  void *notify_connection_cls;
+  gnutls_priority_t priority_cache;
 
   /**
-   * Function to call with the full URI at the
-   * beginning of request processing.  May be NULL.
-   * <p>
-   * Returns the initial pointer to internal state
-   * kept by the client for the request.
+   * What kind of credentials are we offering
+   * for SSL/TLS?
    */
-  LogCallback uri_log_callback;
+  gnutls_credentials_type_t cred_type;
 
   /**
-   * Closure argument to @e uri_log_callback.
+   * Server x509 credentials
+   */
+  gnutls_certificate_credentials_t x509_cred;
+
+  /**
+   * Diffie-Hellman parameters
+   */
+  gnutls_dh_params_t dh_params;
+
+#if GNUTLS_VERSION_MAJOR >= 3
+  /**
+   * Function that can be used to obtain the certificate.  Needed
+   * for SNI support.  See #MHD_OPTION_HTTPS_CERT_CALLBACK.
+   */
+  gnutls_certificate_retrieve_function2 *cert_callback;
+#endif
+
+  /**
+   * Pointer to our SSL/TLS key (in ASCII) in memory.
+   */
+  const char *https_mem_key;
+
+  /**
+   * Pointer to our SSL/TLS certificate (in ASCII) in memory.
    */
-  void *uri_log_callback_cls;
+  const char *https_mem_cert;
 
   /**
-   * Function to call when we unescape escape sequences.
+   * Pointer to 0-terminated HTTPS passphrase in memory.
    */
-  UnescapeCallback unescape_callback;
+  const char *https_key_password;
 
   /**
-   * Closure for @e unescape_callback.
+   * Pointer to our SSL/TLS certificate authority (in ASCII) in memory.
    */
-  void *unescape_callback_cls;
+  const char *https_mem_trust;
 
-#ifdef HAVE_MESSAGES
   /**
-   * Function for logging error messages (if we
-   * support error reporting).
+   * Our Diffie-Hellman parameters in memory.
    */
-  void (*custom_error_log) (void *cls, const char *fmt, va_list va);
+  gnutls_dh_params_t https_mem_dhparams;
 
   /**
-   * Closure argument to @e custom_error_log.
+   * #MHD_YES if we have initialized @e https_mem_dhparams.
    */
-  void *custom_error_log_cls;
-#endif
+  int have_dhparams;
 
   /**
-   * Pointer to master daemon (NULL if this is the master)
+   * Cache of TLS sessions that clients may resume, shared with the
+   * worker daemons.  NULL if disabled.
    */
-  struct MHD_Daemon *master;
+  struct MHD_TLSSessionCache *tls_session_cache;
 
   /**
-   * Worker daemons (one per thread)
+   * Number of sessions to keep in @e tls_session_cache, see
+   * #MHD_OPTION_HTTPS_SESSION_CACHE.
    */
-  struct MHD_Daemon *worker_pool;
+  unsigned int tls_session_cache_size;
 
   /**
-   * Table storing number of connections per IP
+   * #MHD_YES if session tickets were enabled with
+   * #MHD_OPTION_HTTPS_SESSION_TICKET_KEY.
    */
-  void *per_ip_connection_count;
+  int use_session_tickets;
 
   /**
-   * Size of the per-connection memory pools.
+   * Ticket key given with #MHD_OPTION_HTTPS_SESSION_TICKET_KEY,
+   * NULL to generate one.
    */
-  size_t pool_size;
+  const void *https_mem_ticket_key;
 
   /**
-   * Increment for growth of the per-connection memory pools.
+   * Number of bytes in @e https_mem_ticket_key.
    */
-  size_t pool_increment;
+  size_t https_mem_ticket_key_size;
 
   /**
-   * Size of threads created by MHD.
+   * Key to encrypt session tickets with (allocated by GnuTLS).  Only
+   * the one of the master daemon is used, it is protected by
+   * @e ticket_key_lock and can be changed with
+   * #MHD_set_https_session_ticket_key().
    */
-  size_t thread_stack_size;
+  gnutls_datum_t ticket_key;
 
   /**
-   * Number of worker daemons
+   * Mutex for @e ticket_key, initialized if @e ticket_key is set.
    */
-  unsigned int worker_pool_size;
+  MHD_mutex_ ticket_key_lock;
 
   /**
-   * The select thread handle (if we have internal select)
+   * Threads that run the steps of TLS handshakes, shared with the
+   * worker daemons.  NULL to run handshakes in the event loop.
    */
-  MHD_thread_handle_ pid;
+  struct MHD_TLSHandshakePool *tls_handshake_pool;
 
   /**
-   * Mutex for per-IP connection counts.
+   * Number of threads in @e tls_handshake_pool, see
+   * #MHD_OPTION_HTTPS_HANDSHAKE_THREADS.
    */
-  MHD_mutex_ per_ip_connection_mutex;
+  unsigned int tls_handshake_threads;
+
+#endif
+
+#ifdef DAUTH_SUPPORT
 
   /**
-   * Mutex for (modifying) access to the "cleanup" connection DLL.
+   * Character array of random values.
    */
-  MHD_mutex_ cleanup_connection_mutex;
+  const char *digest_auth_random;
 
   /**
-   * Listen socket.
+   * Table of the nonces handed out and their nonce counters,
+   * shared by all worker threads.
    */
-  MHD_socket socket_fd;
+  struct MHD_NonceTable *nonce_table;
 
   /**
-   * Whether to allow/disallow/ignore reuse of listening address.
-   * The semantics is the following:
-   * 0: ignore (user did not ask for neither allow/disallow, use SO_REUSEADDR)
-   * >0: allow (use SO_REUSEPORT on most platforms, SO_REUSEADDR on Windows)
-   * <0: disallow (mostly no action, SO_EXCLUSIVEADDRUSE on Windows)
+   * Size of `digest_auth_random.
    */
-  int listening_address_reuse;
+  size_t digest_auth_rand_size;
 
-#ifdef EPOLL_SUPPORT
   /**
-   * File descriptor associated with our epoll loop.
+   * Size of the nonce-nc array.
    */
-  int epoll_fd;
+  unsigned int nonce_nc_size;
+
+#endif
+
+#ifdef BAUTH_SUPPORT
 
   /**
-   * #MHD_YES if the listen socket is in the 'epoll' set,
-   * #MHD_NO if not.
+   * Basic authentication headers verified by the application,
+   * NULL if the cache is disabled.  Shared by all worker threads.
    */
-  int listen_socket_in_epoll;
+  struct MHD_AuthCache *basic_auth_cache;
 
-#if HTTPS_SUPPORT
   /**
-   * File descriptor associated with the #run_epoll_for_upgrade() loop.
-   * Only available if #MHD_USE_HTTPS_EPOLL_UPGRADE is set.
+   * Number of entries of @e basic_auth_cache.
    */
-  int epoll_upgrade_fd;
+  unsigned int basic_auth_cache_size;
 
   /**
-   * #MHD_YES if @e epoll_upgrade_fd is in the 'epoll' set,
-   * #MHD_NO if not.
+   * Number of seconds to keep entries of @e basic_auth_cache.
    */
-  int upgrade_fd_in_epoll;
-#endif
+  unsigned int basic_auth_cache_timeout;
 
 #endif
 
+#ifdef COMPRESSION_SUPPORT
+
   /**
-   * Inter-thread communication channel.
+   * Responses with a known size below this value are never
+   * compressed.
    */
-  MHD_itc_ itc;
+  size_t compress_min_size;
 
   /**
-   * Are we shutting down?
+   * Maximum size of a decompressed request body, 0 if request
+   * bodies are not decompressed (#MHD_OPTION_REQUEST_DECOMPRESSION).
    */
-  int shutdown;
+  size_t inflate_max_size;
 
   /**
-   * Did we hit some system or process-wide resource limit while
-   * trying to accept() the last time? If so, we don't accept new
-   * connections until we close an existing one.  This effectively
-   * temporarily lowers the "connection_limit" to the current
-   * number of connections.
+   * #MHD_YES if #MHD_OPTION_RESPONSE_COMPRESSION was given.
    */
-  int at_limit;
+  int compress_responses;
 
-  /*
-   * Do we need to process resuming connections?
+#endif
+
+#ifdef TCP_FASTOPEN
+  /**
+   * The queue size for incoming SYN + DATA packets.
    */
-  int resuming;
+  unsigned int fastopen_queue_size;
+#endif
 
   /**
-   * Number of active parallel connections.
+   * The size of queue for listen socket.
    */
-  unsigned int connections;
+  unsigned int listen_backlog_size;
 
   /**
-   * Limit on the number of parallel connections.
+   * Keeps the per-thread state below off the cache lines of the
+   * read-mostly configuration above.  The workers of a thread pool
+   * are copies of the master; while they run, their threads only
+   * write to the fields from here on.
    */
-  unsigned int connection_limit;
+  char state_pad[MHD_CACHE_LINE_SIZE];
 
   /**
-   * After how many seconds of inactivity should
-   * connections time out?  Zero for no timeout.
+   * Head of doubly-linked list of our current, active connections.
    */
-  unsigned int connection_timeout;
+  struct MHD_Connection *connections_head;
 
   /**
-   * Maximum number of connections per IP, or 0 for
-   * unlimited.
+   * Tail of doubly-linked list of our current, active connections.
    */
-  unsigned int per_ip_connection_limit;
+  struct MHD_Connection *connections_tail;
 
   /**
-   * Daemon's flags (bitfield).
+   * Head of doubly-linked list of our current but suspended connections.
    */
-  enum MHD_FLAG options;
+  struct MHD_Connection *suspended_connections_head;
 
   /**
-   * Listen port.
+   * Tail of doubly-linked list of our current but suspended connections.
    */
-  uint16_t port;
+  struct MHD_Connection *suspended_connections_tail;
 
-#if HTTPS_SUPPORT
   /**
-   * Head of DLL of upgrade response handles we are processing.
+   * Head of doubly-linked list of connections to clean up.
    */
-  struct MHD_UpgradeResponseHandle *urh_head;
+  struct MHD_Connection *cleanup_head;
 
   /**
-   * Tail of DLL of upgrade response handles we are processing.
+   * Tail of doubly-linked list of connections to clean up.
    */
-  struct MHD_UpgradeResponseHandle *urh_tail;
+  struct MHD_Connection *cleanup_tail;
 
+#ifdef EPOLL_SUPPORT
   /**
-   * Desired cipher algorithms.
+   * Head of EDLL of connections ready for processing (in epoll mode).
    */
-  gnutls_priority_t priority_cache;
+  struct MHD_Connection *eready_head;
 
   /**
-   * What kind of credentials are we offering
-   * for SSL/TLS?
+   * Tail of EDLL of connections ready for processing (in epoll mode)
    */
-  gnutls_credentials_type_t cred_type;
+  struct MHD_Connection *eready_tail;
+#endif
 
   /**
-   * Server x509 credentials
+   * Head of the XDLL of ALL connections with a default ('normal')
+   * timeout, sorted by timeout (earliest at the tail, most recently
+   * used connection at the head).  MHD can just look at the tail of
+   * this list to determine the timeout for all of its elements;
+   * whenever there is an event of a connection, the connection is
+   * moved back to the tail of the list.
+   *
+   * All connections by default start in this list; if a custom
+   * timeout that does not match @e connection_timeout is set, they
+   * are moved to the @e manual_timeout_head-XDLL.
+   * Not used in MHD_USE_THREAD_PER_CONNECTION mode as each thread
+   * needs only one connection-specific timeout.
    */
-  gnutls_certificate_credentials_t x509_cred;
+  struct MHD_Connection *normal_timeout_head;
 
   /**
-   * Diffie-Hellman parameters
+   * Tail of the XDLL of ALL connections with a default timeout,
+   * sorted by timeout (earliest timeout at the tail).
+   * Not used in MHD_USE_THREAD_PER_CONNECTION mode.
    */
-  gnutls_dh_params_t dh_params;
+  struct MHD_Connection *normal_timeout_tail;
 
-#if GNUTLS_VERSION_MAJOR >= 3
   /**
-   * Function that can be used to obtain the certificate.  Needed
-   * for SNI support.  See #MHD_OPTION_HTTPS_CERT_CALLBACK.
+   * Head of the XDLL of ALL connections with a non-default/custom
+   * timeout, unsorted.  MHD will do a O(n) scan over this list to
+   * determine the current timeout.
+   * Not used in MHD_USE_THREAD_PER_CONNECTION mode.
    */
-  gnutls_certificate_retrieve_function2 *cert_callback;
-#endif
+  struct MHD_Connection *manual_timeout_head;
 
   /**
-   * Pointer to our SSL/TLS key (in ASCII) in memory.
+   * Tail of the XDLL of ALL connections with a non-default/custom
+   * timeout, unsorted.
+   * Not used in MHD_USE_THREAD_PER_CONNECTION mode.
    */
-  const char *https_mem_key;
+  struct MHD_Connection *manual_timeout_tail;
 
   /**
-   * Pointer to our SSL/TLS certificate (in ASCII) in memory.
+   * Mutex for (modifying) access to the "cleanup" connection DLL.
    */
-  const char *https_mem_cert;
+  MHD_mutex_ cleanup_connection_mutex;
 
   /**
-   * Pointer to 0-terminated HTTPS passphrase in memory.
+   * Did we hit some system or process-wide resource limit while
+   * trying to accept() the last time? If so, we don't accept new
+   * connections until we close an existing one.  This effectively
+   * temporarily lowers the "connection_limit" to the current
+   * number of connections.
    */
-  const char *https_key_password;
+  int at_limit;
+
+  /*
+   * Do we need to process resuming connections?
+   */
+  int resuming;
 
   /**
-   * Pointer to our SSL/TLS certificate authority (in ASCII) in memory.
+   * Number of active parallel connections.
    */
-  const char *https_mem_trust;
+  unsigned int connections;
 
+#if HTTPS_SUPPORT
   /**
-   * Our Diffie-Hellman parameters in memory.
+   * Head of DLL of upgrade response handles we are processing.
    */
-  gnutls_dh_params_t https_mem_dhparams;
+  struct MHD_UpgradeResponseHandle *urh_head;
 
   /**
-   * #MHD_YES if we have initialized @e https_mem_dhparams.
+   * Tail of DLL of upgrade response handles we are processing.
    */
-  int have_dhparams;
+  struct MHD_UpgradeResponseHandle *urh_tail;
 
   /**
    * For how many connections do we have 'tls_read_ready' set to MHD_YES?
@@ -1484,52 +1810,79 @@ struct MHD_Daemon
    * which might have ready data within TLS).
    */
   unsigned int num_tls_read_ready;
-
 #endif
 
-#ifdef DAUTH_SUPPORT
-
+#ifdef COMPRESSION_SUPPORT
   /**
-   * Character array of random values.
+   * Free lists of deflate streams that can be reused for
+   * compressing responses, one per content coding.  Each worker
+   * of a thread pool has its own lists.  With
+   * #MHD_USE_THREAD_PER_CONNECTION the lists are protected by
+   * @e cleanup_connection_mutex.
    */
-  const char *digest_auth_random;
+  struct MHD_ZStream *zstream_pool[2];
 
   /**
-   * An array that contains the map nonce-nc.
+   * Number of streams in @e zstream_pool.
    */
-  struct MHD_NonceNc *nnc;
+  unsigned int zstream_pool_size;
+#endif
 
   /**
-   * A rw-lock for synchronizing access to @e nnc.
+   * Keeps @e stats off the cache lines of the fields above.
    */
-  MHD_mutex_ nnc_lock;
+  char stats_pad_head[MHD_CACHE_LINE_SIZE];
 
   /**
-   * Size of `digest_auth_random.
+   * Statistics of the connections handled by this daemon (worker);
+   * only updated by the thread of the daemon, without locks.  With
+   * #MHD_USE_THREAD_PER_CONNECTION, the connection threads also add
+   * to them, so all updates take the @e cleanup_connection_mutex.
    */
-  size_t digest_auth_rand_size;
+  struct MHD_DaemonStats stats;
 
   /**
-   * Size of the nonce-nc array.
+   * Durations of the phases of the requests handled by this daemon
+   * (worker), with #MHD_OPTION_REQUEST_TIMING.  Like @e stats, only
+   * updated by the thread of the daemon (with
+   * #MHD_USE_THREAD_PER_CONNECTION, under the
+   * @e cleanup_connection_mutex).
    */
-  unsigned int nonce_nc_size;
+  struct MHD_Histogram phase_histograms[MHD_REQUEST_PHASE_COUNT];
 
-#endif
+  /**
+   * With #MHD_OPTION_STALL_THRESHOLD, when the current event loop
+   * iteration stopped waiting for activity; 0 while waiting.
+   */
+  uint64_t loop_wake;
 
-#ifdef TCP_FASTOPEN
   /**
-   * The queue size for incoming SYN + DATA packets.
+   * Keeps @e stats off the cache lines of the next daemon in the
+   * worker pool.
    */
-  unsigned int fastopen_queue_size;
-#endif
+  char stats_pad_tail[MHD_CACHE_LINE_SIZE];
 
   /**
-   * The size of queue for listen socket.
+   * #MHD_YES if #MHD_OPTION_REQUEST_TIMING was enabled.
    */
-  unsigned int listen_backlog_size;
+  int request_timing;
 };
 
 
+/**
+ * Statistics to update for connection @a c: those of its daemon,
+ * which are only written by the thread of the daemon, or with
+ * #MHD_USE_THREAD_PER_CONNECTION those of the connection itself,
+ * which its thread adds to those of the daemon when it exits.
+ *
+ * @param c the connection
+ * @return pointer to a `struct MHD_DaemonStats`
+ */
+#define MHD_connection_stats_(c) \
+  ( (0 != ((c)->daemon->options & MHD_USE_THREAD_PER_CONNECTION)) \
+    ? &(c)->cold->stats : &(c)->daemon->stats )
+
+
 #if EXTRA_CHECKS
 #define EXTRA_CHECK(a) do { if (!(a)) abort(); } while (0)
 #else
@@ -1675,6 +2028,21 @@ void
 MHD_unescape_plus (char *arg);
 
 
+/**
+ * Process escape sequences ('%HH') Updates val in place.  This is
+ * the default #UnescapeCallback of a daemon.
+ *
+ * @param cls closure (use NULL)
+ * @param connection handle to connection, not used
+ * @param val value to unescape (modified in the process)
+ * @return length of the resulting val
+ */
+size_t
+MHD_unescape_wrapper_ (void *cls,
+                       struct MHD_Connection *connection,
+                       char *val);
+
+
 /**
  * Callback invoked when iterating over @a key / @a value
  * argument pairs during parsing.
@@ -1715,4 +2083,49 @@ MHD_parse_arguments_ (struct MHD_Connection *connection,
 		      unsigned int *num_headers);
 
 
+/**
+ * Suspend handling of network data for @a connection, like
+ * #MHD_suspend_connection(); with @a internally set, for parking a
+ * connection inside of MHD, without #MHD_USE_SUSPEND_RESUME and
+ * without counting it in the statistics.
+ *
+ * @param connection the connection to suspend
+ * @param internally #MHD_YES if MHD suspends the connection,
+ *        #MHD_NO if the application does
+ */
+void
+MHD_suspend_connection_ (struct MHD_Connection *connection,
+                         int internally);
+
+
+/**
+ * Resume handling of network data for @a connection suspended with
+ * #MHD_suspend_connection_().
+ *
+ * @param connection the connection to resume
+ */
+void
+MHD_resume_connection_ (struct MHD_Connection *connection);
+
+
+/**
+ * Allocate memory aligned to #MHD_CACHE_LINE_SIZE (where the
+ * platform allows it).
+ *
+ * @param size number of bytes to allocate
+ * @return NULL on error (with errno set)
+ */
+void *
+MHD_aligned_malloc_ (size_t size);
+
+
+/**
+ * Free memory allocated with #MHD_aligned_malloc_().
+ *
+ * @param ptr memory to free, may be NULL
+ */
+void
+MHD_aligned_free_ (void *ptr);
+
+
 #endif
@@ -0,0 +1,444 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/ipcount.c
+ * @brief  table with the number of connections per client address
+ * @author libmicrohttpd contributors
+ *
+ * The table is split into shards, each with its own lock, so that
+ * threads accepting and closing connections of different clients
+ * rarely wait for each other.  Each shard is an open-addressing
+ * hash table with linear probing (and backward-shift deletion, so
+ * there are no tombstones).  The slots are allocated when the
+ * table is created, sized for the maximum number of connections
+ * of the daemon.
+ */
+#include "ipcount.h"
+#include "mhd_locks.h"
+#include "mhd_siphash.h"
+
+
+/**
+ * Number of shards, must be a power of two.
+ */
+#define IPCOUNT_SHARDS 16
+
+
+/**
+ * Connection count for one address (or IPv6 prefix).
+ */
+struct IPCountSlot
+{
+  /**
+   * The address as an IPv6 address in network byte order; IPv4
+   * addresses are stored IPv4-mapped (::ffff:a.b.c.d).
+   */
+  uint64_t key[2];
+
+  /**
+   * Hash of @e key.
+   */
+  uint64_t hash;
+
+  /**
+   * Number of connections, 0 if the slot is free.
+   */
+  unsigned int count;
+};
+
+
+/**
+ * One shard of the table.
+ */
+struct IPCountShard
+{
+  /**
+   * Protects this shard.
+   */
+  MHD_mutex_ lock;
+
+  /**
+   * Array of slots, length @e mask + 1.
+   */
+  struct IPCountSlot *slots;
+
+  /**
+   * Number of slots minus one.
+   */
+  size_t mask;
+
+  /**
+   * Number of slots in use.
+   */
+  size_t used;
+
+  /**
+   * Keeps the lock of the next shard off our cache lines; the
+   * shards are locked by the threads of all workers.
+   */
+  char pad[MHD_CACHE_LINE_SIZE];
+};
+
+
+/**
+ * Table with the number of connections per client address.
+ */
+struct MHD_IPCountTable
+{
+  /**
+   * The shards.
+   */
+  struct IPCountShard shards[IPCOUNT_SHARDS];
+
+  /**
+   * Random key of the hash, so that clients cannot choose
+   * addresses that all end up in the same shard or slots.
+   */
+  uint64_t key[2];
+
+  /**
+   * Mask to apply to IPv6 addresses (@e key of the slots).
+   */
+  uint64_t mask6[2];
+};
+
+
+/**
+ * Create a table for counting connections per client address.
+ * All memory is allocated here; adding addresses never allocates.
+ *
+ * @param max_connections maximum number of connections that will
+ *        ever be counted at the same time
+ * @param ipv6_prefix number of leading bits of IPv6 addresses to
+ *        count together (128 to count each address on its own)
+ * @return NULL on error; errno is ENOSYS if no random bytes
+ *         were available for the hash key, otherwise we ran out
+ *         of memory
+ */
+struct MHD_IPCountTable *
+MHD_ipcount_create_ (unsigned int max_connections,
+                     unsigned int ipv6_prefix)
+{
+  struct MHD_IPCountTable *table;
+  struct IPCountSlot *slots;
+  size_t per_shard;
+  unsigned int i;
+  unsigned int j;
+  unsigned char mask[16];
+
+  /* twice the expected number of addresses per shard keeps the
+     probe sequences short; the slack covers uneven distribution */
+  per_shard = 16;
+  while (per_shard < 2 * ((size_t) max_connections / IPCOUNT_SHARDS) + 16)
+    per_shard *= 2;
+  if (NULL == (table = malloc (sizeof (struct MHD_IPCountTable))))
+    return NULL;
+  if (NULL == (slots = calloc (per_shard * IPCOUNT_SHARDS,
+                               sizeof (struct IPCountSlot))))
+    {
+      free (table);
+      return NULL;
+    }
+  for (i = 0; i < IPCOUNT_SHARDS; i++)
+    {
+      if (! MHD_mutex_init_ (&table->shards[i].lock))
+        {
+          for (j = 0; j < i; j++)
+            MHD_mutex_destroy_chk_ (&table->shards[j].lock);
+          free (slots);
+          free (table);
+          return NULL;
+        }
+      table->shards[i].slots = &slots[i * per_shard];
+      table->shards[i].mask = per_shard - 1;
+      table->shards[i].used = 0;
+    }
+  if (ipv6_prefix > 128)
+    ipv6_prefix = 128;
+  for (i = 0; i < 16; i++)
+    {
+      if (ipv6_prefix >= 8 * (i + 1))
+        mask[i] = 0xFF;
+      else if (ipv6_prefix <= 8 * i)
+        mask[i] = 0;
+      else
+        mask[i] = (unsigned char) (0xFF << (8 * (i + 1) - ipv6_prefix));
+    }
+  memcpy (table->mask6,
+          mask,
+          sizeof (mask));
+  if (MHD_YES != MHD_siphash_key_ (table->key,
+                                   NULL,
+                                   0))
+    {
+      MHD_ipcount_destroy_ (table);
+      errno = ENOSYS; /* destroy may have changed it */
+      return NULL;
+    }
+  return table;
+}
+
+
+/**
+ * Destroy a table created with #MHD_ipcount_create_().
+ *
+ * @param table the table to destroy, may be NULL
+ */
+void
+MHD_ipcount_destroy_ (struct MHD_IPCountTable *table)
+{
+  unsigned int i;
+
+  if (NULL == table)
+    return;
+  for (i = 0; i < IPCOUNT_SHARDS; i++)
+    MHD_mutex_destroy_chk_ (&table->shards[i].lock);
+  free (table->shards[0].slots);
+  free (table);
+}
+
+
+/**
+ * Convert a client address to the key used in the table.
+ *
+ * @param table the table
+ * @param addr address of the client
+ * @param addrlen number of bytes in @a addr
+ * @param[out] key set to the key
+ * @return #MHD_YES on success, #MHD_NO if @a addr is not an
+ *         IP address
+ */
+static int
+addr_to_key (const struct MHD_IPCountTable *table,
+             const struct sockaddr *addr,
+             socklen_t addrlen,
+             uint64_t key[2])
+{
+  unsigned char buf[16];
+
+  if (sizeof (struct sockaddr_in) == addrlen)
+    {
+      const struct sockaddr_in *addr4 = (const struct sockaddr_in *) addr;
+
+      memset (buf, 0, 10);
+      buf[10] = 0xFF;
+      buf[11] = 0xFF;
+      memcpy (&buf[12],
+              &addr4->sin_addr,
+              4);
+      memcpy (key, buf, sizeof (buf));
+      return MHD_YES;
+    }
+#if HAVE_INET6
+  if (sizeof (struct sockaddr_in6) == addrlen)
+    {
+      const struct sockaddr_in6 *addr6 = (const struct sockaddr_in6 *) addr;
+
+      memcpy (key,
+              &addr6->sin6_addr,
+              sizeof (buf));
+      /* an IPv4 client of a dual-stack socket is counted as
+         an IPv4 address, not as part of an IPv6 prefix */
+      if (! IN6_IS_ADDR_V4MAPPED (&addr6->sin6_addr))
+        {
+          key[0] &= table->mask6[0];
+          key[1] &= table->mask6[1];
+        }
+      return MHD_YES;
+    }
+#endif
+  return MHD_NO;
+}
+
+
+/**
+ * Compute the hash of a key.
+ *
+ * @param table the table
+ * @param key the key
+ * @return the hash; the high bits select the shard, the low
+ *         bits the first slot to probe
+ */
+static uint64_t
+hash_key (const struct MHD_IPCountTable *table,
+          const uint64_t key[2])
+{
+  return MHD_siphash24_ (table->key,
+                         key,
+                         2 * sizeof (uint64_t));
+}
+
+
+/**
+ * Select the shard for a hash.
+ *
+ * @param table the table
+ * @param hash hash of the key
+ * @return the shard
+ */
+static struct IPCountShard *
+hash_to_shard (struct MHD_IPCountTable *table,
+               uint64_t hash)
+{
+  return &table->shards[(hash >> 56) & (IPCOUNT_SHARDS - 1)];
+}
+
+
+/**
+ * Check if the address is below @a limit connections.  If so,
+ * increment its connection counter.
+ *
+ * @param table table to update
+ * @param addr address of the client
+ * @param addrlen number of bytes in @a addr
+ * @param limit maximum number of connections per address
+ * @return #MHD_YES if the address was below the limit (or is not
+ *         an IP address), #MHD_NO if it is at the limit or if
+ *         the table is full
+ */
+int
+MHD_ipcount_add_ (struct MHD_IPCountTable *table,
+                  const struct sockaddr *addr,
+                  socklen_t addrlen,
+                  unsigned int limit)
+{
+  struct IPCountShard *shard;
+  struct IPCountSlot *slot;
+  uint64_t key[2];
+  uint64_t hash;
+  size_t pos;
+  int result;
+
+  /* Allow unhandled address types through */
+  if (MHD_NO == addr_to_key (table,
+                             addr,
+                             addrlen,
+                             key))
+    return MHD_YES;
+  hash = hash_key (table,
+                   key);
+  shard = hash_to_shard (table,
+                         hash);
+  MHD_mutex_lock_chk_ (&shard->lock);
+  pos = (size_t) hash & shard->mask;
+  while (0 != (slot = &shard->slots[pos])->count)
+    {
+      if ( (slot->key[0] == key[0]) &&
+           (slot->key[1] == key[1]) )
+        break;
+      pos = (pos + 1) & shard->mask;
+    }
+  if (0 != slot->count)
+    {
+      result = (slot->count < limit) ? MHD_YES : MHD_NO;
+      if (MHD_YES == result)
+        slot->count++;
+    }
+  else if (shard->used == shard->mask)
+    {
+      /* keep one slot free so that probing terminates */
+      result = MHD_NO;
+    }
+  else
+    {
+      slot->key[0] = key[0];
+      slot->key[1] = key[1];
+      slot->hash = hash;
+      slot->count = 1;
+      shard->used++;
+      result = MHD_YES;
+    }
+  MHD_mutex_unlock_chk_ (&shard->lock);
+  return result;
+}
+
+
+/**
+ * Decrement the connection counter of an address previously
+ * added with #MHD_ipcount_add_().
+ *
+ * @param table table to update
+ * @param addr address of the client
+ * @param addrlen number of bytes in @a addr
+ */
+void
+MHD_ipcount_del_ (struct MHD_IPCountTable *table,
+                  const struct sockaddr *addr,
+                  socklen_t addrlen)
+{
+  struct IPCountShard *shard;
+  struct IPCountSlot *slot;
+  uint64_t key[2];
+  uint64_t hash;
+  size_t pos;
+  size_t next;
+  size_t home;
+
+  if (MHD_NO == addr_to_key (table,
+                             addr,
+                             addrlen,
+                             key))
+    return;
+  hash = hash_key (table,
+                   key);
+  shard = hash_to_shard (table,
+                         hash);
+  MHD_mutex_lock_chk_ (&shard->lock);
+  pos = (size_t) hash & shard->mask;
+  while (0 != (slot = &shard->slots[pos])->count)
+    {
+      if ( (slot->key[0] == key[0]) &&
+           (slot->key[1] == key[1]) )
+        break;
+      pos = (pos + 1) & shard->mask;
+    }
+  /* Something's wrong if we couldn't find an IP address
+   * that was previously added */
+  if (0 == slot->count)
+    MHD_PANIC (_("Failed to find previously-added IP address\n"));
+  if (0 != --slot->count)
+    {
+      MHD_mutex_unlock_chk_ (&shard->lock);
+      return;
+    }
+  /* Remove the slot, moving back later entries of the probe
+     sequence into the hole so that lookups still find them */
+  shard->used--;
+  next = pos;
+  for (;;)
+    {
+      next = (next + 1) & shard->mask;
+      if (0 == shard->slots[next].count)
+        break;
+      home = (size_t) shard->slots[next].hash & shard->mask;
+      /* the entry at 'next' may stay if its home is cyclically
+         within (pos, next] */
+      if ( (pos <= next)
+           ? ( (pos < home) && (home <= next) )
+           : ( (pos < home) || (home <= next) ) )
+        continue;
+      shard->slots[pos] = shard->slots[next];
+      pos = next;
+    }
+  shard->slots[pos].count = 0;
+  MHD_mutex_unlock_chk_ (&shard->lock);
+}
+
+/* end of ipcount.c */
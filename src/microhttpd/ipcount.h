@@ -0,0 +1,95 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/ipcount.h
+ * @brief  table with the number of connections per client address
+ * @author libmicrohttpd contributors
+ */
+#ifndef IPCOUNT_H
+#define IPCOUNT_H
+
+#include "internal.h"
+
+
+/**
+ * Table with the number of connections per client address.
+ */
+struct MHD_IPCountTable;
+
+
+/**
+ * Create a table for counting connections per client address.
+ * All memory is allocated here; adding addresses never allocates.
+ *
+ * @param max_connections maximum number of connections that will
+ *        ever be counted at the same time
+ * @param ipv6_prefix number of leading bits of IPv6 addresses to
+ *        count together (128 to count each address on its own)
+ * @return NULL on error; errno is ENOSYS if no random bytes
+ *         were available for the hash key, otherwise we ran out
+ *         of memory
+ */
+struct MHD_IPCountTable *
+MHD_ipcount_create_ (unsigned int max_connections,
+                     unsigned int ipv6_prefix);
+
+
+/**
+ * Destroy a table created with #MHD_ipcount_create_().
+ *
+ * @param table the table to destroy, may be NULL
+ */
+void
+MHD_ipcount_destroy_ (struct MHD_IPCountTable *table);
+
+
+/**
+ * Check if the address is below @a limit connections.  If so,
+ * increment its connection counter.
+ *
+ * @param table table to update
+ * @param addr address of the client
+ * @param addrlen number of bytes in @a addr
+ * @param limit maximum number of connections per address
+ * @return #MHD_YES if the address was below the limit (or is not
+ *         an IP address), #MHD_NO if it is at the limit or if
+ *         the table is full
+ */
+int
+MHD_ipcount_add_ (struct MHD_IPCountTable *table,
+                  const struct sockaddr *addr,
+                  socklen_t addrlen,
+                  unsigned int limit);
+
+
+/**
+ * Decrement the connection counter of an address previously
+ * added with #MHD_ipcount_add_().
+ *
+ * @param table table to update
+ * @param addr address of the client
+ * @param addrlen number of bytes in @a addr
+ */
+void
+MHD_ipcount_del_ (struct MHD_IPCountTable *table,
+                  const struct sockaddr *addr,
+                  socklen_t addrlen);
+
+#endif
@@ -0,0 +1,509 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/ipfilter.c
+ * @brief  allow/deny and rate limits for client address ranges
+ * @author libmicrohttpd contributors
+ *
+ * The ranges are kept in a binary trie over the bits of the
+ * address, stored in one array of nodes, so that a lookup is a
+ * walk of at most 128 steps that finds the longest matching
+ * prefix.  IPv4 ranges are stored as IPv4-mapped IPv6 ranges
+ * (::ffff:0:0/96), so one trie serves both address families.
+ *
+ * Once a daemon uses a filter, only the token buckets of its rules
+ * change; they are guarded by a few locks striped over the rules.
+ * Checks read the daemon's filter without a lock and announce
+ * themselves in one of two reader counters, so that a replaced
+ * filter is only destroyed once no check can still use it.
+ */
+#include "ipfilter.h"
+#include "mhd_locks.h"
+#include "mhd_atomic.h"
+#include "mhd_mono_clock.h"
+
+
+/**
+ * Number of locks for the token buckets.
+ */
+#define IP_FILTER_LOCKS 16
+
+/**
+ * Credit of one token in a bucket; a range with a rate of one
+ * connection per second gains one credit per microsecond.
+ */
+#define TOKEN_CREDIT 1000000
+
+
+/**
+ * Node of the trie.
+ */
+struct FilterNode
+{
+  /**
+   * Index of the child for a 0 and a 1 bit, 0 for none (the
+   * root is never a child).
+   */
+  unsigned int child[2];
+
+  /**
+   * Index of the rule of the range ending at this node plus
+   * one, 0 for none.
+   */
+  unsigned int rule;
+};
+
+
+/**
+ * Rule for one address range.
+ */
+struct FilterRule
+{
+  /**
+   * What to do with connections from the range.
+   */
+  enum MHD_IPFilterAction action;
+
+  /**
+   * Connections per second allowed from the range, 0 for no limit.
+   */
+  unsigned int rate;
+
+  /**
+   * Maximum number of tokens in the bucket.
+   */
+  unsigned int burst;
+
+  /**
+   * Credit currently in the bucket, in units of one millionth of
+   * a token (see #TOKEN_CREDIT).
+   */
+  uint64_t credit;
+
+  /**
+   * Time (#MHD_monotonic_usec_counter()) of the last refill.
+   */
+  uint64_t last_refill;
+};
+
+
+/**
+ * Set of address ranges with allow/deny decisions and rate limits.
+ */
+struct MHD_IPFilter
+{
+  /**
+   * Nodes of the trie, the root is at index 0.
+   */
+  struct FilterNode *nodes;
+
+  /**
+   * Rules, referenced from @e nodes.
+   */
+  struct FilterRule *rules;
+
+  /**
+   * Number of entries used in @e nodes.
+   */
+  unsigned int num_nodes;
+
+  /**
+   * Number of entries allocated in @e nodes.
+   */
+  unsigned int max_nodes;
+
+  /**
+   * Number of entries used in @e rules.
+   */
+  unsigned int num_rules;
+
+  /**
+   * Number of entries allocated in @e rules.
+   */
+  unsigned int max_rules;
+
+  /**
+   * What to do with addresses outside of all ranges.
+   */
+  enum MHD_IPFilterAction default_action;
+
+  /**
+   * Locks for the token buckets of @e rules, rule @e i uses
+   * lock @e i modulo #IP_FILTER_LOCKS.
+   */
+  MHD_mutex_ locks[IP_FILTER_LOCKS];
+};
+
+
+/**
+ * Convert an address to the 16 bytes used as key in the trie.
+ *
+ * @param addr the address
+ * @param addrlen number of bytes in @a addr
+ * @param[out] key set to the address as IPv6 address
+ * @return #MHD_YES on success, #MHD_NO if @a addr is not an
+ *         IP address
+ */
+static int
+addr_to_key (const struct sockaddr *addr,
+             socklen_t addrlen,
+             unsigned char key[16])
+{
+  if ( (sizeof (struct sockaddr_in) == addrlen) &&
+       (AF_INET == addr->sa_family) )
+    {
+      memset (key, 0, 10);
+      key[10] = 0xFF;
+      key[11] = 0xFF;
+      memcpy (&key[12],
+              &((const struct sockaddr_in *) addr)->sin_addr,
+              4);
+      return MHD_YES;
+    }
+#if HAVE_INET6
+  if ( (sizeof (struct sockaddr_in6) == addrlen) &&
+       (AF_INET6 == addr->sa_family) )
+    {
+      memcpy (key,
+              &((const struct sockaddr_in6 *) addr)->sin6_addr,
+              16);
+      return MHD_YES;
+    }
+#endif
+  return MHD_NO;
+}
+
+
+/**
+ * Create an empty filter.  Add ranges with #MHD_ip_filter_add() and
+ * pass it to #MHD_start_daemon() with #MHD_OPTION_IP_FILTER or to
+ * #MHD_set_ip_filter().
+ *
+ * @param default_action what to do with connections from
+ *        addresses that are not in any range of the filter
+ * @return NULL on error (out of memory)
+ * @ingroup specialized
+ */
+struct MHD_IPFilter *
+MHD_ip_filter_create (enum MHD_IPFilterAction default_action)
+{
+  struct MHD_IPFilter *filter;
+  unsigned int i;
+  unsigned int j;
+
+  if (NULL == (filter = malloc (sizeof (struct MHD_IPFilter))))
+    return NULL;
+  memset (filter,
+          0,
+          sizeof (struct MHD_IPFilter));
+  filter->max_nodes = 64;
+  if (NULL == (filter->nodes = calloc (filter->max_nodes,
+                                       sizeof (struct FilterNode))))
+    {
+      free (filter);
+      return NULL;
+    }
+  for (i = 0; i < IP_FILTER_LOCKS; i++)
+    {
+      if (! MHD_mutex_init_ (&filter->locks[i]))
+        {
+          for (j = 0; j < i; j++)
+            MHD_mutex_destroy_chk_ (&filter->locks[j]);
+          free (filter->nodes);
+          free (filter);
+          return NULL;
+        }
+    }
+  filter->num_nodes = 1;
+  filter->default_action = default_action;
+  return filter;
+}
+
+
+/**
+ * Add a range of addresses to a filter that is not (yet) used
+ * by a daemon.  If the same range was added before, its rule is
+ * replaced.  Connections are checked against the most specific
+ * (longest) range that contains the client's address.
+ *
+ * @param filter the filter to modify
+ * @param addr first address of the range, a `struct sockaddr_in`
+ *        or `struct sockaddr_in6`; only the address is used
+ * @param addrlen number of bytes in @a addr
+ * @param prefix_len number of leading bits of @a addr that
+ *        define the range (at most 32 for IPv4, 128 for IPv6)
+ * @param action what to do with connections from the range
+ * @param rate if @a action is #MHD_IP_FILTER_ALLOW, maximum number
+ *        of new connections per second from the range as a whole
+ *        (0 for no limit); connections beyond the limit are closed
+ *        right after they were accepted
+ * @param burst number of connections that may be accepted at
+ *        once after the range was idle (0 to use @a rate)
+ * @return #MHD_YES on success, #MHD_NO on error (out of memory
+ *         or invalid address or prefix length)
+ * @ingroup specialized
+ */
+int
+MHD_ip_filter_add (struct MHD_IPFilter *filter,
+                   const struct sockaddr *addr,
+                   socklen_t addrlen,
+                   unsigned int prefix_len,
+                   enum MHD_IPFilterAction action,
+                   unsigned int rate,
+                   unsigned int burst)
+{
+  unsigned char key[16];
+  struct FilterRule *rule;
+  unsigned int node;
+  unsigned int bit;
+  unsigned int i;
+
+  if (MHD_NO == addr_to_key (addr,
+                             addrlen,
+                             key))
+    return MHD_NO;
+  if (AF_INET == addr->sa_family)
+    {
+      if (prefix_len > 32)
+        return MHD_NO;
+      prefix_len += 96;
+    }
+  if (prefix_len > 128)
+    return MHD_NO;
+  /* make room for the worst case first, so that a failure
+     leaves the filter unchanged */
+  if (filter->num_nodes + prefix_len > filter->max_nodes)
+    {
+      struct FilterNode *nodes;
+      unsigned int max;
+
+      max = 2 * (filter->num_nodes + prefix_len);
+      if (NULL == (nodes = realloc (filter->nodes,
+                                    max * sizeof (struct FilterNode))))
+        return MHD_NO;
+      memset (&nodes[filter->max_nodes],
+              0,
+              (max - filter->max_nodes) * sizeof (struct FilterNode));
+      filter->nodes = nodes;
+      filter->max_nodes = max;
+    }
+  if (filter->num_rules == filter->max_rules)
+    {
+      struct FilterRule *rules;
+      unsigned int max;
+
+      max = 2 * filter->max_rules + 8;
+      if (NULL == (rules = realloc (filter->rules,
+                                    max * sizeof (struct FilterRule))))
+        return MHD_NO;
+      filter->rules = rules;
+      filter->max_rules = max;
+    }
+  node = 0;
+  for (i = 0; i < prefix_len; i++)
+    {
+      bit = (key[i / 8] >> (7 - i % 8)) & 1;
+      if (0 == filter->nodes[node].child[bit])
+        filter->nodes[node].child[bit] = filter->num_nodes++;
+      node = filter->nodes[node].child[bit];
+    }
+  if (0 == filter->nodes[node].rule)
+    filter->nodes[node].rule = ++filter->num_rules;
+  rule = &filter->rules[filter->nodes[node].rule - 1];
+  rule->action = action;
+  rule->rate = rate;
+  rule->burst = (0 == burst) ? rate : burst;
+  rule->credit = (uint64_t) rule->burst * TOKEN_CREDIT;
+  rule->last_refill = MHD_monotonic_usec_counter ();
+  return MHD_YES;
+}
+
+
+/**
+ * Destroy a filter that is not used by a daemon.
+ *
+ * @param filter the filter to destroy
+ * @ingroup specialized
+ */
+void
+MHD_ip_filter_destroy (struct MHD_IPFilter *filter)
+{
+  unsigned int i;
+
+  if (NULL == filter)
+    return;
+  for (i = 0; i < IP_FILTER_LOCKS; i++)
+    MHD_mutex_destroy_chk_ (&filter->locks[i]);
+  free (filter->nodes);
+  free (filter->rules);
+  free (filter);
+}
+
+
+/**
+ * Give up the processor for a short while, waiting for checks
+ * that may still use a replaced filter.
+ */
+static void
+wait_for_checks (void)
+{
+#if defined(_WIN32) && !defined(__CYGWIN__)
+  Sleep (1);
+#else
+  struct timespec ts;
+
+  ts.tv_sec = 0;
+  ts.tv_nsec = 100000;
+  (void) nanosleep (&ts,
+                    NULL);
+#endif
+}
+
+
+/**
+ * Replace the filter of a running daemon.  Connections accepted
+ * after this call are checked against @a filter only.  The
+ * daemon takes ownership of @a filter and destroys the previous
+ * one, after waiting for the checks of connections that are being
+ * accepted right now.
+ *
+ * @param daemon daemon started with #MHD_OPTION_IP_FILTER
+ * @param filter the new filter, NULL to accept all connections
+ * @return #MHD_YES on success, #MHD_NO if @a daemon was not
+ *         started with #MHD_OPTION_IP_FILTER (the caller keeps
+ *         ownership of @a filter in this case)
+ * @ingroup specialized
+ */
+int
+MHD_set_ip_filter (struct MHD_Daemon *daemon,
+                   struct MHD_IPFilter *filter)
+{
+  struct MHD_IPFilter *old;
+  long epoch;
+  unsigned int i;
+
+  if (MHD_YES != daemon->ip_filter_enabled)
+    return MHD_NO;
+  MHD_mutex_lock_chk_ (&daemon->ip_filter_lock);
+  old = MHD_atomic_ptr_exchange_ (&daemon->ip_filter,
+                                  filter);
+  /* A check that still uses @a old counted itself as reader before
+     the exchange, in either counter.  Send new checks to the other
+     counter and wait for this one to drain, twice, so that checks
+     arriving all the time cannot keep us waiting. */
+  for (i = 0; i < 2; i++)
+    {
+      epoch = MHD_atomic_counter_get_ (&daemon->ip_filter_epoch);
+      MHD_atomic_counter_set_ (&daemon->ip_filter_epoch,
+                               epoch ^ 1);
+      while (0 != MHD_atomic_counter_get_ (&daemon->ip_filter_readers[epoch]))
+        wait_for_checks ();
+    }
+  MHD_mutex_unlock_chk_ (&daemon->ip_filter_lock);
+  MHD_ip_filter_destroy (old);
+  return MHD_YES;
+}
+
+
+/**
+ * Check if a newly accepted connection from @a addr may be
+ * handled, according to the filter of @a daemon.  Takes a token
+ * from the bucket of the matching range if it is rate limited.
+ *
+ * @param daemon master daemon with the filter
+ * @param addr address of the client
+ * @param addrlen number of bytes in @a addr
+ * @return #MHD_YES to handle the connection, #MHD_NO to close it
+ */
+int
+MHD_ip_filter_check_ (struct MHD_Daemon *daemon,
+                      const struct sockaddr *addr,
+                      socklen_t addrlen)
+{
+  struct MHD_IPFilter *filter;
+  unsigned char key[16];
+  struct FilterRule *rule;
+  unsigned int node;
+  unsigned int match;
+  unsigned int i;
+  long epoch;
+  uint64_t now;
+  uint64_t full;
+  int result;
+
+  if (MHD_NO == addr_to_key (addr,
+                             addrlen,
+                             key))
+    return MHD_YES;
+  epoch = MHD_atomic_counter_get_ (&daemon->ip_filter_epoch);
+  MHD_atomic_counter_inc_ (&daemon->ip_filter_readers[epoch]);
+  filter = MHD_atomic_ptr_load_ (&daemon->ip_filter);
+  if (NULL == filter)
+    {
+      MHD_atomic_counter_dec_ (&daemon->ip_filter_readers[epoch]);
+      return MHD_YES;
+    }
+  node = 0;
+  match = filter->nodes[0].rule;
+  for (i = 0; i < 128; i++)
+    {
+      node = filter->nodes[node].child[(key[i / 8] >> (7 - i % 8)) & 1];
+      if (0 == node)
+        break;
+      if (0 != filter->nodes[node].rule)
+        match = filter->nodes[node].rule;
+    }
+  if (0 == match)
+    {
+      result = (MHD_IP_FILTER_ALLOW == filter->default_action)
+        ? MHD_YES : MHD_NO;
+      MHD_atomic_counter_dec_ (&daemon->ip_filter_readers[epoch]);
+      return result;
+    }
+  rule = &filter->rules[match - 1];
+  result = (MHD_IP_FILTER_ALLOW == rule->action) ? MHD_YES : MHD_NO;
+  if ( (MHD_YES == result) &&
+       (0 != rule->rate) )
+    {
+      full = (uint64_t) rule->burst * TOKEN_CREDIT;
+      MHD_mutex_lock_chk_ (&filter->locks[(match - 1) % IP_FILTER_LOCKS]);
+      now = MHD_monotonic_usec_counter ();
+      if (now > rule->last_refill)
+        {
+          /* refill in proportion to the time that passed; the
+             division keeps the product below 2^64 */
+          if (now - rule->last_refill
+              >= (full - rule->credit + rule->rate - 1) / rule->rate)
+            rule->credit = full;
+          else
+            rule->credit += (now - rule->last_refill) * rule->rate;
+          rule->last_refill = now;
+        }
+      if (rule->credit < TOKEN_CREDIT)
+        result = MHD_NO;
+      else
+        rule->credit -= TOKEN_CREDIT;
+      MHD_mutex_unlock_chk_ (&filter->locks[(match - 1) % IP_FILTER_LOCKS]);
+    }
+  MHD_atomic_counter_dec_ (&daemon->ip_filter_readers[epoch]);
+  return result;
+}
+
+/* end of ipfilter.c */
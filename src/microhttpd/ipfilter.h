@@ -0,0 +1,46 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/ipfilter.h
+ * @brief  allow/deny and rate limits for client address ranges
+ * @author libmicrohttpd contributors
+ */
+#ifndef IPFILTER_H
+#define IPFILTER_H
+
+#include "internal.h"
+
+
+/**
+ * Check if a newly accepted connection from @a addr may be
+ * handled, according to the filter of @a daemon.  Takes a token
+ * from the bucket of the matching range if it is rate limited.
+ *
+ * @param daemon master daemon with the filter
+ * @param addr address of the client
+ * @param addrlen number of bytes in @a addr
+ * @return #MHD_YES to handle the connection, #MHD_NO to close it
+ */
+int
+MHD_ip_filter_check_ (struct MHD_Daemon *daemon,
+                      const struct sockaddr *addr,
+                      socklen_t addrlen);
+
+#endif
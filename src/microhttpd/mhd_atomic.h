@@ -0,0 +1,96 @@
+/*
+  This file is part of libmicrohttpd
+  Copyright (C) 2026 libmicrohttpd contributors
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/**
+ * @file microhttpd/mhd_atomic.h
+ * @brief  Header for platform-independent atomic operations
+ * @author libmicrohttpd contributors
+ *
+ * Provides the few atomic operations on pointers and counters that
+ * are used to read shared data without a lock.  All operations are
+ * sequentially consistent.  Any functions can be implemented as
+ * macro on some platforms, so avoid variable modification in
+ * function parameters.
+ */
+
+#ifndef MHD_ATOMIC_H
+#define MHD_ATOMIC_H 1
+
+#include "mhd_options.h"
+
+/**
+ * Counter that can be changed and read atomically.
+ */
+typedef long MHD_atomic_counter_;
+
+#if defined(__clang__) || \
+  (defined(__GNUC__) && \
+   ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7))))
+#  define MHD_atomic_ptr_load_(pptr) \
+  __atomic_load_n ((pptr), __ATOMIC_SEQ_CST)
+#  define MHD_atomic_ptr_exchange_(pptr,val) \
+  __atomic_exchange_n ((pptr), (val), __ATOMIC_SEQ_CST)
+#  define MHD_atomic_counter_get_(pcnt) \
+  __atomic_load_n ((pcnt), __ATOMIC_SEQ_CST)
+#  define MHD_atomic_counter_set_(pcnt,val) \
+  __atomic_store_n ((pcnt), (val), __ATOMIC_SEQ_CST)
+#  define MHD_atomic_counter_inc_(pcnt) \
+  ((void) __atomic_add_fetch ((pcnt), 1, __ATOMIC_SEQ_CST))
+#  define MHD_atomic_counter_dec_(pcnt) \
+  ((void) __atomic_sub_fetch ((pcnt), 1, __ATOMIC_SEQ_CST))
+#elif defined(__GNUC__)
+/* GCC before 4.7 only has the __sync builtins, all of which are
+   full barriers except for __sync_lock_test_and_set() */
+#  define MHD_atomic_ptr_load_(pptr) \
+  __sync_val_compare_and_swap ((pptr), NULL, NULL)
+#  define MHD_atomic_ptr_exchange_(pptr,val) \
+  (__sync_synchronize (), __sync_lock_test_and_set ((pptr), (val)))
+#  define MHD_atomic_counter_get_(pcnt) \
+  __sync_fetch_and_add ((pcnt), 0)
+#  define MHD_atomic_counter_set_(pcnt,val) \
+  ((void) __sync_synchronize (), *(volatile long *) (pcnt) = (val), \
+   (void) __sync_synchronize ())
+#  define MHD_atomic_counter_inc_(pcnt) \
+  ((void) __sync_add_and_fetch ((pcnt), 1))
+#  define MHD_atomic_counter_dec_(pcnt) \
+  ((void) __sync_sub_and_fetch ((pcnt), 1))
+#elif defined(_WIN32)
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN 1
+#  endif /* !WIN32_LEAN_AND_MEAN */
+#  include <windows.h>
+/* all Interlocked functions are full barriers */
+#  define MHD_atomic_ptr_load_(pptr) \
+  InterlockedCompareExchangePointer ((PVOID volatile *) (pptr), NULL, NULL)
+#  define MHD_atomic_ptr_exchange_(pptr,val) \
+  InterlockedExchangePointer ((PVOID volatile *) (pptr), (val))
+#  define MHD_atomic_counter_get_(pcnt) \
+  InterlockedCompareExchange ((LONG volatile *) (pcnt), 0, 0)
+#  define MHD_atomic_counter_set_(pcnt,val) \
+  ((void) InterlockedExchange ((LONG volatile *) (pcnt), (val)))
+#  define MHD_atomic_counter_inc_(pcnt) \
+  ((void) InterlockedIncrement ((LONG volatile *) (pcnt)))
+#  define MHD_atomic_counter_dec_(pcnt) \
+  ((void) InterlockedDecrement ((LONG volatile *) (pcnt)))
+#else
+#  error No atomic operations are available.
+#endif
+
+#endif /* ! MHD_ATOMIC_H */
@@ -375,3 +375,55 @@ MHD_monotonic_sec_counter (void)
 
   return time (NULL) - sys_clock_start;
 }
+
+
+/**
+ * Monotonic microseconds counter, useful for measuring short
+ * durations.  Uses a high-resolution clock where available.
+ *
+ * @return number of microseconds from some fixed moment
+ */
+uint64_t
+MHD_monotonic_usec_counter (void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+
+  /* not the (possibly coarse) clock of the seconds counter */
+  if (0 == clock_gettime (CLOCK_MONOTONIC,
+                          &ts))
+    return ((uint64_t) ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#endif /* CLOCK_MONOTONIC */
+#endif /* HAVE_CLOCK_GETTIME */
+#ifdef HAVE_CLOCK_GET_TIME
+  if (_MHD_INVALID_CLOCK_SERV != mono_clock_service)
+    {
+      mach_timespec_t cur_time;
+
+      if (KERN_SUCCESS == clock_get_time(mono_clock_service,
+                                         &cur_time))
+        return ((uint64_t) cur_time.tv_sec) * 1000000 + cur_time.tv_nsec / 1000;
+    }
+#endif /* HAVE_CLOCK_GET_TIME */
+#if defined(_WIN32)
+  {
+    LARGE_INTEGER freq;
+    LARGE_INTEGER perf_counter;
+
+    if (QueryPerformanceFrequency (&freq) &&
+        (0 != freq.QuadPart))
+      {
+        QueryPerformanceCounter (&perf_counter); /* never fail on XP and later */
+        return (uint64_t) (perf_counter.QuadPart / freq.QuadPart) * 1000000
+          + (uint64_t) (perf_counter.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+      }
+  }
+#endif /* _WIN32 */
+#ifdef HAVE_GETHRTIME
+  if (1)
+    return ((uint64_t) gethrtime ()) / 1000;
+#endif /* HAVE_GETHRTIME */
+
+  return ((uint64_t) MHD_monotonic_sec_counter ()) * 1000000;
+}
@@ -32,6 +32,7 @@
 #elif defined(HAVE_SYS_TYPES_H)
 #include <sys/types.h>
 #endif
+#include <stdint.h>
 
 /**
  * Initialise monotonic seconds counter.
@@ -57,4 +58,14 @@ MHD_monotonic_sec_counter_finish(void);
 time_t
 MHD_monotonic_sec_counter(void);
 
+
+/**
+ * Monotonic microseconds counter, useful for measuring short
+ * durations.  Uses a high-resolution clock where available.
+ *
+ * @return number of microseconds from some fixed moment
+ */
+uint64_t
+MHD_monotonic_usec_counter(void);
+
 #endif /* MHD_MONO_CLOCK_H */
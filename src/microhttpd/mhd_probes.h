@@ -0,0 +1,68 @@
+/*
+  This file is part of libmicrohttpd
+  Copyright (C) 2026 libmicrohttpd contributors
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/**
+ * @file microhttpd/mhd_probes.h
+ * @brief  Static tracepoints (USDT) for SystemTap, bpftrace and perf
+ * @author libmicrohttpd contributors
+ *
+ * With --enable-usdt, each MHD_PROBE* macro places a probe of the
+ * provider "libmicrohttpd" in the library; a probe is a single NOP
+ * until a tracer attaches to it.  Without it, the macros expand to
+ * nothing.  Arguments must not have side effects.
+ *
+ * Probes and their arguments:
+ *  - accept (connection, fd): a connection was accepted (or added)
+ *  - reject (connection, errno): adding an accepted connection
+ *    failed after its 'accept'; it is closed without 'close'
+ *  - close (connection, termination_code): a connection is closed
+ *  - state (connection, state): the state machine in
+ *    #MHD_connection_handle_idle() reached a new state
+ *  - recv (connection, size, result): recv() on the socket
+ *  - send (connection, size, result): send() on the socket
+ *  - sendfile (connection, size, result): sendfile() on the socket
+ *  - suspend (connection): a connection was suspended
+ *  - resume (connection): a suspended connection is processed again
+ */
+
+#ifndef MHD_PROBES_H
+#define MHD_PROBES_H 1
+
+#include "mhd_options.h"
+
+#ifdef MHD_USDT_PROBES
+#include <sys/sdt.h>
+
+#define MHD_PROBE1(name,a) \
+  STAP_PROBE1 (libmicrohttpd, name, (a))
+#define MHD_PROBE2(name,a,b) \
+  STAP_PROBE2 (libmicrohttpd, name, (a), (b))
+#define MHD_PROBE3(name,a,b,c) \
+  STAP_PROBE3 (libmicrohttpd, name, (a), (b), (c))
+
+#else  /* ! MHD_USDT_PROBES */
+
+#define MHD_PROBE1(name,a) ((void) 0)
+#define MHD_PROBE2(name,a,b) ((void) 0)
+#define MHD_PROBE3(name,a,b,c) ((void) 0)
+
+#endif /* ! MHD_USDT_PROBES */
+
+#endif /* ! MHD_PROBES_H */
@@ -0,0 +1,255 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/mhd_siphash.c
+ * @brief  SipHash-2-4 keyed hash function
+ * @author libmicrohttpd contributors
+ */
+#include "mhd_siphash.h"
+#include "internal.h"
+#include <string.h>
+#ifdef HAVE_SYS_RANDOM_H
+#include <sys/random.h>
+#endif
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#include <windows.h>
+#include <limits.h>
+
+/**
+ * RtlGenRandom() from advapi32, available since Windows XP.  It is
+ * declared here as the SDK headers only provide it under a macro.
+ */
+BOOLEAN NTAPI
+SystemFunction036 (PVOID buf,
+                   ULONG size);
+
+#ifdef _MSC_VER
+#pragma comment(lib, "advapi32.lib")
+#endif
+#endif
+
+
+/**
+ * Rotate @a x left by @a b bits.
+ */
+#define SIP_ROTL(x,b) (uint64_t) (((x) << (b)) | ((x) >> (64 - (b))))
+
+
+/**
+ * One SipRound.
+ *
+ * @param v the state
+ */
+static void
+sip_round (uint64_t v[4])
+{
+  v[0] += v[1];
+  v[1] = SIP_ROTL (v[1], 13);
+  v[1] ^= v[0];
+  v[0] = SIP_ROTL (v[0], 32);
+  v[2] += v[3];
+  v[3] = SIP_ROTL (v[3], 16);
+  v[3] ^= v[2];
+  v[0] += v[3];
+  v[3] = SIP_ROTL (v[3], 21);
+  v[3] ^= v[0];
+  v[2] += v[1];
+  v[1] = SIP_ROTL (v[1], 17);
+  v[1] ^= v[2];
+  v[2] = SIP_ROTL (v[2], 32);
+}
+
+
+/**
+ * Load a little-endian 64-bit value.
+ *
+ * @param p pointer to @a len bytes
+ * @param len number of bytes to load, at most 8
+ * @return the value
+ */
+static uint64_t
+load_le64 (const unsigned char *p,
+           size_t len)
+{
+  uint64_t v;
+
+  v = 0;
+  while (len > 0)
+    {
+      len--;
+      v = (v << 8) | p[len];
+    }
+  return v;
+}
+
+
+/**
+ * Compute SipHash-2-4 of @a data.  SipHash is fast for short
+ * inputs, and without the key clients cannot find inputs that
+ * hash to the same value.
+ *
+ * @param key the key
+ * @param data data to hash
+ * @param len number of bytes in @a data
+ * @return the hash
+ */
+uint64_t
+MHD_siphash24_ (const uint64_t key[2],
+                const void *data,
+                size_t len)
+{
+  const unsigned char *p = (const unsigned char *) data;
+  uint64_t v[4];
+  uint64_t m;
+  size_t left;
+
+  v[0] = key[0] ^ UINT64_C (0x736f6d6570736575);
+  v[1] = key[1] ^ UINT64_C (0x646f72616e646f6d);
+  v[2] = key[0] ^ UINT64_C (0x6c7967656e657261);
+  v[3] = key[1] ^ UINT64_C (0x7465646279746573);
+  for (left = len; left >= 8; left -= 8, p += 8)
+    {
+      m = load_le64 (p, 8);
+      v[3] ^= m;
+      sip_round (v);
+      sip_round (v);
+      v[0] ^= m;
+    }
+  m = load_le64 (p, left) | ((uint64_t) len << 56);
+  v[3] ^= m;
+  sip_round (v);
+  sip_round (v);
+  v[0] ^= m;
+  v[2] ^= 0xFF;
+  sip_round (v);
+  sip_round (v);
+  sip_round (v);
+  sip_round (v);
+  return v[0] ^ v[1] ^ v[2] ^ v[3];
+}
+
+
+/**
+ * Fill @a buf with random bytes from the operating system.
+ *
+ * @param[out] buf where to store the bytes
+ * @param size number of bytes to store
+ * @return #MHD_YES on success, #MHD_NO if no source of random
+ *         bytes is available
+ */
+static int
+get_random (void *buf,
+            size_t size)
+{
+  size_t off;
+#if !defined(_WIN32) || defined(__CYGWIN__)
+  ssize_t ret;
+  int fd;
+#endif
+
+  off = 0;
+#ifdef HAVE_GETRANDOM
+  while (off < size)
+    {
+      ret = getrandom ((char *) buf + off,
+                       size - off,
+                       0);
+      if (0 > ret)
+        {
+          if (EINTR == errno)
+            continue;
+          break; /* for example, ENOSYS: try the device */
+        }
+      off += (size_t) ret;
+    }
+  if (off == size)
+    return MHD_YES;
+#endif
+#if !defined(_WIN32) || defined(__CYGWIN__)
+  fd = open ("/dev/urandom",
+             O_RDONLY);
+  if (-1 != fd)
+    {
+      while (off < size)
+        {
+          ret = read (fd,
+                      (char *) buf + off,
+                      size - off);
+          if (0 > ret)
+            {
+              if (EINTR == errno)
+                continue;
+              break;
+            }
+          if (0 == ret)
+            break;
+          off += (size_t) ret;
+        }
+      (void) close (fd);
+      if (off == size)
+        return MHD_YES;
+    }
+#else
+  if ( (size <= ULONG_MAX) &&
+       (SystemFunction036 (buf,
+                           (ULONG) size)) )
+    return MHD_YES;
+#if HTTPS_SUPPORT
+  if (0 == gnutls_rnd (GNUTLS_RND_KEY,
+                       buf,
+                       size))
+    return MHD_YES;
+#endif
+#endif
+  return MHD_NO;
+}
+
+
+/**
+ * Create a random key for #MHD_siphash24_(), using random bytes
+ * from the operating system, and fold @a secret into it.
+ *
+ * @param[out] key set to the key
+ * @param secret secret data, may be NULL
+ * @param secret_size number of bytes in @a secret
+ * @return #MHD_YES on success, #MHD_NO if no random bytes are
+ *         available (@a key must not be used then); errno is
+ *         set to ENOSYS in that case
+ */
+int
+MHD_siphash_key_ (uint64_t key[2],
+                  const void *secret,
+                  size_t secret_size)
+{
+  unsigned char kbuf[16];
+  size_t i;
+
+  if (MHD_YES != get_random (kbuf,
+                             sizeof (kbuf)))
+    {
+      errno = ENOSYS;
+      return MHD_NO;
+    }
+  for (i = 0; i < secret_size; i++)
+    kbuf[i % sizeof (kbuf)] ^= ((const unsigned char *) secret)[i];
+  key[0] = load_le64 (kbuf, 8);
+  key[1] = load_le64 (&kbuf[8], 8);
+  return MHD_YES;
+}
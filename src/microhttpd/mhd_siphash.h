@@ -0,0 +1,65 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/mhd_siphash.h
+ * @brief  SipHash-2-4 keyed hash function
+ * @author libmicrohttpd contributors
+ */
+#ifndef MHD_SIPHASH_H
+#define MHD_SIPHASH_H
+
+#include "mhd_options.h"
+#include <stdint.h>
+#include <stddef.h>
+
+
+/**
+ * Compute SipHash-2-4 of @a data.  SipHash is fast for short
+ * inputs, and without the key clients cannot find inputs that
+ * hash to the same value.
+ *
+ * @param key the key
+ * @param data data to hash
+ * @param len number of bytes in @a data
+ * @return the hash
+ */
+uint64_t
+MHD_siphash24_ (const uint64_t key[2],
+                const void *data,
+                size_t len);
+
+
+/**
+ * Create a random key for #MHD_siphash24_(), using random bytes
+ * from the operating system, and fold @a secret into it.
+ *
+ * @param[out] key set to the key
+ * @param secret secret data, may be NULL
+ * @param secret_size number of bytes in @a secret
+ * @return #MHD_YES on success, #MHD_NO if no random bytes are
+ *         available (@a key must not be used then); errno is
+ *         set to ENOSYS in that case
+ */
+int
+MHD_siphash_key_ (uint64_t key[2],
+                  const void *secret,
+                  size_t secret_size);
+
+#endif /* MHD_SIPHASH_H */
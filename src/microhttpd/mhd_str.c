@@ -30,6 +30,7 @@
 #endif
 
 #include "mhd_limits.h"
+#include <string.h>
 
 #ifdef MHD_FAVOR_SMALL_CODE
 #ifdef _MHD_inline
@@ -777,3 +778,190 @@ MHD_str_to_uvalue_n_ (const char *str,
   return i;
 }
 #endif /* MHD_FAVOR_SMALL_CODE */
+
+
+/*
+ * Block of functions for splitting and decoding of
+ * "application/x-www-form-urlencoded" data and URI arguments.
+ * Runs of bytes that need no processing are skipped a machine
+ * word at a time.
+ */
+
+#ifndef MHD_FAVOR_SMALL_CODE
+/**
+ * Word with value 0x01 in every byte.
+ */
+#define WORD_ONES (((size_t) ~((size_t) 0)) / 0xFF)
+
+/**
+ * Word with value 0x80 in every byte.
+ */
+#define WORD_HIGHS (WORD_ONES * 0x80)
+
+/**
+ * Check whether any byte of word @a w is zero.
+ * Never gives false positives for the word as a whole.
+ *
+ * @param w the word to check
+ * @return non-zero if some byte of @a w is zero
+ */
+#define word_has_zero(w) (((w) - WORD_ONES) & ~(w) & WORD_HIGHS)
+
+/**
+ * Check whether any byte of word @a w is equal to the
+ * byte @a c.
+ *
+ * @param w the word to check
+ * @param c the byte to look for, multiplied by #WORD_ONES
+ * @return non-zero if @a c was found in @a w
+ */
+#define word_has_byte(w,c) word_has_zero ((w) ^ (c))
+#endif /* ! MHD_FAVOR_SMALL_CODE */
+
+
+/**
+ * Find the first occurrence of any of three characters.
+ *
+ * @param str the string to search, does not need to be 0-terminated
+ * @param len number of characters in @a str
+ * @param c1 first character to look for
+ * @param c2 second character to look for
+ * @param c3 third character to look for
+ * @return offset of the first character in @a str equal to @a c1,
+ *         @a c2 or @a c3, @a len if there is none
+ */
+size_t
+MHD_str_find_any3_n_ (const char *str,
+                      size_t len,
+                      char c1,
+                      char c2,
+                      char c3)
+{
+  size_t i;
+#ifndef MHD_FAVOR_SMALL_CODE
+  const size_t m1 = WORD_ONES * (unsigned char) c1;
+  const size_t m2 = WORD_ONES * (unsigned char) c2;
+  const size_t m3 = WORD_ONES * (unsigned char) c3;
+  size_t w;
+#endif /* ! MHD_FAVOR_SMALL_CODE */
+
+  i = 0;
+#ifndef MHD_FAVOR_SMALL_CODE
+  while (i + sizeof (w) <= len)
+    {
+      memcpy (&w, &str[i], sizeof (w));
+      if (word_has_byte (w, m1) |
+          word_has_byte (w, m2) |
+          word_has_byte (w, m3))
+        break;
+      i += sizeof (w);
+    }
+#endif /* ! MHD_FAVOR_SMALL_CODE */
+  for (; i < len; i++)
+    if ( (c1 == str[i]) ||
+         (c2 == str[i]) ||
+         (c3 == str[i]) )
+      return i;
+  return len;
+}
+
+
+/**
+ * Decode '%HH' escape sequences and, if requested, '+' in place.
+ * Malformed escape sequences are left as they are.
+ *
+ * @param str the string to decode, must have room for @a len + 1
+ *        characters as the result is 0-terminated
+ * @param len number of characters in @a str
+ * @param plus non-zero to convert '+' to ' '
+ * @return length of the decoded string
+ */
+static size_t
+str_unescape_n (char *str,
+                size_t len,
+                int plus)
+{
+  size_t rpos;
+  size_t wpos;
+  int h;
+  int l;
+#ifndef MHD_FAVOR_SMALL_CODE
+  const size_t mpct = WORD_ONES * (unsigned char) '%';
+  const size_t mplus = WORD_ONES * (unsigned char) (plus ? '+' : '%');
+  size_t w;
+#endif /* ! MHD_FAVOR_SMALL_CODE */
+
+  rpos = 0;
+  wpos = 0;
+  while (rpos < len)
+    {
+#ifndef MHD_FAVOR_SMALL_CODE
+      /* skip (and move back) words without anything to decode */
+      while (rpos + sizeof (w) <= len)
+        {
+          memcpy (&w, &str[rpos], sizeof (w));
+          if (word_has_byte (w, mpct) |
+              word_has_byte (w, mplus))
+            break;
+          if (wpos != rpos)
+            memcpy (&str[wpos], &w, sizeof (w));
+          rpos += sizeof (w);
+          wpos += sizeof (w);
+        }
+      if (rpos == len)
+        break;
+#endif /* ! MHD_FAVOR_SMALL_CODE */
+      if ( ('%' == str[rpos]) &&
+           (rpos + 2 < len) &&
+           (0 <= (h = toxdigitvalue (str[rpos + 1]))) &&
+           (0 <= (l = toxdigitvalue (str[rpos + 2]))) )
+        {
+          str[wpos++] = (char) ((unsigned char) (h * 16 + l));
+          rpos += 3;
+          continue;
+        }
+      if ( (plus) &&
+           ('+' == str[rpos]) )
+        str[wpos++] = ' ';
+      else
+        str[wpos++] = str[rpos];
+      rpos++;
+    }
+  str[wpos] = '\0';
+  return wpos;
+}
+
+
+/**
+ * Decode '%HH' escape sequences in place, as found in URIs.
+ *
+ * @param str the string to decode, must have room for @a len + 1
+ *        characters as the result is 0-terminated
+ * @param len number of characters in @a str
+ * @return length of the decoded string
+ */
+size_t
+MHD_str_pct_decode_n_ (char *str,
+                       size_t len)
+{
+  return str_unescape_n (str, len, 0);
+}
+
+
+/**
+ * Decode '%HH' escape sequences and '+' in place, as found in
+ * URI arguments and "application/x-www-form-urlencoded" data.
+ * This is the same as calling #MHD_unescape_plus() followed by
+ * #MHD_http_unescape(), but takes a single pass.
+ *
+ * @param str the string to decode, must have room for @a len + 1
+ *        characters as the result is 0-terminated
+ * @param len number of characters in @a str
+ * @return length of the decoded string
+ */
+size_t
+MHD_str_form_decode_n_ (char *str,
+                        size_t len)
+{
+  return str_unescape_n (str, len, 1);
+}
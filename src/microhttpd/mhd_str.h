@@ -253,4 +253,50 @@ MHD_str_to_uvalue_n_ (const char * str,
 
 #endif /* MHD_FAVOR_SMALL_CODE */
 
+
+/**
+ * Find the first occurrence of any of three characters.
+ *
+ * @param str the string to search, does not need to be 0-terminated
+ * @param len number of characters in @a str
+ * @param c1 first character to look for
+ * @param c2 second character to look for
+ * @param c3 third character to look for
+ * @return offset of the first character in @a str equal to @a c1,
+ *         @a c2 or @a c3, @a len if there is none
+ */
+size_t
+MHD_str_find_any3_n_ (const char *str,
+                      size_t len,
+                      char c1,
+                      char c2,
+                      char c3);
+
+
+/**
+ * Decode '%HH' escape sequences in place, as found in URIs.
+ *
+ * @param str the string to decode, must have room for @a len + 1
+ *        characters as the result is 0-terminated
+ * @param len number of characters in @a str
+ * @return length of the decoded string
+ */
+size_t
+MHD_str_pct_decode_n_ (char *str,
+                       size_t len);
+
+
+/**
+ * Decode '%HH' escape sequences and '+' in place, as found in
+ * URI arguments and "application/x-www-form-urlencoded" data.
+ *
+ * @param str the string to decode, must have room for @a len + 1
+ *        characters as the result is 0-terminated
+ * @param len number of characters in @a str
+ * @return length of the decoded string
+ */
+size_t
+MHD_str_form_decode_n_ (char *str,
+                        size_t len);
+
 #endif /* MHD_STR_H */
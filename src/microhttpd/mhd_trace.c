@@ -0,0 +1,226 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/mhd_trace.c
+ * @brief  recording of the received bytes for #MHD_OPTION_TRACE_FILE
+ * @author libmicrohttpd contributors
+ *
+ * All workers of a daemon write to the same file through a buffered
+ * stdio stream under one lock; the records are therefore in the
+ * order of their timestamps.
+ */
+#include "internal.h"
+#include "mhd_trace.h"
+#include "mhd_locks.h"
+#include "mhd_mono_clock.h"
+
+
+/**
+ * An open trace file.
+ */
+struct MHD_Trace
+{
+  /**
+   * The file.
+   */
+  FILE *file;
+
+  /**
+   * Protects @e file and @e last_connection.
+   */
+  MHD_mutex_ lock;
+
+  /**
+   * When the trace was opened (#MHD_monotonic_usec_counter()).
+   */
+  uint64_t start;
+
+  /**
+   * Number of the last connection.
+   */
+  uint32_t last_connection;
+};
+
+
+/**
+ * Store a 32 bit number in little endian order.
+ *
+ * @param buf where to store @a v
+ * @param v the number
+ */
+static void
+put_le32 (unsigned char *buf,
+          uint32_t v)
+{
+  buf[0] = (unsigned char) v;
+  buf[1] = (unsigned char) (v >> 8);
+  buf[2] = (unsigned char) (v >> 16);
+  buf[3] = (unsigned char) (v >> 24);
+}
+
+
+/**
+ * Create (or truncate) a trace file and write its header.
+ *
+ * @param filename name of the file
+ * @return NULL on error (with errno set)
+ */
+struct MHD_Trace *
+MHD_trace_open_ (const char *filename)
+{
+  struct MHD_Trace *trace;
+  unsigned char header[MHD_TRACE_HEADER_SIZE];
+
+  trace = malloc (sizeof (struct MHD_Trace));
+  if (NULL == trace)
+    return NULL;
+  if (NULL == (trace->file = fopen (filename, "wb")))
+    {
+      free (trace);
+      return NULL;
+    }
+  if (! MHD_mutex_init_ (&trace->lock))
+    {
+      fclose (trace->file);
+      free (trace);
+      errno = ENOMEM;
+      return NULL;
+    }
+  memcpy (header, MHD_TRACE_MAGIC, 8);
+  put_le32 (&header[8], MHD_TRACE_VERSION);
+  if (1 != fwrite (header, sizeof (header), 1, trace->file))
+    {
+      MHD_trace_close_ (trace);
+      errno = EIO;
+      return NULL;
+    }
+  trace->start = MHD_monotonic_usec_counter ();
+  trace->last_connection = 0;
+  return trace;
+}
+
+
+/**
+ * Flush and close a trace file.
+ *
+ * @param trace the trace, may be NULL
+ */
+void
+MHD_trace_close_ (struct MHD_Trace *trace)
+{
+  if (NULL == trace)
+    return;
+  fclose (trace->file);
+  MHD_mutex_destroy_chk_ (&trace->lock);
+  free (trace);
+}
+
+
+/**
+ * Write a record; the lock of @a trace must be held.
+ *
+ * @param trace the trace
+ * @param connection number of the connection
+ * @param type type of the record
+ * @param data data of the record
+ * @param size number of bytes in @a data
+ */
+static void
+write_record (struct MHD_Trace *trace,
+              uint32_t connection,
+              enum MHD_TraceRecordType type,
+              const void *data,
+              size_t size)
+{
+  unsigned char header[MHD_TRACE_RECORD_SIZE];
+  uint64_t now;
+
+  now = MHD_monotonic_usec_counter () - trace->start;
+  put_le32 (&header[0], (uint32_t) now);
+  put_le32 (&header[4], (uint32_t) (now >> 32));
+  put_le32 (&header[8], connection);
+  put_le32 (&header[12], ((uint32_t) type << 24) | (uint32_t) size);
+  /* errors are found by the replayer as a truncated file */
+  if ( (1 == fwrite (header, sizeof (header), 1, trace->file)) &&
+       (0 != size) )
+    (void) fwrite (data, size, 1, trace->file);
+}
+
+
+/**
+ * Assign a number to a new connection and record that it was
+ * accepted.
+ *
+ * @param trace the trace
+ * @return number of the connection in the trace
+ */
+uint32_t
+MHD_trace_connection_ (struct MHD_Trace *trace)
+{
+  uint32_t connection;
+
+  MHD_mutex_lock_chk_ (&trace->lock);
+  connection = ++trace->last_connection;
+  write_record (trace,
+                connection,
+                MHD_TRACE_OPEN,
+                NULL,
+                0);
+  MHD_mutex_unlock_chk_ (&trace->lock);
+  return connection;
+}
+
+
+/**
+ * Add a record to a trace.  Can be called by any thread.
+ *
+ * @param trace the trace
+ * @param connection number of the connection
+ * @param type type of the record
+ * @param data data of the record, NULL if @a size is 0
+ * @param size number of bytes in @a data
+ */
+void
+MHD_trace_record_ (struct MHD_Trace *trace,
+                   uint32_t connection,
+                   enum MHD_TraceRecordType type,
+                   const void *data,
+                   size_t size)
+{
+  const char *pos = data;
+  size_t chunk;
+
+  MHD_mutex_lock_chk_ (&trace->lock);
+  do
+    {
+      chunk = (size > MHD_TRACE_MAX_DATA) ? MHD_TRACE_MAX_DATA : size;
+      write_record (trace,
+                    connection,
+                    type,
+                    pos,
+                    chunk);
+      pos += chunk;
+      size -= chunk;
+    }
+  while (0 != size);
+  MHD_mutex_unlock_chk_ (&trace->lock);
+}
+
+/* end of mhd_trace.c */
@@ -0,0 +1,148 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/mhd_trace.h
+ * @brief  recording of the received bytes for #MHD_OPTION_TRACE_FILE
+ * @author libmicrohttpd contributors
+ *
+ * A trace file starts with #MHD_TRACE_HEADER_SIZE bytes: the magic
+ * #MHD_TRACE_MAGIC and the 32 bit format version #MHD_TRACE_VERSION.
+ * It is followed by records of #MHD_TRACE_RECORD_SIZE bytes, each
+ * followed by its data:
+ * - 64 bit time in microseconds since the trace was opened,
+ * - 32 bit number of the connection, counting from 1 in the order
+ *   the connections were accepted,
+ * - 32 bit type (`enum MHD_TraceRecordType`) in the upper 8 bits
+ *   and the size of the data in the lower 24 bits.
+ * All numbers are little endian.  This header is also used by the
+ * replayer in src/benchmark, so it only defines the format for it.
+ */
+#ifndef MHD_TRACE_H
+#define MHD_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * First bytes of a trace file.
+ */
+#define MHD_TRACE_MAGIC "MHDTRACE"
+
+/**
+ * Version of the format.
+ */
+#define MHD_TRACE_VERSION 1
+
+/**
+ * Size of the file header.
+ */
+#define MHD_TRACE_HEADER_SIZE 12
+
+/**
+ * Size of a record header.
+ */
+#define MHD_TRACE_RECORD_SIZE 16
+
+/**
+ * Largest size of the data of one record.
+ */
+#define MHD_TRACE_MAX_DATA 0xFFFFFF
+
+
+/**
+ * Types of records.
+ */
+enum MHD_TraceRecordType
+{
+  /**
+   * The connection was accepted; no data.
+   */
+  MHD_TRACE_OPEN = 1,
+
+  /**
+   * Bytes were received on the connection.
+   */
+  MHD_TRACE_DATA = 2,
+
+  /**
+   * The client shut down its side of the connection; no data.
+   */
+  MHD_TRACE_EOF = 3,
+
+  /**
+   * The connection was closed; no data.
+   */
+  MHD_TRACE_CLOSE = 4
+};
+
+
+/**
+ * An open trace file.
+ */
+struct MHD_Trace;
+
+
+/**
+ * Create (or truncate) a trace file and write its header.
+ *
+ * @param filename name of the file
+ * @return NULL on error (with errno set)
+ */
+struct MHD_Trace *
+MHD_trace_open_ (const char *filename);
+
+
+/**
+ * Flush and close a trace file.
+ *
+ * @param trace the trace, may be NULL
+ */
+void
+MHD_trace_close_ (struct MHD_Trace *trace);
+
+
+/**
+ * Assign a number to a new connection and record that it was
+ * accepted.
+ *
+ * @param trace the trace
+ * @return number of the connection in the trace
+ */
+uint32_t
+MHD_trace_connection_ (struct MHD_Trace *trace);
+
+
+/**
+ * Add a record to a trace.  Can be called by any thread.
+ *
+ * @param trace the trace
+ * @param connection number of the connection
+ * @param type type of the record
+ * @param data data of the record, NULL if @a size is 0
+ * @param size number of bytes in @a data
+ */
+void
+MHD_trace_record_ (struct MHD_Trace *trace,
+                   uint32_t connection,
+                   enum MHD_TraceRecordType type,
+                   const void *data,
+                   size_t size);
+
+#endif
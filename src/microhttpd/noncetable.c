@@ -0,0 +1,487 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/noncetable.c
+ * @brief  table of digest authentication nonces and their counters
+ * @author libmicrohttpd contributors
+ *
+ * The table is set-associative: a nonce is hashed (with SipHash-2-4
+ * keyed from the digest authentication random value) to a set of
+ * #NONCE_WAYS entries and may live in any of them, so that two
+ * nonces with the same hash do not immediately push each other out.
+ * When a fresh nonce needs an entry, the least recently used entry
+ * of its set is replaced.  The sets are protected by a fixed number
+ * of locks (set N uses lock N modulo #NONCE_LOCKS), so requests with
+ * different nonces rarely wait for each other.
+ *
+ * Each entry also remembers the H(A1) of the last successful
+ * authentication with its nonce, so that further requests with the
+ * same nonce, credentials and URI need neither recompute the nonce
+ * nor H(A1).
+ */
+#include "noncetable.h"
+#include "mhd_locks.h"
+#include "mhd_siphash.h"
+
+
+/**
+ * Number of entries per set.
+ */
+#define NONCE_WAYS 4
+
+/**
+ * Number of locks, must be a power of two.
+ */
+#define NONCE_LOCKS 16
+
+
+/**
+ * A nonce and the nonce counters used with it.
+ */
+struct NonceEntry
+{
+  /**
+   * Nonce counter, a value that increases for each subsequent
+   * request for the same nonce.
+   */
+  uint64_t nc;
+
+  /**
+   * Bitmask over the nc-64 previous nonce values.  Used to
+   * allow out-of-order nonces.
+   */
+  uint64_t nmask;
+
+  /**
+   * Value of the lock's clock when the entry was last used,
+   * to find the least recently used entry of a set.
+   */
+  uint64_t last_use;
+
+  /**
+   * Hash of the request and credentials that were last
+   * authenticated with this nonce (see #MHD_nonce_table_hash_()),
+   * 0 if none.
+   */
+  uint64_t auth_bind;
+
+  /**
+   * H(A1) of the credentials in @e auth_bind.
+   */
+  uint8_t ha1[MHD_MD5_DIGEST_SIZE];
+
+  /**
+   * Upper half of the hash of @e nonce, compared before the
+   * nonce itself.
+   */
+  uint32_t tag;
+
+  /**
+   * Nonce value, empty if the entry is unused.
+   */
+  char nonce[MAX_NONCE_LENGTH];
+};
+
+
+/**
+ * Lock for a group of sets.
+ */
+struct NonceLock
+{
+  /**
+   * Protects all sets that map to this lock.
+   */
+  MHD_mutex_ lock;
+
+  /**
+   * Incremented whenever an entry of one of the sets is used.
+   */
+  uint64_t clock;
+};
+
+
+/**
+ * Table of the nonces handed out to clients.
+ */
+struct MHD_NonceTable
+{
+  /**
+   * The locks.
+   */
+  struct NonceLock locks[NONCE_LOCKS];
+
+  /**
+   * The entries, #NONCE_WAYS consecutive entries per set.
+   */
+  struct NonceEntry *entries;
+
+  /**
+   * Number of sets.
+   */
+  uint32_t num_sets;
+
+  /**
+   * Key for SipHash.
+   */
+  uint64_t key[2];
+};
+
+
+/**
+ * Create a nonce table.
+ *
+ * @param size number of nonces to keep track of
+ * @param key secret used to key the hash function, may be NULL
+ * @param key_size number of bytes in @a key
+ * @return NULL on error; errno is ENOSYS if no random bytes
+ *         were available for the hash key, otherwise we ran out
+ *         of memory
+ */
+struct MHD_NonceTable *
+MHD_nonce_table_create_ (unsigned int size,
+                         const void *key,
+                         size_t key_size)
+{
+  struct MHD_NonceTable *table;
+  uint32_t num_sets;
+  size_t i;
+  unsigned int j;
+
+  num_sets = (size + NONCE_WAYS - 1) / NONCE_WAYS;
+  if (0 == num_sets)
+    num_sets = 1;
+  if (NULL == (table = malloc (sizeof (struct MHD_NonceTable))))
+    return NULL;
+  if (NULL == (table->entries = calloc ((size_t) num_sets * NONCE_WAYS,
+                                        sizeof (struct NonceEntry))))
+    {
+      free (table);
+      return NULL;
+    }
+  for (i = 0; i < NONCE_LOCKS; i++)
+    {
+      if (! MHD_mutex_init_ (&table->locks[i].lock))
+        {
+          for (j = 0; j < i; j++)
+            MHD_mutex_destroy_chk_ (&table->locks[j].lock);
+          free (table->entries);
+          free (table);
+          return NULL;
+        }
+      table->locks[i].clock = 0;
+    }
+  table->num_sets = num_sets;
+  if (MHD_YES != MHD_siphash_key_ (table->key,
+                                   key,
+                                   key_size))
+    {
+      MHD_nonce_table_destroy_ (table);
+      errno = ENOSYS; /* destroy may have changed it */
+      return NULL;
+    }
+  return table;
+}
+
+
+/**
+ * Destroy a table created with #MHD_nonce_table_create_().
+ *
+ * @param table the table to destroy, may be NULL
+ */
+void
+MHD_nonce_table_destroy_ (struct MHD_NonceTable *table)
+{
+  unsigned int i;
+
+  if (NULL == table)
+    return;
+  for (i = 0; i < NONCE_LOCKS; i++)
+    MHD_mutex_destroy_chk_ (&table->locks[i].lock);
+  free (table->entries);
+  free (table);
+}
+
+
+/**
+ * Find the set of @a nonce and lock it.
+ *
+ * @param table the table
+ * @param nonce 0-terminated nonce, shorter than #MAX_NONCE_LENGTH
+ * @param len length of @a nonce
+ * @param[out] set set to the first entry of the set
+ * @param[out] tag set to the tag of @a nonce
+ * @return the lock that was locked
+ */
+static struct NonceLock *
+lock_set (struct MHD_NonceTable *table,
+          const char *nonce,
+          size_t len,
+          struct NonceEntry **set,
+          uint32_t *tag)
+{
+  struct NonceLock *lk;
+  uint64_t hash;
+  uint32_t set_idx;
+
+  hash = MHD_siphash24_ (table->key,
+                         nonce,
+                         len);
+  *tag = (uint32_t) (hash >> 32);
+  set_idx = (uint32_t) hash % table->num_sets;
+  *set = &table->entries[(size_t) set_idx * NONCE_WAYS];
+  lk = &table->locks[set_idx & (NONCE_LOCKS - 1)];
+  MHD_mutex_lock_chk_ (&lk->lock);
+  return lk;
+}
+
+
+/**
+ * Find the entry of @a nonce in a locked set.
+ *
+ * @param set first entry of the set
+ * @param nonce the nonce
+ * @param tag tag of @a nonce
+ * @return NULL if @a nonce is not in the set
+ */
+static struct NonceEntry *
+find_entry (struct NonceEntry *set,
+            const char *nonce,
+            uint32_t tag)
+{
+  unsigned int i;
+
+  for (i = 0; i < NONCE_WAYS; i++)
+    if ( (tag == set[i].tag) &&
+         (0 == strcmp (set[i].nonce,
+                       nonce)) )
+      return &set[i];
+  return NULL;
+}
+
+
+/**
+ * Check a nonce and nonce counter against the table.  A nonce
+ * counter of zero registers a fresh nonce, possibly evicting the
+ * least recently used nonce that hashes to the same set.
+ *
+ * @param table the table to check
+ * @param nonce 0-terminated nonce, shorter than #MAX_NONCE_LENGTH
+ * @param nc the nonce counter, zero to add the nonce to the table
+ * @return #MHD_YES if the nonce is known and @a nc was not used
+ *         with it before (or if @a nc is zero), #MHD_NO if not
+ */
+int
+MHD_nonce_table_check_ (struct MHD_NonceTable *table,
+                        const char *nonce,
+                        uint64_t nc)
+{
+  struct NonceEntry *set;
+  struct NonceEntry *nn;
+  struct NonceLock *lk;
+  uint32_t tag;
+  size_t len;
+  unsigned int i;
+
+  len = strlen (nonce);
+  if (MAX_NONCE_LENGTH <= len)
+    return MHD_NO;
+  lk = lock_set (table,
+                 nonce,
+                 len,
+                 &set,
+                 &tag);
+  nn = find_entry (set,
+                   nonce,
+                   tag);
+  if (0 == nc)
+    {
+      /* Fresh nonce, (re)initialize its entry */
+      if (NULL == nn)
+        {
+          nn = &set[0];
+          for (i = 1; i < NONCE_WAYS; i++)
+            if (set[i].last_use < nn->last_use)
+              nn = &set[i];
+          memcpy (nn->nonce,
+                  nonce,
+                  len + 1);
+          nn->tag = tag;
+        }
+      nn->nc = 0;
+      nn->nmask = 0;
+      nn->auth_bind = 0;
+      nn->last_use = ++lk->clock;
+      MHD_mutex_unlock_chk_ (&lk->lock);
+      return MHD_YES;
+    }
+  if (NULL == nn)
+    {
+      MHD_mutex_unlock_chk_ (&lk->lock);
+      return MHD_NO;
+    }
+  /* Note that we use 64 here, as we do not store the
+     bit for 'nn->nc' itself in 'nn->nmask' */
+  if ( (nc < nn->nc) &&
+       (nc + 64 > nc /* checking for overflow */) &&
+       (nc + 64 >= nn->nc) &&
+       (0 == ((1LLU << (nn->nc - nc - 1)) & nn->nmask)) )
+    {
+      /* Out-of-order nonce, but within 64-bit bitmask, set bit */
+      nn->nmask |= (1LLU << (nn->nc - nc - 1));
+      nn->last_use = ++lk->clock;
+      MHD_mutex_unlock_chk_ (&lk->lock);
+      return MHD_YES;
+    }
+  if (nc <= nn->nc)
+    {
+      /* Counter was used before */
+      MHD_mutex_unlock_chk_ (&lk->lock);
+      return MHD_NO;
+    }
+  /* Nonce is larger, shift bitmask and bump limit */
+  if (64 > nc - nn->nc)
+    nn->nmask <<= (nc - nn->nc); /* small jump, less than mask width */
+  else
+    nn->nmask = 0; /* big jump, unset all bits in the mask */
+  if (64 >= nc - nn->nc)
+    nn->nmask |= (1LLU << (nc - nn->nc - 1)); /* the old limit was used */
+  nn->nc = nc;
+  nn->last_use = ++lk->clock;
+  MHD_mutex_unlock_chk_ (&lk->lock);
+  return MHD_YES;
+}
+
+
+/**
+ * Hash a string (or other data) for a cached authentication,
+ * keyed so that clients cannot find collisions.
+ *
+ * @param table the table
+ * @param prev result of hashing the previous parts, 0 for the first
+ * @param data data to hash
+ * @param size number of bytes in @a data
+ * @return the hash, never 0
+ */
+uint64_t
+MHD_nonce_table_hash_ (const struct MHD_NonceTable *table,
+                       uint64_t prev,
+                       const void *data,
+                       size_t size)
+{
+  uint64_t key[2];
+  uint64_t hash;
+
+  key[0] = table->key[0] ^ prev;
+  key[1] = ~table->key[1];
+  hash = MHD_siphash24_ (key,
+                         data,
+                         size);
+  return (0 == hash) ? 1 : hash;
+}
+
+
+/**
+ * Get the H(A1) of the last authentication with @a nonce.
+ *
+ * @param table the table
+ * @param nonce the nonce
+ * @param bind hash of the request and credentials
+ * @param[out] ha1 set to H(A1)
+ * @return #MHD_YES if the last authentication with @a nonce was
+ *         for @a bind, #MHD_NO if not
+ */
+int
+MHD_nonce_table_get_auth_ (struct MHD_NonceTable *table,
+                           const char *nonce,
+                           uint64_t bind,
+                           uint8_t ha1[MHD_MD5_DIGEST_SIZE])
+{
+  struct NonceEntry *set;
+  struct NonceEntry *nn;
+  struct NonceLock *lk;
+  uint32_t tag;
+  size_t len;
+  int ret;
+
+  len = strlen (nonce);
+  if (MAX_NONCE_LENGTH <= len)
+    return MHD_NO;
+  lk = lock_set (table,
+                 nonce,
+                 len,
+                 &set,
+                 &tag);
+  nn = find_entry (set,
+                   nonce,
+                   tag);
+  ret = MHD_NO;
+  if ( (NULL != nn) &&
+       (bind == nn->auth_bind) )
+    {
+      memcpy (ha1,
+              nn->ha1,
+              MHD_MD5_DIGEST_SIZE);
+      ret = MHD_YES;
+    }
+  MHD_mutex_unlock_chk_ (&lk->lock);
+  return ret;
+}
+
+
+/**
+ * Remember a successful authentication with @a nonce.
+ *
+ * @param table the table
+ * @param nonce the nonce
+ * @param bind hash of the request and credentials
+ * @param ha1 H(A1) of the credentials
+ */
+void
+MHD_nonce_table_set_auth_ (struct MHD_NonceTable *table,
+                           const char *nonce,
+                           uint64_t bind,
+                           const uint8_t ha1[MHD_MD5_DIGEST_SIZE])
+{
+  struct NonceEntry *set;
+  struct NonceEntry *nn;
+  struct NonceLock *lk;
+  uint32_t tag;
+  size_t len;
+
+  len = strlen (nonce);
+  if (MAX_NONCE_LENGTH <= len)
+    return;
+  lk = lock_set (table,
+                 nonce,
+                 len,
+                 &set,
+                 &tag);
+  nn = find_entry (set,
+                   nonce,
+                   tag);
+  if (NULL != nn)
+    {
+      nn->auth_bind = bind;
+      memcpy (nn->ha1,
+              ha1,
+              MHD_MD5_DIGEST_SIZE);
+    }
+  MHD_mutex_unlock_chk_ (&lk->lock);
+}
@@ -0,0 +1,128 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/noncetable.h
+ * @brief  table of digest authentication nonces and their counters
+ * @author libmicrohttpd contributors
+ */
+#ifndef NONCETABLE_H
+#define NONCETABLE_H
+
+#include "internal.h"
+
+
+/**
+ * Table of the nonces handed out to clients and the nonce
+ * counters (nc) they used with them.
+ */
+struct MHD_NonceTable;
+
+
+/**
+ * Create a nonce table.
+ *
+ * @param size number of nonces to keep track of
+ * @param key secret used to key the hash function, may be NULL
+ * @param key_size number of bytes in @a key
+ * @return NULL on error; errno is ENOSYS if no random bytes
+ *         were available for the hash key, otherwise we ran out
+ *         of memory
+ */
+struct MHD_NonceTable *
+MHD_nonce_table_create_ (unsigned int size,
+                         const void *key,
+                         size_t key_size);
+
+
+/**
+ * Destroy a table created with #MHD_nonce_table_create_().
+ *
+ * @param table the table to destroy, may be NULL
+ */
+void
+MHD_nonce_table_destroy_ (struct MHD_NonceTable *table);
+
+
+/**
+ * Check a nonce and nonce counter against the table.  A nonce
+ * counter of zero registers a fresh nonce, possibly evicting the
+ * least recently used nonce that hashes to the same set.
+ *
+ * @param table the table to check
+ * @param nonce 0-terminated nonce, shorter than #MAX_NONCE_LENGTH
+ * @param nc the nonce counter, zero to add the nonce to the table
+ * @return #MHD_YES if the nonce is known and @a nc was not used
+ *         with it before (or if @a nc is zero), #MHD_NO if not
+ */
+int
+MHD_nonce_table_check_ (struct MHD_NonceTable *table,
+                        const char *nonce,
+                        uint64_t nc);
+
+
+/**
+ * Hash a string (or other data) for a cached authentication,
+ * keyed so that clients cannot find collisions.
+ *
+ * @param table the table
+ * @param prev result of hashing the previous parts, 0 for the first
+ * @param data data to hash
+ * @param size number of bytes in @a data
+ * @return the hash, never 0
+ */
+uint64_t
+MHD_nonce_table_hash_ (const struct MHD_NonceTable *table,
+                       uint64_t prev,
+                       const void *data,
+                       size_t size);
+
+
+/**
+ * Get the H(A1) of the last authentication with @a nonce.
+ *
+ * @param table the table
+ * @param nonce the nonce
+ * @param bind hash of the request and credentials
+ * @param[out] ha1 set to H(A1)
+ * @return #MHD_YES if the last authentication with @a nonce was
+ *         for @a bind, #MHD_NO if not
+ */
+int
+MHD_nonce_table_get_auth_ (struct MHD_NonceTable *table,
+                           const char *nonce,
+                           uint64_t bind,
+                           uint8_t ha1[MHD_MD5_DIGEST_SIZE]);
+
+
+/**
+ * Remember a successful authentication with @a nonce.
+ *
+ * @param table the table
+ * @param nonce the nonce
+ * @param bind hash of the request and credentials
+ * @param ha1 H(A1) of the credentials
+ */
+void
+MHD_nonce_table_set_auth_ (struct MHD_NonceTable *table,
+                           const char *nonce,
+                           uint64_t bind,
+                           const uint8_t ha1[MHD_MD5_DIGEST_SIZE]);
+
+#endif
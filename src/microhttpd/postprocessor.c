@@ -170,12 +170,24 @@ struct MHD_PostProcessor
    */
   char *content_transfer_encoding;
 
+  /**
+   * Boundary for which @e skip was computed, NULL if none.
+   */
+  const char *skip_boundary;
+
   /**
    * Unprocessed value bytes due to escape
    * sequences (URL-encoding only).
    */
   char xbuf[8];
 
+  /**
+   * Shift table for finding "\r\n--" followed by
+   * @e skip_boundary in values (Boyer-Moore-Horspool),
+   * shifts are capped at 255.
+   */
+  unsigned char skip[256];
+
   /**
    * Size of our buffer for the key.
    */
@@ -318,6 +330,8 @@ MHD_create_post_processor (struct MHD_Connection *connection,
 	  /* remove enclosing quotes */
 	  ++boundary;
 	  blen -= 2;
+          if (0 == blen)
+            return NULL;        /* invalid boundary */
 	}
     }
   else
@@ -378,10 +392,11 @@ post_process_urlencoded (struct MHD_PostProcessor *pp,
           pp->state = PP_Error;
           return MHD_NO;
         case PP_Init:
-          equals = 0;
-          while ((equals + poff < post_data_len) &&
-                 (post_data[equals + poff] != '='))
-            equals++;
+          equals = MHD_str_find_any3_n_ (&post_data[poff],
+                                         post_data_len - poff,
+                                         '=',
+                                         '=',
+                                         '=');
           if (equals + pp->buffer_pos > pp->buffer_size)
             {
               pp->state = PP_Error;     /* out of memory */
@@ -391,10 +406,9 @@ post_process_urlencoded (struct MHD_PostProcessor *pp,
           pp->buffer_pos += equals;
           if (equals + poff == post_data_len)
             return MHD_YES;     /* no '=' yet */
-          buf[pp->buffer_pos] = '\0';   /* 0-terminate key */
+          MHD_str_form_decode_n_ (buf,
+                                  pp->buffer_pos); /* 0-terminates key */
           pp->buffer_pos = 0;   /* reset for next key */
-	  MHD_unescape_plus (buf);
-          MHD_http_unescape (buf);
           poff += equals + 1;
           pp->state = PP_ProcessValue;
           pp->value_offset = 0;
@@ -406,13 +420,12 @@ post_process_urlencoded (struct MHD_PostProcessor *pp,
           pp->xbuf_pos = 0;
 
           /* find last position in input buffer that is part of the value */
-          amper = 0;
-          while ((amper + poff < post_data_len) &&
-                 (amper < XBUF_SIZE) &&
-                 (post_data[amper + poff] != '&') &&
-                 (post_data[amper + poff] != '\n') &&
-                 (post_data[amper + poff] != '\r'))
-            amper++;
+          amper = MHD_str_find_any3_n_ (&post_data[poff],
+                                        MHD_MIN (post_data_len - poff,
+                                                 XBUF_SIZE),
+                                        '&',
+                                        '\n',
+                                        '\r');
           end_of_value_found = ((amper + poff < post_data_len) &&
                                 ((post_data[amper + poff] == '&') ||
                                  (post_data[amper + poff] == '\n') ||
@@ -458,9 +471,8 @@ post_process_urlencoded (struct MHD_PostProcessor *pp,
             continue;
 
           /* unescape */
-          xbuf[xoff] = '\0';    /* 0-terminate in preparation */
-	  MHD_unescape_plus (xbuf);
-          xoff = MHD_http_unescape (xbuf);
+          xoff = MHD_str_form_decode_n_ (xbuf,
+                                         xoff);
           /* finally: call application! */
 	  pp->must_ikvi = MHD_NO;
           if (MHD_NO == pp->ikvi (pp->cls,
@@ -591,17 +603,25 @@ find_boundary (struct MHD_PostProcessor *pp,
         }
       else
         {
-          /* skip over garbage (RFC 2046, 5.1.1) */
-          dash = memchr (buf,
-                         '-',
-                         pp->buffer_pos);
+          /* skip over garbage (RFC 2046, 5.1.1), at least one byte
+             and up to the next possible boundary */
+          dash = &buf[1];
+          while (NULL != (dash = memchr (dash,
+                                         '-',
+                                         &buf[pp->buffer_pos] - dash)))
+            {
+              if ( (dash + 2 + blen > &buf[pp->buffer_pos]) ||
+                   ( ('-' == dash[1]) &&
+                     (0 == memcmp (&dash[2],
+                                   boundary,
+                                   blen)) ) )
+                break;
+              dash++;
+            }
           if (NULL == dash)
             (*ioffptr) += pp->buffer_pos; /* skip entire buffer */
           else
-            if (dash == buf)
-              (*ioffptr)++; /* at least skip one byte */
-            else
-              (*ioffptr) += dash - buf; /* skip to first possible boundary */
+            (*ioffptr) += dash - buf;
         }
       return MHD_NO;            /* expected boundary */
     }
@@ -735,6 +755,113 @@ process_multipart_headers (struct MHD_PostProcessor *pp,
 }
 
 
+/**
+ * Compute the shift table of @a pp for finding the delimiter
+ * "\r\n--" followed by @a boundary.
+ *
+ * @param pp post processor context
+ * @param boundary the boundary to look for
+ * @param blen strlen(boundary)
+ */
+static void
+prepare_boundary_search (struct MHD_PostProcessor *pp,
+                         const char *boundary,
+                         size_t blen)
+{
+  const size_t dlen = blen + 4;
+  size_t i;
+  size_t shift;
+  unsigned char c;
+
+  memset (pp->skip,
+          (int) MHD_MIN (dlen, 255),
+          sizeof (pp->skip));
+  for (i = 0; i < dlen - 1; i++)
+    {
+      c = (unsigned char) ( (i < 4) ? "\r\n--"[i] : boundary[i - 4]);
+      shift = dlen - 1 - i;
+      pp->skip[c] = (unsigned char) MHD_MIN (shift, 255);
+    }
+  pp->skip_boundary = boundary;
+}
+
+
+/**
+ * Find the delimiter "\r\n--" followed by @a boundary in
+ * @a buf.  If it is not there, find the first byte of a
+ * possible delimiter at the end of @a buf that is not yet
+ * complete.  All bytes before the returned offset are thus
+ * part of the value.
+ *
+ * @param pp post processor context
+ * @param buf data to search
+ * @param size number of bytes in @a buf
+ * @param boundary the boundary to look for
+ * @param blen strlen(boundary), must not be zero
+ * @param[out] found set to #MHD_YES if the delimiter was found
+ * @return offset of the delimiter, or of the start of the
+ *         incomplete delimiter, or @a size
+ */
+static size_t
+search_boundary (struct MHD_PostProcessor *pp,
+                 const char *buf,
+                 size_t size,
+                 const char *boundary,
+                 size_t blen,
+                 int *found)
+{
+  const size_t dlen = blen + 4;
+  const unsigned char last = (unsigned char) boundary[blen - 1];
+  const char *r;
+  size_t pos;
+  size_t len;
+  unsigned char c;
+
+  if (pp->skip_boundary != boundary)
+    prepare_boundary_search (pp,
+                             boundary,
+                             blen);
+  *found = MHD_NO;
+  pos = 0;
+  while (pos + dlen <= size)
+    {
+      c = (unsigned char) buf[pos + dlen - 1];
+      if ( (last == c) &&
+           (0 == memcmp (&buf[pos],
+                         "\r\n--",
+                         4)) &&
+           (0 == memcmp (&buf[pos + 4],
+                         boundary,
+                         blen - 1)) )
+        {
+          *found = MHD_YES;
+          return pos;
+        }
+      pos += pp->skip[c];
+    }
+  /* no complete delimiter; check if the buffer ends with
+     the beginning of one */
+  pos = (size >= dlen) ? size - (dlen - 1) : 0;
+  while (NULL != (r = memchr (&buf[pos],
+                              '\r',
+                              size - pos)))
+    {
+      pos = r - buf;
+      len = size - pos;
+      if ( (0 == memcmp (&buf[pos],
+                         "\r\n--",
+                         MHD_MIN (len, 4))) &&
+           ( (len <= 4) ||
+             (0 == memcmp (&buf[pos + 4],
+                           boundary,
+                           len - 4)) ) )
+        return pos;
+      pos++;
+    }
+  return size;
+}
+
+
 /**
  * We have the value until we hit the given boundary;
  * process accordingly.
@@ -761,65 +888,36 @@ process_value_to_boundary (struct MHD_PostProcessor *pp,
 {
   char *buf = (char *) &pp[1];
   size_t newline;
-  const char *r;
+  int found;
 
   /* all data in buf until the boundary
      (\r\n--+boundary) is part of the value */
-  newline = 0;
-  while (1)
+  newline = search_boundary (pp,
+                             buf,
+                             pp->buffer_pos,
+                             boundary,
+                             blen,
+                             &found);
+  if (MHD_YES == found)
     {
-      while (newline + 4 < pp->buffer_pos)
-        {
-          r = memchr (&buf[newline],
-                      '\r',
-                      pp->buffer_pos - newline - 4);
-          if (NULL == r)
-          {
-            newline = pp->buffer_pos - 4;
-            break;
-          }
-          newline = r - buf;
-          if (0 == memcmp ("\r\n--",
-                           &buf[newline],
-                           4))
-            break;
-          newline++;
-        }
-      if (newline + pp->blen + 4 <= pp->buffer_pos)
-        {
-          /* can check boundary */
-          if (0 != memcmp (&buf[newline + 4],
-                           boundary,
-                           pp->blen))
-            {
-              /* no boundary, "\r\n--" is part of content, skip */
-              newline += 4;
-              continue;
-            }
-          else
-            {
-              /* boundary found, process until newline then
-                 skip boundary and go back to init */
-              pp->skip_rn = RN_Dash;
-              pp->state = next_state;
-              pp->dash_state = next_dash_state;
-              (*ioffptr) += pp->blen + 4;       /* skip boundary as well */
-              buf[newline] = '\0';
-              break;
-            }
-        }
-      else
+      /* boundary found, process until newline then
+         skip boundary and go back to init */
+      pp->skip_rn = RN_Dash;
+      pp->state = next_state;
+      pp->dash_state = next_dash_state;
+      (*ioffptr) += blen + 4;       /* skip boundary as well */
+      buf[newline] = '\0';
+    }
+  else
+    {
+      /* cannot check for boundary, process content that
+         we have and check again later; except, if we have
+         no content, abort (out of memory) */
+      if ( (0 == newline) &&
+           (pp->buffer_pos == pp->buffer_size) )
         {
-          /* cannot check for boundary, process content that
-             we have and check again later; except, if we have
-             no content, abort (out of memory) */
-          if ( (0 == newline) &&
-               (pp->buffer_pos == pp->buffer_size) )
-            {
-              pp->state = PP_Error;
-              return MHD_NO;
-            }
-          break;
+          pp->state = PP_Error;
+          return MHD_NO;
         }
     }
   /* newline is either at beginning of boundary or
@@ -847,6 +945,89 @@ process_value_to_boundary (struct MHD_PostProcessor *pp,
 }
 
 
+/**
+ * Process value data directly from the data given by the
+ * application to #MHD_post_process(), without copying it to
+ * our buffer first.  Only used while our buffer is empty.
+ * Everything before the delimiter (or before what might be
+ * the start of a delimiter at the end of @a data) is given
+ * to the iterator in place; the rest is left to the caller.
+ *
+ * @param pp post processor context
+ * @param data value data from the application
+ * @param size number of bytes in @a data
+ * @param[out] used set to the number of bytes of @a data processed
+ * @return #MHD_YES if we can continue processing,
+ *         #MHD_NO on error
+ */
+static int
+process_value_in_place (struct MHD_PostProcessor *pp,
+                        const char *data,
+                        size_t size,
+                        size_t *used)
+{
+  const char *boundary;
+  size_t blen;
+  size_t end;
+  int found;
+
+  if (PP_ProcessValueToBoundary == pp->state)
+    {
+      boundary = pp->boundary;
+      blen = pp->blen;
+    }
+  else
+    {
+      boundary = pp->nested_boundary;
+      blen = pp->nlen;
+    }
+  end = search_boundary (pp,
+                         data,
+                         size,
+                         boundary,
+                         blen,
+                         &found);
+  /* an empty value is reported once its end is known */
+  if ( ( (0 != end) ||
+         ( (MHD_YES == pp->must_ikvi) &&
+           (MHD_YES == found) ) ) &&
+       (MHD_NO == pp->ikvi (pp->cls,
+                            MHD_POSTDATA_KIND,
+                            pp->content_name,
+                            pp->content_filename,
+                            pp->content_type,
+                            pp->content_transfer_encoding,
+                            data,
+                            pp->value_offset,
+                            end)) )
+    {
+      pp->state = PP_Error;
+      return MHD_NO;
+    }
+  if ( (MHD_YES == found) ||
+       (0 != end) )
+    pp->must_ikvi = MHD_NO;
+  pp->value_offset += end;
+  *used = end;
+  if (MHD_YES == found)
+    {
+      pp->skip_rn = RN_Dash;
+      if (PP_ProcessValueToBoundary == pp->state)
+        {
+          pp->state = PP_PerformCleanup;
+          pp->dash_state = PP_Done;
+        }
+      else
+        {
+          pp->state = PP_Nested_PerformCleanup;
+          pp->dash_state = PP_NextBoundary;
+        }
+      *used += blen + 4;
+    }
+  return MHD_YES;
+}
+
+
 /**
  *
  * @param pp post processor context
@@ -898,7 +1079,9 @@ post_process_multipart (struct MHD_PostProcessor *pp,
   size_t max;
   size_t ioff;
   size_t poff;
+  size_t blen;
   int state_changed;
+  int value_state;
 
   buf = (char *) &pp[1];
   ioff = 0;
@@ -908,11 +1091,46 @@ post_process_multipart (struct MHD_PostProcessor *pp,
           ( (pp->buffer_pos > 0) &&
             (0 != state_changed) ) )
     {
+      value_state = ( (RN_Inactive == pp->skip_rn) &&
+                      ( (PP_ProcessValueToBoundary == pp->state) ||
+                        (PP_Nested_ProcessValueToBoundary == pp->state) ) );
+      if ( (value_state) &&
+           (0 == pp->buffer_pos) &&
+           (poff < post_data_len) )
+        {
+          /* hand the value to the iterator straight from the
+             application's data; only a possible delimiter at
+             the end is left for our buffer */
+          max = 0;
+          if (MHD_NO == process_value_in_place (pp,
+                                                &post_data[poff],
+                                                post_data_len - poff,
+                                                &max))
+            return MHD_NO;
+          poff += max;
+          if (0 != max)
+            {
+              state_changed = 1;
+              continue;
+            }
+        }
       /* first, move as much input data
          as possible to our internal buffer */
       max = pp->buffer_size - pp->buffer_pos;
       if (max > post_data_len - poff)
         max = post_data_len - poff;
+      if ( (value_state) &&
+           (0 != pp->buffer_pos) )
+        {
+          /* our buffer only holds what might be the start of a
+             delimiter; copy just enough to decide, then go back
+             to processing in place */
+          blen = (PP_ProcessValueToBoundary == pp->state)
+            ? pp->blen
+            : pp->nlen;
+          if (max > blen + 4)
+            max = blen + 4;
+        }
       memcpy (&buf[pp->buffer_pos],
               &post_data[poff],
               max);
@@ -1067,6 +1285,11 @@ post_process_multipart (struct MHD_PostProcessor *pp,
               free (pp->content_type);
               pp->content_type = NULL;
               pp->nlen = strlen (pp->nested_boundary);
+              if (0 == pp->nlen)
+                {
+                  pp->state = PP_Error;
+                  return MHD_NO;
+                }
               pp->state = PP_Nested_Init;
               state_changed = 1;
               break;
@@ -1094,6 +1317,8 @@ post_process_multipart (struct MHD_PostProcessor *pp,
           free_unmarked (pp);
           if (NULL != pp->nested_boundary)
             {
+              if (pp->skip_boundary == pp->nested_boundary)
+                pp->skip_boundary = NULL;
               free (pp->nested_boundary);
               pp->nested_boundary = NULL;
             }
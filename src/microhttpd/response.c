@@ -37,6 +37,8 @@
 #include "mhd_itc.h"
 #include "connection.h"
 #include "memorypool.h"
+#include "mhd_str.h"
+#include "websocket.h"
 
 
 #if defined(_WIN32) && defined(MHD_W32_MUTEX_)
@@ -49,6 +51,12 @@
 #include <io.h> /* for lseek(), read() */
 #endif /* _WIN32 */
 
+#ifndef LINUX
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
 
 /**
  * Add a header or footer line to the response.
@@ -638,7 +646,8 @@ MHD_upgrade_action (struct MHD_UpgradeResponseHandle *urh,
     if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION) )
       {
 #if HTTPS_SUPPORT
-        if (0 != (daemon->options & MHD_USE_TLS) )
+        if ( (0 != (daemon->options & MHD_USE_TLS) ) &&
+             (MHD_NO == urh->direct_io) )
           {
             /* signal thread that app is done by shutdown() of 'app' socket */
             shutdown (urh->app.socket,
@@ -646,11 +655,12 @@ MHD_upgrade_action (struct MHD_UpgradeResponseHandle *urh,
           }
 #endif
         /* need to signal the thread that we are done */
-        MHD_semaphore_up (connection->upgrade_sem);
+        MHD_semaphore_up (connection->cold->upgrade_sem);
         return MHD_YES;
       }
 #if HTTPS_SUPPORT
-    if (0 != (daemon->options & MHD_USE_TLS) )
+    if ( (0 != (daemon->options & MHD_USE_TLS) ) &&
+         (MHD_NO == urh->direct_io) )
       {
         urh->was_closed = MHD_YES;
         if (MHD_INVALID_SOCKET != urh->app.socket)
@@ -673,6 +683,128 @@ MHD_upgrade_action (struct MHD_UpgradeResponseHandle *urh,
 }
 
 
+/**
+ * Receive data from the client of an upgraded connection.  With
+ * TLS and #MHD_RF_UPGRADE_DIRECT, the data is decrypted directly
+ * into @a buf; otherwise, this is a recv() on the socket given to
+ * the #MHD_UpgradeHandler.
+ *
+ * @param urh the upgraded connection
+ * @param buf where to store the data
+ * @param size size of @a buf
+ * @return number of bytes received, 0 if the client closed the
+ *         connection, -1 on error (with `errno` set, `EAGAIN`
+ *         if no data is available yet)
+ */
+_MHD_EXTERN ssize_t
+MHD_upgrade_recv (struct MHD_UpgradeResponseHandle *urh,
+                  void *buf,
+                  size_t size)
+{
+  struct MHD_Connection *connection = urh->connection;
+  MHD_socket sock = connection->socket_fd;
+
+#if HTTPS_SUPPORT
+  if (0 != (connection->daemon->options & MHD_USE_TLS))
+    {
+      ssize_t ret;
+
+      if (MHD_NO == urh->direct_io)
+        sock = urh->app.socket;
+      else
+        {
+          ret = gnutls_record_recv (connection->cold->tls_session,
+                                    buf,
+                                    size);
+          if ( (GNUTLS_E_AGAIN == ret) ||
+               (GNUTLS_E_INTERRUPTED == ret) )
+            {
+              MHD_socket_set_error_ (MHD_SCKT_EAGAIN_);
+              return -1;
+            }
+          if (ret < 0)
+            {
+              MHD_socket_set_error_ (MHD_SCKT_ECONNRESET_);
+              return -1;
+            }
+          return ret;
+        }
+    }
+#endif
+#ifdef MHD_POSIX_SOCKETS
+  if (size > SSIZE_MAX)
+    size = SSIZE_MAX; /* return value limit */
+#else  /* MHD_WINSOCK_SOCKETS */
+  if (size > INT_MAX)
+    size = INT_MAX; /* return value limit */
+#endif /* MHD_WINSOCK_SOCKETS */
+  return (ssize_t) recv (sock,
+                         buf,
+                         (MHD_SCKT_SEND_SIZE_) size,
+                         MSG_NOSIGNAL);
+}
+
+
+/**
+ * Send data to the client of an upgraded connection.  With TLS and
+ * #MHD_RF_UPGRADE_DIRECT, the data is encrypted directly from
+ * @a buf; otherwise, this is a send() on the socket given to the
+ * #MHD_UpgradeHandler.
+ *
+ * @param urh the upgraded connection
+ * @param buf the data to send
+ * @param size number of bytes in @a buf
+ * @return number of bytes sent, -1 on error (with `errno` set)
+ */
+_MHD_EXTERN ssize_t
+MHD_upgrade_send (struct MHD_UpgradeResponseHandle *urh,
+                  const void *buf,
+                  size_t size)
+{
+  struct MHD_Connection *connection = urh->connection;
+  MHD_socket sock = connection->socket_fd;
+
+#if HTTPS_SUPPORT
+  if (0 != (connection->daemon->options & MHD_USE_TLS))
+    {
+      ssize_t ret;
+
+      if (MHD_NO == urh->direct_io)
+        sock = urh->app.socket;
+      else
+        {
+          ret = gnutls_record_send (connection->cold->tls_session,
+                                    buf,
+                                    size);
+          if ( (GNUTLS_E_AGAIN == ret) ||
+               (GNUTLS_E_INTERRUPTED == ret) )
+            {
+              MHD_socket_set_error_ (MHD_SCKT_EAGAIN_);
+              return -1;
+            }
+          if (ret < 0)
+            {
+              MHD_socket_set_error_ (MHD_SCKT_ECONNRESET_);
+              return -1;
+            }
+          return ret;
+        }
+    }
+#endif
+#ifdef MHD_POSIX_SOCKETS
+  if (size > SSIZE_MAX)
+    size = SSIZE_MAX; /* return value limit */
+#else  /* MHD_WINSOCK_SOCKETS */
+  if (size > INT_MAX)
+    size = INT_MAX; /* return value limit */
+#endif /* MHD_WINSOCK_SOCKETS */
+  return (ssize_t) send (sock,
+                         buf,
+                         (MHD_SCKT_SEND_SIZE_) size,
+                         MSG_NOSIGNAL);
+}
+
+
 /**
  * We are done sending the header of a given response
  * to the client.  Now it is time to perform the upgrade
@@ -712,7 +844,8 @@ MHD_response_execute_upgrade_ (struct MHD_Response *response,
   rbo = connection->read_buffer_offset;
   connection->read_buffer_offset = 0;
 #if HTTPS_SUPPORT
-  if (0 != (daemon->options & MHD_USE_TLS) )
+  if ( (0 != (daemon->options & MHD_USE_TLS) ) &&
+       (0 == (response->flags & MHD_RF_UPGRADE_DIRECT)) )
   {
     struct MemoryPool *pool;
     size_t avail;
@@ -766,7 +899,7 @@ MHD_response_execute_upgrade_ (struct MHD_Response *response,
     if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION) )
       {
         /* Need to give the thread something to block on... */
-        connection->upgrade_sem = MHD_semaphore_create (0);
+        connection->cold->upgrade_sem = MHD_semaphore_create (0);
       }
 
     if (avail < 8)
@@ -795,7 +928,7 @@ MHD_response_execute_upgrade_ (struct MHD_Response *response,
     /* hand over internal socket to application */
     response->upgrade_handler (response->upgrade_handler_cls,
                                connection,
-                               connection->client_context,
+                               connection->cold->client_context,
                                connection->read_buffer,
                                rbo,
                                urh->app.socket,
@@ -872,19 +1005,24 @@ MHD_response_execute_upgrade_ (struct MHD_Response *response,
         /* Our caller will set 'connection->state' to
            MHD_CONNECTION_UPGRADE, thereby triggering the main method
            of the thread to switch to bi-directional forwarding. */
-        connection->urh = urh;
+        connection->cold->urh = urh;
       }
     return MHD_YES;
   }
   urh->app.socket = MHD_INVALID_SOCKET;
   urh->mhd.socket = MHD_INVALID_SOCKET;
+  /* with TLS, the application gets the socket of the client, but
+     has to use the TLS session via #MHD_upgrade_recv() and
+     #MHD_upgrade_send() */
+  if (0 != (daemon->options & MHD_USE_TLS) )
+    urh->direct_io = MHD_YES;
 #endif
   if (0 != (daemon->options & MHD_USE_THREAD_PER_CONNECTION) )
     {
       /* Need to give the thread something to block on... */
-      connection->upgrade_sem = MHD_semaphore_create (0);
-      connection->urh = urh;
-        if (NULL == connection->upgrade_sem)
+      connection->cold->upgrade_sem = MHD_semaphore_create (0);
+      connection->cold->urh = urh;
+        if (NULL == connection->cold->upgrade_sem)
         {
 #ifdef HAVE_MESSAGES
           MHD_DLOG (daemon,
@@ -907,7 +1045,7 @@ MHD_response_execute_upgrade_ (struct MHD_Response *response,
     }
   response->upgrade_handler (response->upgrade_handler_cls,
                              connection,
-                             connection->client_context,
+                             connection->cold->client_context,
                              connection->read_buffer,
                              rbo,
                              connection->socket_fd,
@@ -978,6 +1116,119 @@ MHD_create_response_for_upgrade (MHD_UpgradeHandler upgrade_handler,
 }
 
 
+/**
+ * Check if the comma-separated list @a value contains @a token
+ * (case-insensitive).
+ *
+ * @param value header value to search, may be NULL
+ * @param token token to look for
+ * @return #MHD_YES if @a token is in @a value
+ */
+static int
+has_token (const char *value,
+           const char *token)
+{
+  size_t tlen = strlen (token);
+  size_t len;
+
+  if (NULL == value)
+    return MHD_NO;
+  while ('\0' != *value)
+    {
+      while ( (' ' == *value) ||
+              ('\t' == *value) ||
+              (',' == *value) )
+        value++;
+      len = 0;
+      while ( ('\0' != value[len]) &&
+              (',' != value[len]) &&
+              (' ' != value[len]) &&
+              ('\t' != value[len]) )
+        len++;
+      if ( (len == tlen) &&
+           (MHD_str_equal_caseless_n_ (value, token, tlen)) )
+        return MHD_YES;
+      value += len;
+    }
+  return MHD_NO;
+}
+
+
+/**
+ * Create a response that accepts the WebSocket (RFC 6455) handshake
+ * of the request on @a connection.
+ *
+ * @param connection the connection with the handshake request
+ * @param upgrade_handler function to call with the upgraded connection
+ * @param upgrade_handler_cls closure for @a upgrade_handler
+ * @return NULL if the request is not a valid WebSocket handshake
+ *         or out of memory
+ */
+_MHD_EXTERN struct MHD_Response *
+MHD_create_response_for_websocket (struct MHD_Connection *connection,
+                                   MHD_UpgradeHandler upgrade_handler,
+                                   void *upgrade_handler_cls)
+{
+  struct MHD_Response *response;
+  const char *key;
+  const char *version;
+  char accept[MHD_WEBSOCKET_ACCEPT_SIZE];
+
+  if ( (NULL == connection) ||
+       (NULL == connection->method) ||
+       (! MHD_str_equal_caseless_ (connection->method,
+                                   MHD_HTTP_METHOD_GET)) ||
+       (MHD_YES != has_token (MHD_lookup_connection_value (connection,
+                                                           MHD_HEADER_KIND,
+                                                           MHD_HTTP_HEADER_UPGRADE),
+                              "websocket")) ||
+       (MHD_YES != has_token (MHD_lookup_connection_value (connection,
+                                                           MHD_HEADER_KIND,
+                                                           MHD_HTTP_HEADER_CONNECTION),
+                              "upgrade")) )
+    return NULL;
+  version = MHD_lookup_connection_value (connection,
+                                         MHD_HEADER_KIND,
+                                         MHD_HTTP_HEADER_SEC_WEBSOCKET_VERSION);
+  key = MHD_lookup_connection_value (connection,
+                                     MHD_HEADER_KIND,
+                                     MHD_HTTP_HEADER_SEC_WEBSOCKET_KEY);
+  if ( (NULL == version) ||
+       (0 != strcmp (version, "13")) ||
+       (NULL == key) ||
+       (MHD_WEBSOCKET_KEY_LENGTH != strlen (key)) ||
+       ('=' != key[MHD_WEBSOCKET_KEY_LENGTH - 1]) ||
+       ('=' != key[MHD_WEBSOCKET_KEY_LENGTH - 2]) )
+    {
+#ifdef HAVE_MESSAGES
+      MHD_DLOG (connection->daemon,
+                _("Invalid WebSocket handshake request\n"));
+#endif
+      return NULL;
+    }
+  MHD_websocket_accept_ (key,
+                         accept);
+  response = MHD_create_response_for_upgrade (upgrade_handler,
+                                              upgrade_handler_cls);
+  if (NULL == response)
+    return NULL;
+  response->flags |= MHD_RF_UPGRADE_DIRECT;
+  if ( (MHD_NO ==
+        MHD_add_response_header (response,
+                                 MHD_HTTP_HEADER_UPGRADE,
+                                 "websocket")) ||
+       (MHD_NO ==
+        MHD_add_response_header (response,
+                                 MHD_HTTP_HEADER_SEC_WEBSOCKET_ACCEPT,
+                                 accept)) )
+    {
+      MHD_destroy_response (response);
+      return NULL;
+    }
+  return response;
+}
+
+
 /**
  * Destroy a response object and associated resources.  Note that
  * libmicrohttpd may keep some of the resources around if the response
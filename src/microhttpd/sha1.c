@@ -0,0 +1,193 @@
+/*
+ * This code implements the SHA-1 message-digest algorithm
+ * (FIPS 180-4).  It is only used for the WebSocket handshake,
+ * where SHA-1 is required by RFC 6455; it must not be used for
+ * anything that relies on collision resistance.
+ * This code is in the public domain; do with it what you wish.
+ *
+ * To compute the message digest of a chunk of bytes, declare an
+ * SHA1Context structure, pass it to SHA1Init, call SHA1Update as
+ * needed on buffers full of bytes, and then call SHA1Final, which
+ * will fill a supplied 20-byte array with the digest.
+ */
+
+#include "sha1.h"
+
+#define PUT_64BIT_BE(cp, value) do {					\
+	(cp)[0] = (uint8_t)((value) >> 56);				\
+	(cp)[1] = (uint8_t)((value) >> 48);				\
+	(cp)[2] = (uint8_t)((value) >> 40);				\
+	(cp)[3] = (uint8_t)((value) >> 32);				\
+	(cp)[4] = (uint8_t)((value) >> 24);				\
+	(cp)[5] = (uint8_t)((value) >> 16);				\
+	(cp)[6] = (uint8_t)((value) >> 8);				\
+	(cp)[7] = (uint8_t)((value)); } while (0)
+
+#define PUT_32BIT_BE(cp, value) do {					\
+	(cp)[0] = (uint8_t)((value) >> 24);				\
+	(cp)[1] = (uint8_t)((value) >> 16);				\
+	(cp)[2] = (uint8_t)((value) >> 8);				\
+	(cp)[3] = (uint8_t)((value)); } while (0)
+
+#define GET_32BIT_BE(cp) (						\
+	((uint32_t)(cp)[0] << 24) | ((uint32_t)(cp)[1] << 16) |		\
+	((uint32_t)(cp)[2] << 8) | (uint32_t)(cp)[3])
+
+#define ROL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static uint8_t PADDING[SHA1_BLOCK_SIZE] = {
+  0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/*
+ * Start SHA-1 accumulation.  Set bit count to 0 and state to the
+ * initial hash value.
+ */
+void
+SHA1Init(struct SHA1Context *ctx)
+{
+  if (!ctx)
+    return;
+
+  ctx->count = 0;
+  ctx->state[0] = 0x67452301;
+  ctx->state[1] = 0xefcdab89;
+  ctx->state[2] = 0x98badcfe;
+  ctx->state[3] = 0x10325476;
+  ctx->state[4] = 0xc3d2e1f0;
+}
+
+/*
+ * Update context to reflect the concatenation of another buffer full
+ * of bytes.
+ */
+void
+SHA1Update(struct SHA1Context *ctx, const unsigned char *input, size_t len)
+{
+  size_t have, need;
+
+  if (!ctx || !input)
+    return;
+
+  /* Check how many bytes we already have and how many more we need. */
+  have = (size_t)((ctx->count >> 3) & (SHA1_BLOCK_SIZE - 1));
+  need = SHA1_BLOCK_SIZE - have;
+
+  /* Update bitcount */
+  ctx->count += (uint64_t)len << 3;
+
+  if (len >= need)
+    {
+      if (have != 0)
+        {
+          memcpy(ctx->buffer + have, input, need);
+          SHA1Transform(ctx->state, ctx->buffer);
+          input += need;
+          len -= need;
+          have = 0;
+        }
+
+      /* Process data in SHA1_BLOCK_SIZE-byte chunks. */
+      while (len >= SHA1_BLOCK_SIZE)
+        {
+          SHA1Transform(ctx->state, (const unsigned char *)input);
+          input += SHA1_BLOCK_SIZE;
+          len -= SHA1_BLOCK_SIZE;
+        }
+    }
+
+  /* Handle any remaining bytes of data. */
+  if (len != 0)
+    memcpy(ctx->buffer + have, input, len);
+}
+
+/*
+ * Final wrapup--pad to a 64-byte boundary, fill in digest and zero
+ * out ctx.
+ */
+void
+SHA1Final(unsigned char digest[SHA1_DIGEST_SIZE], struct SHA1Context *ctx)
+{
+  uint8_t count[8];
+  size_t padlen;
+  int i;
+
+  if (!ctx || !digest)
+    return;
+
+  /* Convert count to 8 bytes in big endian order. */
+  PUT_64BIT_BE(count, ctx->count);
+
+  /* Pad out to 56 mod 64. */
+  padlen = SHA1_BLOCK_SIZE -
+    ((ctx->count >> 3) & (SHA1_BLOCK_SIZE - 1));
+  if (padlen < 1 + 8)
+    padlen += SHA1_BLOCK_SIZE;
+  SHA1Update(ctx, PADDING, padlen - 8); /* padlen - 8 <= 64 */
+  SHA1Update(ctx, count, 8);
+
+  for (i = 0; i < 5; i++)
+    PUT_32BIT_BE(digest + i * 4, ctx->state[i]);
+  memset(ctx, 0, sizeof(*ctx));	/* in case it's sensitive */
+}
+
+/*
+ * The core of the SHA-1 algorithm, this alters an existing SHA-1
+ * hash to reflect the addition of 16 longwords of new data.
+ */
+void
+SHA1Transform(uint32_t state[5], const uint8_t block[SHA1_BLOCK_SIZE])
+{
+  uint32_t a, b, c, d, e, f, k, t;
+  uint32_t w[80];
+  int i;
+
+  for (i = 0; i < 16; i++)
+    w[i] = GET_32BIT_BE(block + i * 4);
+  for (i = 16; i < 80; i++)
+    w[i] = ROL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+  a = state[0];
+  b = state[1];
+  c = state[2];
+  d = state[3];
+  e = state[4];
+
+  for (i = 0; i < 80; i++)
+    {
+      if (i < 20)
+        {
+          f = (b & c) | (~b & d);
+          k = 0x5a827999;
+        }
+      else if (i < 40)
+        {
+          f = b ^ c ^ d;
+          k = 0x6ed9eba1;
+        }
+      else if (i < 60)
+        {
+          f = (b & c) | (b & d) | (c & d);
+          k = 0x8f1bbcdc;
+        }
+      else
+        {
+          f = b ^ c ^ d;
+          k = 0xca62c1d6;
+        }
+      t = ROL(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = ROL(b, 30);
+      b = a;
+      a = t;
+    }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
@@ -0,0 +1,53 @@
+/*
+ * This code implements the SHA-1 message-digest algorithm
+ * (FIPS 180-4).  It is only used for the WebSocket handshake,
+ * where SHA-1 is required by RFC 6455; it must not be used for
+ * anything that relies on collision resistance.
+ * This code is in the public domain; do with it what you wish.
+ *
+ * To compute the message digest of a chunk of bytes, declare an
+ * SHA1Context structure, pass it to SHA1Init, call SHA1Update as
+ * needed on buffers full of bytes, and then call SHA1Final, which
+ * will fill a supplied 20-byte array with the digest.
+ */
+
+#ifndef MHD_SHA1_H
+#define MHD_SHA1_H
+
+#include "platform.h"
+
+#define	SHA1_BLOCK_SIZE              64
+#define	SHA1_DIGEST_SIZE             20
+
+struct SHA1Context
+{
+  uint32_t state[5];			/* state */
+  uint64_t count;			/* number of bits, mod 2^64 */
+  uint8_t buffer[SHA1_BLOCK_SIZE];	/* input buffer */
+};
+
+/*
+ * Start SHA-1 accumulation.  Set bit count to 0 and state to the
+ * initial hash value.
+ */
+void SHA1Init(struct SHA1Context *ctx);
+
+/*
+ * Update context to reflect the concatenation of another buffer full
+ * of bytes.
+ */
+void SHA1Update(struct SHA1Context *ctx, const unsigned char *input, size_t len);
+
+/*
+ * Final wrapup--pad to a 64-byte boundary, fill in digest and zero
+ * out ctx.
+ */
+void SHA1Final(unsigned char digest[SHA1_DIGEST_SIZE], struct SHA1Context *ctx);
+
+/*
+ * The core of the SHA-1 algorithm, this alters an existing SHA-1
+ * hash to reflect the addition of 16 longwords of new data.
+ */
+void SHA1Transform(uint32_t state[5], const uint8_t block[SHA1_BLOCK_SIZE]);
+
+#endif /* !MHD_SHA1_H */
@@ -0,0 +1,263 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 3, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file test_ipcount.c
+ * @brief  Testcase for the table of connections per IP address
+ * @author libmicrohttpd contributors
+ */
+
+#include "ipcount.h"
+#include <stdio.h>
+
+/**
+ * Number of distinct addresses used by #test_many().
+ */
+#define NUM_ADDRS 500
+
+
+static void
+test_panic (void *cls,
+            const char *file,
+            unsigned int line,
+            const char *reason)
+{
+  (void) cls;
+  fprintf (stderr,
+           "Panic at %s:%u: %s\n",
+           file,
+           line,
+           (NULL != reason) ? reason : "");
+  abort ();
+}
+
+
+MHD_PanicCallback mhd_panic = &test_panic;
+
+void *mhd_panic_cls = NULL;
+
+
+static void
+make_addr4 (struct sockaddr_in *sa,
+            uint32_t ip)
+{
+  memset (sa, 0, sizeof (*sa));
+  sa->sin_family = AF_INET;
+  sa->sin_addr.s_addr = htonl (ip);
+}
+
+
+#if HAVE_INET6
+static void
+make_addr6 (struct sockaddr_in6 *sa,
+            const char *ip)
+{
+  memset (sa, 0, sizeof (*sa));
+  sa->sin6_family = AF_INET6;
+  inet_pton (AF_INET6, ip, &sa->sin6_addr);
+}
+#endif
+
+
+static int
+add4 (struct MHD_IPCountTable *t,
+      uint32_t ip,
+      unsigned int limit)
+{
+  struct sockaddr_in sa;
+
+  make_addr4 (&sa, ip);
+  return MHD_ipcount_add_ (t,
+                           (const struct sockaddr *) &sa,
+                           sizeof (sa),
+                           limit);
+}
+
+
+static void
+del4 (struct MHD_IPCountTable *t,
+      uint32_t ip)
+{
+  struct sockaddr_in sa;
+
+  make_addr4 (&sa, ip);
+  MHD_ipcount_del_ (t,
+                    (const struct sockaddr *) &sa,
+                    sizeof (sa));
+}
+
+
+static int
+test_limit ()
+{
+  struct MHD_IPCountTable *t;
+  int ret;
+
+  t = MHD_ipcount_create_ (16, 128);
+  if (NULL == t)
+    return 1;
+  ret = 0;
+  if ( (MHD_YES != add4 (t, 0x7F000001, 3)) ||
+       (MHD_YES != add4 (t, 0x7F000001, 3)) ||
+       (MHD_YES != add4 (t, 0x7F000001, 3)) ||
+       (MHD_NO != add4 (t, 0x7F000001, 3)) ||
+       (MHD_YES != add4 (t, 0x7F000002, 3)) )
+    ret = 1;
+  del4 (t, 0x7F000001);
+  if (MHD_YES != add4 (t, 0x7F000001, 3))
+    ret = 1;
+  MHD_ipcount_destroy_ (t);
+  return ret;
+}
+
+
+/**
+ * Add and remove many addresses so that probe sequences overlap
+ * and entries are moved around when others are removed.
+ */
+static int
+test_many ()
+{
+  struct MHD_IPCountTable *t;
+  unsigned int counts[NUM_ADDRS];
+  unsigned int i;
+  unsigned int round;
+  int ret;
+
+  t = MHD_ipcount_create_ (2 * NUM_ADDRS, 128);
+  if (NULL == t)
+    return 2;
+  ret = 0;
+  memset (counts, 0, sizeof (counts));
+  for (round = 0; round < 8; round++)
+    {
+      for (i = round % 3; i < NUM_ADDRS; i += 1 + round % 2)
+        {
+          if (MHD_YES != add4 (t, 0x0A000000 + i * 257, 2))
+            ret = 2;
+          counts[i]++;
+        }
+      for (i = round % 5; i < NUM_ADDRS; i += 2 + round % 3)
+        {
+          if (0 == counts[i])
+            continue;
+          del4 (t, 0x0A000000 + i * 257);
+          counts[i]--;
+        }
+      /* every address must still be found with its count */
+      for (i = 0; i < NUM_ADDRS; i++)
+        {
+          while (counts[i] < 2)
+            {
+              if (MHD_YES != add4 (t, 0x0A000000 + i * 257, 2))
+                ret = 2;
+              counts[i]++;
+            }
+          if (MHD_NO != add4 (t, 0x0A000000 + i * 257, 2))
+            ret = 2;
+        }
+      for (i = 0; i < NUM_ADDRS; i++)
+        {
+          while (counts[i] > (i + round) % 2)
+            {
+              del4 (t, 0x0A000000 + i * 257);
+              counts[i]--;
+            }
+        }
+    }
+  MHD_ipcount_destroy_ (t);
+  return ret;
+}
+
+
+static int
+test_full ()
+{
+  struct MHD_IPCountTable *t;
+  unsigned int i;
+  unsigned int refused;
+
+  t = MHD_ipcount_create_ (1, 128);
+  if (NULL == t)
+    return 4;
+  refused = 0;
+  for (i = 0; i < 10000; i++)
+    if (MHD_NO == add4 (t, i, 1))
+      refused++;
+  MHD_ipcount_destroy_ (t);
+  /* a tiny table must refuse, not loop forever */
+  return (0 == refused) ? 4 : 0;
+}
+
+
+static int
+test_prefix ()
+{
+#if HAVE_INET6
+  struct MHD_IPCountTable *t;
+  struct sockaddr_in6 a;
+  struct sockaddr_in6 b;
+  struct sockaddr_in6 c;
+  struct sockaddr_in6 m1;
+  struct sockaddr_in6 m2;
+  int ret;
+
+  t = MHD_ipcount_create_ (16, 64);
+  if (NULL == t)
+    return 8;
+  make_addr6 (&a, "2001:db8:1:2::1");
+  make_addr6 (&b, "2001:db8:1:2:ffff::2");
+  make_addr6 (&c, "2001:db8:1:3::1");
+  make_addr6 (&m1, "::ffff:10.0.0.1");
+  make_addr6 (&m2, "::ffff:10.0.0.2");
+  ret = 0;
+  if ( (MHD_YES != MHD_ipcount_add_ (t, (struct sockaddr *) &a, sizeof (a), 1)) ||
+       (MHD_NO != MHD_ipcount_add_ (t, (struct sockaddr *) &b, sizeof (b), 1)) ||
+       (MHD_YES != MHD_ipcount_add_ (t, (struct sockaddr *) &c, sizeof (c), 1)) ||
+       (MHD_YES != MHD_ipcount_add_ (t, (struct sockaddr *) &m1, sizeof (m1), 1)) ||
+       (MHD_YES != MHD_ipcount_add_ (t, (struct sockaddr *) &m2, sizeof (m2), 1)) )
+    ret = 8;
+  /* IPv4-mapped addresses are the same client as plain IPv4 */
+  if (MHD_NO != add4 (t, 0x0A000001, 1))
+    ret = 8;
+  MHD_ipcount_del_ (t, (struct sockaddr *) &b, sizeof (b));
+  if (MHD_YES != MHD_ipcount_add_ (t, (struct sockaddr *) &a, sizeof (a), 1))
+    ret = 8;
+  MHD_ipcount_destroy_ (t);
+  return ret;
+#else
+  return 0;
+#endif
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+
+  errorCount += test_limit ();
+  errorCount += test_many ();
+  errorCount += test_full ();
+  errorCount += test_prefix ();
+  if (errorCount != 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  return errorCount != 0;       /* 0 == pass */
+}
@@ -0,0 +1,197 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 3, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file test_noncetable.c
+ * @brief  Testcase for the table of digest authentication nonces
+ * @author libmicrohttpd contributors
+ */
+
+#include "noncetable.h"
+#include <stdio.h>
+
+/**
+ * Size of the table used by #test_load().
+ */
+#define TABLE_SIZE 1000
+
+
+static void
+test_panic (void *cls,
+            const char *file,
+            unsigned int line,
+            const char *reason)
+{
+  (void) cls;
+  fprintf (stderr,
+           "Panic at %s:%u: %s\n",
+           file,
+           line,
+           (NULL != reason) ? reason : "");
+  abort ();
+}
+
+
+MHD_PanicCallback mhd_panic = &test_panic;
+
+void *mhd_panic_cls = NULL;
+
+
+static void
+make_nonce (char *buf,
+            unsigned int i)
+{
+  snprintf (buf,
+            MAX_NONCE_LENGTH,
+            "%032x%08x",
+            i * 2654435761U,
+            i);
+}
+
+
+static int
+test_counters ()
+{
+  struct MHD_NonceTable *t;
+  char nonce[MAX_NONCE_LENGTH];
+  char other[MAX_NONCE_LENGTH];
+  int ret;
+
+  t = MHD_nonce_table_create_ (16, "secret", 6);
+  if (NULL == t)
+    return 1;
+  make_nonce (nonce, 1);
+  make_nonce (other, 2);
+  ret = 0;
+  if ( (MHD_NO != MHD_nonce_table_check_ (t, nonce, 1)) ||
+       (MHD_YES != MHD_nonce_table_check_ (t, nonce, 0)) ||
+       (MHD_YES != MHD_nonce_table_check_ (t, nonce, 1)) ||
+       (MHD_YES != MHD_nonce_table_check_ (t, nonce, 2)) ||
+       (MHD_NO != MHD_nonce_table_check_ (t, nonce, 2)) ||
+       (MHD_NO != MHD_nonce_table_check_ (t, other, 3)) )
+    ret = 1;
+  /* out of order, but each counter only once */
+  if ( (MHD_YES != MHD_nonce_table_check_ (t, nonce, 5)) ||
+       (MHD_YES != MHD_nonce_table_check_ (t, nonce, 4)) ||
+       (MHD_NO != MHD_nonce_table_check_ (t, nonce, 4)) ||
+       (MHD_YES != MHD_nonce_table_check_ (t, nonce, 3)) ||
+       (MHD_NO != MHD_nonce_table_check_ (t, nonce, 2)) ||
+       (MHD_NO != MHD_nonce_table_check_ (t, nonce, 5)) )
+    ret = 1;
+  /* far ahead, older counters are out of the window */
+  if ( (MHD_YES != MHD_nonce_table_check_ (t, nonce, 69)) ||
+       (MHD_NO != MHD_nonce_table_check_ (t, nonce, 5)) ||
+       (MHD_YES != MHD_nonce_table_check_ (t, nonce, 6)) ||
+       (MHD_YES != MHD_nonce_table_check_ (t, nonce, 200)) ||
+       (MHD_NO != MHD_nonce_table_check_ (t, nonce, 69)) ||
+       (MHD_NO != MHD_nonce_table_check_ (t, nonce, 135)) )
+    ret = 1;
+  MHD_nonce_table_destroy_ (t);
+  return ret;
+}
+
+
+/**
+ * With the table half full, hardly any nonce may be lost to
+ * collisions (about 4% are expected with four entries per set,
+ * 21% if each nonce had only one possible entry).
+ */
+static int
+test_load ()
+{
+  struct MHD_NonceTable *t;
+  char nonce[MAX_NONCE_LENGTH];
+  unsigned int i;
+  unsigned int alive;
+
+  t = MHD_nonce_table_create_ (TABLE_SIZE, NULL, 0);
+  if (NULL == t)
+    return 2;
+  for (i = 0; i < TABLE_SIZE / 2; i++)
+    {
+      make_nonce (nonce, i);
+      if (MHD_YES != MHD_nonce_table_check_ (t, nonce, 0))
+        {
+          MHD_nonce_table_destroy_ (t);
+          return 2;
+        }
+    }
+  alive = 0;
+  for (i = 0; i < TABLE_SIZE / 2; i++)
+    {
+      make_nonce (nonce, i);
+      if (MHD_YES == MHD_nonce_table_check_ (t, nonce, 1))
+        alive++;
+    }
+  MHD_nonce_table_destroy_ (t);
+  if (alive < TABLE_SIZE / 2 * 9 / 10)
+    {
+      fprintf (stderr,
+               "Only %u of %u nonces left\n",
+               alive,
+               TABLE_SIZE / 2);
+      return 2;
+    }
+  return 0;
+}
+
+
+/**
+ * A nonce that is used all the time must survive any number of
+ * fresh nonces.
+ */
+static int
+test_lru ()
+{
+  struct MHD_NonceTable *t;
+  char busy[MAX_NONCE_LENGTH];
+  char nonce[MAX_NONCE_LENGTH];
+  unsigned int i;
+  int ret;
+
+  t = MHD_nonce_table_create_ (8, NULL, 0);
+  if (NULL == t)
+    return 4;
+  make_nonce (busy, 0);
+  ret = (MHD_YES == MHD_nonce_table_check_ (t, busy, 0)) ? 0 : 4;
+  for (i = 1; i < 1000; i++)
+    {
+      make_nonce (nonce, i);
+      if ( (MHD_YES != MHD_nonce_table_check_ (t, nonce, 0)) ||
+           (MHD_YES != MHD_nonce_table_check_ (t, busy, i)) )
+        ret = 4;
+    }
+  MHD_nonce_table_destroy_ (t);
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+
+  errorCount += test_counters ();
+  errorCount += test_load ();
+  errorCount += test_lru ();
+  if (errorCount != 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  return errorCount != 0;       /* 0 == pass */
+}
@@ -67,6 +67,18 @@ const char *want[] = {
   "key2", NULL, NULL, NULL, "",
   "key3", NULL, NULL, NULL, "",
 #define URL_EMPTY_VALUE_END (URL_EMPTY_VALUE_START + 15)
+  NULL, NULL, NULL, NULL, NULL,
+#define NEAR_VALUE "\r\n--AaB03\r\n-\r\n--AaB03y\r\r\n--AaB0"
+#define FORM_NEAR_DATA "--AaB03x\r\ncontent-disposition: form-data; name=\"near\"\r\n\r\n" NEAR_VALUE "\r\n--AaB03x\r\ncontent-disposition: form-data; name=\"x\"\r\n\r\n--AaB03x\r\n--AaB03x--\r\n"
+#define FORM_NEAR_START (URL_EMPTY_VALUE_END + 5)
+  "near", NULL, NULL, NULL, NEAR_VALUE,
+  "x", NULL, NULL, NULL, "--AaB03x",
+#define FORM_NEAR_END (FORM_NEAR_START + 10)
+  NULL, NULL, NULL, NULL, NULL,
+#define FORM_NESTED_LONG_DATA "--AaB03x\r\ncontent-disposition: form-data; name=\"pics\"\r\nContent-type: multipart/mixed, boundary=BbC04y-nested\r\n\r\n--BbC04y-nested\r\nContent-disposition: attachment; filename=\"file1.txt\"\r\nContent-Type: text/plain\r\n\r\nfiledata1\r\n--BbC04y\r\n--BbC04y-nested--\r\n--AaB03x--"
+#define FORM_NESTED_LONG_START (FORM_NEAR_END + 5)
+  "pics", "file1.txt", "text/plain", NULL, "filedata1\r\n--BbC04y",
+#define FORM_NESTED_LONG_END (FORM_NESTED_LONG_START + 5)
   NULL, NULL, NULL, NULL, NULL
 };
 
@@ -227,6 +239,56 @@ test_multipart_splits ()
 }
 
 
+/**
+ * Check values containing partial boundaries, and a nested
+ * boundary of a different length, split at every position.
+ */
+static int
+test_multipart_near_boundary ()
+{
+  static const struct
+  {
+    const char *data;
+    unsigned int start;
+    unsigned int end;
+  } tests[] = {
+    { FORM_NEAR_DATA, FORM_NEAR_START, FORM_NEAR_END },
+    { FORM_NESTED_LONG_DATA, FORM_NESTED_LONG_START, FORM_NESTED_LONG_END }
+  };
+  struct MHD_Connection connection;
+  struct MHD_HTTP_Header header;
+  struct MHD_PostProcessor *pp;
+  unsigned int want_off;
+  unsigned int i;
+  size_t size;
+  size_t splitpoint;
+
+  for (i = 0; i < sizeof (tests) / sizeof (tests[0]); i++)
+  {
+    size = strlen (tests[i].data);
+    for (splitpoint = 1; splitpoint < size; splitpoint++)
+    {
+      want_off = tests[i].start;
+      memset (&connection, 0, sizeof (struct MHD_Connection));
+      memset (&header, 0, sizeof (struct MHD_HTTP_Header));
+      connection.headers_received = &header;
+      header.header = MHD_HTTP_HEADER_CONTENT_TYPE;
+      header.value =
+        MHD_HTTP_POST_ENCODING_MULTIPART_FORMDATA ", boundary=AaB03x";
+      header.kind = MHD_HEADER_KIND;
+      pp = MHD_create_post_processor (&connection,
+                                      1024, &value_checker, &want_off);
+      MHD_post_process (pp, tests[i].data, splitpoint);
+      MHD_post_process (pp, &tests[i].data[splitpoint], size - splitpoint);
+      MHD_destroy_post_processor (pp);
+      if (want_off != tests[i].end)
+        return 8;
+    }
+  }
+  return 0;
+}
+
+
 static int
 test_multipart ()
 {
@@ -340,6 +402,7 @@ main (int argc, char *const *argv)
 
   errorCount += test_multipart_splits ();
   errorCount += test_multipart_garbage ();
+  errorCount += test_multipart_near_boundary ();
   errorCount += test_urlencoding ();
   errorCount += test_multipart ();
   errorCount += test_nested_multipart ();
@@ -94,12 +94,106 @@ test_simple_large ()
   return 0;
 }
 
+/**
+ * Where the multipart value data was given to the iterator.
+ */
+struct InPlace
+{
+  const char *start;
+  const char *end;
+  size_t total;
+  size_t in_place;
+  int bad;
+};
+
+
+static int
+in_place_checker (void *cls,
+                  enum MHD_ValueKind kind,
+                  const char *key,
+                  const char *filename,
+                  const char *content_type,
+                  const char *transfer_encoding,
+                  const char *data, uint64_t off, size_t size)
+{
+  struct InPlace *ip = cls;
+  size_t i;
+
+  if (off != ip->total)
+    ip->bad = 1;
+  for (i = 0; i < size; i++)
+    if ('A' != data[i])
+      ip->bad = 1;
+  if ( (data >= ip->start) &&
+       (data + size <= ip->end) )
+    ip->in_place += size;
+  ip->total += size;
+  return MHD_YES;
+}
+
+
+static int
+test_multipart_large ()
+{
+  static const char head[] =
+    "--AaB03x\r\ncontent-disposition: form-data; name=\"f\"\r\n\r\n";
+  static const char tail[] = "\r\n--AaB03x--\r\n";
+  struct MHD_Connection connection;
+  struct MHD_HTTP_Header header;
+  struct MHD_PostProcessor *pp;
+  struct InPlace ip;
+  size_t i;
+  size_t delta;
+  size_t size;
+  size_t vlen;
+  char data[102400];
+
+  size = sizeof (data);
+  vlen = size - strlen (head) - strlen (tail);
+  memcpy (data, head, strlen (head));
+  memset (&data[strlen (head)], 'A', vlen);
+  memcpy (&data[size - strlen (tail)], tail, strlen (tail));
+  memset (&ip, 0, sizeof (ip));
+  memset (&connection, 0, sizeof (struct MHD_Connection));
+  memset (&header, 0, sizeof (struct MHD_HTTP_Header));
+  connection.headers_received = &header;
+  header.header = MHD_HTTP_HEADER_CONTENT_TYPE;
+  header.value =
+    MHD_HTTP_POST_ENCODING_MULTIPART_FORMDATA ", boundary=AaB03x";
+  header.kind = MHD_HEADER_KIND;
+  pp = MHD_create_post_processor (&connection, 1024,
+                                  &in_place_checker, &ip);
+  i = 0;
+  while (i < size)
+    {
+      delta = 1 + MHD_random_ () % 8192;
+      if (delta > size - i)
+        delta = size - i;
+      ip.start = &data[i];
+      ip.end = &data[i + delta];
+      if (MHD_YES != MHD_post_process (pp, &data[i], delta))
+        ip.bad = 1;
+      i += delta;
+    }
+  MHD_destroy_post_processor (pp);
+  if ( (ip.bad) ||
+       (ip.total != vlen) )
+    return 2;
+  /* only the data around our chunk borders should have
+     been copied to the post processor's buffer */
+  if (ip.in_place < vlen / 2)
+    return 4;
+  return 0;
+}
+
+
 int
 main (int argc, char *const *argv)
 {
   unsigned int errorCount = 0;
 
   errorCount += test_simple_large ();
+  errorCount += test_multipart_large ();
   if (errorCount != 0)
     fprintf (stderr, "Error (code: %u)\n", errorCount);
   return errorCount != 0;       /* 0 == pass */
@@ -3480,6 +3480,155 @@ int run_str_to_X_tests(void)
 }
 
 
+/*
+ * URI and form data decoding functions tests
+ */
+
+struct two_strs
+{
+  const struct str_with_len enc;
+  const struct str_with_len dec;
+};
+
+static const struct two_strs form_strings[] = {
+  {D_STR_W_LEN(""), D_STR_W_LEN("")},
+  {D_STR_W_LEN("abc"), D_STR_W_LEN("abc")},
+  {D_STR_W_LEN("a+b"), D_STR_W_LEN("a b")},
+  {D_STR_W_LEN("%41%62%63"), D_STR_W_LEN("Abc")},
+  {D_STR_W_LEN("%2B+%2b"), D_STR_W_LEN("+ +")},
+  {D_STR_W_LEN("%"), D_STR_W_LEN("%")},
+  {D_STR_W_LEN("%4"), D_STR_W_LEN("%4")},
+  {D_STR_W_LEN("%4g%+1"), D_STR_W_LEN("%4g% 1")},
+  {D_STR_W_LEN("%%41"), D_STR_W_LEN("%A")},
+  {D_STR_W_LEN("long run without anything to decode"),
+   D_STR_W_LEN("long run without anything to decode")},
+  {D_STR_W_LEN("long run with a %20 and a + at the end%21"),
+   D_STR_W_LEN("long run with a   and a   at the end!")},
+  {D_STR_W_LEN("%e4%BD%A0%e5%A5%BD+%E4%B8%96%E7%95%8C......++"),
+   D_STR_W_LEN("\xe4\xbd\xa0\xe5\xa5\xbd \xe4\xb8\x96\xe7\x95\x8c......  ")}
+};
+
+
+int check_str_form_decode(void)
+{
+  int t_failed = 0;
+  size_t i;
+  size_t off;
+  size_t rs;
+  static const size_t n_checks = sizeof(form_strings) / sizeof(form_strings[0]);
+  char buf[128];
+
+  for(i = 0; i < n_checks; i++)
+    {
+      const struct two_strs * const t = form_strings + i;
+
+      /* decode at every alignment to exercise word-wise scanning */
+      for(off = 0; off < 8; off++)
+        {
+          memcpy(buf + off, t->enc.str, t->enc.len + 1);
+          rs = MHD_str_form_decode_n_(buf + off, t->enc.len);
+          if (rs != t->dec.len || 0 != memcmp(buf + off, t->dec.str, t->dec.len + 1))
+            {
+              t_failed++;
+              fprintf(stderr, "FAILED: MHD_str_form_decode_n_(\"%s\") returned %u, while expecting \"%s\".\n",
+                      n_prnt(t->enc.str), (unsigned int) rs, n_prnt(t->dec.str));
+              break;
+            }
+        }
+      if (verbose > 1)
+        printf("PASSED: MHD_str_form_decode_n_(\"%s\") == \"%s\"\n",
+               n_prnt(t->enc.str), n_prnt(t->dec.str));
+    }
+  /* '+' is left alone when decoding URIs */
+  memcpy(buf, "a+b%20c%2B", sizeof("a+b%20c%2B"));
+  rs = MHD_str_pct_decode_n_(buf, strlen(buf));
+  if (rs != 6 || 0 != strcmp(buf, "a+b c+"))
+    {
+      t_failed++;
+      fprintf(stderr, "FAILED: MHD_str_pct_decode_n_(\"a+b%%20c%%2B\") resulted in \"%s\", while expecting \"a+b c+\".\n",
+              n_prnt(buf));
+    }
+  return t_failed;
+}
+
+
+int check_str_find_any3(void)
+{
+  int t_failed = 0;
+  size_t len;
+  size_t pos;
+  size_t rs;
+  char buf[64];
+
+  for(len = 0; len < sizeof(buf); len++)
+    {
+      memset(buf, 'x', sizeof(buf));
+      rs = MHD_str_find_any3_n_(buf, len, '&', '\r', '\n');
+      if (rs != len)
+        {
+          t_failed++;
+          fprintf(stderr, "FAILED: MHD_str_find_any3_n_() found delimiter in %u bytes without one.\n",
+                  (unsigned int) len);
+        }
+      for(pos = 0; pos < len; pos++)
+        {
+          buf[pos] = "&\r\n"[pos % 3];
+          if (pos + 1 < len)
+            buf[pos + 1] = '\n'; /* a later match must not be returned */
+          rs = MHD_str_find_any3_n_(buf, len, '&', '\r', '\n');
+          if (rs != pos)
+            {
+              t_failed++;
+              fprintf(stderr, "FAILED: MHD_str_find_any3_n_() returned %u, while expecting %u.\n",
+                      (unsigned int) rs, (unsigned int) pos);
+            }
+          buf[pos] = 'x';
+          if (pos + 1 < len)
+            buf[pos + 1] = 'x';
+        }
+    }
+  return t_failed;
+}
+
+
+int run_str_unescape_tests(void)
+{
+  int res;
+  int fails = 0;
+
+  res = check_str_form_decode();
+  if (res != 0)
+    {
+      fails += res;
+      fprintf(stderr, "FAILED: testcase check_str_form_decode() failed.\n\n");
+    }
+  else if (verbose > 1)
+    printf("PASSED: testcase check_str_form_decode() successfully passed.\n\n");
+
+  res = check_str_find_any3();
+  if (res != 0)
+    {
+      fails += res;
+      fprintf(stderr, "FAILED: testcase check_str_find_any3() failed.\n\n");
+    }
+  else if (verbose > 1)
+    printf("PASSED: testcase check_str_find_any3() successfully passed.\n\n");
+
+  if (fails)
+    {
+      if (verbose > 0)
+        printf("At least one test failed.\n");
+
+      return 1;
+    }
+
+  if (verbose > 0)
+    printf("All tests passed successfully.\n");
+
+  return 0;
+}
+
+
 int main(int argc, char * argv[])
 {
   if (has_param(argc, argv, "-v") || has_param(argc, argv, "--verbose") || has_param(argc, argv, "--verbose1"))
@@ -3492,5 +3641,8 @@ int main(int argc, char * argv[])
   if (has_in_name(argv[0], "_to_value"))
     return run_str_to_X_tests();
 
+  if (has_in_name(argv[0], "_unescape"))
+    return run_str_unescape_tests();
+
   return run_eq_neq_str_tests();
 }
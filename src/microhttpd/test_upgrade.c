@@ -94,6 +94,238 @@ test_upgrade (int flags,
 }
 
 
+/**
+ * Handle for the upgraded WebSocket connection.
+ */
+static struct MHD_UpgradeResponseHandle *ws_urh;
+
+/**
+ * Set to 1 once the client sent a close frame.
+ */
+static int ws_closed;
+
+
+/**
+ * Echo messages of the client, answer the close frame.
+ */
+static int
+ws_message_cb (void *cls,
+               enum MHD_WebSocketOpcode opcode,
+               const char *data,
+               size_t size,
+               int last)
+{
+  char frame[MHD_WEBSOCKET_MAX_HEADER_SIZE + 125];
+  size_t hsize;
+
+  if ( (MHD_WEBSOCKET_OPCODE_PONG == opcode) ||
+       (size > 125) )
+    return MHD_YES;
+  if (MHD_WEBSOCKET_OPCODE_CLOSE == opcode)
+    ws_closed = 1;
+  hsize = MHD_websocket_encode_header (frame,
+                                       (MHD_WEBSOCKET_OPCODE_PING == opcode)
+                                       ? MHD_WEBSOCKET_OPCODE_PONG
+                                       : opcode,
+                                       last,
+                                       size);
+  memcpy (&frame[hsize], data, size);
+  if ((ssize_t) (hsize + size) !=
+      MHD_upgrade_send (ws_urh,
+                        frame,
+                        hsize + size))
+    abort ();
+  return MHD_YES;
+}
+
+
+/**
+ * Main function for the thread that runs the server side of the
+ * WebSocket connection.
+ *
+ * @param cls the handle for the upgrade
+ */
+static void *
+run_ws (void *cls)
+{
+  struct MHD_WebSocket *ws;
+  char buf[64];
+  ssize_t got;
+
+  ws_urh = cls;
+  ws_closed = 0;
+  make_blocking (usock);
+  ws = MHD_websocket_create (1024,
+                             &ws_message_cb,
+                             NULL);
+  if (NULL == ws)
+    abort ();
+  while (! ws_closed)
+    {
+      got = MHD_upgrade_recv (ws_urh,
+                              buf,
+                              sizeof (buf));
+      if ( (-1 == got) &&
+           (EAGAIN == errno) )
+        continue;
+      if ( (got <= 0) ||
+           (MHD_YES != MHD_websocket_decode (ws, buf, got)) )
+        abort ();
+    }
+  MHD_websocket_destroy (ws);
+  MHD_upgrade_action (ws_urh,
+                      MHD_UPGRADE_ACTION_CLOSE);
+  return NULL;
+}
+
+
+static void
+ws_upgrade_cb (void *cls,
+               struct MHD_Connection *connection,
+               void *con_cls,
+               const char *extra_in,
+               size_t extra_in_size,
+               MHD_socket sock,
+               struct MHD_UpgradeResponseHandle *urh)
+{
+  usock = sock;
+  if (0 != extra_in_size)
+    abort ();
+  if (0 != pthread_create (&pt,
+                           NULL,
+                           &run_ws,
+                           urh))
+    abort ();
+}
+
+
+static int
+ahc_websocket (void *cls,
+               struct MHD_Connection *connection,
+               const char *url,
+               const char *method,
+               const char *version,
+               const char *upload_data,
+               size_t *upload_data_size,
+               void **con_cls)
+{
+  struct MHD_Response *resp;
+  int ret;
+
+  resp = MHD_create_response_for_websocket (connection,
+                                            &ws_upgrade_cb,
+                                            NULL);
+  if (NULL == resp)
+    abort ();
+  ret = MHD_queue_response (connection,
+                            MHD_HTTP_SWITCHING_PROTOCOLS,
+                            resp);
+  MHD_destroy_response (resp);
+  return ret;
+}
+
+
+/**
+ * Client side of #test_websocket(): the handshake example and the
+ * masked "Hello" frame of RFC 6455, then a close frame.
+ *
+ * @param cls the client socket
+ */
+static void *
+run_ws_client (void *cls)
+{
+  MHD_socket *sock = cls;
+  char hdr[512];
+  size_t len;
+
+  send_all (*sock,
+            "GET /chat HTTP/1.1\r\n"
+            "Host: localhost\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: keep-alive, Upgrade\r\n"
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+            "Sec-WebSocket-Version: 13\r\n\r\n");
+  make_blocking (*sock);
+  len = 0;
+  while ( (len < 4) ||
+          (0 != memcmp (&hdr[len - 4], "\r\n\r\n", 4)) )
+    {
+      if ( (len == sizeof (hdr) - 1) ||
+           (1 != read (*sock, &hdr[len], 1)) )
+        abort ();
+      len++;
+    }
+  hdr[len] = '\0';
+  if ( (NULL == strstr (hdr, " 101 ")) ||
+       (NULL == strstr (hdr, "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n")) )
+    abort ();
+  send_all (*sock,
+            "\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58");
+  recv_all (*sock,
+            "\x81\x05Hello");
+  /* empty close frame with a zero mask */
+  if (6 != write (*sock, "\x88\x80\0\0\0\0", 6))
+    abort ();
+  len = 0;
+  while (len < 2)
+    {
+      if (1 != read (*sock, &hdr[len], 1))
+        abort ();
+      len++;
+    }
+  if ( ((char) 0x88 != hdr[0]) ||
+       (0 != hdr[1]) )
+    abort ();
+  MHD_socket_close_chk_ (*sock);
+  done = 1;
+  return NULL;
+}
+
+
+/**
+ * Test the WebSocket handshake and echo a message.
+ *
+ * @param flags which event loop style should be tested
+ */
+static int
+test_websocket (int flags)
+{
+  struct MHD_Daemon *d;
+  MHD_socket sock;
+  struct sockaddr_in sa;
+
+  done = 0;
+  d = MHD_start_daemon (flags | MHD_USE_DEBUG | MHD_USE_SUSPEND_RESUME,
+                        1080,
+                        NULL, NULL,
+                        &ahc_websocket, NULL,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 2;
+  sock = socket (AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (MHD_INVALID_SOCKET == sock)
+    abort ();
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons (1080);
+  sa.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  if (0 != connect (sock,
+                    (struct sockaddr *) &sa,
+                    sizeof (sa)))
+    abort ();
+  if (0 != pthread_create (&pt_client,
+                           NULL,
+                           &run_ws_client,
+                           &sock))
+    abort ();
+  pthread_join (pt_client,
+                NULL);
+  pthread_join (pt,
+                NULL);
+  MHD_stop_daemon (d);
+  return 0;
+}
+
+
 int
 main (int argc,
       char *const *argv)
@@ -131,6 +363,12 @@ main (int argc,
   error_count += test_upgrade (MHD_USE_EPOLL_INTERNALLY,
                                2);
 #endif
+
+  /* WebSocket handshake and framing */
+  error_count += test_websocket (MHD_USE_SELECT_INTERNALLY);
+#ifdef EPOLL_SUPPORT
+  error_count += test_websocket (MHD_USE_EPOLL_INTERNALLY);
+#endif
   /* report result */
   if (0 != error_count)
     fprintf (stderr,
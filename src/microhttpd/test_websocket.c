@@ -0,0 +1,384 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 3, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file test_websocket.c
+ * @brief  Testcase for the WebSocket handshake and frame codec
+ * @author libmicrohttpd contributors
+ */
+
+#include "websocket.h"
+#include <stdio.h>
+
+/**
+ * Size of the payload used by #test_large().
+ */
+#define LARGE_SIZE 70001
+
+
+/**
+ * What the message callback saw.
+ */
+struct Result
+{
+  /**
+   * Concatenated chunks of the data messages.
+   */
+  char data[LARGE_SIZE];
+
+  /**
+   * Bytes in @e data.
+   */
+  size_t data_size;
+
+  /**
+   * Number of data messages completed.
+   */
+  unsigned int messages;
+
+  /**
+   * Opcode of the last data message.
+   */
+  enum MHD_WebSocketOpcode opcode;
+
+  /**
+   * Payload of the last control frame.
+   */
+  char control[126];
+
+  /**
+   * Number of control frames.
+   */
+  unsigned int controls;
+
+  /**
+   * Opcode of the last control frame.
+   */
+  enum MHD_WebSocketOpcode control_opcode;
+
+  /**
+   * Value to return from the callback.
+   */
+  int ret;
+};
+
+
+static int
+message_cb (void *cls,
+            enum MHD_WebSocketOpcode opcode,
+            const char *data,
+            size_t size,
+            int last)
+{
+  struct Result *r = cls;
+
+  if (opcode >= MHD_WEBSOCKET_OPCODE_CLOSE)
+    {
+      memcpy (r->control, data, size);
+      r->control[size] = '\0';
+      r->control_opcode = opcode;
+      r->controls++;
+      return r->ret;
+    }
+  memcpy (&r->data[r->data_size], data, size);
+  r->data_size += size;
+  r->opcode = opcode;
+  if (MHD_YES == last)
+    r->messages++;
+  return r->ret;
+}
+
+
+/**
+ * Append a masked client frame to @a buf.
+ *
+ * @param buf where to write the frame
+ * @param first_byte FIN, RSV and opcode bits
+ * @param payload the payload
+ * @param size number of bytes in @a payload
+ * @return size of the frame
+ */
+static size_t
+client_frame (char *buf,
+              unsigned char first_byte,
+              const char *payload,
+              size_t size)
+{
+  static const unsigned char mask[4] = { 0x37, 0xfa, 0x21, 0x3d };
+  size_t hsize;
+
+  hsize = MHD_websocket_encode_header (buf,
+                                       MHD_WEBSOCKET_OPCODE_CONTINUATION,
+                                       MHD_NO,
+                                       size);
+  buf[0] = (char) first_byte;
+  buf[1] = (char) (buf[1] | 0x80);
+  memcpy (&buf[hsize], mask, 4);
+  memcpy (&buf[hsize + 4], payload, size);
+  MHD_websocket_unmask_ (&buf[hsize + 4], size, mask, 0);
+  return hsize + 4 + size;
+}
+
+
+static int
+test_accept ()
+{
+  char accept[MHD_WEBSOCKET_ACCEPT_SIZE];
+
+  /* example from RFC 6455, section 1.3 */
+  MHD_websocket_accept_ ("dGhlIHNhbXBsZSBub25jZQ==",
+                         accept);
+  if (0 != strcmp (accept,
+                   "s3pPLMBiTxaQ9kYGzzhZRbK+xOo="))
+    {
+      fprintf (stderr,
+               "Wrong accept value `%s'\n",
+               accept);
+      return 1;
+    }
+  return 0;
+}
+
+
+static int
+test_encode ()
+{
+  char h[MHD_WEBSOCKET_MAX_HEADER_SIZE];
+
+  if ( (2 != MHD_websocket_encode_header (h, MHD_WEBSOCKET_OPCODE_TEXT,
+                                          MHD_YES, 125)) ||
+       ((char) 0x81 != h[0]) ||
+       (125 != h[1]) )
+    return 2;
+  if ( (4 != MHD_websocket_encode_header (h, MHD_WEBSOCKET_OPCODE_BINARY,
+                                          MHD_NO, 65535)) ||
+       (0x02 != h[0]) ||
+       (126 != h[1]) ||
+       ((char) 0xff != h[2]) ||
+       ((char) 0xff != h[3]) )
+    return 2;
+  if ( (10 != MHD_websocket_encode_header (h, MHD_WEBSOCKET_OPCODE_PING,
+                                           MHD_YES, 65536)) ||
+       ((char) 0x89 != h[0]) ||
+       (127 != h[1]) ||
+       (0 != h[6]) ||
+       (1 != h[7]) ||
+       (0 != h[8]) ||
+       (0 != h[9]) )
+    return 2;
+  return 0;
+}
+
+
+/**
+ * A fragmented text message with a ping in between, decoded in one
+ * call and byte by byte.
+ */
+static int
+test_fragments ()
+{
+  static struct Result r;
+  struct MHD_WebSocket *ws;
+  char buf[256];
+  size_t size;
+  size_t i;
+  int split;
+
+  for (split = 0; split < 2; split++)
+    {
+      size = client_frame (buf, 0x01, "Hel", 3);
+      size += client_frame (&buf[size], 0x89, "ping", 4);
+      size += client_frame (&buf[size], 0x00, "", 0);
+      size += client_frame (&buf[size], 0x80, "lo", 2);
+      size += client_frame (&buf[size], 0x82, "", 0);
+      memset (&r, 0, sizeof (r));
+      r.ret = MHD_YES;
+      ws = MHD_websocket_create (0, &message_cb, &r);
+      if (NULL == ws)
+        return 4;
+      if (0 == split)
+        {
+          if (MHD_YES != MHD_websocket_decode (ws, buf, size))
+            r.ret = MHD_NO;
+        }
+      else
+        {
+          for (i = 0; i < size; i++)
+            if (MHD_YES != MHD_websocket_decode (ws, &buf[i], 1))
+              r.ret = MHD_NO;
+        }
+      MHD_websocket_destroy (ws);
+      if ( (MHD_YES != r.ret) ||
+           (2 != r.messages) ||
+           (MHD_WEBSOCKET_OPCODE_BINARY != r.opcode) ||
+           (5 != r.data_size) ||
+           (0 != memcmp (r.data, "Hello", 5)) ||
+           (1 != r.controls) ||
+           (MHD_WEBSOCKET_OPCODE_PING != r.control_opcode) ||
+           (0 != strcmp (r.control, "ping")) )
+        return 4;
+    }
+  return 0;
+}
+
+
+/**
+ * A frame with a 64-bit length, split at odd positions so that the
+ * word-wise unmasking starts at every phase of the mask.
+ */
+static int
+test_large ()
+{
+  static struct Result r;
+  static char payload[LARGE_SIZE];
+  static char buf[LARGE_SIZE + 14];
+  struct MHD_WebSocket *ws;
+  size_t size;
+  size_t off;
+  size_t chunk;
+  size_t i;
+
+  for (i = 0; i < LARGE_SIZE; i++)
+    payload[i] = (char) (i * 7 + i / 251);
+  size = client_frame (buf, 0x82, payload, LARGE_SIZE);
+  memset (&r, 0, sizeof (r));
+  r.ret = MHD_YES;
+  ws = MHD_websocket_create (LARGE_SIZE, &message_cb, &r);
+  if (NULL == ws)
+    return 8;
+  off = 0;
+  chunk = 1;
+  while (off < size)
+    {
+      if (chunk > size - off)
+        chunk = size - off;
+      if (MHD_YES != MHD_websocket_decode (ws, &buf[off], chunk))
+        break;
+      off += chunk;
+      chunk = chunk * 3 + 5;
+    }
+  MHD_websocket_destroy (ws);
+  if ( (off != size) ||
+       (1 != r.messages) ||
+       (LARGE_SIZE != r.data_size) ||
+       (0 != memcmp (r.data, payload, LARGE_SIZE)) )
+    return 8;
+  return 0;
+}
+
+
+/**
+ * Decode @a size bytes of @a buf with a fresh decoder.
+ *
+ * @return result of #MHD_websocket_decode()
+ */
+static int
+decode_once (char *buf,
+             size_t size,
+             uint64_t max_message_size,
+             int cb_ret)
+{
+  static struct Result r;
+  struct MHD_WebSocket *ws;
+  int ret;
+
+  memset (&r, 0, sizeof (r));
+  r.ret = cb_ret;
+  ws = MHD_websocket_create (max_message_size, &message_cb, &r);
+  if (NULL == ws)
+    return MHD_NO;
+  ret = MHD_websocket_decode (ws, buf, size);
+  MHD_websocket_destroy (ws);
+  return ret;
+}
+
+
+static int
+test_errors ()
+{
+  char buf[256];
+  size_t size;
+  int ret;
+
+  ret = 0;
+  /* not masked */
+  size = client_frame (buf, 0x81, "abc", 3);
+  buf[1] = (char) (buf[1] & 0x7f);
+  if (MHD_NO != decode_once (buf, size, 0, MHD_YES))
+    ret = 16;
+  /* RSV bit without extension */
+  size = client_frame (buf, 0xc1, "abc", 3);
+  if (MHD_NO != decode_once (buf, size, 0, MHD_YES))
+    ret = 16;
+  /* fragmented control frame */
+  size = client_frame (buf, 0x09, "abc", 3);
+  if (MHD_NO != decode_once (buf, size, 0, MHD_YES))
+    ret = 16;
+  /* continuation without a message */
+  size = client_frame (buf, 0x80, "abc", 3);
+  if (MHD_NO != decode_once (buf, size, 0, MHD_YES))
+    ret = 16;
+  /* new message before the last one is finished */
+  size = client_frame (buf, 0x01, "abc", 3);
+  size += client_frame (&buf[size], 0x81, "abc", 3);
+  if (MHD_NO != decode_once (buf, size, 0, MHD_YES))
+    ret = 16;
+  /* reserved opcode */
+  size = client_frame (buf, 0x83, "abc", 3);
+  if (MHD_NO != decode_once (buf, size, 0, MHD_YES))
+    ret = 16;
+  /* message too large, over two frames */
+  size = client_frame (buf, 0x01, "abc", 3);
+  size += client_frame (&buf[size], 0x80, "abc", 3);
+  if (MHD_NO != decode_once (buf, size, 5, MHD_YES))
+    ret = 16;
+  size = client_frame (buf, 0x01, "abc", 3);
+  size += client_frame (&buf[size], 0x80, "abc", 3);
+  if (MHD_YES != decode_once (buf, size, 6, MHD_YES))
+    ret = 16;
+  /* data after a close frame */
+  size = client_frame (buf, 0x88, "", 0);
+  if (MHD_YES != decode_once (buf, size, 0, MHD_YES))
+    ret = 16;
+  size += client_frame (&buf[size], 0x81, "abc", 3);
+  if (MHD_NO != decode_once (buf, size, 0, MHD_YES))
+    ret = 16;
+  /* callback asks to stop */
+  size = client_frame (buf, 0x81, "abc", 3);
+  if (MHD_NO != decode_once (buf, size, 0, MHD_NO))
+    ret = 16;
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+
+  errorCount += test_accept ();
+  errorCount += test_encode ();
+  errorCount += test_fragments ();
+  errorCount += test_large ();
+  errorCount += test_errors ();
+  if (errorCount != 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  return errorCount != 0;       /* 0 == pass */
+}
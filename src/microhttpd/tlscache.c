@@ -0,0 +1,453 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/tlscache.c
+ * @brief  cache of TLS sessions for session resumption
+ * @author libmicrohttpd contributors
+ *
+ * GnuTLS hands us the parameters of each new session, which we
+ * keep under the session ID; a client that presents the ID again
+ * can then resume the session with an abbreviated handshake.
+ * GnuTLS checks the age of the parameters it gets back, so entries
+ * are only ever replaced when their set is full.  Like the nonce
+ * table, the cache is set-associative with striped locks, and a
+ * new session replaces the least recently used entry of its set.
+ * One cache is shared by all threads of a daemon.
+ */
+#include "tlscache.h"
+#include "mhd_locks.h"
+#include "mhd_siphash.h"
+
+
+/**
+ * Number of entries per set.
+ */
+#define TLS_CACHE_WAYS 4
+
+/**
+ * Number of locks, must be a power of two.
+ */
+#define TLS_CACHE_LOCKS 16
+
+/**
+ * Maximum length of a session ID (as in TLS 1.2).
+ */
+#define TLS_CACHE_MAX_ID 32
+
+
+/**
+ * Parameters of a TLS session.
+ */
+struct TLSCacheEntry
+{
+  /**
+   * Value of the lock's clock when the entry was last used,
+   * to find the least recently used entry of a set.
+   */
+  uint64_t last_use;
+
+  /**
+   * Hash of the session ID.
+   */
+  uint64_t hash;
+
+  /**
+   * Session parameters as given by GnuTLS, NULL if the entry is
+   * unused.
+   */
+  void *data;
+
+  /**
+   * Number of bytes in @e data.
+   */
+  size_t data_size;
+
+  /**
+   * Number of bytes in @e id.
+   */
+  size_t id_size;
+
+  /**
+   * The session ID.
+   */
+  uint8_t id[TLS_CACHE_MAX_ID];
+};
+
+
+/**
+ * Lock for a group of sets.
+ */
+struct TLSCacheLock
+{
+  /**
+   * Protects all sets that map to this lock.
+   */
+  MHD_mutex_ lock;
+
+  /**
+   * Incremented whenever an entry of one of the sets is used.
+   */
+  uint64_t clock;
+};
+
+
+/**
+ * Cache of TLS sessions.
+ */
+struct MHD_TLSSessionCache
+{
+  /**
+   * Locks, set N uses lock N modulo #TLS_CACHE_LOCKS.
+   */
+  struct TLSCacheLock locks[TLS_CACHE_LOCKS];
+
+  /**
+   * The entries, #TLS_CACHE_WAYS consecutive entries per set.
+   */
+  struct TLSCacheEntry *entries;
+
+  /**
+   * Number of sets.
+   */
+  uint32_t num_sets;
+
+  /**
+   * Key for hashing session IDs.
+   */
+  uint64_t key[2];
+};
+
+
+/**
+ * Free session parameters, clearing the secrets in them first.
+ *
+ * @param data session parameters, may be NULL
+ * @param data_size number of bytes in @a data
+ */
+static void
+free_data (void *data,
+           size_t data_size)
+{
+  volatile uint8_t *p = data;
+
+  if (NULL == data)
+    return;
+  while (0 != data_size--)
+    *p++ = 0;
+  free (data);
+}
+
+
+/**
+ * Create a cache of TLS sessions.
+ *
+ * @param size number of sessions to remember
+ * @return NULL on error; errno is ENOSYS if no random bytes
+ *         were available for the hash key, otherwise we ran out
+ *         of memory
+ */
+struct MHD_TLSSessionCache *
+MHD_tls_session_cache_create_ (unsigned int size)
+{
+  struct MHD_TLSSessionCache *cache;
+  uint32_t num_sets;
+  unsigned int i;
+  unsigned int j;
+
+  num_sets = (size + TLS_CACHE_WAYS - 1) / TLS_CACHE_WAYS;
+  if (0 == num_sets)
+    num_sets = 1;
+  if (NULL == (cache = malloc (sizeof (struct MHD_TLSSessionCache))))
+    return NULL;
+  if (NULL == (cache->entries = calloc ((size_t) num_sets * TLS_CACHE_WAYS,
+                                        sizeof (struct TLSCacheEntry))))
+    {
+      free (cache);
+      return NULL;
+    }
+  for (i = 0; i < TLS_CACHE_LOCKS; i++)
+    {
+      if (! MHD_mutex_init_ (&cache->locks[i].lock))
+        {
+          for (j = 0; j < i; j++)
+            MHD_mutex_destroy_chk_ (&cache->locks[j].lock);
+          free (cache->entries);
+          free (cache);
+          return NULL;
+        }
+      cache->locks[i].clock = 0;
+    }
+  cache->num_sets = num_sets;
+  if (MHD_YES != MHD_siphash_key_ (cache->key,
+                                   NULL,
+                                   0))
+    {
+      MHD_tls_session_cache_destroy_ (cache);
+      errno = ENOSYS; /* destroy may have changed it */
+      return NULL;
+    }
+  return cache;
+}
+
+
+/**
+ * Destroy a cache created with #MHD_tls_session_cache_create_().
+ *
+ * @param cache the cache to destroy, may be NULL
+ */
+void
+MHD_tls_session_cache_destroy_ (struct MHD_TLSSessionCache *cache)
+{
+  size_t i;
+
+  if (NULL == cache)
+    return;
+  for (i = 0; i < (size_t) cache->num_sets * TLS_CACHE_WAYS; i++)
+    free_data (cache->entries[i].data,
+               cache->entries[i].data_size);
+  for (i = 0; i < TLS_CACHE_LOCKS; i++)
+    MHD_mutex_destroy_chk_ (&cache->locks[i].lock);
+  free (cache->entries);
+  free (cache);
+}
+
+
+/**
+ * Find the set of a session ID and lock it.
+ *
+ * @param cache the cache
+ * @param id the session ID
+ * @param[out] hash set to the hash of @a id
+ * @param[out] set set to the first entry of the set
+ * @param[out] entry set to the entry with @a id, NULL if there is none
+ * @return the lock that was locked
+ */
+static struct TLSCacheLock *
+lock_set (struct MHD_TLSSessionCache *cache,
+          const gnutls_datum_t *id,
+          uint64_t *hash,
+          struct TLSCacheEntry **set,
+          struct TLSCacheEntry **entry)
+{
+  struct TLSCacheLock *lk;
+  uint32_t set_idx;
+  unsigned int i;
+
+  *hash = MHD_siphash24_ (cache->key,
+                          id->data,
+                          id->size);
+  set_idx = (uint32_t) *hash % cache->num_sets;
+  *set = &cache->entries[(size_t) set_idx * TLS_CACHE_WAYS];
+  lk = &cache->locks[set_idx & (TLS_CACHE_LOCKS - 1)];
+  MHD_mutex_lock_chk_ (&lk->lock);
+  *entry = NULL;
+  for (i = 0; i < TLS_CACHE_WAYS; i++)
+    {
+      if ( (NULL != (*set)[i].data) &&
+           (*hash == (*set)[i].hash) &&
+           (id->size == (*set)[i].id_size) &&
+           (0 == memcmp (id->data,
+                         (*set)[i].id,
+                         id->size)) )
+        {
+          *entry = &(*set)[i];
+          break;
+        }
+    }
+  return lk;
+}
+
+
+/**
+ * Store the parameters of a new session, called by GnuTLS.
+ *
+ * @param cls the `struct MHD_TLSSessionCache`
+ * @param id the session ID
+ * @param data the session parameters
+ * @return 0 on success, a negative value on error
+ */
+static int
+store_session (void *cls,
+               gnutls_datum_t id,
+               gnutls_datum_t data)
+{
+  struct MHD_TLSSessionCache *cache = cls;
+  struct TLSCacheEntry *set;
+  struct TLSCacheEntry *e;
+  struct TLSCacheLock *lk;
+  uint64_t hash;
+  void *copy;
+  void *old;
+  size_t old_size;
+  unsigned int i;
+
+  if ( (0 == id.size) ||
+       (TLS_CACHE_MAX_ID < id.size) ||
+       (0 == data.size) )
+    return GNUTLS_E_DB_ERROR;
+  if (NULL == (copy = malloc (data.size)))
+    return GNUTLS_E_DB_ERROR;
+  memcpy (copy,
+          data.data,
+          data.size);
+  lk = lock_set (cache,
+                 &id,
+                 &hash,
+                 &set,
+                 &e);
+  if (NULL == e)
+    {
+      e = &set[0];
+      for (i = 0; i < TLS_CACHE_WAYS; i++)
+        {
+          if (NULL == set[i].data)
+            {
+              e = &set[i];
+              break;
+            }
+          if (set[i].last_use < e->last_use)
+            e = &set[i];
+        }
+      e->hash = hash;
+      e->id_size = id.size;
+      memcpy (e->id,
+              id.data,
+              id.size);
+    }
+  old = e->data;
+  old_size = e->data_size;
+  e->data = copy;
+  e->data_size = data.size;
+  e->last_use = ++lk->clock;
+  MHD_mutex_unlock_chk_ (&lk->lock);
+  free_data (old,
+             old_size);
+  return 0;
+}
+
+
+/**
+ * Look up the parameters of a session to resume, called by GnuTLS.
+ *
+ * @param cls the `struct MHD_TLSSessionCache`
+ * @param id the session ID
+ * @return copy of the session parameters (allocated with
+ *         gnutls_malloc()), empty if the session is unknown
+ */
+static gnutls_datum_t
+retrieve_session (void *cls,
+                  gnutls_datum_t id)
+{
+  struct MHD_TLSSessionCache *cache = cls;
+  struct TLSCacheEntry *set;
+  struct TLSCacheEntry *e;
+  struct TLSCacheLock *lk;
+  uint64_t hash;
+  gnutls_datum_t res;
+
+  res.data = NULL;
+  res.size = 0;
+  if ( (0 == id.size) ||
+       (TLS_CACHE_MAX_ID < id.size) )
+    return res;
+  lk = lock_set (cache,
+                 &id,
+                 &hash,
+                 &set,
+                 &e);
+  if ( (NULL != e) &&
+       (NULL != (res.data = gnutls_malloc (e->data_size))) )
+    {
+      memcpy (res.data,
+              e->data,
+              e->data_size);
+      res.size = e->data_size;
+      e->last_use = ++lk->clock;
+    }
+  MHD_mutex_unlock_chk_ (&lk->lock);
+  return res;
+}
+
+
+/**
+ * Forget a session, called by GnuTLS if the session failed or
+ * its parameters expired.
+ *
+ * @param cls the `struct MHD_TLSSessionCache`
+ * @param id the session ID
+ * @return 0 on success, a negative value if the session is unknown
+ */
+static int
+remove_session (void *cls,
+                gnutls_datum_t id)
+{
+  struct MHD_TLSSessionCache *cache = cls;
+  struct TLSCacheEntry *set;
+  struct TLSCacheEntry *e;
+  struct TLSCacheLock *lk;
+  uint64_t hash;
+  void *old;
+  size_t old_size;
+
+  if ( (0 == id.size) ||
+       (TLS_CACHE_MAX_ID < id.size) )
+    return GNUTLS_E_DB_ERROR;
+  lk = lock_set (cache,
+                 &id,
+                 &hash,
+                 &set,
+                 &e);
+  if (NULL == e)
+    {
+      MHD_mutex_unlock_chk_ (&lk->lock);
+      return GNUTLS_E_DB_ERROR;
+    }
+  old = e->data;
+  old_size = e->data_size;
+  e->data = NULL;
+  e->data_size = 0;
+  e->last_use = 0;
+  MHD_mutex_unlock_chk_ (&lk->lock);
+  free_data (old,
+             old_size);
+  return 0;
+}
+
+
+/**
+ * Make GnuTLS store the parameters of @a session in @a cache, and
+ * look up the sessions that clients ask to resume there.
+ *
+ * @param cache the cache
+ * @param session a new server session
+ */
+void
+MHD_tls_session_cache_attach_ (struct MHD_TLSSessionCache *cache,
+                               gnutls_session_t session)
+{
+  gnutls_db_set_ptr (session,
+                     cache);
+  gnutls_db_set_store_function (session,
+                                &store_session);
+  gnutls_db_set_retrieve_function (session,
+                                   &retrieve_session);
+  gnutls_db_set_remove_function (session,
+                                 &remove_session);
+}
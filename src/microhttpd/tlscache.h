@@ -0,0 +1,69 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/tlscache.h
+ * @brief  cache of TLS sessions for session resumption
+ * @author libmicrohttpd contributors
+ */
+#ifndef TLSCACHE_H
+#define TLSCACHE_H
+
+#include "internal.h"
+
+
+/**
+ * Cache of TLS session parameters, indexed by session ID.
+ */
+struct MHD_TLSSessionCache;
+
+
+/**
+ * Create a cache of TLS sessions.
+ *
+ * @param size number of sessions to remember
+ * @return NULL on error; errno is ENOSYS if no random bytes
+ *         were available for the hash key, otherwise we ran out
+ *         of memory
+ */
+struct MHD_TLSSessionCache *
+MHD_tls_session_cache_create_ (unsigned int size);
+
+
+/**
+ * Destroy a cache created with #MHD_tls_session_cache_create_().
+ *
+ * @param cache the cache to destroy, may be NULL
+ */
+void
+MHD_tls_session_cache_destroy_ (struct MHD_TLSSessionCache *cache);
+
+
+/**
+ * Make GnuTLS store the parameters of @a session in @a cache, and
+ * look up the sessions that clients ask to resume there.
+ *
+ * @param cache the cache
+ * @param session a new server session
+ */
+void
+MHD_tls_session_cache_attach_ (struct MHD_TLSSessionCache *cache,
+                               gnutls_session_t session);
+
+#endif
@@ -0,0 +1,253 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/tlshandshake.c
+ * @brief  thread pool for the steps of TLS handshakes
+ * @author libmicrohttpd contributors
+ *
+ * The public key operations of a full handshake take milliseconds,
+ * which would delay all other connections of an event loop.  When
+ * a connection in the handshake has data to process, its event loop
+ * suspends it (internally, invisible to the application) and queues
+ * it here; one of the threads of the pool calls gnutls_handshake()
+ * once (the sockets are non-blocking, so this does not wait for the
+ * network) and resumes the connection.
+ * The event loop then processes the result like that of a
+ * handshake step of its own: it waits for more data, starts
+ * processing HTTP or closes the connection.
+ */
+#include "tlshandshake.h"
+#include "mhd_locks.h"
+#include "mhd_threads.h"
+
+
+/**
+ * Threads that run the steps of TLS handshakes.
+ */
+struct MHD_TLSHandshakePool
+{
+  /**
+   * Protects the queue and @e shutdown.
+   */
+  MHD_mutex_ lock;
+
+  /**
+   * Counts the queued connections (and the threads that have to
+   * stop, once @e shutdown is set).
+   */
+  struct MHD_Semaphore *sem;
+
+  /**
+   * First connection in the queue.
+   */
+  struct MHD_Connection *head;
+
+  /**
+   * Last connection in the queue.
+   */
+  struct MHD_Connection *tail;
+
+  /**
+   * The threads.
+   */
+  MHD_thread_handle_ *threads;
+
+  /**
+   * Number of threads running.
+   */
+  unsigned int num_threads;
+
+  /**
+   * #MHD_YES once the pool was stopped.
+   */
+  int shutdown;
+};
+
+
+/**
+ * Main function of the threads of the pool.
+ *
+ * @param cls the `struct MHD_TLSHandshakePool`
+ * @return always 0 (on shutdown)
+ */
+static MHD_THRD_RTRN_TYPE_ MHD_THRD_CALL_SPEC_
+handshake_thread (void *cls)
+{
+  struct MHD_TLSHandshakePool *pool = cls;
+  struct MHD_Connection *connection;
+
+  while (1)
+    {
+      MHD_semaphore_down (pool->sem);
+      MHD_mutex_lock_chk_ (&pool->lock);
+      connection = pool->head;
+      if (NULL != connection)
+        {
+          pool->head = connection->cold->tls_handshake_next;
+          if (NULL == pool->head)
+            pool->tail = NULL;
+        }
+      MHD_mutex_unlock_chk_ (&pool->lock);
+      if (NULL == connection)
+        break; /* queue is empty after shutdown */
+      /* the event loop processes the result after the resumption */
+      connection->cold->tls_handshake_ret = gnutls_handshake (connection->cold->tls_session);
+      MHD_resume_connection_ (connection);
+    }
+  return (MHD_THRD_RTRN_TYPE_)0;
+}
+
+
+/**
+ * Create a pool of threads for TLS handshakes.
+ *
+ * @param num_threads number of threads
+ * @param stack_size size of the stack of each thread, 0 for default
+ * @return NULL on error
+ */
+struct MHD_TLSHandshakePool *
+MHD_tls_handshake_pool_create_ (unsigned int num_threads,
+                                size_t stack_size)
+{
+  struct MHD_TLSHandshakePool *pool;
+
+  if (NULL == (pool = malloc (sizeof (struct MHD_TLSHandshakePool))))
+    return NULL;
+  if (NULL == (pool->threads = malloc (num_threads
+                                       * sizeof (MHD_thread_handle_))))
+    {
+      free (pool);
+      return NULL;
+    }
+  if (NULL == (pool->sem = MHD_semaphore_create (0)))
+    {
+      free (pool->threads);
+      free (pool);
+      return NULL;
+    }
+  if (! MHD_mutex_init_ (&pool->lock))
+    {
+      MHD_semaphore_destroy (pool->sem);
+      free (pool->threads);
+      free (pool);
+      return NULL;
+    }
+  pool->head = NULL;
+  pool->tail = NULL;
+  pool->shutdown = MHD_NO;
+  for (pool->num_threads = 0; pool->num_threads < num_threads; pool->num_threads++)
+    {
+      if (! MHD_create_named_thread_ (&pool->threads[pool->num_threads],
+                                      "MHD-handshake",
+                                      stack_size,
+                                      &handshake_thread,
+                                      pool))
+        {
+          MHD_tls_handshake_pool_destroy_ (pool);
+          return NULL;
+        }
+    }
+  return pool;
+}
+
+
+/**
+ * Let the threads of the pool finish the queued handshake steps
+ * and stop them.  Afterwards, #MHD_tls_handshake_pool_submit_()
+ * fails.
+ *
+ * @param pool the pool, may be NULL
+ */
+void
+MHD_tls_handshake_pool_stop_ (struct MHD_TLSHandshakePool *pool)
+{
+  unsigned int i;
+
+  if (NULL == pool)
+    return;
+  MHD_mutex_lock_chk_ (&pool->lock);
+  if (MHD_YES == pool->shutdown)
+    {
+      MHD_mutex_unlock_chk_ (&pool->lock);
+      return;
+    }
+  pool->shutdown = MHD_YES;
+  MHD_mutex_unlock_chk_ (&pool->lock);
+  for (i = 0; i < pool->num_threads; i++)
+    MHD_semaphore_up (pool->sem);
+  for (i = 0; i < pool->num_threads; i++)
+    if (! MHD_join_thread_ (pool->threads[i]))
+      MHD_PANIC (_("Failed to join a thread\n"));
+}
+
+
+/**
+ * Stop the pool (if necessary) and free it.
+ *
+ * @param pool the pool, may be NULL
+ */
+void
+MHD_tls_handshake_pool_destroy_ (struct MHD_TLSHandshakePool *pool)
+{
+  if (NULL == pool)
+    return;
+  MHD_tls_handshake_pool_stop_ (pool);
+  MHD_mutex_destroy_chk_ (&pool->lock);
+  MHD_semaphore_destroy (pool->sem);
+  free (pool->threads);
+  free (pool);
+}
+
+
+/**
+ * Run the next step of the TLS handshake of @a connection in the
+ * pool.  The connection is suspended until the step is done; the
+ * result is then in its @e tls_handshake_ret.
+ *
+ * @param pool the pool
+ * @param connection connection in state #MHD_TLS_CONNECTION_INIT,
+ *        called from its event loop
+ * @return #MHD_YES if the step was queued, #MHD_NO if the pool
+ *         is stopped
+ */
+int
+MHD_tls_handshake_pool_submit_ (struct MHD_TLSHandshakePool *pool,
+                                struct MHD_Connection *connection)
+{
+  MHD_mutex_lock_chk_ (&pool->lock);
+  if (MHD_YES == pool->shutdown)
+    {
+      MHD_mutex_unlock_chk_ (&pool->lock);
+      return MHD_NO;
+    }
+  /* suspend before a thread can pick up (and resume) the connection */
+  connection->cold->tls_handshake_queued = MHD_YES;
+  MHD_suspend_connection_ (connection,
+                           MHD_YES);
+  connection->cold->tls_handshake_next = NULL;
+  if (NULL == pool->tail)
+    pool->head = connection;
+  else
+    pool->tail->cold->tls_handshake_next = connection;
+  pool->tail = connection;
+  MHD_mutex_unlock_chk_ (&pool->lock);
+  MHD_semaphore_up (pool->sem);
+  return MHD_YES;
+}
@@ -0,0 +1,84 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/tlshandshake.h
+ * @brief  thread pool for the steps of TLS handshakes
+ * @author libmicrohttpd contributors
+ */
+#ifndef TLSHANDSHAKE_H
+#define TLSHANDSHAKE_H
+
+#include "internal.h"
+
+
+/**
+ * Threads that run the steps of TLS handshakes.
+ */
+struct MHD_TLSHandshakePool;
+
+
+/**
+ * Create a pool of threads for TLS handshakes.
+ *
+ * @param num_threads number of threads
+ * @param stack_size size of the stack of each thread, 0 for default
+ * @return NULL on error
+ */
+struct MHD_TLSHandshakePool *
+MHD_tls_handshake_pool_create_ (unsigned int num_threads,
+                                size_t stack_size);
+
+
+/**
+ * Let the threads of the pool finish the queued handshake steps
+ * and stop them.  Afterwards, #MHD_tls_handshake_pool_submit_()
+ * fails.
+ *
+ * @param pool the pool, may be NULL
+ */
+void
+MHD_tls_handshake_pool_stop_ (struct MHD_TLSHandshakePool *pool);
+
+
+/**
+ * Stop the pool (if necessary) and free it.
+ *
+ * @param pool the pool, may be NULL
+ */
+void
+MHD_tls_handshake_pool_destroy_ (struct MHD_TLSHandshakePool *pool);
+
+
+/**
+ * Run the next step of the TLS handshake of @a connection in the
+ * pool.  The connection is suspended until the step is done; the
+ * result is then in its @e tls_handshake_ret.
+ *
+ * @param pool the pool
+ * @param connection connection in state #MHD_TLS_CONNECTION_INIT,
+ *        called from its event loop
+ * @return #MHD_YES if the step was queued, #MHD_NO if the pool
+ *         is stopped
+ */
+int
+MHD_tls_handshake_pool_submit_ (struct MHD_TLSHandshakePool *pool,
+                                struct MHD_Connection *connection);
+
+#endif
@@ -0,0 +1,571 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/websocket.c
+ * @brief  WebSocket handshake and framing (RFC 6455)
+ * @author libmicrohttpd contributors
+ *
+ * The decoder never copies payload: it unmasks the data in the
+ * buffer of the application and passes pointers into it to the
+ * message callback, chunk by chunk.  Only control frames that are
+ * split over two buffers are collected (they have at most 125
+ * bytes).
+ */
+#include "websocket.h"
+#include "sha1.h"
+
+
+/**
+ * GUID appended to the key of the client (RFC 6455, 1.3).
+ */
+#define WEBSOCKET_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+/**
+ * Maximum size of the header of a frame from a client.
+ */
+#define MAX_CLIENT_HEADER_SIZE 14
+
+/**
+ * Maximum payload of a control frame.
+ */
+#define MAX_CONTROL_SIZE 125
+
+
+/**
+ * States of the decoder.
+ */
+enum WebSocketState
+{
+  /**
+   * Reading the header of a frame.
+   */
+  WS_STATE_HEADER = 0,
+
+  /**
+   * Reading the payload of a frame.
+   */
+  WS_STATE_PAYLOAD = 1,
+
+  /**
+   * A close frame was received or an error occured; no more
+   * data is accepted.
+   */
+  WS_STATE_DONE = 2
+};
+
+
+/**
+ * Decoder for the frames sent by a WebSocket client.
+ */
+struct MHD_WebSocket
+{
+  /**
+   * Function to call with the messages.
+   */
+  MHD_WebSocketMessageCallback cb;
+
+  /**
+   * Closure for @e cb.
+   */
+  void *cb_cls;
+
+  /**
+   * Maximum size of a message, 0 for no limit.
+   */
+  uint64_t max_message_size;
+
+  /**
+   * Size of the data message received so far.
+   */
+  uint64_t message_size;
+
+  /**
+   * Bytes of payload left in the current frame.
+   */
+  uint64_t left;
+
+  /**
+   * Bytes of payload of the current frame unmasked so far
+   * (modulo 4 is all that matters).
+   */
+  size_t mask_off;
+
+  /**
+   * Bytes in @e header.
+   */
+  size_t header_off;
+
+  /**
+   * Bytes in @e control.
+   */
+  size_t control_off;
+
+  /**
+   * Opcode of the data message in progress,
+   * #MHD_WEBSOCKET_OPCODE_CONTINUATION if there is none.
+   */
+  enum MHD_WebSocketOpcode message_opcode;
+
+  /**
+   * Opcode of the current frame.
+   */
+  enum MHD_WebSocketOpcode frame_opcode;
+
+  /**
+   * State of the decoder.
+   */
+  enum WebSocketState state;
+
+  /**
+   * #MHD_YES if the current frame is the last of its message.
+   */
+  int fin;
+
+  /**
+   * Masking key of the current frame.
+   */
+  unsigned char mask[4];
+
+  /**
+   * Header of the current frame, while it is incomplete.
+   */
+  unsigned char header[MAX_CLIENT_HEADER_SIZE];
+
+  /**
+   * Payload of a control frame that was split over several
+   * buffers.
+   */
+  char control[MAX_CONTROL_SIZE];
+};
+
+
+/**
+ * Compute the "Sec-WebSocket-Accept" value for the
+ * "Sec-WebSocket-Key" @a key of a client.
+ *
+ * @param key the key of the client, #MHD_WEBSOCKET_KEY_LENGTH
+ *        characters
+ * @param[out] accept where to write the 0-terminated value
+ */
+void
+MHD_websocket_accept_ (const char *key,
+                       char accept[MHD_WEBSOCKET_ACCEPT_SIZE])
+{
+  static const char b64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  struct SHA1Context ctx;
+  unsigned char digest[SHA1_DIGEST_SIZE];
+  uint32_t v;
+  size_t i;
+  size_t o;
+
+  SHA1Init (&ctx);
+  SHA1Update (&ctx,
+              (const unsigned char *) key,
+              MHD_WEBSOCKET_KEY_LENGTH);
+  SHA1Update (&ctx,
+              (const unsigned char *) WEBSOCKET_GUID,
+              strlen (WEBSOCKET_GUID));
+  SHA1Final (digest,
+             &ctx);
+  /* 20 bytes: six groups of three, then two bytes and one '=' */
+  o = 0;
+  for (i = 0; i < 18; i += 3)
+    {
+      v = ((uint32_t) digest[i] << 16) |
+        ((uint32_t) digest[i + 1] << 8) |
+        (uint32_t) digest[i + 2];
+      accept[o++] = b64[(v >> 18) & 63];
+      accept[o++] = b64[(v >> 12) & 63];
+      accept[o++] = b64[(v >> 6) & 63];
+      accept[o++] = b64[v & 63];
+    }
+  v = ((uint32_t) digest[18] << 16) |
+    ((uint32_t) digest[19] << 8);
+  accept[o++] = b64[(v >> 18) & 63];
+  accept[o++] = b64[(v >> 12) & 63];
+  accept[o++] = b64[(v >> 6) & 63];
+  accept[o++] = '=';
+  accept[o] = '\0';
+}
+
+
+/**
+ * XOR @a size bytes of @a data with the masking key @a mask,
+ * starting at position @a offset of the masked payload.
+ *
+ * @param data payload to (un)mask in place
+ * @param size number of bytes in @a data
+ * @param mask the masking key of the frame
+ * @param offset position of @a data in the payload of the frame
+ */
+void
+MHD_websocket_unmask_ (char *data,
+                       size_t size,
+                       const unsigned char mask[4],
+                       size_t offset)
+{
+  unsigned char word_mask[8];
+  uint64_t w;
+  uint64_t v;
+  size_t i;
+  size_t j;
+
+  i = 0;
+  while ( (i < size) &&
+          (0 != (((uintptr_t) &data[i]) & 7)) )
+    {
+      data[i] ^= mask[(offset + i) & 3];
+      i++;
+    }
+  if (size - i >= 8)
+    {
+      /* eight bytes at a time; as 8 is a multiple of 4, the mask
+         of the words does not change */
+      for (j = 0; j < 8; j++)
+        word_mask[j] = mask[(offset + i + j) & 3];
+      memcpy (&w, word_mask, 8);
+      for (; i + 8 <= size; i += 8)
+        {
+          memcpy (&v, &data[i], 8);
+          v ^= w;
+          memcpy (&data[i], &v, 8);
+        }
+    }
+  for (; i < size; i++)
+    data[i] ^= mask[(offset + i) & 3];
+}
+
+
+/**
+ * Create a decoder for the frames a WebSocket client sends.
+ *
+ * @param max_message_size maximum size of a (data) message,
+ *        0 for no limit
+ * @param cb function to call with the messages
+ * @param cb_cls closure for @a cb
+ * @return NULL on error (out of memory)
+ */
+_MHD_EXTERN struct MHD_WebSocket *
+MHD_websocket_create (uint64_t max_message_size,
+                      MHD_WebSocketMessageCallback cb,
+                      void *cb_cls)
+{
+  struct MHD_WebSocket *ws;
+
+  if (NULL == (ws = malloc (sizeof (struct MHD_WebSocket))))
+    return NULL;
+  memset (ws,
+          0,
+          sizeof (struct MHD_WebSocket));
+  ws->cb = cb;
+  ws->cb_cls = cb_cls;
+  ws->max_message_size = max_message_size;
+  ws->message_opcode = MHD_WEBSOCKET_OPCODE_CONTINUATION;
+  ws->state = WS_STATE_HEADER;
+  return ws;
+}
+
+
+/**
+ * Destroy a decoder.
+ *
+ * @param ws the decoder, may be NULL
+ */
+_MHD_EXTERN void
+MHD_websocket_destroy (struct MHD_WebSocket *ws)
+{
+  free (ws);
+}
+
+
+/**
+ * Pass a chunk of the payload of the current frame to the
+ * application.
+ *
+ * @param ws the decoder
+ * @param data the unmasked chunk
+ * @param size number of bytes in @a data
+ * @return #MHD_YES to continue, #MHD_NO if the application or the
+ *         protocol demands closing the connection
+ */
+static int
+deliver (struct MHD_WebSocket *ws,
+         const char *data,
+         size_t size)
+{
+  int last;
+
+  switch (ws->frame_opcode)
+    {
+    case MHD_WEBSOCKET_OPCODE_CLOSE:
+    case MHD_WEBSOCKET_OPCODE_PING:
+    case MHD_WEBSOCKET_OPCODE_PONG:
+      if (0 != ws->left)
+        {
+          /* collect split control frames */
+          memcpy (&ws->control[ws->control_off],
+                  data,
+                  size);
+          ws->control_off += size;
+          return MHD_YES;
+        }
+      if (0 != ws->control_off)
+        {
+          memcpy (&ws->control[ws->control_off],
+                  data,
+                  size);
+          data = ws->control;
+          size += ws->control_off;
+          ws->control_off = 0;
+        }
+      if (MHD_WEBSOCKET_OPCODE_CLOSE == ws->frame_opcode)
+        ws->state = WS_STATE_DONE;
+      return ws->cb (ws->cb_cls,
+                     ws->frame_opcode,
+                     data,
+                     size,
+                     MHD_YES);
+    default:
+      last = ( (0 == ws->left) &&
+               (MHD_YES == ws->fin) ) ? MHD_YES : MHD_NO;
+      if ( (0 == size) &&
+           (MHD_NO == last) )
+        return MHD_YES;
+      if (MHD_NO == ws->cb (ws->cb_cls,
+                            ws->message_opcode,
+                            data,
+                            size,
+                            last))
+        return MHD_NO;
+      if (MHD_YES == last)
+        {
+          ws->message_opcode = MHD_WEBSOCKET_OPCODE_CONTINUATION;
+          ws->message_size = 0;
+        }
+      return MHD_YES;
+    }
+}
+
+
+/**
+ * Check the complete header of a frame and prepare for its
+ * payload.
+ *
+ * @param ws the decoder, with the header in @e header
+ * @return #MHD_YES on success, #MHD_NO on protocol errors
+ */
+static int
+start_frame (struct MHD_WebSocket *ws)
+{
+  const unsigned char *h = ws->header;
+  enum MHD_WebSocketOpcode opcode;
+  uint64_t len;
+  size_t pos;
+
+  if (0 != (h[0] & 0x70))
+    return MHD_NO; /* no extensions negotiated, RSV bits must be 0 */
+  if (0 == (h[1] & 0x80))
+    return MHD_NO; /* clients must mask their frames */
+  opcode = (enum MHD_WebSocketOpcode) (h[0] & 0x0F);
+  ws->fin = (0 != (h[0] & 0x80)) ? MHD_YES : MHD_NO;
+  len = h[1] & 0x7F;
+  pos = 2;
+  if (126 == len)
+    {
+      len = ((uint64_t) h[2] << 8) | h[3];
+      pos = 4;
+    }
+  else if (127 == len)
+    {
+      len = 0;
+      for (pos = 2; pos < 10; pos++)
+        len = (len << 8) | h[pos];
+      if (0 != (len >> 63))
+        return MHD_NO;
+    }
+  memcpy (ws->mask,
+          &h[pos],
+          4);
+  switch (opcode)
+    {
+    case MHD_WEBSOCKET_OPCODE_CLOSE:
+    case MHD_WEBSOCKET_OPCODE_PING:
+    case MHD_WEBSOCKET_OPCODE_PONG:
+      if ( (MHD_NO == ws->fin) ||
+           (len > MAX_CONTROL_SIZE) )
+        return MHD_NO;
+      break;
+    case MHD_WEBSOCKET_OPCODE_TEXT:
+    case MHD_WEBSOCKET_OPCODE_BINARY:
+      if (MHD_WEBSOCKET_OPCODE_CONTINUATION != ws->message_opcode)
+        return MHD_NO; /* previous message not finished */
+      ws->message_opcode = opcode;
+      break;
+    case MHD_WEBSOCKET_OPCODE_CONTINUATION:
+      if (MHD_WEBSOCKET_OPCODE_CONTINUATION == ws->message_opcode)
+        return MHD_NO; /* no message to continue */
+      break;
+    default:
+      return MHD_NO;
+    }
+  if ( (MHD_WEBSOCKET_OPCODE_TEXT == opcode) ||
+       (MHD_WEBSOCKET_OPCODE_BINARY == opcode) ||
+       (MHD_WEBSOCKET_OPCODE_CONTINUATION == opcode) )
+    {
+      if ( (0 != ws->max_message_size) &&
+           (len > ws->max_message_size - ws->message_size) )
+        return MHD_NO;
+      ws->message_size += len;
+    }
+  ws->frame_opcode = opcode;
+  ws->left = len;
+  ws->mask_off = 0;
+  ws->header_off = 0;
+  ws->state = WS_STATE_PAYLOAD;
+  return MHD_YES;
+}
+
+
+/**
+ * Decode data received from a WebSocket client.  The payload is
+ * unmasked in place, and the message callback is called with
+ * pointers into @a data; for data messages, it may be called
+ * several times per message.
+ *
+ * @param ws the decoder
+ * @param data the data received, modified
+ * @param size number of bytes in @a data
+ * @return #MHD_YES on success, #MHD_NO if the connection should
+ *         be closed (protocol error, message too large, data after
+ *         a close frame or the callback returned #MHD_NO)
+ */
+_MHD_EXTERN int
+MHD_websocket_decode (struct MHD_WebSocket *ws,
+                      char *data,
+                      size_t size)
+{
+  size_t off;
+  size_t hsize;
+  size_t chunk;
+
+  off = 0;
+  while (off < size)
+    {
+      switch (ws->state)
+        {
+        case WS_STATE_HEADER:
+          while ( (ws->header_off < 2) &&
+                  (off < size) )
+            ws->header[ws->header_off++] = (unsigned char) data[off++];
+          if (ws->header_off < 2)
+            return MHD_YES;
+          hsize = 2 + 4;
+          if (126 == (ws->header[1] & 0x7F))
+            hsize += 2;
+          else if (127 == (ws->header[1] & 0x7F))
+            hsize += 8;
+          while ( (ws->header_off < hsize) &&
+                  (off < size) )
+            ws->header[ws->header_off++] = (unsigned char) data[off++];
+          if (ws->header_off < hsize)
+            return MHD_YES;
+          if (MHD_YES != start_frame (ws))
+            {
+              ws->state = WS_STATE_DONE;
+              return MHD_NO;
+            }
+          if (0 == ws->left)
+            {
+              ws->state = WS_STATE_HEADER;
+              if (MHD_YES != deliver (ws, NULL, 0))
+                {
+                  ws->state = WS_STATE_DONE;
+                  return MHD_NO;
+                }
+            }
+          break;
+        case WS_STATE_PAYLOAD:
+          chunk = size - off;
+          if (chunk > ws->left)
+            chunk = (size_t) ws->left;
+          MHD_websocket_unmask_ (&data[off],
+                                 chunk,
+                                 ws->mask,
+                                 ws->mask_off);
+          ws->mask_off += chunk;
+          ws->left -= chunk;
+          if (0 == ws->left)
+            ws->state = WS_STATE_HEADER;
+          if (MHD_YES != deliver (ws, &data[off], chunk))
+            {
+              ws->state = WS_STATE_DONE;
+              return MHD_NO;
+            }
+          off += chunk;
+          break;
+        case WS_STATE_DONE:
+        default:
+          return MHD_NO;
+        }
+    }
+  return MHD_YES;
+}
+
+
+/**
+ * Write the header of a frame from the server into @a buf.
+ *
+ * @param buf where to write the header, at least
+ *        #MHD_WEBSOCKET_MAX_HEADER_SIZE bytes
+ * @param opcode opcode of the frame
+ * @param last #MHD_YES if this is the last frame of the message
+ * @param payload_size size of the payload that follows the header
+ * @return size of the header
+ */
+_MHD_EXTERN size_t
+MHD_websocket_encode_header (char *buf,
+                             enum MHD_WebSocketOpcode opcode,
+                             int last,
+                             uint64_t payload_size)
+{
+  unsigned char *h = (unsigned char *) buf;
+  unsigned int i;
+
+  h[0] = (unsigned char) (((MHD_YES == last) ? 0x80 : 0) | (opcode & 0x0F));
+  if (payload_size < 126)
+    {
+      h[1] = (unsigned char) payload_size;
+      return 2;
+    }
+  if (payload_size <= 0xFFFF)
+    {
+      h[1] = 126;
+      h[2] = (unsigned char) (payload_size >> 8);
+      h[3] = (unsigned char) payload_size;
+      return 4;
+    }
+  h[1] = 127;
+  for (i = 0; i < 8; i++)
+    h[2 + i] = (unsigned char) (payload_size >> (56 - 8 * i));
+  return MHD_WEBSOCKET_MAX_HEADER_SIZE;
+}
+
+/* end of websocket.c */
@@ -0,0 +1,71 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     This library is free software; you can redistribute it and/or
+     modify it under the terms of the GNU Lesser General Public
+     License as published by the Free Software Foundation; either
+     version 2.1 of the License, or (at your option) any later version.
+
+     This library is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     Lesser General Public License for more details.
+
+     You should have received a copy of the GNU Lesser General Public
+     License along with this library; if not, write to the Free Software
+     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file microhttpd/websocket.h
+ * @brief  WebSocket handshake and framing (RFC 6455)
+ * @author libmicrohttpd contributors
+ */
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include "platform.h"
+#include "microhttpd.h"
+
+/**
+ * Length of a "Sec-WebSocket-Key" (base64 of 16 bytes).
+ */
+#define MHD_WEBSOCKET_KEY_LENGTH 24
+
+/**
+ * Size of the buffer for a "Sec-WebSocket-Accept" value (base64
+ * of a SHA-1 digest, plus the 0-terminator).
+ */
+#define MHD_WEBSOCKET_ACCEPT_SIZE 29
+
+
+/**
+ * Compute the "Sec-WebSocket-Accept" value for the
+ * "Sec-WebSocket-Key" @a key of a client.
+ *
+ * @param key the key of the client, #MHD_WEBSOCKET_KEY_LENGTH
+ *        characters
+ * @param[out] accept where to write the 0-terminated value
+ */
+void
+MHD_websocket_accept_ (const char *key,
+                       char accept[MHD_WEBSOCKET_ACCEPT_SIZE]);
+
+
+/**
+ * XOR @a size bytes of @a data with the masking key @a mask,
+ * starting at position @a offset of the masked payload.
+ *
+ * @param data payload to (un)mask in place
+ * @param size number of bytes in @a data
+ * @param mask the masking key of the frame
+ * @param offset position of @a data in the payload of the frame
+ */
+void
+MHD_websocket_unmask_ (char *data,
+                       size_t size,
+                       const unsigned char mask[4],
+                       size_t offset);
+
+#endif
@@ -0,0 +1,254 @@
+/*
+ This file is part of libmicrohttpd
+ Copyright (C) 2026 libmicrohttpd contributors
+
+ libmicrohttpd is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published
+ by the Free Software Foundation; either version 2, or (at your
+ option) any later version.
+
+ libmicrohttpd is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with libmicrohttpd; see the file COPYING.  If not, write to the
+ Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * @file test_https_handshake_threads.c
+ * @brief  Testcase for TLS handshakes in a separate thread pool
+ *         (#MHD_OPTION_HTTPS_HANDSHAKE_THREADS)
+ * @author libmicrohttpd contributors
+ */
+
+#include "platform.h"
+#include "microhttpd.h"
+#include <curl/curl.h>
+#include <pthread.h>
+#include <gcrypt.h>
+#include "tls_test_common.h"
+#include "mhd_sockets.h" /* for struct sockaddr_in */
+
+/**
+ * Number of client threads.
+ */
+#define CLIENTS 4
+
+/**
+ * Number of requests made by each client thread.
+ */
+#define REQUESTS 3
+
+extern const char srv_key_pem[];
+extern const char srv_self_signed_cert_pem[];
+
+
+static size_t
+discard_buffer (void *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  (void) ptr; (void) ctx;
+  return size * nmemb;
+}
+
+
+/**
+ * Make #REQUESTS requests, each over a new connection.
+ *
+ * @param cls unused
+ * @return NULL on success
+ */
+static void *
+client_thread (void *cls)
+{
+  static int failed;
+  CURL *c;
+  CURLcode errornum;
+  char url[256];
+  unsigned int i;
+  void *ret;
+
+  (void) cls;
+  gen_test_file_url (url, DEAMON_TEST_PORT);
+  c = curl_easy_init ();
+  curl_easy_setopt (c, CURLOPT_URL, url);
+  curl_easy_setopt (c, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+  curl_easy_setopt (c, CURLOPT_TIMEOUT, 10L);
+  curl_easy_setopt (c, CURLOPT_CONNECTTIMEOUT, 10L);
+  curl_easy_setopt (c, CURLOPT_WRITEFUNCTION, &discard_buffer);
+  curl_easy_setopt (c, CURLOPT_SSL_VERIFYPEER, 0);
+  curl_easy_setopt (c, CURLOPT_SSL_VERIFYHOST, 0);
+  curl_easy_setopt (c, CURLOPT_FAILONERROR, 1);
+  /* a new connection (and TLS handshake) for every request */
+  curl_easy_setopt (c, CURLOPT_FORBID_REUSE, 1L);
+  curl_easy_setopt (c, CURLOPT_NOSIGNAL, 1);
+  ret = NULL;
+  for (i = 0; i < REQUESTS; i++)
+    {
+      if (CURLE_OK != (errornum = curl_easy_perform (c)))
+        {
+          fprintf (stderr, "curl_easy_perform failed: `%s'\n",
+                   curl_easy_strerror (errornum));
+          ret = &failed;
+        }
+    }
+  curl_easy_cleanup (c);
+  return ret;
+}
+
+
+/**
+ * Open a TCP connection to the daemon and send @a data instead of
+ * a TLS handshake.
+ *
+ * @return the socket, #MHD_INVALID_SOCKET on error
+ */
+static MHD_socket
+connect_raw (const char *data)
+{
+  struct sockaddr_in sa;
+  MHD_socket fd;
+
+  fd = socket (PF_INET, SOCK_STREAM, 0);
+  if (MHD_INVALID_SOCKET == fd)
+    return MHD_INVALID_SOCKET;
+  memset (&sa, 0, sizeof (sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons (DEAMON_TEST_PORT);
+  sa.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  if ( (0 != connect (fd, (struct sockaddr *) &sa, sizeof (sa))) ||
+       ( (0 != strlen (data)) &&
+         (0 > send (fd, data, strlen (data), 0)) ) )
+    {
+      MHD_socket_close_ (fd);
+      return MHD_INVALID_SOCKET;
+    }
+  return fd;
+}
+
+
+/**
+ * Run parallel clients against a daemon with two handshake threads,
+ * while one client sends garbage and another one never completes
+ * its handshake.
+ *
+ * @param flags event loop flags of the daemon
+ * @param pool_size number of worker threads of the daemon
+ * @return 0 on success
+ */
+static int
+test_handshakes (unsigned int flags,
+                 unsigned int pool_size)
+{
+  struct MHD_Daemon *d;
+  struct MHD_DaemonStats stats;
+  int have_stats;
+  pthread_t clients[CLIENTS];
+  void *client_ret;
+  MHD_socket garbage;
+  MHD_socket silent;
+  unsigned int i;
+  int ret;
+
+  d = MHD_start_daemon (flags | MHD_USE_SELECT_INTERNALLY | MHD_USE_TLS |
+                        MHD_USE_DEBUG,
+                        DEAMON_TEST_PORT,
+                        NULL, NULL, &http_ahc, NULL,
+                        MHD_OPTION_HTTPS_MEM_KEY, srv_key_pem,
+                        MHD_OPTION_HTTPS_MEM_CERT, srv_self_signed_cert_pem,
+                        MHD_OPTION_HTTPS_HANDSHAKE_THREADS, 2,
+                        MHD_OPTION_THREAD_POOL_SIZE, pool_size,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    {
+      fprintf (stderr, MHD_E_SERVER_INIT);
+      return 1;
+    }
+  ret = 0;
+  silent = connect_raw ("");
+  garbage = connect_raw ("GET / HTTP/1.1\r\n\r\n");
+  for (i = 0; i < CLIENTS; i++)
+    if (0 != pthread_create (&clients[i], NULL, &client_thread, NULL))
+      {
+        fprintf (stderr, "Error: failed to spawn test client threads.\n");
+        MHD_stop_daemon (d);
+        return 1;
+      }
+  for (i = 0; i < CLIENTS; i++)
+    if ( (0 != pthread_join (clients[i], &client_ret)) ||
+         (NULL != client_ret) )
+      ret = 1;
+  /* the handshake steps do not suspend connections visibly */
+  have_stats = MHD_get_daemon_stats (d, &stats);
+  if ( (MHD_YES != have_stats) ||
+       (0 != stats.connections_suspended) )
+    {
+      fprintf (stderr, "Handshakes counted as suspended connections\n");
+      ret = 1;
+    }
+  if (MHD_INVALID_SOCKET != garbage)
+    MHD_socket_close_ (garbage);
+  /* the daemon must stop with a handshake still going on */
+  MHD_stop_daemon (d);
+  if (MHD_INVALID_SOCKET != silent)
+    MHD_socket_close_ (silent);
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+  struct MHD_Daemon *d;
+
+  gcry_control (GCRYCTL_ENABLE_QUICK_RANDOM, 0);
+#ifdef GCRYCTL_INITIALIZATION_FINISHED
+  gcry_control (GCRYCTL_INITIALIZATION_FINISHED, 0);
+#endif
+  if (0 != curl_global_init (CURL_GLOBAL_ALL))
+    {
+      fprintf (stderr, "Error (code: %u)\n", errorCount);
+      return -1;
+    }
+  if (NULL == curl_version_info (CURLVERSION_NOW)->ssl_version)
+    {
+      fprintf (stderr, "Curl does not support SSL.  Cannot run the test.\n");
+      curl_global_cleanup ();
+      return 77;
+    }
+
+  /* the handshake threads need an internal event loop */
+  d = MHD_start_daemon (MHD_USE_TLS,
+                        DEAMON_TEST_PORT,
+                        NULL, NULL, &http_ahc, NULL,
+                        MHD_OPTION_HTTPS_MEM_KEY, srv_key_pem,
+                        MHD_OPTION_HTTPS_MEM_CERT, srv_self_signed_cert_pem,
+                        MHD_OPTION_HTTPS_HANDSHAKE_THREADS, 2,
+                        MHD_OPTION_END);
+  if (NULL != d)
+    {
+      fprintf (stderr,
+               "Daemon started without MHD_USE_SELECT_INTERNALLY\n");
+      MHD_stop_daemon (d);
+      errorCount++;
+    }
+
+  errorCount += test_handshakes (0, 0);
+  errorCount += test_handshakes (0, 2);
+  if (MHD_YES == MHD_is_feature_supported (MHD_FEATURE_POLL))
+    errorCount += test_handshakes (MHD_USE_POLL, 0);
+  if (MHD_YES == MHD_is_feature_supported (MHD_FEATURE_EPOLL))
+    {
+      errorCount += test_handshakes (MHD_USE_EPOLL, 0);
+      errorCount += test_handshakes (MHD_USE_EPOLL, 2);
+    }
+  print_test_result (errorCount, argv[0]);
+  curl_global_cleanup ();
+  if (errorCount > 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  return errorCount != 0;
+}
@@ -0,0 +1,398 @@
+/*
+ This file is part of libmicrohttpd
+ Copyright (C) 2026 libmicrohttpd contributors
+
+ libmicrohttpd is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published
+ by the Free Software Foundation; either version 2, or (at your
+ option) any later version.
+
+ libmicrohttpd is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with libmicrohttpd; see the file COPYING.  If not, write to the
+ Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * @file test_https_session_resume.c
+ * @brief  Testcase for TLS session resumption with the session cache
+ *         and with session tickets
+ * @author libmicrohttpd contributors
+ */
+
+#include "platform.h"
+#include "microhttpd.h"
+#include <curl/curl.h>
+#include <gcrypt.h>
+#include "tls_test_common.h"
+#include "mhd_sockets.h" /* for struct sockaddr_in */
+
+extern const char srv_key_pem[];
+extern const char srv_self_signed_cert_pem[];
+
+/**
+ * Number of requests that were made over a resumed session.
+ */
+static unsigned int resumed;
+
+
+static size_t
+discard_buffer (void *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  (void) ptr; (void) ctx;
+  return size * nmemb;
+}
+
+
+static int
+resume_ahc (void *cls, struct MHD_Connection *connection,
+            const char *url, const char *method,
+            const char *upload_data, const char *version,
+            size_t *upload_data_size, void **ptr)
+{
+  const union MHD_ConnectionInfo *ci;
+  struct MHD_Response *response;
+  int ret;
+
+  if (NULL == *ptr)
+    {
+      *ptr = &resume_ahc;
+      return MHD_YES;
+    }
+  ci = MHD_get_connection_info (connection,
+                                MHD_CONNECTION_INFO_GNUTLS_SESSION);
+  if ( (NULL != ci) &&
+       (0 != gnutls_session_is_resumed (ci->tls_session)) )
+    resumed++;
+  response = MHD_create_response_from_buffer (strlen (EMPTY_PAGE),
+					      (void *) EMPTY_PAGE,
+					      MHD_RESPMEM_PERSISTENT);
+  ret = MHD_queue_response (connection, MHD_HTTP_OK, response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+/**
+ * Fetch the page over a new connection, resuming the TLS session
+ * of the last request made with @a c if possible.
+ *
+ * @return 0 on success
+ */
+static int
+fetch (CURL *c)
+{
+  CURLcode errornum;
+
+  if (CURLE_OK != (errornum = curl_easy_perform (c)))
+    {
+      fprintf (stderr, "curl_easy_perform failed: `%s'\n",
+               curl_easy_strerror (errornum));
+      return 1;
+    }
+  return 0;
+}
+
+
+static CURL *
+setup_curl ()
+{
+  CURL *c;
+  char url[256];
+
+  gen_test_file_url (url, DEAMON_TEST_PORT);
+  c = curl_easy_init ();
+#if DEBUG_HTTPS_TEST
+  curl_easy_setopt (c, CURLOPT_VERBOSE, 1);
+#endif
+  curl_easy_setopt (c, CURLOPT_URL, url);
+  curl_easy_setopt (c, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+  curl_easy_setopt (c, CURLOPT_TIMEOUT, 10L);
+  curl_easy_setopt (c, CURLOPT_CONNECTTIMEOUT, 10L);
+  curl_easy_setopt (c, CURLOPT_WRITEFUNCTION, &discard_buffer);
+  curl_easy_setopt (c, CURLOPT_SSL_VERIFYPEER, 0);
+  curl_easy_setopt (c, CURLOPT_SSL_VERIFYHOST, 0);
+  curl_easy_setopt (c, CURLOPT_FAILONERROR, 1);
+  /* a new connection (and TLS handshake) for every request */
+  curl_easy_setopt (c, CURLOPT_FORBID_REUSE, 1L);
+  curl_easy_setopt (c, CURLOPT_NOSIGNAL, 1);
+  return c;
+}
+
+
+/**
+ * Make three requests, and check how many of them resumed the
+ * session of the previous one.
+ *
+ * @param name name of the test for error messages
+ * @param d the daemon
+ * @param expected number of requests that should resume
+ * @return 0 on success
+ */
+static int
+test_resume (const char *name,
+             struct MHD_Daemon *d,
+             unsigned int expected)
+{
+  CURL *c;
+  unsigned int i;
+  int ret;
+
+  if (NULL == d)
+    {
+      fprintf (stderr, MHD_E_SERVER_INIT);
+      return 1;
+    }
+  c = setup_curl ();
+  resumed = 0;
+  ret = 0;
+  for (i = 0; i < 3; i++)
+    ret |= fetch (c);
+  if (resumed != expected)
+    {
+      fprintf (stderr,
+               "%s: %u of 3 requests resumed, expected %u\n",
+               name,
+               resumed,
+               expected);
+      ret = 1;
+    }
+  curl_easy_cleanup (c);
+  return ret;
+}
+
+
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+/**
+ * Fetch the page over a new connection with GnuTLS (as libcurl
+ * does not use session tickets with every TLS library), resuming
+ * the session in @a data if possible.
+ *
+ * @param[in,out] data session to resume, empty for none; set to
+ *        the new session
+ * @return 0 on success
+ */
+static int
+fetch_gnutls (gnutls_datum_t *data)
+{
+  static const char request[] =
+    "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+  gnutls_certificate_credentials_t xcred;
+  gnutls_session_t session;
+  struct sockaddr_in sa;
+  MHD_socket fd;
+  char buf[1024];
+  size_t pos;
+  ssize_t got;
+  int ret;
+
+  fd = socket (PF_INET, SOCK_STREAM, 0);
+  if (MHD_INVALID_SOCKET == fd)
+    return 1;
+  memset (&sa, 0, sizeof (sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons (DEAMON_TEST_PORT);
+  sa.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  if (0 != connect (fd, (struct sockaddr *) &sa, sizeof (sa)))
+    {
+      MHD_socket_close_ (fd);
+      return 1;
+    }
+  gnutls_certificate_allocate_credentials (&xcred);
+  gnutls_init (&session, GNUTLS_CLIENT);
+  gnutls_set_default_priority (session);
+  gnutls_credentials_set (session, GNUTLS_CRD_CERTIFICATE, xcred);
+  if (NULL != data->data)
+    gnutls_session_set_data (session, data->data, data->size);
+  gnutls_transport_set_int (session, fd);
+  do
+    ret = gnutls_handshake (session);
+  while ( (ret < 0) &&
+          (0 == gnutls_error_is_fatal (ret)) );
+  if (ret >= 0)
+    {
+      if (sizeof (request) - 1 !=
+          gnutls_record_send (session, request, sizeof (request) - 1))
+        ret = GNUTLS_E_PUSH_ERROR;
+      /* read up to the end of the page; the session must not end with
+         an error, or GnuTLS would not allow resuming it */
+      pos = 0;
+      while ( (ret >= 0) &&
+              ( (pos < strlen ("</html>")) ||
+                (0 != memcmp (&buf[pos - strlen ("</html>")],
+                              "</html>",
+                              strlen ("</html>"))) ) )
+        {
+          if (sizeof (buf) == pos)
+            {
+              ret = GNUTLS_E_RECORD_OVERFLOW;
+              break;
+            }
+          got = gnutls_record_recv (session,
+                                    &buf[pos],
+                                    sizeof (buf) - pos);
+          if (got > 0)
+            pos += (size_t) got;
+          else if (0 == got)
+            ret = GNUTLS_E_PREMATURE_TERMINATION;
+          else if (0 != gnutls_error_is_fatal ((int) got))
+            ret = (int) got;
+        }
+    }
+  gnutls_free (data->data);
+  data->data = NULL;
+  data->size = 0;
+  if (ret >= 0)
+    gnutls_session_get_data2 (session, data);
+  else
+    fprintf (stderr, "TLS connection failed: %s\n", gnutls_strerror (ret));
+  gnutls_deinit (session);
+  gnutls_certificate_free_credentials (xcred);
+  MHD_socket_close_ (fd);
+  return (ret >= 0) ? 0 : 1;
+}
+
+
+/**
+ * Check that session tickets resume sessions, and that tickets
+ * issued with a replaced key are no longer accepted.
+ *
+ * @return 0 on success
+ */
+static int
+test_tickets ()
+{
+  struct MHD_Daemon *d;
+  gnutls_datum_t key;
+  gnutls_datum_t data;
+  unsigned int i;
+  int ret;
+
+  d = MHD_start_daemon (MHD_USE_SELECT_INTERNALLY | MHD_USE_TLS |
+                        MHD_USE_DEBUG, DEAMON_TEST_PORT,
+                        NULL, NULL, &resume_ahc, NULL,
+                        MHD_OPTION_HTTPS_MEM_KEY, srv_key_pem,
+                        MHD_OPTION_HTTPS_MEM_CERT, srv_self_signed_cert_pem,
+                        MHD_OPTION_HTTPS_SESSION_TICKET_KEY,
+                        (size_t) 0, NULL,
+                        MHD_OPTION_THREAD_POOL_SIZE, 2,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    {
+      fprintf (stderr, MHD_E_SERVER_INIT);
+      return 1;
+    }
+  ret = 0;
+  data.data = NULL;
+  data.size = 0;
+  resumed = 0;
+  for (i = 0; i < 3; i++)
+    ret |= fetch_gnutls (&data);
+  if (2 != resumed)
+    {
+      fprintf (stderr,
+               "tickets: %u of 3 requests resumed, expected 2\n",
+               resumed);
+      ret = 1;
+    }
+  if (GNUTLS_E_SUCCESS != gnutls_session_ticket_key_generate (&key))
+    {
+      gnutls_free (data.data);
+      MHD_stop_daemon (d);
+      return 1;
+    }
+  if ( (MHD_NO != MHD_set_https_session_ticket_key (d,
+                                                    key.data,
+                                                    key.size - 1)) ||
+       (MHD_YES != MHD_set_https_session_ticket_key (d,
+                                                     key.data,
+                                                     key.size)) )
+    {
+      fprintf (stderr, "Failed to replace the session ticket key\n");
+      ret = 1;
+    }
+  gnutls_free (key.data);
+
+  /* the old ticket is rejected, the new one accepted */
+  resumed = 0;
+  if ( (0 != fetch_gnutls (&data)) ||
+       (0 != resumed) ||
+       (0 != fetch_gnutls (&data)) ||
+       (1 != resumed) )
+    {
+      fprintf (stderr, "Wrong sessions resumed after key change\n");
+      ret = 1;
+    }
+  gnutls_free (data.data);
+  MHD_stop_daemon (d);
+  return ret;
+}
+#endif
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+  struct MHD_Daemon *d;
+
+  gcry_control (GCRYCTL_ENABLE_QUICK_RANDOM, 0);
+#ifdef GCRYCTL_INITIALIZATION_FINISHED
+  gcry_control (GCRYCTL_INITIALIZATION_FINISHED, 0);
+#endif
+  if (0 != curl_global_init (CURL_GLOBAL_ALL))
+    {
+      fprintf (stderr, "Error (code: %u)\n", errorCount);
+      return -1;
+    }
+  if (NULL == curl_version_info (CURLVERSION_NOW)->ssl_version)
+    {
+      fprintf (stderr, "Curl does not support SSL.  Cannot run the test.\n");
+      curl_global_cleanup ();
+      return 77;
+    }
+
+  /* no resumption by default */
+  d = MHD_start_daemon (MHD_USE_SELECT_INTERNALLY | MHD_USE_TLS |
+                        MHD_USE_DEBUG, DEAMON_TEST_PORT,
+                        NULL, NULL, &resume_ahc, NULL,
+                        MHD_OPTION_HTTPS_MEM_KEY, srv_key_pem,
+                        MHD_OPTION_HTTPS_MEM_CERT, srv_self_signed_cert_pem,
+                        MHD_OPTION_END);
+  errorCount += test_resume ("default", d, 0);
+  if (NULL != d)
+    {
+      if (MHD_NO != MHD_set_https_session_ticket_key (d, NULL, 0))
+        errorCount++;
+      MHD_stop_daemon (d);
+    }
+
+  /* session IDs only exist up to TLS 1.2; the sessions have to be
+     found whichever worker handled the previous connection */
+  d = MHD_start_daemon (MHD_USE_SELECT_INTERNALLY | MHD_USE_TLS |
+                        MHD_USE_DEBUG, DEAMON_TEST_PORT,
+                        NULL, NULL, &resume_ahc, NULL,
+                        MHD_OPTION_HTTPS_PRIORITIES, "NORMAL:-VERS-TLS1.3",
+                        MHD_OPTION_HTTPS_MEM_KEY, srv_key_pem,
+                        MHD_OPTION_HTTPS_MEM_CERT, srv_self_signed_cert_pem,
+                        MHD_OPTION_HTTPS_SESSION_CACHE, 16,
+                        MHD_OPTION_THREAD_POOL_SIZE, 4,
+                        MHD_OPTION_END);
+  errorCount += test_resume ("cache", d, 2);
+  if (NULL != d)
+    MHD_stop_daemon (d);
+
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+  errorCount += test_tickets ();
+#endif
+  print_test_result (errorCount, argv[0]);
+  curl_global_cleanup ();
+  if (errorCount > 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  return errorCount != 0;
+}
@@ -0,0 +1,393 @@
+/*
+ This file is part of libmicrohttpd
+ Copyright (C) 2026 libmicrohttpd contributors
+
+ libmicrohttpd is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published
+ by the Free Software Foundation; either version 2, or (at your
+ option) any later version.
+
+ libmicrohttpd is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with libmicrohttpd; see the file COPYING.  If not, write to the
+ Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * @file test_https_upgrade_direct.c
+ * @brief  Testcase for upgraded TLS connections that use the TLS
+ *         session directly (#MHD_RF_UPGRADE_DIRECT)
+ * @author libmicrohttpd contributors
+ */
+
+#include "platform.h"
+#include "microhttpd.h"
+#include <pthread.h>
+#include <poll.h>
+#include <gcrypt.h>
+#include "tls_test_common.h"
+#include "mhd_sockets.h" /* for struct sockaddr_in */
+
+extern const char srv_key_pem[];
+extern const char srv_self_signed_cert_pem[];
+
+/**
+ * Thread of the application that talks to the upgraded connection.
+ */
+static pthread_t pt;
+
+/**
+ * Set to 1 once @e pt was started.
+ */
+static int app_started;
+
+/**
+ * Set to 1 if the application was given a socketpair instead of
+ * the socket of the client.
+ */
+static int wrong_socket;
+
+/**
+ * Set to 1 if the application side of the test failed.
+ */
+static int app_failed;
+
+
+/**
+ * Wait until @a sock is ready for @a events.
+ */
+static void
+wait_for (MHD_socket sock,
+          short events)
+{
+  struct pollfd p;
+
+  p.fd = sock;
+  p.events = events;
+  p.revents = 0;
+  (void) poll (&p, 1, 1000);
+}
+
+
+/**
+ * Send all of @a text with #MHD_upgrade_send().
+ *
+ * @return 0 on success
+ */
+static int
+upgrade_send_all (struct MHD_UpgradeResponseHandle *urh,
+                  MHD_socket sock,
+                  const char *text)
+{
+  size_t len = strlen (text);
+  size_t off;
+  ssize_t ret;
+
+  for (off = 0; off < len; off += (size_t) ret)
+    {
+      ret = MHD_upgrade_send (urh,
+                              &text[off],
+                              len - off);
+      if (0 > ret)
+        {
+          if (! MHD_SCKT_ERR_IS_EAGAIN_ (MHD_socket_get_error_ ()))
+            return 1;
+          wait_for (sock, POLLOUT);
+          ret = 0;
+        }
+    }
+  return 0;
+}
+
+
+/**
+ * Receive exactly @a text with #MHD_upgrade_recv().
+ *
+ * @return 0 on success
+ */
+static int
+upgrade_recv_all (struct MHD_UpgradeResponseHandle *urh,
+                  MHD_socket sock,
+                  const char *text)
+{
+  size_t len = strlen (text);
+  char buf[64];
+  size_t off;
+  ssize_t ret;
+
+  for (off = 0; off < len; off += (size_t) ret)
+    {
+      ret = MHD_upgrade_recv (urh,
+                              &buf[off],
+                              len - off);
+      if (0 == ret)
+        return 1;
+      if (0 > ret)
+        {
+          if (! MHD_SCKT_ERR_IS_EAGAIN_ (MHD_socket_get_error_ ()))
+            return 1;
+          wait_for (sock, POLLIN);
+          ret = 0;
+        }
+    }
+  return (0 == memcmp (buf, text, len)) ? 0 : 1;
+}
+
+
+/**
+ * Arguments for #run_app().
+ */
+struct AppArgs
+{
+  struct MHD_UpgradeResponseHandle *urh;
+  MHD_socket sock;
+};
+
+
+/**
+ * Application side of the upgraded connection.
+ *
+ * @param cls the `struct AppArgs`
+ */
+static void *
+run_app (void *cls)
+{
+  static struct AppArgs args;
+
+  args = *(struct AppArgs *) cls;
+  free (cls);
+  if ( (0 != upgrade_send_all (args.urh, args.sock, "Hello")) ||
+       (0 != upgrade_recv_all (args.urh, args.sock, "World")) ||
+       (0 != upgrade_send_all (args.urh, args.sock, "Finished")) )
+    app_failed = 1;
+  MHD_upgrade_action (args.urh,
+                      MHD_UPGRADE_ACTION_CLOSE);
+  return NULL;
+}
+
+
+static void
+upgrade_cb (void *cls,
+            struct MHD_Connection *connection,
+            void *con_cls,
+            const char *extra_in,
+            size_t extra_in_size,
+            MHD_socket sock,
+            struct MHD_UpgradeResponseHandle *urh)
+{
+  struct AppArgs *args;
+  struct sockaddr_in sa;
+  socklen_t sa_len;
+
+  (void) cls; (void) connection; (void) con_cls; (void) extra_in;
+  sa_len = sizeof (sa);
+  if ( (0 != getpeername (sock, (struct sockaddr *) &sa, &sa_len)) ||
+       (AF_INET != sa.sin_family) )
+    wrong_socket = 1;
+  if ( (0 != extra_in_size) ||
+       (NULL == (args = malloc (sizeof (struct AppArgs)))) )
+    abort ();
+  args->urh = urh;
+  args->sock = sock;
+  if (0 != pthread_create (&pt, NULL, &run_app, args))
+    abort ();
+  app_started = 1;
+}
+
+
+static int
+ahc_upgrade (void *cls,
+             struct MHD_Connection *connection,
+             const char *url,
+             const char *method,
+             const char *version,
+             const char *upload_data,
+             size_t *upload_data_size,
+             void **con_cls)
+{
+  struct MHD_Response *resp;
+  int ret;
+
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size; (void) con_cls;
+  resp = MHD_create_response_for_upgrade (&upgrade_cb,
+                                          NULL);
+  MHD_set_response_options (resp,
+                            MHD_RF_UPGRADE_DIRECT,
+                            MHD_RO_END);
+  MHD_add_response_header (resp,
+                           MHD_HTTP_HEADER_UPGRADE,
+                           "Hello World Protocol");
+  ret = MHD_queue_response (connection,
+                            MHD_HTTP_SWITCHING_PROTOCOLS,
+                            resp);
+  MHD_destroy_response (resp);
+  return ret;
+}
+
+
+/**
+ * Read from @a session until @a text was received; if @a text
+ * is NULL, read up to the end of the HTTP header.
+ *
+ * @return 0 on success
+ */
+static int
+client_recv (gnutls_session_t session,
+             const char *text)
+{
+  char buf[1024];
+  size_t pos;
+  ssize_t got;
+
+  pos = 0;
+  while (1)
+    {
+      if ( (NULL != text) &&
+           (pos >= strlen (text)) )
+        return (0 == memcmp (buf, text, strlen (text))) ? 0 : 1;
+      if ( (NULL == text) &&
+           (pos >= 4) &&
+           (0 == memcmp (&buf[pos - 4], "\r\n\r\n", 4)) )
+        return 0;
+      if (sizeof (buf) == pos)
+        return 1;
+      /* byte by byte, the header must not eat the data after it */
+      got = gnutls_record_recv (session, &buf[pos], 1);
+      if (0 >= got)
+        return 1;
+      pos++;
+    }
+}
+
+
+/**
+ * Talk the upgraded protocol with the daemon over TLS.
+ *
+ * @return 0 on success
+ */
+static int
+run_client ()
+{
+  static const char request[] =
+    "GET / HTTP/1.1\r\nHost: localhost\r\nConnection: Upgrade\r\n\r\n";
+  gnutls_certificate_credentials_t xcred;
+  gnutls_session_t session;
+  struct sockaddr_in sa;
+  MHD_socket fd;
+  int ret;
+
+  fd = socket (PF_INET, SOCK_STREAM, 0);
+  if (MHD_INVALID_SOCKET == fd)
+    return 1;
+  memset (&sa, 0, sizeof (sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons (DEAMON_TEST_PORT);
+  sa.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  if (0 != connect (fd, (struct sockaddr *) &sa, sizeof (sa)))
+    {
+      MHD_socket_close_ (fd);
+      return 1;
+    }
+  gnutls_certificate_allocate_credentials (&xcred);
+  gnutls_init (&session, GNUTLS_CLIENT);
+  gnutls_set_default_priority (session);
+  gnutls_credentials_set (session, GNUTLS_CRD_CERTIFICATE, xcred);
+  gnutls_transport_set_int (session, fd);
+  do
+    ret = gnutls_handshake (session);
+  while ( (ret < 0) &&
+          (0 == gnutls_error_is_fatal (ret)) );
+  if ( (ret < 0) ||
+       (sizeof (request) - 1 !=
+        gnutls_record_send (session, request, sizeof (request) - 1)) ||
+       (0 != client_recv (session, NULL)) ||
+       (0 != client_recv (session, "Hello")) ||
+       (5 != gnutls_record_send (session, "World", 5)) ||
+       (0 != client_recv (session, "Finished")) )
+    ret = 1;
+  else
+    ret = 0;
+  gnutls_deinit (session);
+  gnutls_certificate_free_credentials (xcred);
+  MHD_socket_close_ (fd);
+  return ret;
+}
+
+
+/**
+ * Upgrade a connection and talk to it through
+ * #MHD_upgrade_send() and #MHD_upgrade_recv().
+ *
+ * @param flags threading model of the daemon
+ * @param pool size of the thread pool, 0 to disable
+ * @return 0 on success
+ */
+static int
+test_upgrade (unsigned int flags,
+              unsigned int pool)
+{
+  struct MHD_Daemon *d;
+  int ret;
+
+  if (0 == (flags & MHD_USE_THREAD_PER_CONNECTION))
+    flags |= MHD_USE_SUSPEND_RESUME;
+  d = MHD_start_daemon (flags | MHD_USE_DEBUG | MHD_USE_TLS,
+                        DEAMON_TEST_PORT,
+                        NULL, NULL, &ahc_upgrade, NULL,
+                        MHD_OPTION_HTTPS_MEM_KEY, srv_key_pem,
+                        MHD_OPTION_HTTPS_MEM_CERT, srv_self_signed_cert_pem,
+                        MHD_OPTION_THREAD_POOL_SIZE, pool,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    {
+      fprintf (stderr, MHD_E_SERVER_INIT);
+      return 1;
+    }
+  app_started = 0;
+  wrong_socket = 0;
+  app_failed = 0;
+  ret = run_client ();
+  if (0 != app_started)
+    pthread_join (pt, NULL);
+  MHD_stop_daemon (d);
+  if (0 != wrong_socket)
+    {
+      fprintf (stderr, "Upgrade handler did not get the client socket\n");
+      ret = 1;
+    }
+  if (0 != app_failed)
+    {
+      fprintf (stderr, "MHD_upgrade_send/recv failed\n");
+      ret = 1;
+    }
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+
+  gcry_control (GCRYCTL_ENABLE_QUICK_RANDOM, 0);
+#ifdef GCRYCTL_INITIALIZATION_FINISHED
+  gcry_control (GCRYCTL_INITIALIZATION_FINISHED, 0);
+#endif
+  errorCount += test_upgrade (MHD_USE_SELECT_INTERNALLY, 0);
+  errorCount += test_upgrade (MHD_USE_SELECT_INTERNALLY, 2);
+  errorCount += test_upgrade (MHD_USE_THREAD_PER_CONNECTION, 0);
+  if (MHD_YES == MHD_is_feature_supported (MHD_FEATURE_POLL))
+    errorCount += test_upgrade (MHD_USE_POLL_INTERNALLY, 0);
+  if (MHD_YES == MHD_is_feature_supported (MHD_FEATURE_EPOLL))
+    errorCount += test_upgrade (MHD_USE_EPOLL_INTERNALLY, 2);
+  print_test_result (errorCount, argv[0]);
+  if (errorCount > 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  return errorCount != 0;
+}
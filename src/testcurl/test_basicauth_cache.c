@@ -0,0 +1,201 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file test_basicauth_cache.c
+ * @brief  Testcase for the cache of verified Basic Auth credentials
+ * @author libmicrohttpd contributors
+ */
+#include "MHD_config.h"
+#include "platform.h"
+#include <curl/curl.h>
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef WINDOWS
+#include <unistd.h>
+#endif
+
+#define PORT 1339
+
+/**
+ * Number of times the handler had to check the password.
+ */
+static unsigned int verifications;
+
+/**
+ * Number of times the cache reported verified credentials.
+ */
+static unsigned int cached;
+
+
+static size_t
+discardBuffer (void *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  (void) ptr; (void) ctx;
+  return size * nmemb;
+}
+
+
+static int
+ahc_echo (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **unused)
+{
+  static const char *page = "ok";
+  struct MHD_Response *response;
+  char user[32];
+  char *username;
+  char *password;
+  int ok;
+  int ret;
+
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size; (void) unused;
+  ok = MHD_NO;
+  if (MHD_YES == MHD_basic_auth_get_verified (connection,
+                                              user,
+                                              sizeof (user)))
+    {
+      cached++;
+      ok = (0 == strcmp (user, "testuser")) ? MHD_YES : MHD_NO;
+    }
+  else
+    {
+      password = NULL;
+      username = MHD_basic_auth_get_username_password (connection,
+                                                       &password);
+      if ( (NULL != username) &&
+           (0 == strcmp (username, "testuser")) &&
+           (0 == strcmp (password, "testpass")) )
+        {
+          verifications++;
+          ok = MHD_YES;
+          /* fails if the daemon has no cache, which is fine */
+          (void) MHD_basic_auth_set_verified (connection,
+                                              username);
+        }
+      free (username);
+      free (password);
+    }
+  response = MHD_create_response_from_buffer (strlen (page),
+                                              (void *) page,
+                                              MHD_RESPMEM_PERSISTENT);
+  if (MHD_YES == ok)
+    ret = MHD_queue_response (connection, MHD_HTTP_OK, response);
+  else
+    ret = MHD_queue_basic_auth_fail_response (connection,
+                                              "TestRealm",
+                                              response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+/**
+ * Fetch a page with the given credentials.
+ *
+ * @return 0 if the request succeeded, 1 if not
+ */
+static int
+fetch (const char *userpwd)
+{
+  CURL *c;
+  CURLcode errornum;
+
+  c = curl_easy_init ();
+  curl_easy_setopt (c, CURLOPT_URL, "http://127.0.0.1:1339/");
+  curl_easy_setopt (c, CURLOPT_WRITEFUNCTION, &discardBuffer);
+  curl_easy_setopt (c, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+  curl_easy_setopt (c, CURLOPT_USERPWD, userpwd);
+  curl_easy_setopt (c, CURLOPT_FAILONERROR, 1L);
+  curl_easy_setopt (c, CURLOPT_TIMEOUT, 15L);
+  curl_easy_setopt (c, CURLOPT_CONNECTTIMEOUT, 15L);
+  curl_easy_setopt (c, CURLOPT_NOSIGNAL, 1L);
+  errornum = curl_easy_perform (c);
+  curl_easy_cleanup (c);
+  return (CURLE_OK == errornum) ? 0 : 1;
+}
+
+
+static int
+testCache (unsigned int cache_size)
+{
+  struct MHD_Daemon *d;
+  unsigned int i;
+  int ret;
+
+  verifications = 0;
+  cached = 0;
+  d = MHD_start_daemon (MHD_USE_SELECT_INTERNALLY | MHD_USE_DEBUG,
+                        PORT, NULL, NULL, &ahc_echo, NULL,
+                        MHD_OPTION_BASIC_AUTH_CACHE_SIZE, cache_size,
+                        MHD_OPTION_BASIC_AUTH_CACHE_TIMEOUT, 2,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 1;
+  ret = 0;
+  for (i = 0; i < 5; i++)
+    if (0 != fetch ("testuser:testpass"))
+      ret |= 2;
+  if (0 == fetch ("testuser:wrongpass"))
+    ret |= 4;
+  if (0 == cache_size)
+    {
+      /* no cache, every request has to be checked */
+      if ( (5 != verifications) ||
+           (0 != cached) )
+        ret |= 8;
+      MHD_stop_daemon (d);
+      return ret;
+    }
+  if ( (1 != verifications) ||
+       (4 != cached) )
+    ret |= 8;
+  /* entries time out */
+  sleep (3);
+  if ( (0 != fetch ("testuser:testpass")) ||
+       (2 != verifications) )
+    ret |= 16;
+  MHD_stop_daemon (d);
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+
+  if (0 != curl_global_init (CURL_GLOBAL_WIN32))
+    return 2;
+  errorCount += testCache (16);
+  errorCount += testCache (0);
+  if (errorCount != 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  curl_global_cleanup ();
+  return errorCount != 0;       /* 0 == pass */
+}
@@ -0,0 +1,255 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file test_broadcast.c
+ * @brief  Testcase for #MHD_broadcast_response()
+ * @author libmicrohttpd contributors
+ */
+
+#include "MHD_config.h"
+#include "platform.h"
+#include <curl/curl.h>
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifndef WINDOWS
+#include <unistd.h>
+#endif
+
+/**
+ * Port of the daemon.
+ */
+#define PORT 1095
+
+/**
+ * Number of long-poll clients.
+ */
+#define NUM_CLIENTS 32
+
+/**
+ * The event published to all clients.
+ */
+#define EVENT "event"
+
+
+/**
+ * Connections suspended by #ahc_wait().
+ */
+static struct MHD_Connection *waiting[NUM_CLIENTS];
+
+/**
+ * Number of entries in #waiting.
+ */
+static unsigned int num_waiting;
+
+/**
+ * Lock for #waiting and #num_waiting.
+ */
+static pthread_mutex_t waiting_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+struct CBC
+{
+  char buf[16];
+  size_t pos;
+};
+
+
+static size_t
+copyBuffer (void *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  struct CBC *cbc = ctx;
+
+  if (cbc->pos + size * nmemb > sizeof (cbc->buf))
+    return 0;                   /* overflow */
+  memcpy (&cbc->buf[cbc->pos], ptr, size * nmemb);
+  cbc->pos += size * nmemb;
+  return size * nmemb;
+}
+
+
+/**
+ * Suspend every request until the event is broadcast.
+ */
+static int
+ahc_wait (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **unused)
+{
+  static int marker;
+
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size;
+  if (&marker != *unused)
+    {
+      *unused = &marker;
+      return MHD_YES;
+    }
+  *unused = NULL;
+  MHD_suspend_connection (connection);
+  pthread_mutex_lock (&waiting_lock);
+  if (num_waiting < NUM_CLIENTS)
+    waiting[num_waiting++] = connection;
+  pthread_mutex_unlock (&waiting_lock);
+  return MHD_YES;
+}
+
+
+static int
+testBroadcast (unsigned int flags,
+               unsigned int pool)
+{
+  struct MHD_Daemon *d;
+  struct MHD_Response *response;
+  struct CBC cbc[NUM_CLIENTS];
+  CURL *c[NUM_CLIENTS];
+  CURLM *multi;
+  CURLMsg *msg;
+  int running;
+  int msgs;
+  unsigned int done;
+  unsigned int queued;
+  unsigned int i;
+  long code;
+  time_t start;
+  int ret;
+
+  num_waiting = 0;
+  d = MHD_start_daemon (flags | MHD_USE_SUSPEND_RESUME | MHD_USE_DEBUG,
+                        PORT, NULL, NULL, &ahc_wait, NULL,
+                        MHD_OPTION_THREAD_POOL_SIZE, pool,
+                        MHD_OPTION_CONNECTION_LIMIT, (unsigned int) (2 * NUM_CLIENTS),
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 1;
+  multi = curl_multi_init ();
+  if (NULL == multi)
+    {
+      MHD_stop_daemon (d);
+      return 1;
+    }
+  for (i = 0; i < NUM_CLIENTS; i++)
+    {
+      cbc[i].pos = 0;
+      c[i] = curl_easy_init ();
+      curl_easy_setopt (c[i], CURLOPT_URL, "http://127.0.0.1:1095/events");
+      curl_easy_setopt (c[i], CURLOPT_WRITEFUNCTION, &copyBuffer);
+      curl_easy_setopt (c[i], CURLOPT_WRITEDATA, &cbc[i]);
+      curl_easy_setopt (c[i], CURLOPT_TIMEOUT, 30L);
+      curl_easy_setopt (c[i], CURLOPT_CONNECTTIMEOUT, 15L);
+      curl_easy_setopt (c[i], CURLOPT_FORBID_REUSE, 1L);
+      curl_easy_setopt (c[i], CURLOPT_NOSIGNAL, 1L);
+      curl_multi_add_handle (multi, c[i]);
+    }
+
+  /* wait for all clients to be suspended */
+  ret = 0;
+  start = time (NULL);
+  running = NUM_CLIENTS;
+  while (1)
+    {
+      curl_multi_perform (multi, &running);
+      pthread_mutex_lock (&waiting_lock);
+      done = num_waiting;
+      pthread_mutex_unlock (&waiting_lock);
+      if (NUM_CLIENTS == done)
+        break;
+      if ( (0 == running) ||
+           (time (NULL) - start > 15) )
+        {
+          ret |= 2;
+          break;
+        }
+      curl_multi_wait (multi, NULL, 0, 10, NULL);
+    }
+
+  response = MHD_create_response_from_buffer (strlen (EVENT),
+                                              (void *) EVENT,
+                                              MHD_RESPMEM_PERSISTENT);
+  /* the clients may already see the response when the call returns,
+     so only look at the result afterwards */
+  queued = MHD_broadcast_response (waiting,
+                                   done,
+                                   MHD_HTTP_OK,
+                                   response);
+  MHD_destroy_response (response);
+  if (queued != done)
+    ret |= 4;
+
+  /* all clients must get the event */
+  done = 0;
+  start = time (NULL);
+  while ( (0 != running) &&
+          (time (NULL) - start <= 15) )
+    {
+      curl_multi_perform (multi, &running);
+      curl_multi_wait (multi, NULL, 0, 10, NULL);
+    }
+  while (NULL != (msg = curl_multi_info_read (multi, &msgs)))
+    {
+      if (CURLMSG_DONE != msg->msg)
+        continue;
+      if (CURLE_OK != msg->data.result)
+        continue;
+      code = 0;
+      curl_easy_getinfo (msg->easy_handle, CURLINFO_RESPONSE_CODE, &code);
+      if (MHD_HTTP_OK == code)
+        done++;
+    }
+  if (NUM_CLIENTS != done)
+    ret |= 8;
+  for (i = 0; i < NUM_CLIENTS; i++)
+    {
+      if ( (strlen (EVENT) != cbc[i].pos) ||
+           (0 != memcmp (cbc[i].buf, EVENT, strlen (EVENT))) )
+        ret |= 16;
+      curl_multi_remove_handle (multi, c[i]);
+      curl_easy_cleanup (c[i]);
+    }
+  curl_multi_cleanup (multi);
+  MHD_stop_daemon (d);
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+
+  if (0 != curl_global_init (CURL_GLOBAL_WIN32))
+    return 2;
+  errorCount += testBroadcast (MHD_USE_SELECT_INTERNALLY, 0);
+  errorCount += testBroadcast (MHD_USE_SELECT_INTERNALLY, 4);
+  if (MHD_YES == MHD_is_feature_supported (MHD_FEATURE_EPOLL))
+    errorCount += testBroadcast (MHD_USE_EPOLL_INTERNALLY, 4);
+  if (errorCount != 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  curl_global_cleanup ();
+  return errorCount != 0;       /* 0 == pass */
+}
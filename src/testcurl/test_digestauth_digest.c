@@ -0,0 +1,211 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file test_digestauth_digest.c
+ * @brief  Testcase for libmicrohttpd Digest Auth with a stored H(A1)
+ * @author libmicrohttpd contributors
+ */
+#include "MHD_config.h"
+#include "platform.h"
+#include <curl/curl.h>
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef HAVE_GCRYPT_H
+#include <gcrypt.h>
+#endif
+
+#ifndef WINDOWS
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#define PAGE "<html><head><title>libmicrohttpd demo</title></head><body>Access granted</body></html>"
+
+#define DENIED "<html><head><title>libmicrohttpd demo</title></head><body>Access denied</body></html>"
+
+#define MY_OPAQUE "11733b200778ce33060f31c9af70a870ba96ddd4"
+
+#define REALM "test@example.com"
+
+/**
+ * MD5 ("testuser:test@example.com:testpass").
+ */
+static const uint8_t userdigest[MHD_MD5_DIGEST_SIZE] = {
+  0xa0, 0xa6, 0x23, 0x76, 0x8f, 0x9a, 0x35, 0x3a,
+  0xc3, 0x8e, 0xc6, 0x45, 0x1c, 0x09, 0x37, 0x1b
+};
+
+
+static size_t
+discardBuffer (void *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  (void) ptr; (void) ctx;
+  return size * nmemb;
+}
+
+
+/**
+ * Check the credentials with the stored digest if @a cls is not
+ * NULL, and with the password otherwise.
+ */
+static int
+ahc_echo (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **unused)
+{
+  struct MHD_Response *response;
+  char *username;
+  int ret;
+
+  username = MHD_digest_auth_get_username (connection);
+  if ( (username == NULL) ||
+       (0 != strcmp (username, "testuser")) )
+    {
+      free (username);
+      response = MHD_create_response_from_buffer (strlen (DENIED),
+                                                  DENIED,
+                                                  MHD_RESPMEM_PERSISTENT);
+      ret = MHD_queue_auth_fail_response (connection, REALM,
+                                          MY_OPAQUE,
+                                          response,
+                                          MHD_NO);
+      MHD_destroy_response (response);
+      return ret;
+    }
+  if (NULL != cls)
+    ret = MHD_digest_auth_check_digest (connection, REALM,
+                                        username,
+                                        userdigest,
+                                        300);
+  else
+    ret = MHD_digest_auth_check (connection, REALM,
+                                 username,
+                                 "testpass",
+                                 300);
+  free (username);
+  if ( (ret == MHD_INVALID_NONCE) ||
+       (ret == MHD_NO) )
+    {
+      response = MHD_create_response_from_buffer (strlen (DENIED),
+                                                  DENIED,
+                                                  MHD_RESPMEM_PERSISTENT);
+      if (NULL == response)
+        return MHD_NO;
+      ret = MHD_queue_auth_fail_response (connection, REALM,
+                                          MY_OPAQUE,
+                                          response,
+                                          (ret == MHD_INVALID_NONCE) ? MHD_YES : MHD_NO);
+      MHD_destroy_response (response);
+      return ret;
+    }
+  response = MHD_create_response_from_buffer (strlen (PAGE), PAGE,
+                                              MHD_RESPMEM_PERSISTENT);
+  ret = MHD_queue_response (connection, MHD_HTTP_OK, response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+static CURL *
+setupCURL (const char *userpwd)
+{
+  CURL *c;
+
+  c = curl_easy_init ();
+  curl_easy_setopt (c, CURLOPT_URL, "http://127.0.0.1:1338/bar");
+  curl_easy_setopt (c, CURLOPT_WRITEFUNCTION, &discardBuffer);
+  curl_easy_setopt (c, CURLOPT_HTTPAUTH, CURLAUTH_DIGEST);
+  curl_easy_setopt (c, CURLOPT_USERPWD, userpwd);
+  curl_easy_setopt (c, CURLOPT_FAILONERROR, 1L);
+  curl_easy_setopt (c, CURLOPT_TIMEOUT, 150L);
+  curl_easy_setopt (c, CURLOPT_CONNECTTIMEOUT, 150L);
+  curl_easy_setopt (c, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+  curl_easy_setopt (c, CURLOPT_NOSIGNAL, 1L);
+  return c;
+}
+
+
+static int
+testDigestAuth (void *mode)
+{
+  CURL *c;
+  CURLcode errornum;
+  struct MHD_Daemon *d;
+  unsigned int i;
+  int ret;
+
+  d = MHD_start_daemon (MHD_USE_SELECT_INTERNALLY | MHD_USE_DEBUG,
+                        1338, NULL, NULL, &ahc_echo, mode,
+                        MHD_OPTION_DIGEST_AUTH_RANDOM, 8, "01234567",
+                        MHD_OPTION_END);
+  if (d == NULL)
+    return 1;
+  ret = 0;
+  /* the same nonce is used with increasing nonce counters */
+  c = setupCURL ("testuser:testpass");
+  for (i = 0; i < 5; i++)
+    {
+      if (CURLE_OK != (errornum = curl_easy_perform (c)))
+        {
+          fprintf (stderr,
+                   "curl_easy_perform failed: `%s'\n",
+                   curl_easy_strerror (errornum));
+          ret |= 2;
+        }
+    }
+  curl_easy_cleanup (c);
+  /* a wrong password must fail, even with a nonce that was
+     already used successfully */
+  c = setupCURL ("testuser:wrongpass");
+  if (CURLE_OK == curl_easy_perform (c))
+    ret |= 4;
+  curl_easy_cleanup (c);
+  MHD_stop_daemon (d);
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+
+#ifdef HAVE_GCRYPT_H
+  gcry_control (GCRYCTL_ENABLE_QUICK_RANDOM, 0);
+#ifdef GCRYCTL_INITIALIZATION_FINISHED
+  gcry_control (GCRYCTL_INITIALIZATION_FINISHED, 0);
+#endif
+#endif
+  if (0 != curl_global_init (CURL_GLOBAL_WIN32))
+    return 2;
+  errorCount += testDigestAuth ((void *) userdigest);
+  errorCount += testDigestAuth (NULL);
+  if (errorCount != 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  curl_global_cleanup ();
+  return errorCount != 0;       /* 0 == pass */
+}
@@ -0,0 +1,336 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file test_get_compressed.c
+ * @brief  Testcase for gzip/deflate compression of responses
+ *         (#MHD_OPTION_RESPONSE_COMPRESSION)
+ * @author libmicrohttpd contributors
+ */
+
+#include "MHD_config.h"
+#include "platform.h"
+#include <curl/curl.h>
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef WINDOWS
+#include <unistd.h>
+#endif
+
+#if defined(CPU_COUNT) && (CPU_COUNT+0) < 2
+#undef CPU_COUNT
+#endif
+#if !defined(CPU_COUNT)
+#define CPU_COUNT 2
+#endif
+
+/**
+ * Size of the test body.
+ */
+#define BODY_SIZE (256 * 1024)
+
+/**
+ * Responses smaller than this are not compressed.
+ */
+#define MIN_SIZE 1024
+
+/**
+ * The body we serve (and expect to get back).
+ */
+static char *body;
+
+struct CBC
+{
+  char *buf;
+  size_t pos;
+  size_t size;
+};
+
+/**
+ * Content codings seen in the response headers.
+ */
+struct HDR
+{
+  int gzip;
+  int deflate;
+  int vary;
+  int content_length;
+};
+
+
+static size_t
+copyBuffer (void *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  struct CBC *cbc = ctx;
+
+  if (cbc->pos + size * nmemb > cbc->size)
+    return 0;                   /* overflow */
+  memcpy (&cbc->buf[cbc->pos], ptr, size * nmemb);
+  cbc->pos += size * nmemb;
+  return size * nmemb;
+}
+
+
+static size_t
+checkHeader (char *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  struct HDR *hdr = ctx;
+  const size_t len = size * nmemb;
+
+  if ( (len >= strlen ("Content-Encoding: gzip")) &&
+       (0 == strncmp (ptr, "Content-Encoding: gzip",
+                      strlen ("Content-Encoding: gzip"))) )
+    hdr->gzip = 1;
+  if ( (len >= strlen ("Content-Encoding: deflate")) &&
+       (0 == strncmp (ptr, "Content-Encoding: deflate",
+                      strlen ("Content-Encoding: deflate"))) )
+    hdr->deflate = 1;
+  if ( (len >= strlen ("Vary: Accept-Encoding")) &&
+       (0 == strncmp (ptr, "Vary: Accept-Encoding",
+                      strlen ("Vary: Accept-Encoding"))) )
+    hdr->vary = 1;
+  if ( (len >= strlen ("Content-Length:")) &&
+       (0 == strncmp (ptr, "Content-Length:",
+                      strlen ("Content-Length:"))) )
+    hdr->content_length = 1;
+  return len;
+}
+
+
+/**
+ * Content reader returning the body in small, odd-sized pieces.
+ */
+static ssize_t
+crc (void *cls, uint64_t pos, char *buf, size_t max)
+{
+  size_t len;
+
+  (void) cls;
+  if (pos >= BODY_SIZE)
+    return MHD_CONTENT_READER_END_OF_STREAM;
+  len = 1000;
+  if (len > max)
+    len = max;
+  if (len > BODY_SIZE - pos)
+    len = BODY_SIZE - pos;
+  memcpy (buf, &body[pos], len);
+  return len;
+}
+
+
+static int
+ahc_echo (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **unused)
+{
+  struct MHD_Response *response;
+  int ret;
+
+  (void) cls; (void) version; (void) upload_data;
+  (void) upload_data_size; (void) unused;
+  if (0 != strcmp (MHD_HTTP_METHOD_GET, method))
+    return MHD_NO;              /* unexpected method */
+  if (0 == strcmp (url, "/callback"))
+    response = MHD_create_response_from_callback (MHD_SIZE_UNKNOWN,
+                                                  4096,
+                                                  &crc, NULL, NULL);
+  else if (0 == strcmp (url, "/small"))
+    response = MHD_create_response_from_buffer (MIN_SIZE - 1,
+                                                body,
+                                                MHD_RESPMEM_PERSISTENT);
+  else
+    response = MHD_create_response_from_buffer (BODY_SIZE,
+                                                body,
+                                                MHD_RESPMEM_PERSISTENT);
+  if (NULL == response)
+    return MHD_NO;
+  if (0 == strcmp (url, "/image"))
+    MHD_add_response_header (response,
+                             MHD_HTTP_HEADER_CONTENT_TYPE,
+                             "image/png");
+  else
+    MHD_add_response_header (response,
+                             MHD_HTTP_HEADER_CONTENT_TYPE,
+                             "text/plain");
+  ret = MHD_queue_response (connection, MHD_HTTP_OK, response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+/**
+ * Fetch @a path with the given "Accept-Encoding" and check the
+ * body and which content coding was used.
+ *
+ * @param port port the daemon listens on
+ * @param path URL path to request
+ * @param encoding value for "Accept-Encoding", NULL for none
+ * @param expect "gzip", "deflate" or NULL for uncompressed
+ * @param size expected size of the (decoded) body
+ * @return 0 on success
+ */
+static int
+fetch (uint16_t port,
+       const char *path,
+       const char *encoding,
+       const char *expect,
+       size_t size)
+{
+  CURL *c;
+  struct CBC cbc;
+  struct HDR hdr;
+  char url[128];
+  CURLcode errornum;
+
+  cbc.buf = malloc (BODY_SIZE);
+  if (NULL == cbc.buf)
+    return 1;
+  cbc.size = BODY_SIZE;
+  cbc.pos = 0;
+  memset (&hdr, 0, sizeof (hdr));
+  snprintf (url, sizeof (url), "http://127.0.0.1:%u%s",
+            (unsigned int) port, path);
+  c = curl_easy_init ();
+  curl_easy_setopt (c, CURLOPT_URL, url);
+  curl_easy_setopt (c, CURLOPT_WRITEFUNCTION, &copyBuffer);
+  curl_easy_setopt (c, CURLOPT_WRITEDATA, &cbc);
+  curl_easy_setopt (c, CURLOPT_HEADERFUNCTION, &checkHeader);
+  curl_easy_setopt (c, CURLOPT_HEADERDATA, &hdr);
+  if (NULL != encoding)
+    curl_easy_setopt (c, CURLOPT_ENCODING, encoding);
+  curl_easy_setopt (c, CURLOPT_FAILONERROR, 1);
+  curl_easy_setopt (c, CURLOPT_TIMEOUT, 150L);
+  curl_easy_setopt (c, CURLOPT_CONNECTTIMEOUT, 150L);
+  curl_easy_setopt (c, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+  curl_easy_setopt (c, CURLOPT_NOSIGNAL, 1);
+  errornum = curl_easy_perform (c);
+  curl_easy_cleanup (c);
+  if (CURLE_OK != errornum)
+    {
+      fprintf (stderr,
+               "curl_easy_perform failed for `%s': `%s'\n",
+               path,
+               curl_easy_strerror (errornum));
+      free (cbc.buf);
+      return 2;
+    }
+  if ( (cbc.pos != size) ||
+       (0 != memcmp (cbc.buf, body, size)) )
+    {
+      fprintf (stderr,
+               "Wrong body for `%s' (got %u bytes)\n",
+               path,
+               (unsigned int) cbc.pos);
+      free (cbc.buf);
+      return 4;
+    }
+  free (cbc.buf);
+  if ( (NULL == expect) &&
+       (hdr.gzip || hdr.deflate) )
+    {
+      fprintf (stderr,
+               "Unexpected compression for `%s'\n",
+               path);
+      return 8;
+    }
+  if ( (NULL != expect) &&
+       ( ( (0 == strcmp (expect, "gzip")) && (! hdr.gzip) ) ||
+         ( (0 == strcmp (expect, "deflate")) && (! hdr.deflate) ) ||
+         (hdr.content_length) ||
+         (! hdr.vary) ) )
+    {
+      fprintf (stderr,
+               "Missing or wrong compression for `%s'\n",
+               path);
+      return 16;
+    }
+  return 0;
+}
+
+
+static int
+testGet (unsigned int flags,
+         unsigned int pool_size,
+         uint16_t port)
+{
+  struct MHD_Daemon *d;
+  int ret;
+
+  d = MHD_start_daemon (flags | MHD_USE_DEBUG,
+                        port, NULL, NULL, &ahc_echo, NULL,
+                        MHD_OPTION_RESPONSE_COMPRESSION, (size_t) MIN_SIZE,
+                        MHD_OPTION_THREAD_POOL_SIZE, pool_size,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 1;
+  ret = 0;
+  ret |= fetch (port, "/buffer", "gzip", "gzip", BODY_SIZE);
+  ret |= fetch (port, "/buffer", "deflate", "deflate", BODY_SIZE);
+  ret |= fetch (port, "/callback", "gzip", "gzip", BODY_SIZE);
+  /* streams are reused from the pool now */
+  ret |= fetch (port, "/callback", "gzip", "gzip", BODY_SIZE);
+  ret |= fetch (port, "/buffer", NULL, NULL, BODY_SIZE);
+  ret |= fetch (port, "/small", "gzip", NULL, MIN_SIZE - 1);
+  ret |= fetch (port, "/image", "gzip", NULL, BODY_SIZE);
+  MHD_stop_daemon (d);
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+  curl_version_info_data *curl_info;
+  size_t i;
+
+  if (MHD_YES != MHD_is_feature_supported (MHD_FEATURE_COMPRESSION))
+    return 77;
+  if (0 != curl_global_init (CURL_GLOBAL_WIN32))
+    return 2;
+  curl_info = curl_version_info (CURLVERSION_NOW);
+  if (0 == (curl_info->features & CURL_VERSION_LIBZ))
+    {
+      curl_global_cleanup ();
+      return 77;
+    }
+  body = malloc (BODY_SIZE);
+  if (NULL == body)
+    return 2;
+  for (i = 0; i < BODY_SIZE; i++)
+    body[i] = "{\"key\": \"value\", \"n\": 0123456789}\n"[i % 35];
+  errorCount += testGet (MHD_USE_SELECT_INTERNALLY, 0, 1084);
+  errorCount += testGet (MHD_USE_THREAD_PER_CONNECTION, 0, 1085);
+  errorCount += testGet (MHD_USE_SELECT_INTERNALLY, CPU_COUNT, 1086);
+  if (MHD_YES == MHD_is_feature_supported (MHD_FEATURE_EPOLL))
+    errorCount += testGet (MHD_USE_EPOLL_INTERNALLY, 0, 1087);
+  if (errorCount != 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  free (body);
+  curl_global_cleanup ();
+  return errorCount != 0;       /* 0 == pass */
+}
@@ -0,0 +1,234 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file test_ipfilter.c
+ * @brief  Testcase for address range filters (#MHD_OPTION_IP_FILTER)
+ * @author libmicrohttpd contributors
+ */
+
+#include "MHD_config.h"
+#include "platform.h"
+#include <curl/curl.h>
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mhd_sockets.h" /* for struct sockaddr_in */
+
+#ifndef WINDOWS
+#include <unistd.h>
+#endif
+
+/**
+ * Port of the daemon.
+ */
+#define PORT 1094
+
+
+static size_t
+discardBuffer (void *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  (void) ptr; (void) ctx;
+  return size * nmemb;
+}
+
+
+static int
+ahc_echo (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **unused)
+{
+  static const char *page = "ok";
+  struct MHD_Response *response;
+  int ret;
+
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size; (void) unused;
+  response = MHD_create_response_from_buffer (strlen (page),
+                                              (void *) page,
+                                              MHD_RESPMEM_PERSISTENT);
+  ret = MHD_queue_response (connection, MHD_HTTP_OK, response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+/**
+ * Fetch a page over a new connection.
+ *
+ * @return 0 if the request succeeded, 1 if not
+ */
+static int
+fetch (void)
+{
+  CURL *c;
+  CURLcode errornum;
+
+  c = curl_easy_init ();
+  curl_easy_setopt (c, CURLOPT_URL, "http://127.0.0.1:1094/");
+  curl_easy_setopt (c, CURLOPT_WRITEFUNCTION, &discardBuffer);
+  curl_easy_setopt (c, CURLOPT_FAILONERROR, 1);
+  curl_easy_setopt (c, CURLOPT_TIMEOUT, 15L);
+  curl_easy_setopt (c, CURLOPT_CONNECTTIMEOUT, 15L);
+  curl_easy_setopt (c, CURLOPT_FORBID_REUSE, 1L);
+  curl_easy_setopt (c, CURLOPT_NOSIGNAL, 1);
+  errornum = curl_easy_perform (c);
+  curl_easy_cleanup (c);
+  return (CURLE_OK == errornum) ? 0 : 1;
+}
+
+
+/**
+ * Create a filter with one IPv4 range.
+ */
+static struct MHD_IPFilter *
+make_filter (enum MHD_IPFilterAction default_action,
+             uint32_t ip,
+             unsigned int prefix_len,
+             enum MHD_IPFilterAction action,
+             unsigned int rate,
+             unsigned int burst)
+{
+  struct MHD_IPFilter *filter;
+  struct sockaddr_in sa;
+
+  filter = MHD_ip_filter_create (default_action);
+  if (NULL == filter)
+    return NULL;
+  memset (&sa, 0, sizeof (sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl (ip);
+  if (MHD_YES != MHD_ip_filter_add (filter,
+                                    (struct sockaddr *) &sa,
+                                    sizeof (sa),
+                                    prefix_len,
+                                    action,
+                                    rate,
+                                    burst))
+    {
+      MHD_ip_filter_destroy (filter);
+      return NULL;
+    }
+  return filter;
+}
+
+
+static int
+testFilter (unsigned int flags)
+{
+  struct MHD_Daemon *d;
+  struct MHD_IPFilter *filter;
+  struct sockaddr_in sa;
+  unsigned int failed;
+  unsigned int i;
+  int ret;
+
+  ret = 0;
+  /* nothing to replace if the daemon was started without a filter */
+  d = MHD_start_daemon (flags | MHD_USE_DEBUG,
+                        PORT, NULL, NULL, &ahc_echo, NULL,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 1;
+  if (MHD_NO != MHD_set_ip_filter (d, NULL))
+    ret |= 2;
+  MHD_stop_daemon (d);
+
+  /* loopback denied */
+  filter = make_filter (MHD_IP_FILTER_ALLOW,
+                        0x7F000000, 8,
+                        MHD_IP_FILTER_DENY, 0, 0);
+  if (NULL == filter)
+    return 1;
+  d = MHD_start_daemon (flags | MHD_USE_DEBUG,
+                        PORT, NULL, NULL, &ahc_echo, NULL,
+                        MHD_OPTION_IP_FILTER, filter,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    {
+      MHD_ip_filter_destroy (filter);
+      return 1;
+    }
+  if (0 == fetch ())
+    ret |= 4;
+
+  /* the most specific range wins */
+  filter = make_filter (MHD_IP_FILTER_DENY,
+                        0x7F000000, 8,
+                        MHD_IP_FILTER_DENY, 0, 0);
+  memset (&sa, 0, sizeof (sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl (0x7F000001);
+  if ( (NULL == filter) ||
+       (MHD_YES != MHD_ip_filter_add (filter,
+                                      (struct sockaddr *) &sa,
+                                      sizeof (sa),
+                                      32,
+                                      MHD_IP_FILTER_ALLOW,
+                                      0, 0)) ||
+       (MHD_YES != MHD_set_ip_filter (d, filter)) )
+    ret |= 8;
+  if (0 != fetch ())
+    ret |= 16;
+
+  /* rate limit of one connection per second, burst of two; at
+     most one refill can happen while we try five connections */
+  filter = make_filter (MHD_IP_FILTER_DENY,
+                        0x7F000000, 8,
+                        MHD_IP_FILTER_ALLOW, 1, 2);
+  if ( (NULL == filter) ||
+       (MHD_YES != MHD_set_ip_filter (d, filter)) )
+    ret |= 8;
+  failed = 0;
+  for (i = 0; i < 5; i++)
+    failed += fetch ();
+  if ( (failed < 2) ||
+       (failed > 3) )
+    ret |= 32;
+
+  /* no filter at all */
+  if (MHD_YES != MHD_set_ip_filter (d, NULL))
+    ret |= 8;
+  if (0 != fetch ())
+    ret |= 64;
+  MHD_stop_daemon (d);
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+
+  if (0 != curl_global_init (CURL_GLOBAL_WIN32))
+    return 2;
+  errorCount += testFilter (MHD_USE_SELECT_INTERNALLY);
+  errorCount += testFilter (MHD_USE_THREAD_PER_CONNECTION);
+  if (errorCount != 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  curl_global_cleanup ();
+  return errorCount != 0;       /* 0 == pass */
+}
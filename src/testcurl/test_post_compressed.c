@@ -0,0 +1,424 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file test_post_compressed.c
+ * @brief  Testcase for decompression of request bodies
+ *         (#MHD_OPTION_REQUEST_DECOMPRESSION)
+ * @author libmicrohttpd contributors
+ */
+
+#include "MHD_config.h"
+#include "platform.h"
+#include <curl/curl.h>
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#ifndef WINDOWS
+#include <unistd.h>
+#endif
+
+#if defined(CPU_COUNT) && (CPU_COUNT+0) < 2
+#undef CPU_COUNT
+#endif
+#if !defined(CPU_COUNT)
+#define CPU_COUNT 2
+#endif
+
+/**
+ * Size of the uncompressed test body.
+ */
+#define BODY_SIZE (256 * 1024)
+
+/**
+ * Limit on the size of decompressed bodies.
+ */
+#define MAX_SIZE (BODY_SIZE + 1024)
+
+/**
+ * The uncompressed body.
+ */
+static char *body;
+
+/**
+ * Per-request state of the handler.
+ */
+struct Upload
+{
+  char *buf;
+  size_t pos;
+};
+
+struct CBC
+{
+  char *buf;
+  size_t pos;
+  size_t size;
+};
+
+/**
+ * Data for the content reader of curl (chunked uploads).
+ */
+struct RCB
+{
+  const char *data;
+  size_t pos;
+  size_t size;
+};
+
+
+static size_t
+copyBuffer (void *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  struct CBC *cbc = ctx;
+
+  if (cbc->pos + size * nmemb > cbc->size)
+    return 0;                   /* overflow */
+  memcpy (&cbc->buf[cbc->pos], ptr, size * nmemb);
+  cbc->pos += size * nmemb;
+  return size * nmemb;
+}
+
+
+static size_t
+readBuffer (void *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  struct RCB *rcb = ctx;
+  size_t len = size * nmemb;
+
+  /* small pieces, so that chunks end in the middle of
+     deflate blocks */
+  if (len > 777)
+    len = 777;
+  if (len > rcb->size - rcb->pos)
+    len = rcb->size - rcb->pos;
+  memcpy (ptr, &rcb->data[rcb->pos], len);
+  rcb->pos += len;
+  return len;
+}
+
+
+static void
+completed (void *cls,
+           struct MHD_Connection *connection,
+           void **con_cls,
+           enum MHD_RequestTerminationCode toe)
+{
+  struct Upload *up = *con_cls;
+
+  (void) cls; (void) connection; (void) toe;
+  if (NULL == up)
+    return;
+  free (up->buf);
+  free (up);
+  *con_cls = NULL;
+}
+
+
+static int
+ahc_echo (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **con_cls)
+{
+  const int *partial = cls;
+  struct Upload *up = *con_cls;
+  struct MHD_Response *response;
+  size_t len;
+  int ret;
+
+  (void) url; (void) version;
+  if (0 != strcmp (MHD_HTTP_METHOD_POST, method))
+    return MHD_NO;              /* unexpected method */
+  if (NULL == up)
+    {
+      up = malloc (sizeof (struct Upload));
+      if (NULL == up)
+        return MHD_NO;
+      up->buf = malloc (MAX_SIZE);
+      if (NULL == up->buf)
+        {
+          free (up);
+          return MHD_NO;
+        }
+      up->pos = 0;
+      *con_cls = up;
+      return MHD_YES;
+    }
+  if (0 != *upload_data_size)
+    {
+      len = *upload_data_size;
+      /* optionally leave some data for the next call */
+      if ( (*partial) &&
+           (len > 1000) )
+        len = 1000;
+      if (up->pos + len > MAX_SIZE)
+        return MHD_NO;
+      memcpy (&up->buf[up->pos], upload_data, len);
+      up->pos += len;
+      *upload_data_size -= len;
+      if (0 != *upload_data_size)
+        {
+          /* make MHD call us again for the rest */
+          MHD_suspend_connection (connection);
+          MHD_resume_connection (connection);
+        }
+      return MHD_YES;
+    }
+  if ( (BODY_SIZE != up->pos) ||
+       (0 != memcmp (up->buf, body, BODY_SIZE)) )
+    {
+      fprintf (stderr,
+               "Wrong upload (%u bytes)\n",
+               (unsigned int) up->pos);
+      return MHD_NO;
+    }
+  response = MHD_create_response_from_buffer (strlen ("ok"),
+                                              (void *) "ok",
+                                              MHD_RESPMEM_PERSISTENT);
+  ret = MHD_queue_response (connection, MHD_HTTP_OK, response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+/**
+ * Compress @a size bytes at @a data.
+ *
+ * @param data data to compress
+ * @param size number of bytes at @a data
+ * @param gzip non-zero for gzip format, zero for zlib ("deflate")
+ * @param[out] out_size set to the size of the result
+ * @return the compressed data, NULL on error
+ */
+static char *
+compress_data (const char *data,
+               size_t size,
+               int gzip,
+               size_t *out_size)
+{
+  z_stream zs;
+  char *out;
+  size_t max;
+
+  memset (&zs, 0, sizeof (zs));
+  if (Z_OK != deflateInit2 (&zs,
+                            Z_BEST_COMPRESSION,
+                            Z_DEFLATED,
+                            gzip ? 15 + 16 : 15,
+                            8,
+                            Z_DEFAULT_STRATEGY))
+    return NULL;
+  max = deflateBound (&zs, size);
+  out = malloc (max);
+  if (NULL == out)
+    {
+      deflateEnd (&zs);
+      return NULL;
+    }
+  zs.next_in = (Bytef *) data;
+  zs.avail_in = size;
+  zs.next_out = (Bytef *) out;
+  zs.avail_out = max;
+  if (Z_STREAM_END != deflate (&zs, Z_FINISH))
+    {
+      deflateEnd (&zs);
+      free (out);
+      return NULL;
+    }
+  *out_size = max - zs.avail_out;
+  deflateEnd (&zs);
+  return out;
+}
+
+
+/**
+ * Upload @a size bytes at @a data with the given "Content-Encoding".
+ *
+ * @param port port the daemon listens on
+ * @param data request body to send
+ * @param size number of bytes at @a data
+ * @param encoding value for "Content-Encoding"
+ * @param chunked non-zero to send the body with chunked encoding
+ * @return 0 if the server replied with "ok", 1 if the request
+ *         failed
+ */
+static int
+upload (uint16_t port,
+        const char *data,
+        size_t size,
+        const char *encoding,
+        int chunked)
+{
+  CURL *c;
+  struct CBC cbc;
+  struct RCB rcb;
+  struct curl_slist *headers;
+  char hdr[64];
+  char url[128];
+  char buf[16];
+  CURLcode errornum;
+
+  cbc.buf = buf;
+  cbc.size = sizeof (buf);
+  cbc.pos = 0;
+  rcb.data = data;
+  rcb.size = size;
+  rcb.pos = 0;
+  snprintf (url, sizeof (url), "http://127.0.0.1:%u/", (unsigned int) port);
+  snprintf (hdr, sizeof (hdr), "Content-Encoding: %s", encoding);
+  headers = curl_slist_append (NULL, hdr);
+  if (chunked)
+    headers = curl_slist_append (headers, "Transfer-Encoding: chunked");
+  headers = curl_slist_append (headers, "Content-Type: application/json");
+  c = curl_easy_init ();
+  curl_easy_setopt (c, CURLOPT_URL, url);
+  curl_easy_setopt (c, CURLOPT_WRITEFUNCTION, &copyBuffer);
+  curl_easy_setopt (c, CURLOPT_WRITEDATA, &cbc);
+  curl_easy_setopt (c, CURLOPT_HTTPHEADER, headers);
+  curl_easy_setopt (c, CURLOPT_POST, 1L);
+  if (chunked)
+    {
+      curl_easy_setopt (c, CURLOPT_READFUNCTION, &readBuffer);
+      curl_easy_setopt (c, CURLOPT_READDATA, &rcb);
+    }
+  else
+    {
+      curl_easy_setopt (c, CURLOPT_POSTFIELDS, data);
+      curl_easy_setopt (c, CURLOPT_POSTFIELDSIZE, (long) size);
+    }
+  curl_easy_setopt (c, CURLOPT_FAILONERROR, 1L);
+  curl_easy_setopt (c, CURLOPT_TIMEOUT, 150L);
+  curl_easy_setopt (c, CURLOPT_CONNECTTIMEOUT, 150L);
+  curl_easy_setopt (c, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+  curl_easy_setopt (c, CURLOPT_NOSIGNAL, 1L);
+  errornum = curl_easy_perform (c);
+  curl_easy_cleanup (c);
+  curl_slist_free_all (headers);
+  if (CURLE_OK != errornum)
+    return 1;
+  if ( (2 != cbc.pos) ||
+       (0 != memcmp (buf, "ok", 2)) )
+    return 1;
+  return 0;
+}
+
+
+static int
+testPost (unsigned int flags,
+          unsigned int pool_size,
+          int partial,
+          uint16_t port)
+{
+  struct MHD_Daemon *d;
+  char *gz;
+  char *zl;
+  char *bomb;
+  char *zeros;
+  size_t gz_size;
+  size_t zl_size;
+  size_t bomb_size;
+  int ret;
+
+  gz = compress_data (body, BODY_SIZE, 1, &gz_size);
+  zl = compress_data (body, BODY_SIZE, 0, &zl_size);
+  zeros = calloc (1, 16 * MAX_SIZE);
+  bomb = (NULL == zeros) ? NULL : compress_data (zeros, 16 * MAX_SIZE,
+                                                 1, &bomb_size);
+  free (zeros);
+  if ( (NULL == gz) ||
+       (NULL == zl) ||
+       (NULL == bomb) )
+    {
+      free (gz);
+      free (zl);
+      free (bomb);
+      return 1;
+    }
+  d = MHD_start_daemon (flags | MHD_USE_DEBUG,
+                        port, NULL, NULL, &ahc_echo, &partial,
+                        MHD_OPTION_NOTIFY_COMPLETED, &completed, NULL,
+                        MHD_OPTION_REQUEST_DECOMPRESSION, (size_t) MAX_SIZE,
+                        MHD_OPTION_THREAD_POOL_SIZE, pool_size,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    {
+      free (gz);
+      free (zl);
+      free (bomb);
+      return 1;
+    }
+  ret = 0;
+  if (0 != upload (port, gz, gz_size, "gzip", 0))
+    ret |= 2;
+  if (0 != upload (port, zl, zl_size, "deflate", 0))
+    ret |= 4;
+  if (0 != upload (port, gz, gz_size, "gzip", 1))
+    ret |= 8;
+  /* unknown codings are passed through, the handler sees
+     the raw data */
+  if (0 != upload (port, body, BODY_SIZE, "identity", 0))
+    ret |= 16;
+  /* these must be refused */
+  if (0 == upload (port, bomb, bomb_size, "gzip", 0))
+    ret |= 32;
+  if (0 == upload (port, gz, gz_size / 2, "gzip", 0))
+    ret |= 64;
+  if (0 == upload (port, body, BODY_SIZE, "gzip", 0))
+    ret |= 128;
+  MHD_stop_daemon (d);
+  free (gz);
+  free (zl);
+  free (bomb);
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+  size_t i;
+
+  if (MHD_YES != MHD_is_feature_supported (MHD_FEATURE_COMPRESSION))
+    return 77;
+  if (0 != curl_global_init (CURL_GLOBAL_WIN32))
+    return 2;
+  body = malloc (BODY_SIZE);
+  if (NULL == body)
+    return 2;
+  for (i = 0; i < BODY_SIZE; i++)
+    body[i] = "{\"key\": \"value\", \"n\": 0123456789}\n"[(i * 7) % 35];
+  errorCount += testPost (MHD_USE_SELECT_INTERNALLY, 0, 0, 1090);
+  errorCount += testPost (MHD_USE_SELECT_INTERNALLY | MHD_USE_SUSPEND_RESUME,
+                          0, 1, 1091);
+  errorCount += testPost (MHD_USE_THREAD_PER_CONNECTION, 0, 0, 1092);
+  errorCount += testPost (MHD_USE_SELECT_INTERNALLY, CPU_COUNT, 0, 1093);
+  if (errorCount != 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  free (body);
+  curl_global_cleanup ();
+  return errorCount != 0;       /* 0 == pass */
+}
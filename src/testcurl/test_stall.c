@@ -0,0 +1,272 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file test_stall.c
+ * @brief  Testcase for #MHD_OPTION_STALL_THRESHOLD
+ * @author libmicrohttpd contributors
+ */
+
+#include "MHD_config.h"
+#include "platform.h"
+#include <curl/curl.h>
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef WINDOWS
+#include <unistd.h>
+#endif
+
+/**
+ * Port of the daemon.
+ */
+#define PORT 1098
+
+/**
+ * Threshold of the watchdog, in microseconds.
+ */
+#define THRESHOLD_USEC 20000
+
+/**
+ * How long the slow callbacks take, in microseconds.
+ */
+#define SLOW_USEC 60000
+
+
+/**
+ * Number of stalls reported per `enum MHD_StallSource`.
+ */
+static volatile unsigned int stalls[MHD_STALL_REQUEST_COMPLETED + 1];
+
+/**
+ * Set if a stall was reported with wrong arguments.
+ */
+static volatile int bad_report;
+
+/**
+ * Number of worker threads of the daemon being tested.
+ */
+static unsigned int num_workers;
+
+
+static size_t
+discardBuffer (void *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  (void) ptr; (void) ctx;
+  return size * nmemb;
+}
+
+
+static void
+stall_cb (void *cls,
+          enum MHD_StallSource source,
+          const char *method,
+          const char *url,
+          unsigned int worker,
+          uint64_t duration_usec)
+{
+  (void) cls;
+  if ( ((unsigned int) source > MHD_STALL_REQUEST_COMPLETED) ||
+       (worker >= num_workers) ||
+       (duration_usec < THRESHOLD_USEC) )
+    {
+      bad_report = 1;
+      return;
+    }
+  if (MHD_STALL_EVENT_LOOP == source)
+    {
+      if ( (NULL != method) ||
+           (NULL != url) )
+        bad_report = 1;
+    }
+  else if ( (NULL == method) ||
+            (NULL == url) ||
+            (0 != strcmp (method, MHD_HTTP_METHOD_GET)) ||
+            ( (MHD_STALL_ACCESS_HANDLER == source) &&
+              (0 != strcmp (url, "/slow")) ) ||
+            ( (MHD_STALL_CONTENT_READER == source) &&
+              (0 != strcmp (url, "/slowbody")) ) )
+    bad_report = 1;
+  stalls[source]++;
+}
+
+
+static ssize_t
+slow_reader (void *cls,
+             uint64_t pos,
+             char *buf,
+             size_t max)
+{
+  (void) cls;
+  if (pos > 0)
+    return MHD_CONTENT_READER_END_OF_STREAM;
+  usleep (SLOW_USEC);
+  buf[0] = 'x';
+  return 1;
+}
+
+
+static int
+ahc_echo (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **unused)
+{
+  static const char *page = "ok";
+  struct MHD_Response *response;
+  int ret;
+
+  (void) cls; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size; (void) unused;
+  if (0 == strcmp (url, "/slow"))
+    usleep (SLOW_USEC);
+  if (0 == strcmp (url, "/slowbody"))
+    response = MHD_create_response_from_callback (MHD_SIZE_UNKNOWN,
+                                                  1024,
+                                                  &slow_reader,
+                                                  NULL,
+                                                  NULL);
+  else
+    response = MHD_create_response_from_buffer (strlen (page),
+                                                (void *) page,
+                                                MHD_RESPMEM_PERSISTENT);
+  ret = MHD_queue_response (connection, MHD_HTTP_OK, response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+/**
+ * Fetch a page over a new connection.
+ *
+ * @param url the URL to fetch
+ * @return 0 if the request succeeded, 1 if not
+ */
+static int
+fetch (const char *url)
+{
+  CURL *c;
+  CURLcode errornum;
+
+  c = curl_easy_init ();
+  curl_easy_setopt (c, CURLOPT_URL, url);
+  curl_easy_setopt (c, CURLOPT_WRITEFUNCTION, &discardBuffer);
+  curl_easy_setopt (c, CURLOPT_FAILONERROR, 1);
+  curl_easy_setopt (c, CURLOPT_TIMEOUT, 15L);
+  curl_easy_setopt (c, CURLOPT_CONNECTTIMEOUT, 15L);
+  curl_easy_setopt (c, CURLOPT_NOSIGNAL, 1);
+  errornum = curl_easy_perform (c);
+  curl_easy_cleanup (c);
+  return (CURLE_OK == errornum) ? 0 : 1;
+}
+
+
+static int
+testStall (unsigned int flags,
+           unsigned int pool)
+{
+  struct MHD_Daemon *d;
+  struct MHD_DaemonStats stats;
+  int have_stats;
+  int loops;
+  time_t start;
+  int ret;
+
+  memset ((void *) stalls, 0, sizeof (stalls));
+  bad_report = 0;
+  num_workers = (0 == pool) ? 1 : pool;
+  loops = (0 == (flags & MHD_USE_THREAD_PER_CONNECTION));
+  d = MHD_start_daemon (flags | MHD_USE_DEBUG,
+                        PORT, NULL, NULL, &ahc_echo, NULL,
+                        MHD_OPTION_THREAD_POOL_SIZE, pool,
+                        MHD_OPTION_STALL_THRESHOLD, (unsigned int) THRESHOLD_USEC,
+                        MHD_OPTION_STALL_CALLBACK, &stall_cb, NULL,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 1;
+  ret = 0;
+  if (0 != fetch ("http://127.0.0.1:1098/fast"))
+    ret |= 2;
+  if (0 != stalls[MHD_STALL_ACCESS_HANDLER] +
+      stalls[MHD_STALL_CONTENT_READER])
+    ret |= 4;
+  if ( (0 != fetch ("http://127.0.0.1:1098/slow")) ||
+       (0 != fetch ("http://127.0.0.1:1098/slowbody")) )
+    ret |= 2;
+
+  /* the event loop is reported after its iteration */
+  start = time (NULL);
+  do
+    {
+      have_stats = MHD_get_daemon_stats (d, &stats);
+      if ( (MHD_YES != have_stats) ||
+           ( (stats.stalls >= 2) &&
+             ( (! loops) ||
+               (0 != stalls[MHD_STALL_EVENT_LOOP]) ) ) )
+        break;
+      usleep (10000);
+    }
+  while (time (NULL) - start < 5);
+  if ( (MHD_YES != have_stats) ||
+       (bad_report) ||
+       (1 != stalls[MHD_STALL_ACCESS_HANDLER]) ||
+       (1 != stalls[MHD_STALL_CONTENT_READER]) ||
+       (0 != stalls[MHD_STALL_REQUEST_COMPLETED]) ||
+       (stats.stalls < 2) ||
+       ( (loops) &&
+         ( (0 == stalls[MHD_STALL_EVENT_LOOP]) ||
+           (stats.loop_lag_max_usec < SLOW_USEC) ) ) )
+    {
+      fprintf (stderr,
+               "Unexpected stalls: %u loop, %u handler, %u reader, %u completed%s\n",
+               stalls[MHD_STALL_EVENT_LOOP],
+               stalls[MHD_STALL_ACCESS_HANDLER],
+               stalls[MHD_STALL_CONTENT_READER],
+               stalls[MHD_STALL_REQUEST_COMPLETED],
+               bad_report ? " (bad report)" : "");
+      ret |= 8;
+    }
+  MHD_stop_daemon (d);
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+
+  if (0 != curl_global_init (CURL_GLOBAL_WIN32))
+    return 2;
+  errorCount += testStall (MHD_USE_SELECT_INTERNALLY, 0);
+  errorCount += testStall (MHD_USE_SELECT_INTERNALLY, 2);
+  if (MHD_YES == MHD_is_feature_supported (MHD_FEATURE_POLL))
+    errorCount += testStall (MHD_USE_SELECT_INTERNALLY | MHD_USE_POLL, 0);
+  errorCount += testStall (MHD_USE_THREAD_PER_CONNECTION, 0);
+  if (errorCount != 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  curl_global_cleanup ();
+  return errorCount != 0;       /* 0 == pass */
+}
@@ -0,0 +1,192 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file test_stats.c
+ * @brief  Testcase for #MHD_get_daemon_stats()
+ * @author libmicrohttpd contributors
+ */
+
+#include "MHD_config.h"
+#include "platform.h"
+#include <curl/curl.h>
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef WINDOWS
+#include <unistd.h>
+#endif
+
+/**
+ * Port of the daemon.
+ */
+#define PORT 1096
+
+/**
+ * Number of requests sent over one connection.
+ */
+#define NUM_REQUESTS 3
+
+/**
+ * Body of the responses.
+ */
+#define PAGE "Hello, statistics"
+
+
+static size_t
+discardBuffer (void *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  (void) ptr; (void) ctx;
+  return size * nmemb;
+}
+
+
+static int
+ahc_echo (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **unused)
+{
+  struct MHD_Response *response;
+  int ret;
+
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size; (void) unused;
+  response = MHD_create_response_from_buffer (strlen (PAGE),
+                                              (void *) PAGE,
+                                              MHD_RESPMEM_PERSISTENT);
+  ret = MHD_queue_response (connection, MHD_HTTP_OK, response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+/**
+ * Sum of the closed connections in @a stats.
+ */
+static uint64_t
+num_closed (const struct MHD_DaemonStats *stats)
+{
+  uint64_t sum;
+  unsigned int i;
+
+  sum = 0;
+  for (i = 0; i <= MHD_REQUEST_TERMINATED_CLIENT_ABORT; i++)
+    sum += stats->connections_closed[i];
+  return sum;
+}
+
+
+static int
+testStats (unsigned int flags,
+           unsigned int pool)
+{
+  struct MHD_Daemon *d;
+  struct MHD_DaemonStats stats;
+  int have_stats;
+  CURL *c;
+  unsigned int i;
+  time_t start;
+  int ret;
+
+  d = MHD_start_daemon (flags | MHD_USE_DEBUG,
+                        PORT, NULL, NULL, &ahc_echo, NULL,
+                        MHD_OPTION_THREAD_POOL_SIZE, pool,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 1;
+  ret = 0;
+  have_stats = MHD_get_daemon_stats (d, &stats);
+  if ( (MHD_YES != have_stats) ||
+       (0 != stats.connections_accepted) ||
+       (0 != stats.bytes_sent) )
+    ret |= 2;
+
+  /* several requests over one connection */
+  c = curl_easy_init ();
+  curl_easy_setopt (c, CURLOPT_URL, "http://127.0.0.1:1096/");
+  curl_easy_setopt (c, CURLOPT_WRITEFUNCTION, &discardBuffer);
+  curl_easy_setopt (c, CURLOPT_FAILONERROR, 1);
+  curl_easy_setopt (c, CURLOPT_TIMEOUT, 15L);
+  curl_easy_setopt (c, CURLOPT_CONNECTTIMEOUT, 15L);
+  curl_easy_setopt (c, CURLOPT_NOSIGNAL, 1);
+  for (i = 0; i < NUM_REQUESTS; i++)
+    if (CURLE_OK != curl_easy_perform (c))
+      ret |= 4;
+  curl_easy_cleanup (c);
+
+  /* the close of the connection is seen asynchronously */
+  start = time (NULL);
+  do
+    {
+      have_stats = MHD_get_daemon_stats (d, &stats);
+      if ( (MHD_YES == have_stats) &&
+           (1 == num_closed (&stats)) )
+        break;
+      usleep (10000);
+    }
+  while (time (NULL) - start < 5);
+  if (MHD_YES != have_stats)
+    {
+      MHD_stop_daemon (d);
+      return ret | 8;
+    }
+  if ( (1 != stats.connections_accepted) ||
+       (NUM_REQUESTS != stats.requests_completed) ||
+       (NUM_REQUESTS - 1 > stats.keepalive_reuses) ||
+       (NUM_REQUESTS * strlen (PAGE) > stats.bytes_sent) ||
+       (stats.bytes_sendfile > stats.bytes_sent) ||
+       (NUM_REQUESTS * strlen ("GET / HTTP/1.1\r\n\r\n") > stats.bytes_received) ||
+       (0 != stats.connections_suspended) ||
+       (1 != num_closed (&stats)) )
+    {
+      fprintf (stderr,
+               "Unexpected statistics: %u accepted, %u completed, %u reused, %u closed\n",
+               (unsigned int) stats.connections_accepted,
+               (unsigned int) stats.requests_completed,
+               (unsigned int) stats.keepalive_reuses,
+               (unsigned int) num_closed (&stats));
+      ret |= 16;
+    }
+  MHD_stop_daemon (d);
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+
+  if (0 != curl_global_init (CURL_GLOBAL_WIN32))
+    return 2;
+  errorCount += testStats (MHD_USE_SELECT_INTERNALLY, 0);
+  errorCount += testStats (MHD_USE_SELECT_INTERNALLY, 2);
+  errorCount += testStats (MHD_USE_THREAD_PER_CONNECTION, 0);
+  if (errorCount != 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  curl_global_cleanup ();
+  return errorCount != 0;       /* 0 == pass */
+}
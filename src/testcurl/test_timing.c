@@ -0,0 +1,223 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file test_timing.c
+ * @brief  Testcase for #MHD_OPTION_REQUEST_TIMING
+ * @author libmicrohttpd contributors
+ */
+
+#include "MHD_config.h"
+#include "platform.h"
+#include <curl/curl.h>
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef WINDOWS
+#include <unistd.h>
+#endif
+
+/**
+ * Port of the daemon.
+ */
+#define PORT 1097
+
+/**
+ * Number of requests sent over one connection.
+ */
+#define NUM_REQUESTS 4
+
+/**
+ * How long the handler takes, in microseconds.
+ */
+#define HANDLER_USEC 20000
+
+
+/**
+ * Number of requests for which the completion callback saw a
+ * plausible #MHD_CONNECTION_INFO_REQUEST_TIMING.
+ */
+static volatile unsigned int timed_ok;
+
+
+static size_t
+discardBuffer (void *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  (void) ptr; (void) ctx;
+  return size * nmemb;
+}
+
+
+static int
+ahc_echo (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **unused)
+{
+  static const char *page = "slow";
+  struct MHD_Response *response;
+  int ret;
+
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size; (void) unused;
+  usleep (HANDLER_USEC);
+  response = MHD_create_response_from_buffer (strlen (page),
+                                              (void *) page,
+                                              MHD_RESPMEM_PERSISTENT);
+  ret = MHD_queue_response (connection, MHD_HTTP_OK, response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+static void
+completed_cb (void *cls,
+              struct MHD_Connection *connection,
+              void **con_cls,
+              enum MHD_RequestTerminationCode toe)
+{
+  const union MHD_ConnectionInfo *info;
+
+  (void) cls; (void) con_cls;
+  if (MHD_REQUEST_TERMINATED_COMPLETED_OK != toe)
+    return;
+  info = MHD_get_connection_info (connection,
+                                  MHD_CONNECTION_INFO_REQUEST_TIMING);
+  if ( (NULL != info) &&
+       (HANDLER_USEC <= info->phase_usec[MHD_REQUEST_PHASE_HANDLER]) &&
+       (info->phase_usec[MHD_REQUEST_PHASE_HANDLER] <=
+        info->phase_usec[MHD_REQUEST_PHASE_TOTAL]) )
+    timed_ok++;
+}
+
+
+static int
+testTiming (unsigned int flags,
+            unsigned int pool)
+{
+  struct MHD_Daemon *d;
+  struct MHD_Histogram total;
+  struct MHD_Histogram handler;
+  int found;
+  CURL *c;
+  unsigned int i;
+  time_t start;
+  int ret;
+
+  /* nothing is measured without the option */
+  d = MHD_start_daemon (flags | MHD_USE_DEBUG,
+                        PORT, NULL, NULL, &ahc_echo, NULL,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 1;
+  ret = 0;
+  if (MHD_NO != MHD_get_phase_histogram (d,
+                                         MHD_REQUEST_PHASE_TOTAL,
+                                         &total))
+    ret |= 2;
+  MHD_stop_daemon (d);
+
+  timed_ok = 0;
+  d = MHD_start_daemon (flags | MHD_USE_DEBUG,
+                        PORT, NULL, NULL, &ahc_echo, NULL,
+                        MHD_OPTION_THREAD_POOL_SIZE, pool,
+                        MHD_OPTION_REQUEST_TIMING, (unsigned int) MHD_YES,
+                        MHD_OPTION_NOTIFY_COMPLETED, &completed_cb, NULL,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return ret | 1;
+  if (MHD_NO != MHD_get_phase_histogram (d,
+                                         MHD_REQUEST_PHASE_COUNT,
+                                         &total))
+    ret |= 2;
+  c = curl_easy_init ();
+  curl_easy_setopt (c, CURLOPT_URL, "http://127.0.0.1:1097/");
+  curl_easy_setopt (c, CURLOPT_WRITEFUNCTION, &discardBuffer);
+  curl_easy_setopt (c, CURLOPT_FAILONERROR, 1);
+  curl_easy_setopt (c, CURLOPT_TIMEOUT, 15L);
+  curl_easy_setopt (c, CURLOPT_CONNECTTIMEOUT, 15L);
+  curl_easy_setopt (c, CURLOPT_NOSIGNAL, 1);
+  for (i = 0; i < NUM_REQUESTS; i++)
+    if (CURLE_OK != curl_easy_perform (c))
+      ret |= 4;
+  curl_easy_cleanup (c);
+
+  /* the client may see the response before the request is recorded */
+  start = time (NULL);
+  do
+    {
+      found = MHD_get_phase_histogram (d,
+                                       MHD_REQUEST_PHASE_TOTAL,
+                                       &total);
+      if ( (MHD_YES != found) ||
+           ( (NUM_REQUESTS == total.count) &&
+             (NUM_REQUESTS == timed_ok) ) )
+        break;
+      usleep (10000);
+    }
+  while (time (NULL) - start < 5);
+  if (MHD_YES != found)
+    {
+      MHD_stop_daemon (d);
+      return ret | 8;
+    }
+  if ( (MHD_YES != MHD_get_phase_histogram (d,
+                                            MHD_REQUEST_PHASE_HANDLER,
+                                            &handler)) ||
+       (NUM_REQUESTS != total.count) ||
+       (NUM_REQUESTS != handler.count) ||
+       (MHD_histogram_percentile (&handler, 0) < HANDLER_USEC / 2) ||
+       (MHD_histogram_percentile (&total, 100) != total.max) ||
+       (MHD_histogram_percentile (&total, 50) > total.max) ||
+       (total.sum < NUM_REQUESTS * HANDLER_USEC) ||
+       (NUM_REQUESTS != timed_ok) )
+    {
+      fprintf (stderr,
+               "Unexpected timing: %u requests, %u usec p50, %u timed\n",
+               (unsigned int) total.count,
+               (unsigned int) MHD_histogram_percentile (&total, 50),
+               timed_ok);
+      ret |= 16;
+    }
+  MHD_stop_daemon (d);
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+
+  if (0 != curl_global_init (CURL_GLOBAL_WIN32))
+    return 2;
+  errorCount += testTiming (MHD_USE_SELECT_INTERNALLY, 0);
+  errorCount += testTiming (MHD_USE_SELECT_INTERNALLY, 2);
+  errorCount += testTiming (MHD_USE_THREAD_PER_CONNECTION, 0);
+  if (errorCount != 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  curl_global_cleanup ();
+  return errorCount != 0;       /* 0 == pass */
+}
@@ -0,0 +1,254 @@
+/*
+     This file is part of libmicrohttpd
+     Copyright (C) 2026 libmicrohttpd contributors
+
+     libmicrohttpd is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 2, or (at your
+     option) any later version.
+
+     libmicrohttpd is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with libmicrohttpd; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+
+/**
+ * @file test_trace.c
+ * @brief  Testcase for #MHD_OPTION_TRACE_FILE
+ * @author libmicrohttpd contributors
+ */
+
+#include "MHD_config.h"
+#include "platform.h"
+#include <curl/curl.h>
+#include <microhttpd.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mhd_trace.h"
+
+#ifndef WINDOWS
+#include <unistd.h>
+#endif
+
+/**
+ * Port of the daemon.
+ */
+#define PORT 1100
+
+/**
+ * Number of requests sent over one connection.
+ */
+#define NUM_REQUESTS 3
+
+/**
+ * Name of the trace file.
+ */
+#define TRACE_FILE "test_trace.tmp"
+
+/**
+ * Body of the responses.
+ */
+#define PAGE "Hello, trace"
+
+
+static size_t
+discardBuffer (void *ptr, size_t size, size_t nmemb, void *ctx)
+{
+  (void) ptr; (void) ctx;
+  return size * nmemb;
+}
+
+
+static int
+ahc_echo (void *cls,
+          struct MHD_Connection *connection,
+          const char *url,
+          const char *method,
+          const char *version,
+          const char *upload_data, size_t *upload_data_size,
+          void **unused)
+{
+  struct MHD_Response *response;
+  int ret;
+
+  (void) cls; (void) url; (void) method; (void) version;
+  (void) upload_data; (void) upload_data_size; (void) unused;
+  response = MHD_create_response_from_buffer (strlen (PAGE),
+                                              (void *) PAGE,
+                                              MHD_RESPMEM_PERSISTENT);
+  ret = MHD_queue_response (connection, MHD_HTTP_OK, response);
+  MHD_destroy_response (response);
+  return ret;
+}
+
+
+static uint32_t
+get_le32 (const unsigned char *buf)
+{
+  return (uint32_t) buf[0]
+    | ((uint32_t) buf[1] << 8)
+    | ((uint32_t) buf[2] << 16)
+    | ((uint32_t) buf[3] << 24);
+}
+
+
+/**
+ * Check the trace of one connection with #NUM_REQUESTS requests.
+ *
+ * @return 0 if the trace is as expected
+ */
+static int
+checkTrace (void)
+{
+  unsigned char buf[16384];
+  char data[sizeof (buf)];
+  const unsigned char *pos;
+  const char *req;
+  FILE *f;
+  size_t size;
+  size_t off;
+  size_t data_len;
+  uint64_t usec;
+  uint64_t last_usec;
+  uint32_t word;
+  unsigned int type;
+  unsigned int opened;
+  unsigned int closed;
+  unsigned int i;
+
+  if (NULL == (f = fopen (TRACE_FILE, "rb")))
+    return 1;
+  size = fread (buf, 1, sizeof (buf), f);
+  fclose (f);
+  if ( (size < MHD_TRACE_HEADER_SIZE) ||
+       (0 != memcmp (buf, MHD_TRACE_MAGIC, 8)) ||
+       (MHD_TRACE_VERSION != get_le32 (&buf[8])) )
+    return 2;
+  opened = 0;
+  closed = 0;
+  data_len = 0;
+  last_usec = 0;
+  off = MHD_TRACE_HEADER_SIZE;
+  while (off + MHD_TRACE_RECORD_SIZE <= size)
+    {
+      pos = &buf[off];
+      usec = (uint64_t) get_le32 (pos)
+        | ((uint64_t) get_le32 (&pos[4]) << 32);
+      word = get_le32 (&pos[12]);
+      type = word >> 24;
+      word &= MHD_TRACE_MAX_DATA;
+      off += MHD_TRACE_RECORD_SIZE + word;
+      if ( (off > size) ||
+           (usec < last_usec) ||
+           (1 != get_le32 (&pos[8])) ||
+           (0 != closed) )
+        return 4;
+      last_usec = usec;
+      switch (type)
+        {
+        case MHD_TRACE_OPEN:
+          if ( (0 != opened) ||
+               (0 != word) )
+            return 8;
+          opened = 1;
+          break;
+        case MHD_TRACE_DATA:
+          if (0 == opened)
+            return 8;
+          memcpy (&data[data_len], &pos[MHD_TRACE_RECORD_SIZE], word);
+          data_len += word;
+          break;
+        case MHD_TRACE_EOF:
+          break;
+        case MHD_TRACE_CLOSE:
+          closed = 1;
+          break;
+        default:
+          return 16;
+        }
+    }
+  if ( (off != size) ||
+       (0 == closed) )
+    return 32;
+  /* all requests were recorded completely */
+  data[data_len] = '\0';
+  req = data;
+  for (i = 0; i < NUM_REQUESTS; i++)
+    {
+      if (0 != strncmp (req, "GET /trace HTTP/1.1\r\n", 21))
+        return 64;
+      req = strstr (req, "\r\n\r\n");
+      if (NULL == req)
+        return 64;
+      req += 4;
+    }
+  if ('\0' != *req)
+    return 64;
+  return 0;
+}
+
+
+static int
+testTrace (unsigned int flags,
+           unsigned int pool)
+{
+  struct MHD_Daemon *d;
+  CURL *c;
+  unsigned int i;
+  int ret;
+
+  d = MHD_start_daemon (flags | MHD_USE_DEBUG,
+                        PORT, NULL, NULL, &ahc_echo, NULL,
+                        MHD_OPTION_THREAD_POOL_SIZE, pool,
+                        MHD_OPTION_TRACE_FILE, TRACE_FILE,
+                        MHD_OPTION_END);
+  if (NULL == d)
+    return 1;
+  ret = 0;
+  c = curl_easy_init ();
+  curl_easy_setopt (c, CURLOPT_URL, "http://127.0.0.1:1100/trace");
+  curl_easy_setopt (c, CURLOPT_WRITEFUNCTION, &discardBuffer);
+  curl_easy_setopt (c, CURLOPT_FAILONERROR, 1);
+  curl_easy_setopt (c, CURLOPT_TIMEOUT, 15L);
+  curl_easy_setopt (c, CURLOPT_CONNECTTIMEOUT, 15L);
+  curl_easy_setopt (c, CURLOPT_NOSIGNAL, 1);
+  for (i = 0; i < NUM_REQUESTS; i++)
+    if (CURLE_OK != curl_easy_perform (c))
+      ret |= 2;
+  curl_easy_cleanup (c);
+  /* closes the connection and the trace */
+  MHD_stop_daemon (d);
+  i = checkTrace ();
+  if (0 != i)
+    {
+      fprintf (stderr,
+               "Unexpected trace (code: %u)\n",
+               i);
+      ret |= 4;
+    }
+  unlink (TRACE_FILE);
+  return ret;
+}
+
+
+int
+main (int argc, char *const *argv)
+{
+  unsigned int errorCount = 0;
+
+  if (0 != curl_global_init (CURL_GLOBAL_WIN32))
+    return 2;
+  errorCount += testTrace (MHD_USE_SELECT_INTERNALLY, 0);
+  errorCount += testTrace (MHD_USE_SELECT_INTERNALLY, 2);
+  errorCount += testTrace (MHD_USE_THREAD_PER_CONNECTION, 0);
+  if (errorCount != 0)
+    fprintf (stderr, "Error (code: %u)\n", errorCount);
+  curl_global_cleanup ();
+  return errorCount != 0;       /* 0 == pass */
+}